@@ -0,0 +1,34 @@
+#include "wppch.h"
+#include "Benchmark.h"
+
+#include <cstring>
+
+namespace Warp::Bench {
+
+	std::vector<Benchmark>& getBenchmarks() {
+		static std::vector<Benchmark> s_benchmarks;
+		return s_benchmarks;
+	}
+}
+
+// Runs every registered benchmark, or only those whose name contains one of the arguments
+int main(int argc, char** argv) {
+
+	WP_LOG_INIT();
+
+	for (const auto& benchmark : Warp::Bench::getBenchmarks()) {
+		bool selected = argc < 2;
+		for (int i = 1; i < argc && !selected; ++i) {
+			selected = std::strstr(benchmark.name, argv[i]) != nullptr;
+		}
+		if (!selected) {
+			continue;
+		}
+
+		std::printf("== %s\n", benchmark.name);
+		benchmark.function();
+		std::printf("\n");
+	}
+
+	WP_LOG_SHUTDOWN();
+}
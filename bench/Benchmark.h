@@ -0,0 +1,58 @@
+#pragma once
+#include <chrono>
+#include <cstdio>
+#include <vector>
+
+namespace Warp::Bench {
+
+	using BenchmarkFunction = void(*)();
+
+	struct Benchmark {
+		const char* name;
+		BenchmarkFunction function;
+	};
+
+	std::vector<Benchmark>& getBenchmarks();
+
+	struct Registration {
+		Registration(const char* name, BenchmarkFunction function) {
+			getBenchmarks().push_back({ name, function });
+		}
+	};
+
+	class Timer {
+
+	public:
+		Timer() : m_start(std::chrono::high_resolution_clock::now()) {}
+
+		void reset() { m_start = std::chrono::high_resolution_clock::now(); }
+
+		double elapsedMs() const {
+			return std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - m_start).count();
+		}
+
+		double elapsedNs() const {
+			return std::chrono::duration<double, std::nano>(std::chrono::high_resolution_clock::now() - m_start).count();
+		}
+
+	private:
+		std::chrono::high_resolution_clock::time_point m_start;
+	};
+
+	// Keeps the optimizer from removing a computed value, the empty asm claims to read it through memory
+	template<class T>
+	inline void doNotOptimize(const T& value) {
+#if defined(_MSC_VER) && !defined(__clang__)
+		static const T* volatile s_sink;
+		s_sink = &value;
+		(void)s_sink;
+#else
+		asm volatile("" : : "g"(&value) : "memory");
+#endif
+	}
+}
+
+#define WP_BENCHMARK(name) \
+	static void name(); \
+	static ::Warp::Bench::Registration name##_registration(#name, name); \
+	static void name()
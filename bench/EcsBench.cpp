@@ -0,0 +1,181 @@
+#include "wppch.h"
+#include "Benchmark.h"
+#include "Core/JobSystem.h"
+#include "ECS/World.h"
+
+#include <algorithm>
+#include <random>
+
+using namespace Warp;
+
+constexpr uint32_t ENTITY_COUNT = 1 << 20;
+constexpr uint32_t PASS_COUNT = 20;
+constexpr uint32_t STRUCTURAL_COUNT = 100000;
+
+struct Position {
+	float x, y, z;
+};
+
+struct Velocity {
+	float x, y, z;
+};
+
+struct Health {
+	float current, maximum;
+};
+
+// Data the movement pass never reads, but an object carries along anyway
+struct RenderData {
+	float transform[12];
+	uint32_t mesh, material;
+};
+
+// The same entity as one object, all of its data in one place
+struct GameObject {
+	Position position;
+	Velocity velocity;
+	Health health;
+	RenderData render;
+};
+
+// The heap allocated polymorphic alternative
+class SceneObject {
+
+public:
+	virtual ~SceneObject() = default;
+
+	virtual void update(float deltaTime) = 0;
+};
+
+class MovingObject : public SceneObject {
+
+public:
+	void update(float deltaTime) override {
+		m_data.position.x += m_data.velocity.x * deltaTime;
+		m_data.position.y += m_data.velocity.y * deltaTime;
+		m_data.position.z += m_data.velocity.z * deltaTime;
+	}
+
+private:
+	GameObject m_data{};
+};
+
+static void move(Position& position, const Velocity& velocity, float deltaTime) {
+	position.x += velocity.x * deltaTime;
+	position.y += velocity.y * deltaTime;
+	position.z += velocity.z * deltaTime;
+}
+
+template<class Function>
+static double measurePasses(const Function& pass) {
+	pass();
+
+	Bench::Timer timer;
+	for (uint32_t i = 0; i < PASS_COUNT; ++i) {
+		pass();
+	}
+	return timer.elapsedMs() / PASS_COUNT;
+}
+
+static void printPass(const char* name, double passMs) {
+	std::printf("%-28s %10.3f ms per pass %8.2f ns per entity\n", name, passMs, passMs * 1e6 / ENTITY_COUNT);
+}
+
+// One movement pass over every entity. The entities also carry health and render data the pass does not need,
+// which the object layouts drag through the cache and the archetype chunks keep in separate arrays.
+WP_BENCHMARK(EcsIteration) {
+	const float deltaTime = 1.0f / 60.0f;
+
+	{
+		std::vector<GameObject> objects(ENTITY_COUNT);
+		for (uint32_t i = 0; i < ENTITY_COUNT; ++i) {
+			objects[i].velocity = { 1.0f, float(i & 7), 0.5f };
+		}
+		printPass("AoS vector", measurePasses([&]() {
+			for (auto& object : objects) {
+				move(object.position, object.velocity, deltaTime);
+			}
+		}));
+		Bench::doNotOptimize(objects[0].position.x);
+	}
+
+	{
+		// Shuffled, as objects created and destroyed over time end up scattered across the heap
+		std::vector<ScopedRef<SceneObject>> objects;
+		objects.reserve(ENTITY_COUNT);
+		for (uint32_t i = 0; i < ENTITY_COUNT; ++i) {
+			objects.push_back(CreateScopedRef<MovingObject>());
+		}
+		std::shuffle(objects.begin(), objects.end(), std::mt19937(42));
+		printPass("Polymorphic heap objects", measurePasses([&]() {
+			for (auto& object : objects) {
+				object->update(deltaTime);
+			}
+		}));
+	}
+
+	JobSystem jobSystem;
+	World world;
+	for (uint32_t i = 0; i < ENTITY_COUNT; ++i) {
+		world.create(Position{}, Velocity{ 1.0f, float(i & 7), 0.5f }, Health{ 100.0f, 100.0f }, RenderData{});
+	}
+	auto query = world.query<Position, const Velocity>();
+
+	printPass("ECS each", measurePasses([&]() {
+		query.each([deltaTime](Position& position, const Velocity& velocity) {
+			move(position, velocity, deltaTime);
+		});
+	}));
+	printPass("ECS eachChunk", measurePasses([&]() {
+		query.eachChunk([deltaTime](uint32_t count, const Entity*, Position* positions, const Velocity* velocities) {
+			for (uint32_t i = 0; i < count; ++i) {
+				move(positions[i], velocities[i], deltaTime);
+			}
+		});
+	}));
+
+	char name[64];
+	std::snprintf(name, sizeof(name), "ECS eachParallel (%u workers)", jobSystem.getWorkerCount());
+	printPass(name, measurePasses([&]() {
+		query.eachParallel([deltaTime](Position& position, const Velocity& velocity) {
+			move(position, velocity, deltaTime);
+		});
+	}));
+	Bench::doNotOptimize(world.get<Position>(Entity{ 0, 0 })->x);
+}
+
+// Moving entities between archetypes through the graph edges, and creating and destroying them
+WP_BENCHMARK(EcsStructuralChanges) {
+	World world;
+	std::vector<Entity> entities(STRUCTURAL_COUNT);
+
+	Bench::Timer timer;
+	for (auto& entity : entities) {
+		entity = world.create(Position{}, Velocity{});
+	}
+	double createNs = timer.elapsedNs() / STRUCTURAL_COUNT;
+
+	timer.reset();
+	for (auto entity : entities) {
+		world.add<Health>(entity, Health{ 100.0f, 100.0f });
+	}
+	double addNs = timer.elapsedNs() / STRUCTURAL_COUNT;
+
+	timer.reset();
+	for (auto entity : entities) {
+		world.remove<Health>(entity);
+	}
+	double removeNs = timer.elapsedNs() / STRUCTURAL_COUNT;
+
+	timer.reset();
+	for (auto entity : entities) {
+		world.destroy(entity);
+	}
+	double destroyNs = timer.elapsedNs() / STRUCTURAL_COUNT;
+
+	std::printf("%-28s %10.1f ns per entity\n", "create with 2 components", createNs);
+	std::printf("%-28s %10.1f ns per entity\n", "add component", addNs);
+	std::printf("%-28s %10.1f ns per entity\n", "remove component", removeNs);
+	std::printf("%-28s %10.1f ns per entity\n", "destroy", destroyNs);
+	std::printf("%-28s %10u\n", "archetypes", world.getArchetypeCount());
+}
\ No newline at end of file
@@ -0,0 +1,107 @@
+#include "wppch.h"
+#include "Benchmark.h"
+#include "Core/Layer.h"
+#include "Events/EventQueue.h"
+
+#include <array>
+#include <atomic>
+#include <thread>
+
+using namespace Warp;
+
+constexpr uint32_t EVENT_COUNT = 1000000;
+// Roughly what a fast mouse and a few keys produce between two frames
+constexpr uint32_t EVENTS_PER_FRAME = 32;
+constexpr size_t BATCH_SIZE = 64;
+
+static Event makeEvent(uint32_t i) {
+	Event event(i % 4 == 0 ? EventType::KeyPress : EventType::MouseMove);
+	event.mouseMove = { static_cast<float>(i), static_cast<float>(i) };
+	return event;
+}
+
+// Counts the events of its types, the top layer handles every fourth one
+class CountingLayer : public Layer {
+
+public:
+	CountingLayer(EventMask mask, bool handles) : Layer("Counting", mask), m_handles(handles) {}
+
+	void onEvents(const EventBatch& events) override {
+		for (Event& event : events) {
+			++count;
+			event.handled = m_handles && count % 4 == 0;
+		}
+	}
+
+	uint64_t count = 0;
+
+private:
+	bool m_handles;
+};
+
+// Frames of pushes by the callbacks followed by one drain, all on one thread like glfwPollEvents
+WP_BENCHMARK(EventQueuePushDrain) {
+	auto queue = CreateScopedRef<EventQueue>();
+	std::array<Event, BATCH_SIZE> batch;
+
+	uint64_t drained = 0;
+	Bench::Timer timer;
+	for (uint32_t i = 0; i < EVENT_COUNT; i += EVENTS_PER_FRAME) {
+		for (uint32_t j = 0; j < EVENTS_PER_FRAME; ++j) {
+			queue->push(makeEvent(i + j));
+		}
+		for (size_t count; (count = queue->pop(batch.data(), batch.size())) > 0;) {
+			drained += count;
+		}
+	}
+	double ns = timer.elapsedNs() / EVENT_COUNT;
+	std::printf("%-22s %10.2f ns/event %10llu drained %10llu dropped\n", "push + drain", ns,
+		static_cast<unsigned long long>(drained), static_cast<unsigned long long>(queue->getDroppedCount()));
+}
+
+// One thread pushes while another drains, what the queue would see with input read on its own thread
+WP_BENCHMARK(EventQueueCrossThread) {
+	auto queue = CreateScopedRef<EventQueue>();
+	std::atomic<bool> done{ false };
+
+	Bench::Timer timer;
+	std::thread producer([&]() {
+		for (uint32_t i = 0; i < EVENT_COUNT; ++i) {
+			while (!queue->push(makeEvent(i))) {
+				std::this_thread::yield();
+			}
+		}
+		done.store(true, std::memory_order_release);
+	});
+
+	std::array<Event, BATCH_SIZE> batch;
+	uint64_t drained = 0;
+	while (!done.load(std::memory_order_acquire) || !queue->isEmpty()) {
+		drained += queue->pop(batch.data(), batch.size());
+	}
+	producer.join();
+
+	// Retried pushes count as dropped too
+	double ns = timer.elapsedNs() / EVENT_COUNT;
+	std::printf("%-22s %10.2f ns/event %10llu drained %10llu full\n", "cross thread", ns,
+		static_cast<unsigned long long>(drained), static_cast<unsigned long long>(queue->getDroppedCount()));
+}
+
+// Batches handed top to bottom to a UI layer that takes input and a game layer that only wants the mouse
+WP_BENCHMARK(EventDispatch) {
+	std::array<Event, BATCH_SIZE> batch;
+	CountingLayer game(EVENT_MASK_MOUSE, false);
+	CountingLayer ui(EVENT_MASK_INPUT, true);
+
+	Bench::Timer timer;
+	for (uint32_t i = 0; i < EVENT_COUNT; i += BATCH_SIZE) {
+		for (uint32_t j = 0; j < BATCH_SIZE; ++j) {
+			batch[j] = makeEvent(i + j);
+		}
+		ui.onEvents(EventBatch(batch.data(), batch.size(), ui.getEventMask()));
+		game.onEvents(EventBatch(batch.data(), batch.size(), game.getEventMask()));
+	}
+	double ns = timer.elapsedNs() / EVENT_COUNT;
+	std::printf("%-22s %10.2f ns/event %10llu ui %10llu game\n", "dispatch", ns,
+		static_cast<unsigned long long>(ui.count), static_cast<unsigned long long>(game.count));
+}
@@ -0,0 +1,60 @@
+#include "wppch.h"
+#include "Benchmark.h"
+#include "Core/FramePacer.h"
+
+#include <thread>
+
+using namespace Warp;
+
+constexpr double RUN_SECONDS = 2.0;
+constexpr double WORK_MS = 2.0;
+
+// Stands in for a frame's worth of CPU work
+static void simulateWork(double milliseconds) {
+	Bench::Timer timer;
+	while (timer.elapsedMs() < milliseconds) {
+	}
+}
+
+static void runPolicy(const char* name, const FramePacingSettings& settings) {
+	FramePacer pacer(settings);
+
+	uint64_t fixedSteps = 0;
+	Bench::Timer timer;
+	while (timer.elapsedMs() < RUN_SECONDS * 1000.0) {
+		if (settings.mode == FramePacingMode::Idle) {
+			// No window on the benchmark host, so no event ever arrives and glfwWaitEventsTimeout runs into its timeout
+			std::this_thread::sleep_for(std::chrono::duration<double>(settings.idleTimeout));
+		}
+
+		pacer.beginFrame();
+		while (pacer.stepFixed()) {
+			++fixedSteps;
+		}
+		simulateWork(WORK_MS);
+		pacer.endFrame();
+	}
+
+	auto stats = pacer.getStats();
+	std::printf("%-22s %8llu %10.1f %10.3f %10.3f %10.3f %8.1f%%\n", name, static_cast<unsigned long long>(stats.frameCount),
+		fixedSteps / RUN_SECONDS, stats.averageFrameMs, stats.jitterMs, stats.maxFrameMs, stats.cpuUsage * 100.0);
+}
+
+WP_BENCHMARK(FramePacing) {
+	std::printf("%-22s %8s %10s %10s %10s %10s %9s\n", "policy", "frames", "fixed/s", "avg ms", "jitter ms", "max ms", "cpu");
+
+	FramePacingSettings settings;
+	settings.mode = FramePacingMode::Unlimited;
+	runPolicy("unlimited", settings);
+
+	settings.mode = FramePacingMode::LimitFps;
+	settings.targetFps = 60.0;
+	runPolicy("limit 60fps", settings);
+
+	settings.targetFps = 144.0;
+	runPolicy("limit 144fps", settings);
+
+	settings.mode = FramePacingMode::Idle;
+	settings.idleTimeout = 0.1;
+	runPolicy("idle (100ms timeout)", settings);
+}
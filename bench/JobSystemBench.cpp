@@ -0,0 +1,96 @@
+#include "wppch.h"
+#include "Benchmark.h"
+#include "Core/JobSystem.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+
+using namespace Warp;
+
+constexpr uint32_t FRAME_COUNT = 60;
+
+// Synthetic per-frame workload: a few transform-like passes over a large array, each pass depending on the previous one
+static void simulateFrame(JobSystem& jobSystem, std::vector<float>& data) {
+	for (int pass = 0; pass < 4; ++pass) {
+		jobSystem.parallel_for(static_cast<uint32_t>(data.size()), 4096, [&data, pass](uint32_t begin, uint32_t end) {
+			for (uint32_t i = begin; i < end; ++i) {
+				float value = data[i];
+				for (int k = 0; k < 16; ++k) {
+					value = std::sqrt(value * value + static_cast<float>(pass + k));
+				}
+				data[i] = value * 0.5f;
+			}
+		});
+	}
+}
+
+// Many tiny independent jobs per frame, measures scheduling and stealing overhead rather than throughput
+static void simulateSmallJobs(JobSystem& jobSystem, std::vector<float>& data) {
+	JobCounter counter;
+	for (uint32_t i = 0; i < 2048; ++i) {
+		float* value = &data[i];
+		jobSystem.schedule([value]() { *value = std::sqrt(*value + 1.0f); }, &counter);
+	}
+	jobSystem.wait(counter);
+}
+
+WP_BENCHMARK(JobSystemScaling) {
+	uint32_t maxWorkers = std::max(1u, std::thread::hardware_concurrency());
+	std::vector<float> data(1 << 20, 1.0f);
+
+	std::printf("%8s %16s %10s %16s\n", "workers", "frame ms (avg)", "speedup", "2048 jobs us");
+
+	std::vector<uint32_t> workerCounts;
+	for (uint32_t workers = 1; workers < maxWorkers; workers *= 2) {
+		workerCounts.push_back(workers);
+	}
+	workerCounts.push_back(maxWorkers);
+
+	double singleWorkerMs = 0.0;
+	for (uint32_t workers : workerCounts) {
+		JobSystem jobSystem(workers);
+
+		simulateFrame(jobSystem, data);
+
+		Bench::Timer timer;
+		for (uint32_t frame = 0; frame < FRAME_COUNT; ++frame) {
+			simulateFrame(jobSystem, data);
+		}
+		double frameMs = timer.elapsedMs() / FRAME_COUNT;
+
+		timer.reset();
+		for (uint32_t frame = 0; frame < FRAME_COUNT; ++frame) {
+			simulateSmallJobs(jobSystem, data);
+		}
+		double smallJobsUs = timer.elapsedMs() * 1000.0 / FRAME_COUNT;
+
+		if (workers == 1) {
+			singleWorkerMs = frameMs;
+		}
+		std::printf("%8u %16.3f %9.2fx %16.1f\n", workers, frameMs, singleWorkerMs / frameMs, smallJobsUs);
+	}
+	Bench::doNotOptimize(data[0]);
+}
+
+// Schedules several job pools worth of jobs before the first wait, a pool slot must not be reused while its job is
+// queued or running. Every other job depends on a counter that may not be done yet, so some are deferred instead.
+WP_BENCHMARK(JobPoolOverflow) {
+	constexpr uint32_t JOB_COUNT = 4 * JobSystem::JOB_POOL_SIZE;
+	JobSystem jobSystem;
+
+	std::atomic<uint32_t> executed{ 0 };
+	JobCounter gate, counter;
+	jobSystem.schedule([]() {}, &gate);
+
+	Bench::Timer timer;
+	for (uint32_t i = 0; i < JOB_COUNT; ++i) {
+		jobSystem.schedule([&executed]() { executed.fetch_add(1, std::memory_order_relaxed); }, &counter, i % 2 == 0 ? nullptr : &gate);
+	}
+	jobSystem.wait(counter);
+	double jobUs = timer.elapsedMs() * 1000.0 / JOB_COUNT;
+
+	bool passed = executed.load() == JOB_COUNT;
+	std::printf("%u jobs, %u executed, %.3f us per job: %s\n", JOB_COUNT, executed.load(), jobUs, passed ? "ok" : "FAILED");
+	WP_ASSERTM(passed, "Jobs were lost when the job pool wrapped around");
+}
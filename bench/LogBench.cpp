@@ -0,0 +1,99 @@
+#include "wppch.h"
+#include "Benchmark.h"
+
+#include <spdlog/sinks/basic_file_sink.h>
+#include <spdlog/sinks/null_sink.h>
+
+#include <thread>
+
+#ifdef WP_LOG_ENABLE
+
+using namespace Warp;
+
+constexpr uint32_t CALLS_PER_THREAD = 100000;
+constexpr uint32_t BURST_SIZE = 256;
+
+// Average ns per WP_LOG_INFO call seen by the calling threads while they log as fast as they can.
+// Once a thread's ring is full this includes waiting for the log thread.
+static double measureSustained(LogMode mode, spdlog::sink_ptr sink, uint32_t threadCount) {
+	Log::shutdown();
+	Log::init(mode, sink);
+
+	std::vector<double> threadNs(threadCount);
+	std::vector<std::thread> threads;
+	for (uint32_t t = 0; t < threadCount; ++t) {
+		threads.emplace_back([&threadNs, t]() {
+			std::string name = "entity";
+			Bench::Timer timer;
+			for (uint32_t i = 0; i < CALLS_PER_THREAD; ++i) {
+				WP_LOG_INFO("Frame {0}: updated {1} at ({2}, {3})", i, name, 1.5f * i, 2.0 * t);
+			}
+			threadNs[t] = timer.elapsedNs() / CALLS_PER_THREAD;
+		});
+	}
+	for (auto& thread : threads) {
+		thread.join();
+	}
+
+	Log::flush();
+	Log::shutdown();
+
+	double sum = 0.0;
+	for (double ns : threadNs) {
+		sum += ns;
+	}
+	return sum / threadCount;
+}
+
+// Average ns per call for a frame-sized burst of messages, the log catches up between frames
+static double measureBurst(LogMode mode, spdlog::sink_ptr sink) {
+	Log::shutdown();
+	Log::init(mode, sink);
+
+	std::string name = "entity";
+	double totalNs = 0.0;
+	for (uint32_t frame = 0; frame < CALLS_PER_THREAD / BURST_SIZE; ++frame) {
+		Bench::Timer timer;
+		for (uint32_t i = 0; i < BURST_SIZE; ++i) {
+			WP_LOG_INFO("Frame {0}: updated {1} at ({2}, {3})", frame, name, 1.5f * i, 2.0 * i);
+		}
+		totalNs += timer.elapsedNs();
+		Log::flush();
+	}
+
+	Log::shutdown();
+	return totalNs / CALLS_PER_THREAD;
+}
+
+WP_BENCHMARK(LogCallCost) {
+	std::printf("%-28s %12s %12s %12s\n", "setup", "burst", "1 thread", "4 threads");
+
+	auto run = [](const char* name, LogMode mode, auto createSink) {
+		double burst = measureBurst(mode, createSink());
+		double single = measureSustained(mode, createSink(), 1);
+		double multi = measureSustained(mode, createSink(), 4);
+		std::printf("%-28s %9.1f ns %9.1f ns %9.1f ns\n", name, burst, single, multi);
+	};
+
+	auto fileSink = []() { return CreateCountedRef<spdlog::sinks::basic_file_sink_mt>("bench_log.txt", true); };
+	auto nullSink = []() { return CreateCountedRef<spdlog::sinks::null_sink_mt>(); };
+
+	run("sync, file, flush each", LogMode::Sync, fileSink);
+	run("async, file", LogMode::Async, fileSink);
+	run("sync, null sink", LogMode::Sync, nullSink);
+	run("async, null sink", LogMode::Async, nullSink);
+
+	// Compiled out when WP_LOG_ACTIVE_LEVEL is above trace, as in Release
+	Log::shutdown();
+	Log::init(LogMode::Async, nullSink());
+	Bench::Timer timer;
+	for (uint32_t i = 0; i < BURST_SIZE; ++i) {
+		WP_LOG_TRACE("Trace {0}", i);
+	}
+	std::printf("%-28s %9.1f ns\n", "async trace burst", timer.elapsedNs() / BURST_SIZE);
+
+	Log::shutdown();
+	Log::init();
+}
+
+#endif
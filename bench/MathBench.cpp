@@ -0,0 +1,176 @@
+#include "wppch.h"
+#include "Benchmark.h"
+#include "Math/Math.h"
+
+#include <random>
+
+using namespace Warp;
+using namespace Warp::Math;
+
+constexpr size_t POINT_COUNT = 1 << 20;
+constexpr size_t MATRIX_COUNT = 1 << 16;
+constexpr size_t BOX_COUNT = 1 << 20;
+constexpr uint32_t PASS_COUNT = 20;
+
+template<class Function>
+static double measurePasses(const Function& pass) {
+	pass();
+
+	Bench::Timer timer;
+	for (uint32_t i = 0; i < PASS_COUNT; ++i) {
+		pass();
+	}
+	return timer.elapsedMs() / PASS_COUNT;
+}
+
+static void printPass(const char* name, SimdLevel level, double passMs, double scalarMs, size_t count) {
+	char label[64];
+	std::snprintf(label, sizeof(label), "%s %s", name, toString(level));
+	std::printf("%-28s %10.3f ms per pass %8.2f ns per element %6.2fx\n", label, passMs, passMs * 1e6 / count, scalarMs / passMs);
+}
+
+static std::vector<float> randomFloats(size_t count, float minimum, float maximum, uint32_t seed) {
+	std::mt19937 random(seed);
+	std::uniform_real_distribution<float> distribution(minimum, maximum);
+	std::vector<float> values(count);
+	for (auto& value : values) {
+		value = distribution(random);
+	}
+	return values;
+}
+
+static std::vector<SimdLevel> getLevels() {
+	std::vector<SimdLevel> levels;
+	for (auto level : { SimdLevel::Scalar, SimdLevel::Sse2, SimdLevel::Avx2 }) {
+		if (level <= getSupportedSimdLevel()) {
+			levels.push_back(level);
+		}
+	}
+	return levels;
+}
+
+static float maxDifference(const float* a, const float* b, size_t count) {
+	float difference = 0.0f;
+	for (size_t i = 0; i < count; ++i) {
+		difference = std::max(difference, std::fabs(a[i] - b[i]));
+	}
+	return difference;
+}
+
+static Mat4 createViewProjection() {
+	return Mat4::perspective(1.0f, 16.0f / 9.0f, 0.1f, 200.0f) * Mat4::lookAt({ 0.0f, 10.0f, 0.0f }, { 30.0f, 0.0f, 40.0f }, { 0.0f, 1.0f, 0.0f });
+}
+
+// Every kernel level against the scalar one, with the results checked against it
+WP_BENCHMARK(MathTransformPoints) {
+	std::printf("Supported SIMD level: %s\n", toString(getSupportedSimdLevel()));
+
+	auto x = randomFloats(POINT_COUNT, -100.0f, 100.0f, 1);
+	auto y = randomFloats(POINT_COUNT, -100.0f, 100.0f, 2);
+	auto z = randomFloats(POINT_COUNT, -100.0f, 100.0f, 3);
+	Mat4 matrix = Mat4::transform({ 1.0f, 2.0f, 3.0f }, Quat::fromAxisAngle(normalize(Vec3(1.0f, 1.0f, 0.0f)), 0.7f), Vec3(2.0f));
+
+	std::vector<float> expectedX(POINT_COUNT), expectedY(POINT_COUNT), expectedZ(POINT_COUNT);
+	std::vector<float> outX(POINT_COUNT), outY(POINT_COUNT), outZ(POINT_COUNT);
+	double scalarMs = 0.0;
+	for (auto level : getLevels()) {
+		const Kernels& kernels = getKernels(level);
+		bool scalar = level == SimdLevel::Scalar;
+		float* destinationX = scalar ? expectedX.data() : outX.data();
+		float* destinationY = scalar ? expectedY.data() : outY.data();
+		float* destinationZ = scalar ? expectedZ.data() : outZ.data();
+		double passMs = measurePasses([&]() {
+			kernels.transformPoints(matrix, x.data(), y.data(), z.data(), destinationX, destinationY, destinationZ, POINT_COUNT);
+		});
+		if (scalar) {
+			scalarMs = passMs;
+		}
+		else {
+			[[maybe_unused]] float difference = std::max({ maxDifference(outX.data(), expectedX.data(), POINT_COUNT),
+				maxDifference(outY.data(), expectedY.data(), POINT_COUNT), maxDifference(outZ.data(), expectedZ.data(), POINT_COUNT) });
+			WP_ASSERTM(difference < 1e-3f, "Transformed points differ from the scalar kernel");
+		}
+		printPass("transformPoints", level, passMs, scalarMs, POINT_COUNT);
+	}
+	Bench::doNotOptimize(outX[0]);
+}
+
+WP_BENCHMARK(MathMultiplyMatrices) {
+	auto values = randomFloats(MATRIX_COUNT * 32, -2.0f, 2.0f, 4);
+	std::vector<Mat4> a(MATRIX_COUNT), b(MATRIX_COUNT), expected(MATRIX_COUNT), out(MATRIX_COUNT);
+	for (size_t i = 0; i < MATRIX_COUNT; ++i) {
+		std::copy_n(values.data() + i * 32, 16, a[i].data());
+		std::copy_n(values.data() + i * 32 + 16, 16, b[i].data());
+	}
+
+	double scalarMs = 0.0;
+	for (auto level : getLevels()) {
+		const Kernels& kernels = getKernels(level);
+		bool scalar = level == SimdLevel::Scalar;
+		Mat4* destination = scalar ? expected.data() : out.data();
+		double passMs = measurePasses([&]() {
+			kernels.multiplyMatrices(a.data(), b.data(), destination, MATRIX_COUNT);
+		});
+		if (scalar) {
+			scalarMs = passMs;
+		}
+		else {
+			[[maybe_unused]] float difference = maxDifference(out.data()->data(), expected.data()->data(), MATRIX_COUNT * 16);
+			WP_ASSERTM(difference < 1e-4f, "Matrix products differ from the scalar kernel");
+		}
+		printPass("multiplyMatrices", level, passMs, scalarMs, MATRIX_COUNT);
+	}
+
+	// The operator on single matrices, as used outside of batches
+	double operatorMs = measurePasses([&]() {
+		for (size_t i = 0; i < MATRIX_COUNT; ++i) {
+			out[i] = a[i] * b[i];
+		}
+	});
+	std::printf("%-28s %10.3f ms per pass %8.2f ns per element %6.2fx\n", "Mat4 operator*", operatorMs, operatorMs * 1e6 / MATRIX_COUNT, scalarMs / operatorMs);
+	Bench::doNotOptimize(out[0]);
+}
+
+WP_BENCHMARK(MathCullAabbs) {
+	auto centerX = randomFloats(BOX_COUNT, -100.0f, 100.0f, 5);
+	auto centerY = randomFloats(BOX_COUNT, -20.0f, 20.0f, 6);
+	auto centerZ = randomFloats(BOX_COUNT, -100.0f, 100.0f, 7);
+	auto extentX = randomFloats(BOX_COUNT, 0.1f, 2.0f, 8);
+	auto extentY = randomFloats(BOX_COUNT, 0.1f, 2.0f, 9);
+	auto extentZ = randomFloats(BOX_COUNT, 0.1f, 2.0f, 10);
+	AabbArrays boxes = { centerX.data(), centerY.data(), centerZ.data(), extentX.data(), extentY.data(), extentZ.data() };
+	Frustum frustum = Frustum::fromMatrix(createViewProjection());
+
+	std::vector<uint8_t> expected(BOX_COUNT), visible(BOX_COUNT);
+	double scalarMs = 0.0;
+	for (auto level : getLevels()) {
+		const Kernels& kernels = getKernels(level);
+		bool scalar = level == SimdLevel::Scalar;
+		uint8_t* destination = scalar ? expected.data() : visible.data();
+		double passMs = measurePasses([&]() {
+			kernels.cullAabbs(frustum, boxes, destination, BOX_COUNT);
+		});
+		if (scalar) {
+			scalarMs = passMs;
+		}
+		else {
+			// Boxes touching a plane may come out either way, as FMA rounds differently
+			[[maybe_unused]] size_t mismatches = 0;
+			for (size_t i = 0; i < BOX_COUNT; ++i) {
+				mismatches += visible[i] != expected[i];
+			}
+			WP_ASSERTM(mismatches < BOX_COUNT / 10000, "Culling results differ from the scalar kernel");
+		}
+		printPass("cullAabbs", level, passMs, scalarMs, BOX_COUNT);
+	}
+
+	size_t visibleCount = 0;
+	for (size_t i = 0; i < BOX_COUNT; ++i) {
+		visibleCount += expected[i];
+		if (i % 4096 == 0) {
+			[[maybe_unused]] Aabb box = { { centerX[i], centerY[i], centerZ[i] }, { extentX[i], extentY[i], extentZ[i] } };
+			WP_ASSERTM(frustum.intersects(box) == (expected[i] != 0), "Scalar kernel disagrees with Frustum::intersects");
+		}
+	}
+	std::printf("%-28s %10zu of %zu\n", "visible boxes", visibleCount, BOX_COUNT);
+}
\ No newline at end of file
@@ -0,0 +1,132 @@
+#include "wppch.h"
+#include "Benchmark.h"
+#include "Memory/Memory.h"
+
+#include <random>
+#include <thread>
+
+using namespace Warp;
+
+constexpr uint32_t FRAME_COUNT = 200;
+constexpr uint32_t ALLOCATIONS_PER_FRAME = 10000;
+
+struct Particle {
+	float position[3];
+	float velocity[3];
+	float color[4];
+	float lifetime;
+	uint32_t flags;
+};
+
+static std::vector<size_t> createSizes() {
+	std::mt19937 random(42);
+	std::uniform_int_distribution<size_t> distribution(16, 256);
+
+	std::vector<size_t> sizes(ALLOCATIONS_PER_FRAME);
+	for (auto& size : sizes) {
+		size = distribution(random);
+	}
+	return sizes;
+}
+
+// Per-frame scratch memory of mixed sizes, released at the end of the frame
+WP_BENCHMARK(MemoryFrameScratch) {
+	auto sizes = createSizes();
+	std::vector<void*> pointers(sizes.size());
+
+	Bench::Timer timer;
+	for (uint32_t frame = 0; frame < FRAME_COUNT; ++frame) {
+		for (size_t i = 0; i < sizes.size(); ++i) {
+			pointers[i] = ::operator new(sizes[i]);
+			static_cast<char*>(pointers[i])[0] = 1;
+		}
+		for (size_t i = 0; i < sizes.size(); ++i) {
+			::operator delete(pointers[i]);
+		}
+	}
+	double heapNs = timer.elapsedNs() / (FRAME_COUNT * sizes.size());
+
+	FrameAllocator frameAllocator(4 * 1024 * 1024);
+	timer.reset();
+	for (uint32_t frame = 0; frame < FRAME_COUNT; ++frame) {
+		frameAllocator.beginFrame();
+		for (size_t i = 0; i < sizes.size(); ++i) {
+			pointers[i] = frameAllocator.allocate(sizes[i], 16);
+			static_cast<char*>(pointers[i])[0] = 1;
+		}
+	}
+	double frameNs = timer.elapsedNs() / (FRAME_COUNT * sizes.size());
+
+	std::printf("%-24s %10.1f ns per allocation\n", "new/delete", heapNs);
+	std::printf("%-24s %10.1f ns per allocation\n", "FrameAllocator", frameNs);
+}
+
+// Creating and destroying many small objects through the ref helpers
+WP_BENCHMARK(MemoryObjectChurn) {
+	std::vector<ScopedRef<Particle>> heapScoped(ALLOCATIONS_PER_FRAME);
+	std::vector<AllocatedScopedRef<Particle, PoolAllocator>> poolScoped(ALLOCATIONS_PER_FRAME);
+	std::vector<CountedRef<Particle>> counted(ALLOCATIONS_PER_FRAME);
+	auto& pool = PoolAllocator::get();
+
+	auto measure = [](auto&& body) {
+		Bench::Timer timer;
+		for (uint32_t frame = 0; frame < FRAME_COUNT; ++frame) {
+			body();
+		}
+		return timer.elapsedNs() / (FRAME_COUNT * ALLOCATIONS_PER_FRAME);
+	};
+
+	double heapScopedNs = measure([&]() {
+		for (auto& ref : heapScoped) ref = CreateScopedRef<Particle>();
+		for (auto& ref : heapScoped) ref.reset();
+	});
+	double poolScopedNs = measure([&]() {
+		for (auto& ref : poolScoped) ref = CreateScopedRef<Particle>(std::allocator_arg, pool);
+		for (auto& ref : poolScoped) ref.reset();
+	});
+	double heapCountedNs = measure([&]() {
+		for (auto& ref : counted) ref = CreateCountedRef<Particle>();
+		for (auto& ref : counted) ref.reset();
+	});
+	double poolCountedNs = measure([&]() {
+		for (auto& ref : counted) ref = CreateCountedRef<Particle>(std::allocator_arg, pool);
+		for (auto& ref : counted) ref.reset();
+	});
+
+	std::printf("%-24s %10.1f ns per create+destroy\n", "ScopedRef heap", heapScopedNs);
+	std::printf("%-24s %10.1f ns per create+destroy\n", "ScopedRef pool", poolScopedNs);
+	std::printf("%-24s %10.1f ns per create+destroy\n", "CountedRef heap", heapCountedNs);
+	std::printf("%-24s %10.1f ns per create+destroy\n", "CountedRef pool", poolCountedNs);
+}
+
+// Several threads allocating and freeing at once, where a shared heap contends
+WP_BENCHMARK(MemoryThreadedChurn) {
+	uint32_t threadCount = std::max(2u, std::thread::hardware_concurrency());
+
+	auto run = [threadCount](auto&& allocate, auto&& deallocate) {
+		Bench::Timer timer;
+		std::vector<std::thread> threads;
+		for (uint32_t t = 0; t < threadCount; ++t) {
+			threads.emplace_back([&]() {
+				std::vector<void*> pointers(ALLOCATIONS_PER_FRAME);
+				for (uint32_t frame = 0; frame < FRAME_COUNT / 4; ++frame) {
+					for (auto& pointer : pointers) pointer = allocate();
+					for (auto& pointer : pointers) deallocate(pointer);
+				}
+			});
+		}
+		for (auto& thread : threads) {
+			thread.join();
+		}
+		return timer.elapsedNs() / (threadCount * (FRAME_COUNT / 4) * ALLOCATIONS_PER_FRAME);
+	};
+
+	auto& pool = PoolAllocator::get();
+	double heapNs = run([]() { return ::operator new(sizeof(Particle)); }, [](void* pointer) { ::operator delete(pointer); });
+	double poolNs = run([&pool]() { return pool.allocate(sizeof(Particle), alignof(Particle)); },
+		[&pool](void* pointer) { pool.deallocate(pointer, sizeof(Particle), alignof(Particle)); });
+
+	std::printf("%u threads\n", threadCount);
+	std::printf("%-24s %10.1f ns per allocate+free\n", "new/delete", heapNs);
+	std::printf("%-24s %10.1f ns per allocate+free\n", "PoolAllocator", poolNs);
+}
@@ -0,0 +1,79 @@
+#include "wppch.h"
+#include "Benchmark.h"
+
+using namespace Warp;
+
+constexpr uint32_t HANDLE_COUNT = 100000;
+constexpr uint32_t ROUNDS = 50;
+
+struct Payload {
+	float transform[12];
+};
+
+struct SharedObject : Payload {};
+struct AtomicObject : Payload, RefCounted {};
+struct LocalObject : Payload, LocalRefCounted {};
+
+// Counts the bytes std::allocate_shared requests, which is what make_shared allocates per object
+template<class T>
+struct CountingAllocator {
+	using value_type = T;
+
+	size_t* bytes;
+
+	explicit CountingAllocator(size_t* bytes) : bytes(bytes) {}
+
+	template<class U>
+	CountingAllocator(const CountingAllocator<U>& other) : bytes(other.bytes) {}
+
+	T* allocate(size_t count) {
+		*bytes += sizeof(T) * count;
+		return std::allocator<T>().allocate(count);
+	}
+
+	void deallocate(T* pointer, size_t count) { std::allocator<T>().deallocate(pointer, count); }
+
+	template<class U>
+	bool operator==(const CountingAllocator<U>& other) const { return bytes == other.bytes; }
+
+	template<class U>
+	bool operator!=(const CountingAllocator<U>& other) const { return bytes != other.bytes; }
+};
+
+// Copies every handle into a second container and destroys the copies again
+template<class Ref>
+static double measureCopyDestroy(const std::vector<Ref>& handles) {
+	std::vector<Ref> copies;
+	copies.reserve(handles.size());
+
+	Bench::Timer timer;
+	for (uint32_t round = 0; round < ROUNDS; ++round) {
+		for (const auto& handle : handles) {
+			copies.push_back(handle);
+		}
+		copies.clear();
+	}
+	return timer.elapsedNs() / (ROUNDS * handles.size());
+}
+
+template<class Ref, class Create>
+static void run(const char* name, size_t bytesPerObject, Create create) {
+	std::vector<Ref> handles;
+	handles.reserve(HANDLE_COUNT);
+	for (uint32_t i = 0; i < HANDLE_COUNT; ++i) {
+		handles.push_back(create());
+	}
+
+	double ns = measureCopyDestroy(handles);
+	std::printf("%-22s %10.2f ns %10zu B %10zu B\n", name, ns, sizeof(Ref), bytesPerObject);
+}
+
+WP_BENCHMARK(RefCountCopyDestroy) {
+	size_t sharedBytes = 0;
+	std::allocate_shared<SharedObject>(CountingAllocator<SharedObject>(&sharedBytes));
+
+	std::printf("%-22s %13s %12s %12s\n", "handle", "copy+destroy", "handle", "per object");
+	run<CountedRef<SharedObject>>("std::shared_ptr", sharedBytes, []() { return CreateCountedRef<SharedObject>(); });
+	run<IntrusiveRef<AtomicObject>>("RefCounted", sizeof(AtomicObject), []() { return CreateIntrusiveRef<AtomicObject>(); });
+	run<IntrusiveRef<LocalObject>>("LocalRefCounted", sizeof(LocalObject), []() { return CreateIntrusiveRef<LocalObject>(); });
+}
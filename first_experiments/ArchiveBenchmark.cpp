@@ -0,0 +1,141 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "AssetArchive.h"
+
+// Compares loading assets one file at a time with std::ifstream, as readFile did, against looking them up in a
+// mapped archive. Both paths read every byte once, the way createShaderModule consumes the code. archiveMs includes
+// mapping and unmapping the archive, archiveLookupMs reuses one open archive like the application does.
+// Usage: ArchiveBenchmark <archive> <files...> [--iterations <count>]
+
+using Clock = std::chrono::steady_clock;
+
+static std::vector<char> readFile(const std::string& filename) {
+	std::ifstream file(filename, std::ios::ate | std::ios::binary);
+
+	if (!file.is_open()) {
+		throw std::runtime_error("failed to open file!");
+	}
+
+	size_t fileSize = (size_t) file.tellg();
+	std::vector<char> buffer(fileSize);
+
+	file.seekg(0);
+	file.read(buffer.data(), fileSize);
+	file.close();
+
+	return buffer;
+}
+
+static uint64_t consume(const char* data, size_t size) {
+	uint64_t sum = 0;
+	for (size_t i = 0; i < size; ++i) {
+		sum += static_cast<uint8_t>(data[i]);
+	}
+	return sum;
+}
+
+static void writeSummary(std::ostream& out, const char* name, std::vector<double> samples) {
+	std::sort(samples.begin(), samples.end());
+
+	double sum = 0.0;
+	for (double sample : samples) {
+		sum += sample;
+	}
+
+	out << "\t\"" << name << "\": { "
+		<< "\"avg\": " << sum / samples.size()
+		<< ", \"min\": " << samples.front()
+		<< ", \"p50\": " << samples[samples.size() / 2]
+		<< ", \"p99\": " << samples[std::min(samples.size() - 1, samples.size() * 99 / 100)]
+		<< " }";
+}
+
+int main(int argc, char** argv) {
+	std::string archivePath;
+	std::vector<std::string> files;
+	size_t iterations = 1000;
+
+	for (int i = 1; i < argc; ++i) {
+		if (std::string(argv[i]) == "--iterations" && i + 1 < argc) {
+			iterations = std::max<size_t>(1, std::strtoul(argv[++i], nullptr, 10));
+		}
+		else if (archivePath.empty()) {
+			archivePath = argv[i];
+		}
+		else {
+			files.push_back(argv[i]);
+		}
+	}
+
+	if (archivePath.empty() || files.empty()) {
+		std::cerr << "usage: ArchiveBenchmark <archive> <files...> [--iterations <count>]" << std::endl;
+		return EXIT_FAILURE;
+	}
+
+	try {
+		std::vector<std::string> names;
+		size_t totalBytes = 0;
+		for (const auto& file : files) {
+			names.push_back(std::filesystem::path(file).filename().string());
+			totalBytes += std::filesystem::file_size(file);
+		}
+
+		std::vector<double> streamMs, archiveMs, archiveLookupMs;
+		uint64_t streamSum = 0, archiveSum = 0, lookupSum = 0;
+		AssetArchive openArchive(archivePath);
+
+		for (size_t iteration = 0; iteration < iterations; ++iteration) {
+			auto start = Clock::now();
+			for (const auto& file : files) {
+				auto data = readFile(file);
+				streamSum += consume(data.data(), data.size());
+			}
+			streamMs.push_back(std::chrono::duration<double, std::milli>(Clock::now() - start).count());
+
+			start = Clock::now();
+			{
+				AssetArchive archive(archivePath);
+				for (const auto& name : names) {
+					AssetSpan asset = archive.get(name);
+					archiveSum += consume(asset.data, asset.size);
+				}
+			}
+			archiveMs.push_back(std::chrono::duration<double, std::milli>(Clock::now() - start).count());
+
+			start = Clock::now();
+			for (const auto& name : names) {
+				AssetSpan asset = openArchive.get(name);
+				lookupSum += consume(asset.data, asset.size);
+			}
+			archiveLookupMs.push_back(std::chrono::duration<double, std::milli>(Clock::now() - start).count());
+		}
+
+		if (streamSum != archiveSum || streamSum != lookupSum) {
+			throw std::runtime_error("archive contents differ from the files!");
+		}
+
+		std::cout << "{\n";
+		std::cout << "\t\"assets\": " << files.size() << ",\n";
+		std::cout << "\t\"bytes\": " << totalBytes << ",\n";
+		std::cout << "\t\"iterations\": " << iterations << ",\n";
+		writeSummary(std::cout, "ifstreamMs", streamMs);
+		std::cout << ",\n";
+		writeSummary(std::cout, "archiveMs", archiveMs);
+		std::cout << ",\n";
+		writeSummary(std::cout, "archiveLookupMs", archiveLookupMs);
+		std::cout << "\n}\n";
+	}
+	catch (const std::exception& e) {
+		std::cerr << e.what() << std::endl;
+		return EXIT_FAILURE;
+	}
+
+	return EXIT_SUCCESS;
+}
\ No newline at end of file
@@ -0,0 +1,260 @@
+#pragma once
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// Packed archive, written by AssetPacker and read through a read-only memory mapping. Layout, little endian:
+//   ArchiveHeader
+//   ArchiveEntry[entryCount]
+//   uint32_t buckets[bucketCount]   open addressing hash table of entry indices, EMPTY_BUCKET if unused
+//   names                           concatenated, not null terminated
+//   blobs                           each starting at a multiple of BLOB_ALIGNMENT
+namespace AssetArchiveFormat {
+	const uint32_t MAGIC = 0x4B415057; // "WPAK"
+	const uint32_t VERSION = 1;
+	const uint32_t BLOB_ALIGNMENT = 64;
+	const uint32_t EMPTY_BUCKET = ~0u;
+
+	struct ArchiveHeader {
+		uint32_t magic;
+		uint32_t version;
+		uint32_t entryCount;
+		// Power of two, at least twice the entry count
+		uint32_t bucketCount;
+		uint64_t entriesOffset;
+		uint64_t bucketsOffset;
+		uint64_t namesOffset;
+		uint64_t fileSize;
+	};
+
+	struct ArchiveEntry {
+		uint64_t nameHash;
+		uint64_t offset;
+		uint64_t size;
+		uint32_t nameOffset;
+		uint32_t nameLength;
+	};
+
+	// FNV-1a
+	inline uint64_t hashName(std::string_view name) {
+		uint64_t value = 14695981039346656037ull;
+		for (char c : name) {
+			value = (value ^ static_cast<uint8_t>(c)) * 1099511628211ull;
+		}
+		return value;
+	}
+}
+
+// View into the mapping, valid as long as the archive is open
+struct AssetSpan {
+	const char* data = nullptr;
+	size_t size = 0;
+
+	explicit operator bool() const {
+		return data != nullptr;
+	}
+};
+
+class AssetArchive {
+
+public:
+	AssetArchive() = default;
+
+	explicit AssetArchive(const std::string& path) {
+		open(path);
+	}
+
+	~AssetArchive() {
+		close();
+	}
+
+	AssetArchive(const AssetArchive&) = delete;
+	AssetArchive& operator=(const AssetArchive&) = delete;
+
+	void open(const std::string& path) {
+		close();
+		map(path);
+
+		try {
+			validate();
+		}
+		catch (...) {
+			close();
+			throw;
+		}
+	}
+
+	void close() {
+		if (!mapping) {
+			return;
+		}
+#ifdef _WIN32
+		UnmapViewOfFile(mapping);
+#else
+		munmap(const_cast<char*>(mapping), mappingSize);
+#endif
+		mapping = nullptr;
+		mappingSize = 0;
+	}
+
+	bool isOpen() const {
+		return mapping != nullptr;
+	}
+
+	// Returns an empty span if the archive holds no asset of that name
+	AssetSpan find(std::string_view name) const {
+		using namespace AssetArchiveFormat;
+
+		uint64_t nameHash = hashName(name);
+		uint32_t mask = header().bucketCount - 1;
+
+		// validate makes sure there is an empty bucket, the probe count bounds the loop regardless
+		uint32_t bucket = static_cast<uint32_t>(nameHash) & mask;
+		for (uint32_t probe = 0; probe < header().bucketCount; ++probe, bucket = (bucket + 1) & mask) {
+			uint32_t index = buckets()[bucket];
+			if (index == EMPTY_BUCKET) {
+				return {};
+			}
+
+			const ArchiveEntry& entry = entries()[index];
+			if (entry.nameHash == nameHash && std::string_view(names() + entry.nameOffset, entry.nameLength) == name) {
+				return { mapping + entry.offset, static_cast<size_t>(entry.size) };
+			}
+		}
+		return {};
+	}
+
+	AssetSpan get(std::string_view name) const {
+		AssetSpan asset = find(name);
+		if (!asset) {
+			throw std::runtime_error("asset " + std::string(name) + " not found in archive!");
+		}
+		return asset;
+	}
+
+	uint32_t getAssetCount() const {
+		return header().entryCount;
+	}
+
+private:
+	const char* mapping = nullptr;
+	size_t mappingSize = 0;
+
+	const AssetArchiveFormat::ArchiveHeader& header() const {
+		return *reinterpret_cast<const AssetArchiveFormat::ArchiveHeader*>(mapping);
+	}
+
+	const AssetArchiveFormat::ArchiveEntry* entries() const {
+		return reinterpret_cast<const AssetArchiveFormat::ArchiveEntry*>(mapping + header().entriesOffset);
+	}
+
+	const uint32_t* buckets() const {
+		return reinterpret_cast<const uint32_t*>(mapping + header().bucketsOffset);
+	}
+
+	const char* names() const {
+		return mapping + header().namesOffset;
+	}
+
+	void map(const std::string& path) {
+#ifdef _WIN32
+		HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+		if (file == INVALID_HANDLE_VALUE) {
+			throw std::runtime_error("failed to open asset archive " + path + "!");
+		}
+
+		LARGE_INTEGER size;
+		HANDLE fileMapping = nullptr;
+		if (GetFileSizeEx(file, &size) && size.QuadPart > 0) {
+			fileMapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+		}
+		CloseHandle(file);
+		if (!fileMapping) {
+			throw std::runtime_error("failed to map asset archive " + path + "!");
+		}
+
+		mapping = static_cast<const char*>(MapViewOfFile(fileMapping, FILE_MAP_READ, 0, 0, 0));
+		CloseHandle(fileMapping);
+		mappingSize = static_cast<size_t>(size.QuadPart);
+#else
+		int file = ::open(path.c_str(), O_RDONLY);
+		if (file < 0) {
+			throw std::runtime_error("failed to open asset archive " + path + "!");
+		}
+
+		struct stat status;
+		void* address = MAP_FAILED;
+		if (fstat(file, &status) == 0 && status.st_size > 0) {
+			address = mmap(nullptr, static_cast<size_t>(status.st_size), PROT_READ, MAP_PRIVATE, file, 0);
+		}
+		::close(file);
+		if (address == MAP_FAILED) {
+			throw std::runtime_error("failed to map asset archive " + path + "!");
+		}
+
+		mapping = static_cast<const char*>(address);
+		mappingSize = static_cast<size_t>(status.st_size);
+#endif
+		if (!mapping) {
+			throw std::runtime_error("failed to map asset archive " + path + "!");
+		}
+	}
+
+	// Bounds are checked once here, so lookups never have to
+	void validate() const {
+		using namespace AssetArchiveFormat;
+
+		auto fits = [&](uint64_t offset, uint64_t size) {
+			return offset <= mappingSize && size <= mappingSize - offset;
+		};
+
+		if (mappingSize < sizeof(ArchiveHeader) || header().magic != MAGIC || header().version != VERSION || header().fileSize != mappingSize) {
+			throw std::runtime_error("invalid asset archive!");
+		}
+
+		const ArchiveHeader& archive = header();
+		if (archive.bucketCount == 0 || (archive.bucketCount & (archive.bucketCount - 1)) != 0 || archive.bucketCount <= archive.entryCount ||
+			archive.entriesOffset % alignof(ArchiveEntry) != 0 || archive.bucketsOffset % alignof(uint32_t) != 0 ||
+			!fits(archive.entriesOffset, uint64_t(archive.entryCount) * sizeof(ArchiveEntry)) ||
+			!fits(archive.bucketsOffset, uint64_t(archive.bucketCount) * sizeof(uint32_t)) ||
+			!fits(archive.namesOffset, 0)) {
+			throw std::runtime_error("invalid asset archive!");
+		}
+
+		for (uint32_t i = 0; i < archive.entryCount; ++i) {
+			const ArchiveEntry& entry = entries()[i];
+			if (!fits(entry.offset, entry.size) || entry.offset % BLOB_ALIGNMENT != 0 ||
+				!fits(archive.namesOffset + entry.nameOffset, entry.nameLength)) {
+				throw std::runtime_error("invalid asset archive!");
+			}
+		}
+
+		// Buckets may repeat an entry, so more buckets than entries doesn't guarantee an empty one to end a probe
+		uint32_t emptyBuckets = 0;
+		for (uint32_t i = 0; i < archive.bucketCount; ++i) {
+			if (buckets()[i] == EMPTY_BUCKET) {
+				++emptyBuckets;
+			}
+			else if (buckets()[i] >= archive.entryCount) {
+				throw std::runtime_error("invalid asset archive!");
+			}
+		}
+		if (emptyBuckets == 0) {
+			throw std::runtime_error("invalid asset archive!");
+		}
+	}
+};
\ No newline at end of file
@@ -0,0 +1,137 @@
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "AssetArchive.h"
+
+// Packs files into an archive for AssetArchive, assets are named by their file name.
+// Usage: AssetPacker <archive> <files...>
+
+struct PackedAsset {
+	std::string name;
+	std::vector<char> data;
+};
+
+static std::vector<char> readFile(const std::string& filename) {
+	std::ifstream file(filename, std::ios::ate | std::ios::binary);
+
+	if (!file.is_open()) {
+		throw std::runtime_error("failed to open " + filename + "!");
+	}
+
+	size_t fileSize = (size_t) file.tellg();
+	std::vector<char> buffer(fileSize);
+
+	file.seekg(0);
+	file.read(buffer.data(), fileSize);
+
+	return buffer;
+}
+
+static uint64_t alignOffset(uint64_t offset, uint64_t alignment) {
+	return (offset + alignment - 1) / alignment * alignment;
+}
+
+static void writeArchive(const std::string& path, const std::vector<PackedAsset>& assets) {
+	using namespace AssetArchiveFormat;
+
+	uint32_t bucketCount = 2;
+	while (bucketCount < assets.size() * 2) {
+		bucketCount *= 2;
+	}
+
+	ArchiveHeader header{};
+	header.magic = MAGIC;
+	header.version = VERSION;
+	header.entryCount = static_cast<uint32_t>(assets.size());
+	header.bucketCount = bucketCount;
+	header.entriesOffset = sizeof(ArchiveHeader);
+	header.bucketsOffset = header.entriesOffset + assets.size() * sizeof(ArchiveEntry);
+	header.namesOffset = header.bucketsOffset + bucketCount * sizeof(uint32_t);
+
+	std::vector<ArchiveEntry> entries(assets.size());
+	std::vector<uint32_t> buckets(bucketCount, EMPTY_BUCKET);
+	std::string names;
+
+	for (size_t i = 0; i < assets.size(); ++i) {
+		entries[i].nameHash = hashName(assets[i].name);
+		entries[i].nameOffset = static_cast<uint32_t>(names.size());
+		entries[i].nameLength = static_cast<uint32_t>(assets[i].name.size());
+		names += assets[i].name;
+
+		uint32_t bucket = static_cast<uint32_t>(entries[i].nameHash) & (bucketCount - 1);
+		while (buckets[bucket] != EMPTY_BUCKET) {
+			bucket = (bucket + 1) & (bucketCount - 1);
+		}
+		buckets[bucket] = static_cast<uint32_t>(i);
+	}
+
+	uint64_t offset = header.namesOffset + names.size();
+	for (size_t i = 0; i < assets.size(); ++i) {
+		offset = alignOffset(offset, BLOB_ALIGNMENT);
+		entries[i].offset = offset;
+		entries[i].size = assets[i].data.size();
+		offset += assets[i].data.size();
+	}
+	header.fileSize = offset;
+
+	// Written next to the target and renamed, so a running application never maps a half written archive
+	std::string temporaryPath = path + ".tmp";
+	{
+		std::ofstream file(temporaryPath, std::ios::binary | std::ios::trunc);
+		if (!file.is_open()) {
+			throw std::runtime_error("failed to create " + temporaryPath + "!");
+		}
+
+		file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+		file.write(reinterpret_cast<const char*>(entries.data()), entries.size() * sizeof(ArchiveEntry));
+		file.write(reinterpret_cast<const char*>(buckets.data()), buckets.size() * sizeof(uint32_t));
+		file.write(names.data(), names.size());
+
+		const char padding[BLOB_ALIGNMENT] = {};
+		for (size_t i = 0; i < assets.size(); ++i) {
+			file.write(padding, entries[i].offset - static_cast<uint64_t>(file.tellp()));
+			file.write(assets[i].data.data(), assets[i].data.size());
+		}
+
+		if (!file) {
+			throw std::runtime_error("failed to write " + temporaryPath + "!");
+		}
+	}
+	std::filesystem::rename(temporaryPath, path);
+}
+
+int main(int argc, char** argv) {
+	if (argc < 3) {
+		std::cerr << "usage: AssetPacker <archive> <files...>" << std::endl;
+		return EXIT_FAILURE;
+	}
+
+	try {
+		std::vector<PackedAsset> assets;
+		for (int i = 2; i < argc; ++i) {
+			std::string name = std::filesystem::path(argv[i]).filename().string();
+			for (const auto& asset : assets) {
+				if (asset.name == name) {
+					throw std::runtime_error("duplicate asset name " + name + "!");
+				}
+			}
+			assets.push_back({ name, readFile(argv[i]) });
+		}
+
+		writeArchive(argv[1], assets);
+
+		// Opening it again validates what was just written
+		AssetArchive archive(argv[1]);
+		std::cout << "packed " << archive.getAssetCount() << " assets into " << argv[1] << std::endl;
+	}
+	catch (const std::exception& e) {
+		std::cerr << e.what() << std::endl;
+		return EXIT_FAILURE;
+	}
+
+	return EXIT_SUCCESS;
+}
\ No newline at end of file
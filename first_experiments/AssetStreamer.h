@@ -0,0 +1,918 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include "WorkerPool.h"
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <Windows.h>
+#else
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#if defined(__linux__) && __has_include(<linux/io_uring.h>)
+#define ASSET_STREAMER_IO_URING
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#endif
+
+enum class AssetPriority {
+	High,
+	Normal,
+	Low
+};
+
+const uint32_t ASSET_PRIORITY_COUNT = 3;
+
+enum class AssetStatus {
+	Loaded,
+	Failed,
+	Cancelled
+};
+
+struct LoadedAsset {
+	uint64_t id = 0;
+	std::string path;
+	AssetStatus status = AssetStatus::Loaded;
+	std::vector<char> data;
+	// errno, or GetLastError on Windows, if the load failed
+	int error = 0;
+};
+
+#ifdef ASSET_STREAMER_IO_URING
+// Minimal io_uring through the raw system calls, only what the streamer needs: one thread fills the submission queue
+// and reaps the completion queue. Both rings and the submission entries are shared with the kernel through mmap.
+class IoUringQueue {
+
+public:
+	IoUringQueue() = default;
+
+	~IoUringQueue() {
+		destroy();
+	}
+
+	IoUringQueue(const IoUringQueue&) = delete;
+	IoUringQueue& operator=(const IoUringQueue&) = delete;
+
+	// Returns false if the kernel does not support io_uring or does not allow it, e.g. inside a sandbox
+	bool init(uint32_t entries) {
+		destroy();
+
+		io_uring_params params = {};
+		int result = static_cast<int>(syscall(__NR_io_uring_setup, entries, &params));
+		if (result < 0) {
+			return false;
+		}
+		ring = result;
+
+		sqRingSize = params.sq_off.array + params.sq_entries * sizeof(uint32_t);
+		cqRingSize = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+		bool singleMapping = params.features & IORING_FEAT_SINGLE_MMAP;
+		if (singleMapping) {
+			sqRingSize = cqRingSize = std::max(sqRingSize, cqRingSize);
+		}
+
+		sqRing = mmap(nullptr, sqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring, IORING_OFF_SQ_RING);
+		if (sqRing == MAP_FAILED) {
+			sqRing = nullptr;
+			destroy();
+			return false;
+		}
+		if (singleMapping) {
+			cqRing = sqRing;
+		}
+		else {
+			cqRing = mmap(nullptr, cqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring, IORING_OFF_CQ_RING);
+			if (cqRing == MAP_FAILED) {
+				cqRing = nullptr;
+				destroy();
+				return false;
+			}
+		}
+
+		sqeSize = params.sq_entries * sizeof(io_uring_sqe);
+		void* mappedSqes = mmap(nullptr, sqeSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring, IORING_OFF_SQES);
+		if (mappedSqes == MAP_FAILED) {
+			destroy();
+			return false;
+		}
+		sqes = static_cast<io_uring_sqe*>(mappedSqes);
+
+		char* sq = static_cast<char*>(sqRing);
+		sqHead = reinterpret_cast<uint32_t*>(sq + params.sq_off.head);
+		sqTail = reinterpret_cast<uint32_t*>(sq + params.sq_off.tail);
+		sqMask = *reinterpret_cast<uint32_t*>(sq + params.sq_off.ring_mask);
+		sqArray = reinterpret_cast<uint32_t*>(sq + params.sq_off.array);
+		sqEntries = params.sq_entries;
+
+		char* cq = static_cast<char*>(cqRing);
+		cqHead = reinterpret_cast<uint32_t*>(cq + params.cq_off.head);
+		cqTail = reinterpret_cast<uint32_t*>(cq + params.cq_off.tail);
+		cqMask = *reinterpret_cast<uint32_t*>(cq + params.cq_off.ring_mask);
+		cqes = reinterpret_cast<io_uring_cqe*>(cq + params.cq_off.cqes);
+
+		queuedCount = 0;
+		return true;
+	}
+
+	void destroy() {
+		if (sqes) {
+			munmap(sqes, sqeSize);
+			sqes = nullptr;
+		}
+		if (cqRing && cqRing != sqRing) {
+			munmap(cqRing, cqRingSize);
+		}
+		cqRing = nullptr;
+		if (sqRing) {
+			munmap(sqRing, sqRingSize);
+			sqRing = nullptr;
+		}
+		if (ring >= 0) {
+			close(ring);
+			ring = -1;
+		}
+	}
+
+	// Queues a read into one buffer, submitted by the next submitAndWait. Returns false if the submission queue is full.
+	bool queueRead(int file, const iovec* buffer, uint64_t offset, uint64_t userData) {
+		uint32_t tail = *sqTail;
+		if (tail - __atomic_load_n(sqHead, __ATOMIC_ACQUIRE) >= sqEntries) {
+			return false;
+		}
+
+		uint32_t index = tail & sqMask;
+		io_uring_sqe& sqe = sqes[index];
+		std::memset(&sqe, 0, sizeof(sqe));
+		// READV rather than READ, which needs Linux 5.6
+		sqe.opcode = IORING_OP_READV;
+		sqe.fd = file;
+		sqe.addr = reinterpret_cast<uint64_t>(buffer);
+		sqe.len = 1;
+		sqe.off = offset;
+		sqe.user_data = userData;
+		sqArray[index] = index;
+
+		__atomic_store_n(sqTail, tail + 1, __ATOMIC_RELEASE);
+		++queuedCount;
+		return true;
+	}
+
+	// Submits the queued reads and blocks until at least waitCount of all reads in flight have completed.
+	// Returns a negative errno if the kernel refused the submission.
+	int submitAndWait(uint32_t waitCount) {
+		while (true) {
+			int result = static_cast<int>(syscall(__NR_io_uring_enter, ring, queuedCount, waitCount, waitCount > 0 ? IORING_ENTER_GETEVENTS : 0, nullptr, 0));
+			if (result >= 0) {
+				queuedCount -= std::min<uint32_t>(queuedCount, static_cast<uint32_t>(result));
+				++enterCount;
+				return 0;
+			}
+			if (errno != EINTR) {
+				return -errno;
+			}
+		}
+	}
+
+	// Takes back the reads queued since the last submission, calling function(userData) for each
+	template<class Function>
+	void discardQueued(const Function& function) {
+		uint32_t tail = *sqTail;
+		for (uint32_t i = tail - queuedCount; i != tail; ++i) {
+			function(sqes[sqArray[i & sqMask]].user_data);
+		}
+		__atomic_store_n(sqTail, tail - queuedCount, __ATOMIC_RELEASE);
+		queuedCount = 0;
+	}
+
+	// Calls function(userData, result) for every completion, result is the byte count or a negative errno
+	template<class Function>
+	uint32_t reapCompletions(const Function& function) {
+		uint32_t head = *cqHead;
+		uint32_t tail = __atomic_load_n(cqTail, __ATOMIC_ACQUIRE);
+		uint32_t count = tail - head;
+
+		for (; head != tail; ++head) {
+			const io_uring_cqe& cqe = cqes[head & cqMask];
+			function(cqe.user_data, cqe.res);
+		}
+		__atomic_store_n(cqHead, head, __ATOMIC_RELEASE);
+		return count;
+	}
+
+	uint64_t getEnterCount() const {
+		return enterCount;
+	}
+
+private:
+	int ring = -1;
+	void* sqRing = nullptr;
+	void* cqRing = nullptr;
+	size_t sqRingSize = 0;
+	size_t cqRingSize = 0;
+	size_t sqeSize = 0;
+
+	io_uring_sqe* sqes = nullptr;
+	uint32_t* sqHead = nullptr;
+	uint32_t* sqTail = nullptr;
+	uint32_t* sqArray = nullptr;
+	uint32_t sqMask = 0;
+	uint32_t sqEntries = 0;
+
+	io_uring_cqe* cqes = nullptr;
+	uint32_t* cqHead = nullptr;
+	uint32_t* cqTail = nullptr;
+	uint32_t cqMask = 0;
+
+	uint32_t queuedCount = 0;
+	uint64_t enterCount = 0;
+};
+#endif
+
+// Loads whole files in the background. Requests wait in one queue per priority and are read through io_uring on Linux,
+// batched up to the queue depth, or with blocking reads elsewhere and when io_uring is unavailable. The reads run as
+// tasks on the worker pool that only hold a thread while there is something to read: one task submitting and reaping
+// the io_uring reads, or up to threadCount tasks with one blocking read in flight each. Finished loads are handed back
+// on the thread calling dispatchCompletions, normally the main thread once per frame. The bytes of loads that were
+// started but not yet dispatched are kept under a memory budget, a request that does not fit waits in the queue until
+// completions have been dispatched. A single file larger than the budget is still loaded, but only once nothing else is
+// in flight.
+class AssetStreamer {
+
+public:
+	using Callback = std::function<void(LoadedAsset& asset)>;
+
+	enum class Backend {
+		None,
+		ThreadPool,
+		IoUring
+	};
+
+	struct Settings {
+		uint64_t memoryBudget = 64ull << 20;
+		// Reads in flight at once with io_uring
+		uint32_t queueDepth = 64;
+		// Tasks of the fallback, each holds a thread of the worker pool with one blocking read in flight
+		uint32_t threadCount = 4;
+		bool allowIoUring = true;
+	};
+
+	struct Statistics {
+		uint64_t requestCount = 0;
+		uint64_t loadedCount = 0;
+		uint64_t failedCount = 0;
+		uint64_t cancelledCount = 0;
+		uint64_t loadedBytes = 0;
+		// Most bytes started but not yet dispatched at once
+		uint64_t peakInFlightBytes = 0;
+		// Times a request had to wait for the memory budget
+		uint64_t budgetWaitCount = 0;
+		// io_uring_enter calls, each submits a batch of reads
+		uint64_t submitCount = 0;
+	};
+
+	AssetStreamer() = default;
+
+	~AssetStreamer() {
+		shutdown();
+	}
+
+	AssetStreamer(const AssetStreamer&) = delete;
+	AssetStreamer& operator=(const AssetStreamer&) = delete;
+
+	// The pool has to outlive the streamer. Without workers in the pool the reads run on the thread calling load.
+	void init(const Settings& newSettings, WorkerPool& workers) {
+		shutdown();
+
+		settings = newSettings;
+		settings.queueDepth = std::max(settings.queueDepth, 1u);
+		settings.threadCount = std::max(settings.threadCount, 1u);
+		this->workers = &workers;
+		statistics = {};
+		running = true;
+
+		backend = Backend::ThreadPool;
+#ifdef ASSET_STREAMER_IO_URING
+		if (settings.allowIoUring && ioUring.init(settings.queueDepth)) {
+			backend = Backend::IoUring;
+		}
+#endif
+	}
+
+	// Waits for the reads in flight and drops every request that was not dispatched, without calling its callback
+	void shutdown() {
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			running = false;
+			// Tasks finish the reads they have in flight and return, tasks still queued on the pool return right away
+			tasksFinished.wait(lock, [this] { return taskCount == 0; });
+		}
+
+#ifdef ASSET_STREAMER_IO_URING
+		ioUring.destroy();
+#endif
+		for (auto& queue : queues) {
+			queue.clear();
+		}
+		for (auto& [id, request] : requests) {
+			closeFile(*request);
+		}
+		requests.clear();
+		completed.clear();
+		inFlightBytes = 0;
+		backend = Backend::None;
+	}
+
+	// Returns the id to cancel the request with. The callback runs inside dispatchCompletions, also for failed and
+	// cancelled loads, and may move the data out of the asset.
+	uint64_t load(const std::string& path, AssetPriority priority, Callback callback) {
+		auto request = std::make_unique<Request>();
+		request->priority = priority;
+		request->callback = std::move(callback);
+		request->asset.path = path;
+
+		uint64_t id;
+		uint32_t taskCount;
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			if (!running) {
+				throw std::runtime_error("asset streamer is not initialized!");
+			}
+			id = request->asset.id = ++lastId;
+			queues[static_cast<uint32_t>(priority)].push_back(request.get());
+			requests.emplace(id, std::move(request));
+			++statistics.requestCount;
+			taskCount = reserveTasks();
+		}
+		submitTasks(taskCount);
+		return id;
+	}
+
+	// The future is fulfilled by dispatchCompletions as well, so it must not be waited on by the dispatching thread
+	std::future<LoadedAsset> loadFuture(const std::string& path, AssetPriority priority, uint64_t* id = nullptr) {
+		auto promise = std::make_shared<std::promise<LoadedAsset>>();
+		std::future<LoadedAsset> future = promise->get_future();
+
+		uint64_t requestId = load(path, priority, [promise](LoadedAsset& asset) {
+			promise->set_value(std::move(asset));
+		});
+		if (id) {
+			*id = requestId;
+		}
+		return future;
+	}
+
+	// Requests still in the queue, also those waiting for the budget, are dropped right away, reads in flight are
+	// finished and their data freed.
+	// Either way the load is reported as cancelled by the next dispatchCompletions. Returns false for unknown ids
+	// and loads that already completed.
+	bool cancel(uint64_t id) {
+		std::lock_guard<std::mutex> lock(mutex);
+		auto found = requests.find(id);
+		if (found == requests.end() || found->second->finished) {
+			return false;
+		}
+
+		Request* request = found->second.get();
+		request->cancelled = true;
+
+		auto& queue = queues[static_cast<uint32_t>(request->priority)];
+		auto queued = std::find(queue.begin(), queue.end(), request);
+		if (queued != queue.end()) {
+			queue.erase(queued);
+			finish(*request, AssetStatus::Cancelled, 0);
+		}
+		return true;
+	}
+
+	// Runs the callbacks of up to maxCount finished loads in completion order and releases their budget. Returns the
+	// number of callbacks run.
+	uint32_t dispatchCompletions(uint32_t maxCount = ~0u) {
+		std::vector<Request*> batch;
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			size_t count = std::min<size_t>(maxCount, completed.size());
+			batch.assign(completed.begin(), completed.begin() + count);
+			completed.erase(completed.begin(), completed.begin() + count);
+		}
+		if (batch.empty()) {
+			return 0;
+		}
+
+		for (Request* request : batch) {
+			if (request->callback) {
+				request->callback(request->asset);
+			}
+		}
+
+		uint32_t taskCount;
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			for (Request* request : batch) {
+				inFlightBytes -= request->reservedBytes;
+				requests.erase(request->asset.id);
+			}
+			// The budget they held may let waiting requests start
+			taskCount = reserveTasks();
+		}
+		submitTasks(taskCount);
+		return static_cast<uint32_t>(batch.size());
+	}
+
+	// Requests whose callback has not run yet
+	size_t getPendingCount() const {
+		std::lock_guard<std::mutex> lock(mutex);
+		return requests.size();
+	}
+
+	uint64_t getInFlightBytes() const {
+		std::lock_guard<std::mutex> lock(mutex);
+		return inFlightBytes;
+	}
+
+	Statistics getStatistics() const {
+		std::lock_guard<std::mutex> lock(mutex);
+		Statistics result = statistics;
+#ifdef ASSET_STREAMER_IO_URING
+		result.submitCount = submitCount;
+#endif
+		return result;
+	}
+
+	Backend getBackend() const {
+		return backend;
+	}
+
+	const char* getBackendName() const {
+		switch (backend) {
+		case Backend::ThreadPool: return "thread pool";
+		case Backend::IoUring: return "io_uring";
+		default: return "none";
+		}
+	}
+
+private:
+	struct Request {
+		LoadedAsset asset;
+		AssetPriority priority = AssetPriority::Normal;
+		Callback callback;
+		std::atomic<bool> cancelled{ false };
+		// Set under the mutex once the request is in the completed list
+		bool finished = false;
+		// Counted as a budget wait once, however often it is put back
+		bool waitedForBudget = false;
+		uint64_t reservedBytes = 0;
+
+		// Read state, only touched by the thread loading the request
+#ifdef _WIN32
+		HANDLE file = INVALID_HANDLE_VALUE;
+#else
+		int file = -1;
+#endif
+		uint64_t size = 0;
+		uint64_t offset = 0;
+#ifdef ASSET_STREAMER_IO_URING
+		iovec buffer = {};
+#endif
+	};
+
+	Settings settings;
+	// Only changes from io_uring to the thread pool while running, if io_uring fails
+	std::atomic<Backend> backend{ Backend::None };
+	WorkerPool* workers = nullptr;
+
+	mutable std::mutex mutex;
+	std::condition_variable tasksFinished;
+	bool running = false;
+	// Submitted to the pool and not returned yet
+	uint32_t taskCount = 0;
+	uint64_t lastId = 0;
+	std::deque<Request*> queues[ASSET_PRIORITY_COUNT];
+	// Owns every request until its callback has run
+	std::unordered_map<uint64_t, std::unique_ptr<Request>> requests;
+	std::vector<Request*> completed;
+	uint64_t inFlightBytes = 0;
+	Statistics statistics;
+
+#ifdef ASSET_STREAMER_IO_URING
+	IoUringQueue ioUring;
+	// Written by the io_uring task, read under the mutex
+	std::atomic<uint64_t> submitCount{ 0 };
+#endif
+
+	size_t getQueuedCount() const {
+		size_t count = 0;
+		for (const auto& queue : queues) {
+			count += queue.size();
+		}
+		return count;
+	}
+
+	Request* popRequest() {
+		for (auto& queue : queues) {
+			if (!queue.empty()) {
+				Request* request = queue.front();
+				queue.pop_front();
+				return request;
+			}
+		}
+		return nullptr;
+	}
+
+	// Needs the mutex
+	bool fitsBudget(const Request& request) const {
+		return inFlightBytes == 0 || inFlightBytes + request.size <= settings.memoryBudget;
+	}
+
+	// Needs the mutex
+	void reserve(Request& request) {
+		request.reservedBytes = request.size;
+		inFlightBytes += request.size;
+		statistics.peakInFlightBytes = std::max(statistics.peakInFlightBytes, inFlightBytes);
+	}
+
+	// Needs the mutex. Failed and cancelled loads give their budget back right away.
+	void finish(Request& request, AssetStatus status, int error) {
+		closeFile(request);
+
+		if (status == AssetStatus::Loaded && request.cancelled) {
+			status = AssetStatus::Cancelled;
+		}
+		request.asset.status = status;
+		request.asset.error = error;
+		if (status != AssetStatus::Loaded) {
+			request.asset.data = {};
+			inFlightBytes -= request.reservedBytes;
+			request.reservedBytes = 0;
+		}
+
+		switch (status) {
+		case AssetStatus::Loaded:
+			++statistics.loadedCount;
+			statistics.loadedBytes += request.size;
+			break;
+		case AssetStatus::Failed:
+			++statistics.failedCount;
+			break;
+		case AssetStatus::Cancelled:
+			++statistics.cancelledCount;
+			break;
+		}
+
+		request.finished = true;
+		completed.push_back(&request);
+	}
+
+	// Needs the mutex. Counts one task per queued request as started, up to the tasks the backend may have running at
+	// once, and returns how many submitTasks has to submit.
+	uint32_t reserveTasks() {
+		if (!running) {
+			return 0;
+		}
+		uint32_t maxTasks = backend == Backend::IoUring ? 1 : settings.threadCount;
+		uint32_t count = static_cast<uint32_t>(std::min<size_t>(maxTasks - taskCount, getQueuedCount()));
+		taskCount += count;
+		return count;
+	}
+
+	// Outside of the lock, a pool without workers runs the tasks right here
+	void submitTasks(uint32_t count) {
+		for (uint32_t i = 0; i < count; ++i) {
+#ifdef ASSET_STREAMER_IO_URING
+			if (backend == Backend::IoUring) {
+				workers->submit([this] { ioUringTask(); });
+				continue;
+			}
+#endif
+			workers->submit([this] { readTask(); });
+		}
+	}
+
+	// Needs the mutex, the tasks call it last
+	void finishTask() {
+		--taskCount;
+		tasksFinished.notify_all();
+	}
+
+	// Opens the request and reserves its budget. Returns nullptr if the request was finished right here, because it
+	// failed to open or was cancelled, and if it does not fit the budget yet. Then it goes back to the front of its
+	// queue, waiting for completions to be dispatched, which is what starts the tasks again.
+	Request* startRequest(std::unique_lock<std::mutex>& lock, Request* request) {
+		if (!isOpen(*request)) {
+			lock.unlock();
+			int error = openFile(*request);
+			lock.lock();
+			if (error != 0) {
+				finish(*request, AssetStatus::Failed, error);
+				return nullptr;
+			}
+		}
+
+		if (!running || request->cancelled) {
+			finish(*request, AssetStatus::Cancelled, 0);
+			return nullptr;
+		}
+
+		if (!fitsBudget(*request)) {
+			if (!request->waitedForBudget) {
+				request->waitedForBudget = true;
+				++statistics.budgetWaitCount;
+			}
+			queues[static_cast<uint32_t>(request->priority)].push_front(request);
+			return nullptr;
+		}
+
+		reserve(*request);
+		return request;
+	}
+
+	// Blocking reads until the queue is empty or its next request has to wait for the budget
+	void readTask() {
+		std::unique_lock<std::mutex> lock(mutex);
+
+		while (running && getQueuedCount() > 0) {
+			Request* next = popRequest();
+			Request* request = startRequest(lock, next);
+			if (!request) {
+				if (!next->finished) {
+					break;
+				}
+				continue;
+			}
+
+			lock.unlock();
+			int error = readFile(*request);
+			lock.lock();
+			finish(*request, error == 0 ? AssetStatus::Loaded : AssetStatus::Failed, error);
+		}
+
+		finishTask();
+	}
+
+#ifdef ASSET_STREAMER_IO_URING
+	// Submits and reaps the reads until nothing is queued or in flight. A read that finds the submission queue full
+	// waits in waiting until reaping made room. If the kernel refuses a submission, the reads the task holds fail with
+	// its error and the streamer falls back to blocking reads for everything after them.
+	void ioUringTask() {
+		uint32_t inFlight = 0;
+		std::vector<Request*> starting;
+		std::deque<Request*> waiting;
+
+		while (true) {
+			{
+				std::unique_lock<std::mutex> lock(mutex);
+				while (running && inFlight + starting.size() < settings.queueDepth && getQueuedCount() > 0) {
+					Request* next = popRequest();
+					Request* request = startRequest(lock, next);
+					if (request) {
+						starting.push_back(request);
+					}
+					else if (!next->finished) {
+						// Waits for the budget, the reads in flight are reaped first
+						break;
+					}
+				}
+
+				if (inFlight == 0 && starting.empty()) {
+					finishTask();
+					return;
+				}
+			}
+
+			// Buffers are allocated outside of the lock, so load calls on the main thread never wait for them
+			for (Request* request : starting) {
+				request->asset.data.resize(static_cast<size_t>(request->size));
+				if (request->size == 0) {
+					completeIoUringRead(request, 0, inFlight, waiting);
+				}
+				else {
+					queueIoUringRead(*request, waiting);
+					++inFlight;
+				}
+			}
+			starting.clear();
+
+			if (inFlight == 0) {
+				continue;
+			}
+
+			// Busy means the completion queue is full, which reaping takes care of
+			int error = ioUring.submitAndWait(1);
+			if (error != 0 && error != -EAGAIN && error != -EBUSY) {
+				failIoUring(-error, inFlight, waiting);
+				return;
+			}
+			submitCount = ioUring.getEnterCount();
+
+			ioUring.reapCompletions([&](uint64_t userData, int result) {
+				completeIoUringRead(reinterpret_cast<Request*>(userData), result, inFlight, waiting);
+			});
+			while (!waiting.empty() && queueIoUringRead(*waiting.front(), waiting)) {
+				waiting.pop_front();
+			}
+		}
+	}
+
+	// Returns false if the request has to wait in waiting, behind the ones already there, for the submission queue to
+	// have room. The front of waiting is taken out by the caller once it returns true for it.
+	bool queueIoUringRead(Request& request, std::deque<Request*>& waiting) {
+		bool retry = !waiting.empty() && waiting.front() == &request;
+		if (!waiting.empty() && !retry) {
+			waiting.push_back(&request);
+			return false;
+		}
+
+		request.buffer.iov_base = request.asset.data.data() + request.offset;
+		request.buffer.iov_len = static_cast<size_t>(request.size - request.offset);
+		if (!ioUring.queueRead(request.file, &request.buffer, request.offset, reinterpret_cast<uint64_t>(&request))) {
+			if (!retry) {
+				waiting.push_back(&request);
+			}
+			return false;
+		}
+		return true;
+	}
+
+	void completeIoUringRead(Request* request, int result, uint32_t& inFlight, std::deque<Request*>& waiting) {
+		if (result == -EINTR || result == -EAGAIN) {
+			queueIoUringRead(*request, waiting);
+			return;
+		}
+		if (result > 0) {
+			request->offset += static_cast<uint64_t>(result);
+			if (request->offset < request->size) {
+				// Short read, the rest is read by the next submission
+				queueIoUringRead(*request, waiting);
+				return;
+			}
+		}
+
+		if (request->size > 0) {
+			--inFlight;
+		}
+
+		std::lock_guard<std::mutex> lock(mutex);
+		if (result < 0) {
+			finish(*request, AssetStatus::Failed, -result);
+		}
+		else if (request->offset < request->size) {
+			// The file shrank while it was read
+			finish(*request, AssetStatus::Failed, EIO);
+		}
+		else {
+			finish(*request, AssetStatus::Loaded, 0);
+		}
+	}
+
+	// The reads still in the submission queue or waiting for it never reached the kernel and fail right away, those the
+	// kernel has are waited for, as it writes into their buffers, and fail unless they completed. The queued requests
+	// are then left to blocking read tasks.
+	void failIoUring(int error, uint32_t& inFlight, std::deque<Request*>& waiting) {
+		ioUring.discardQueued([&](uint64_t userData) {
+			waiting.push_back(reinterpret_cast<Request*>(userData));
+		});
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			for (Request* request : waiting) {
+				finish(*request, AssetStatus::Failed, error);
+			}
+		}
+		inFlight -= static_cast<uint32_t>(waiting.size());
+		waiting.clear();
+
+		while (inFlight > 0) {
+			uint32_t reaped = ioUring.reapCompletions([&](uint64_t userData, int result) {
+				Request* request = reinterpret_cast<Request*>(userData);
+				if (result > 0) {
+					request->offset += static_cast<uint64_t>(result);
+				}
+				--inFlight;
+
+				std::lock_guard<std::mutex> lock(mutex);
+				if (request->offset == request->size) {
+					finish(*request, AssetStatus::Loaded, 0);
+				}
+				else {
+					finish(*request, AssetStatus::Failed, result < 0 && result != -EINTR && result != -EAGAIN ? -result : error);
+				}
+			});
+			if (reaped == 0 && inFlight > 0 && ioUring.submitAndWait(1) != 0) {
+				std::this_thread::yield();
+			}
+		}
+
+		uint32_t taskCount;
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			backend = Backend::ThreadPool;
+			finishTask();
+			taskCount = reserveTasks();
+		}
+		submitTasks(taskCount);
+	}
+#endif
+
+	static bool isOpen(const Request& request) {
+#ifdef _WIN32
+		return request.file != INVALID_HANDLE_VALUE;
+#else
+		return request.file >= 0;
+#endif
+	}
+
+	// Opens the file and reads its size, returns 0 or the error code
+	static int openFile(Request& request) {
+#ifdef _WIN32
+		request.file = CreateFileA(request.asset.path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+		if (request.file == INVALID_HANDLE_VALUE) {
+			return static_cast<int>(GetLastError());
+		}
+
+		LARGE_INTEGER size;
+		if (!GetFileSizeEx(request.file, &size)) {
+			int error = static_cast<int>(GetLastError());
+			closeFile(request);
+			return error;
+		}
+		request.size = static_cast<uint64_t>(size.QuadPart);
+#else
+		request.file = ::open(request.asset.path.c_str(), O_RDONLY | O_CLOEXEC);
+		if (request.file < 0) {
+			return errno;
+		}
+
+		struct stat status;
+		if (fstat(request.file, &status) != 0) {
+			int error = errno;
+			closeFile(request);
+			return error;
+		}
+		request.size = static_cast<uint64_t>(status.st_size);
+#endif
+		return 0;
+	}
+
+	static void closeFile(Request& request) {
+#ifdef _WIN32
+		if (request.file != INVALID_HANDLE_VALUE) {
+			CloseHandle(request.file);
+			request.file = INVALID_HANDLE_VALUE;
+		}
+#else
+		if (request.file >= 0) {
+			::close(request.file);
+			request.file = -1;
+		}
+#endif
+	}
+
+	// Blocking read of the whole file, returns 0 or the error code
+	static int readFile(Request& request) {
+		request.asset.data.resize(static_cast<size_t>(request.size));
+		char* data = request.asset.data.data();
+
+		while (request.offset < request.size) {
+#ifdef _WIN32
+			DWORD chunk = static_cast<DWORD>(std::min<uint64_t>(request.size - request.offset, 1u << 30));
+			DWORD read = 0;
+			if (!ReadFile(request.file, data + request.offset, chunk, &read, nullptr)) {
+				return static_cast<int>(GetLastError());
+			}
+#else
+			ssize_t read = pread(request.file, data + request.offset, static_cast<size_t>(request.size - request.offset), static_cast<off_t>(request.offset));
+			if (read < 0) {
+				if (errno == EINTR) {
+					continue;
+				}
+				return errno;
+			}
+#endif
+			if (read == 0) {
+				// The file shrank while it was read
+				return EIO;
+			}
+			request.offset += static_cast<uint64_t>(read);
+		}
+		return 0;
+	}
+};
\ No newline at end of file
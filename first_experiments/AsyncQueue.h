@@ -0,0 +1,174 @@
+#pragma once
+#include <vulkan/vulkan.hpp>
+
+#include <chrono>
+#include <limits>
+#include <stdexcept>
+#include <vector>
+
+// A queue of a family without graphics, a compute only or transfer only one, that runs work next to the frames.
+// Every submission signals the next value of the queue's own timeline semaphore, which the graphics queue waits on
+// through FrameSync::addWait. Like the frames, submissions cycle through slots with one command pool each, begin
+// blocks until the last submission of the slot has completed.
+//
+// Buffers are created exclusive, so what one family wrote has to be released by it and acquired by the other before
+// the other reads it, with releaseBuffer and acquireBuffer recorded on either queue. Contents that are overwritten
+// anyway need no transfer, only the semaphore wait.
+class AsyncQueue {
+
+public:
+	struct Statistics {
+		uint64_t submitCount = 0;
+		// Buffers released to another family
+		uint64_t ownershipTransferCount = 0;
+		// Time begin blocked waiting for a slot
+		double stallMs = 0.0;
+	};
+
+	AsyncQueue() = default;
+
+	AsyncQueue(const AsyncQueue&) = delete;
+	AsyncQueue& operator=(const AsyncQueue&) = delete;
+
+	void init(vk::Device device, vk::Queue queue, uint32_t family, uint32_t slotCount) {
+		this->device = device;
+		this->queue = queue;
+		this->family = family;
+		submitValue = 0;
+		statistics = {};
+
+		vk::SemaphoreTypeCreateInfo typeInfo{};
+		typeInfo.semaphoreType = vk::SemaphoreType::eTimeline;
+		typeInfo.initialValue = 0;
+
+		vk::SemaphoreCreateInfo timelineInfo{};
+		timelineInfo.pNext = &typeInfo;
+
+		slots.clear();
+		slots.resize(slotCount);
+		try {
+			timeline = device.createSemaphoreUnique(timelineInfo);
+			for (Slot& slot : slots) {
+				slot.pool = device.createCommandPoolUnique(vk::CommandPoolCreateInfo(vk::CommandPoolCreateFlagBits::eTransient, family));
+				slot.commandBuffer = device.allocateCommandBuffers(vk::CommandBufferAllocateInfo(*slot.pool, vk::CommandBufferLevel::ePrimary, 1))[0];
+			}
+		}
+		catch (vk::SystemError err) {
+			throw std::runtime_error("failed to create async queue!");
+		}
+	}
+
+	bool isValid() const {
+		return bool(queue);
+	}
+
+	// Waits until the next slot is free and begins its command buffer
+	vk::CommandBuffer begin() {
+		Slot& slot = slots[submitValue % slots.size()];
+		wait(slot.value);
+		device.resetCommandPool(*slot.pool, vk::CommandPoolResetFlags());
+		slot.commandBuffer.begin(vk::CommandBufferBeginInfo(vk::CommandBufferUsageFlagBits::eOneTimeSubmit));
+		return slot.commandBuffer;
+	}
+
+	// Ends and submits the command buffer of the last begin, after the wait value of another queue's timeline
+	// semaphore is reached at waitStage, if one is given. Returns the value signalled once it has completed.
+	uint64_t submit(vk::Semaphore waitSemaphore = {}, uint64_t waitValue = 0, vk::PipelineStageFlags waitStage = vk::PipelineStageFlagBits::eAllCommands) {
+		Slot& slot = slots[submitValue % slots.size()];
+		slot.commandBuffer.end();
+		slot.value = ++submitValue;
+
+		bool waiting = bool(waitSemaphore) && waitValue > 0;
+		vk::TimelineSemaphoreSubmitInfo timelineInfo{};
+		timelineInfo.waitSemaphoreValueCount = waiting ? 1 : 0;
+		timelineInfo.pWaitSemaphoreValues = &waitValue;
+		timelineInfo.signalSemaphoreValueCount = 1;
+		timelineInfo.pSignalSemaphoreValues = &slot.value;
+
+		vk::SubmitInfo submitInfo{};
+		submitInfo.pNext = &timelineInfo;
+		submitInfo.waitSemaphoreCount = waiting ? 1 : 0;
+		submitInfo.pWaitSemaphores = &waitSemaphore;
+		submitInfo.pWaitDstStageMask = &waitStage;
+		submitInfo.commandBufferCount = 1;
+		submitInfo.pCommandBuffers = &slot.commandBuffer;
+		submitInfo.signalSemaphoreCount = 1;
+		submitInfo.pSignalSemaphores = &*timeline;
+
+		try {
+			queue.submit(submitInfo, nullptr);
+		}
+		catch (vk::SystemError err) {
+			throw std::runtime_error("failed to submit async command buffer!");
+		}
+		++statistics.submitCount;
+		return slot.value;
+	}
+
+	// Blocks until the submission that signals value has completed
+	void wait(uint64_t value) {
+		if (value == 0 || device.getSemaphoreCounterValue(*timeline) >= value) {
+			return;
+		}
+
+		vk::SemaphoreWaitInfo waitInfo{};
+		waitInfo.semaphoreCount = 1;
+		waitInfo.pSemaphores = &*timeline;
+		waitInfo.pValues = &value;
+
+		auto waitStart = std::chrono::steady_clock::now();
+		if (device.waitSemaphores(waitInfo, std::numeric_limits<uint64_t>::max()) != vk::Result::eSuccess) {
+			throw std::runtime_error("failed to wait for async queue!");
+		}
+		statistics.stallMs += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - waitStart).count();
+	}
+
+	// Gives up ownership of a buffer written on this queue to dstFamily, recorded after the writes. Its submission has
+	// to be waited on by the one acquiring the buffer.
+	void releaseBuffer(vk::CommandBuffer commandBuffer, vk::Buffer buffer, uint32_t dstFamily, vk::PipelineStageFlags srcStage, vk::AccessFlags srcAccess) {
+		// The destination access is ignored on release
+		vk::BufferMemoryBarrier barrier(srcAccess, vk::AccessFlags(), family, dstFamily, buffer, 0, VK_WHOLE_SIZE);
+		commandBuffer.pipelineBarrier(srcStage, vk::PipelineStageFlagBits::eBottomOfPipe, vk::DependencyFlags(), nullptr, barrier, nullptr);
+		++statistics.ownershipTransferCount;
+	}
+
+	// The other half of releaseBuffer, recorded on the queue of dstFamily before the reads
+	static void acquireBuffer(vk::CommandBuffer commandBuffer, vk::Buffer buffer, uint32_t srcFamily, uint32_t dstFamily, vk::PipelineStageFlags dstStage, vk::AccessFlags dstAccess) {
+		// The source access is ignored on acquire
+		vk::BufferMemoryBarrier barrier(vk::AccessFlags(), dstAccess, srcFamily, dstFamily, buffer, 0, VK_WHOLE_SIZE);
+		commandBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eTopOfPipe, dstStage, vk::DependencyFlags(), nullptr, barrier, nullptr);
+	}
+
+	vk::Semaphore getSemaphore() const {
+		return *timeline;
+	}
+
+	uint32_t getFamily() const {
+		return family;
+	}
+
+	// Value of the last submission, 0 before the first
+	uint64_t getSubmitValue() const {
+		return submitValue;
+	}
+
+	const Statistics& getStatistics() const {
+		return statistics;
+	}
+
+private:
+	struct Slot {
+		vk::UniqueCommandPool pool;
+		vk::CommandBuffer commandBuffer;
+		// Signalled by the last submission of the slot
+		uint64_t value = 0;
+	};
+
+	vk::Device device;
+	vk::Queue queue;
+	uint32_t family = 0;
+	vk::UniqueSemaphore timeline;
+	std::vector<Slot> slots;
+	uint64_t submitValue = 0;
+	Statistics statistics;
+};
\ No newline at end of file
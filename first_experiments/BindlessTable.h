@@ -0,0 +1,234 @@
+#pragma once
+#include <vulkan/vulkan.hpp>
+
+#include <algorithm>
+#include <deque>
+#include <stdexcept>
+#include <vector>
+
+// One descriptor set with every texture and buffer of the renderer, bound once per command buffer. Shaders index the
+// arrays with indices handed in through push constants, so draws change resources without touching descriptor sets.
+// Built on descriptor indexing, core in Vulkan 1.2 but with optional features, see isSupported. Descriptors are
+// written as update after bind, adding a resource only queues its write and update writes all queued ones with a
+// single vkUpdateDescriptorSets call before the frame is recorded. Removed indices are reused once every frame that
+// may still use them has completed, until then the command buffers in flight may still read the old descriptor.
+class BindlessTable {
+
+public:
+	static constexpr uint32_t TEXTURE_BINDING = 0, BUFFER_BINDING = 1;
+
+	struct Statistics {
+		uint32_t textureCount = 0;
+		uint32_t bufferCount = 0;
+		uint32_t textureCapacity = 0;
+		uint32_t bufferCapacity = 0;
+		uint64_t writeCount = 0;
+		uint64_t updateCount = 0;
+	};
+
+	// The shaders index the arrays with push constants, which takes the dynamic indexing features of Vulkan 1.0
+	static bool isSupported(vk::PhysicalDevice physicalDevice) {
+		auto chain = physicalDevice.getFeatures2<vk::PhysicalDeviceFeatures2, vk::PhysicalDeviceVulkan12Features>();
+		const auto& coreFeatures = chain.get<vk::PhysicalDeviceFeatures2>().features;
+		const auto& features = chain.get<vk::PhysicalDeviceVulkan12Features>();
+		return coreFeatures.shaderSampledImageArrayDynamicIndexing && coreFeatures.shaderStorageBufferArrayDynamicIndexing
+			&& features.runtimeDescriptorArray && features.descriptorBindingPartiallyBound
+			&& features.descriptorBindingUpdateUnusedWhilePending
+			&& features.descriptorBindingSampledImageUpdateAfterBind && features.descriptorBindingStorageBufferUpdateAfterBind;
+	}
+
+	// Turns on what the table needs in the features passed to the device create info
+	static void enableFeatures(vk::PhysicalDeviceFeatures& coreFeatures, vk::PhysicalDeviceVulkan12Features& features) {
+		coreFeatures.shaderSampledImageArrayDynamicIndexing = VK_TRUE;
+		coreFeatures.shaderStorageBufferArrayDynamicIndexing = VK_TRUE;
+		features.runtimeDescriptorArray = VK_TRUE;
+		features.descriptorBindingPartiallyBound = VK_TRUE;
+		features.descriptorBindingUpdateUnusedWhilePending = VK_TRUE;
+		features.descriptorBindingSampledImageUpdateAfterBind = VK_TRUE;
+		features.descriptorBindingStorageBufferUpdateAfterBind = VK_TRUE;
+	}
+
+	// The capacities are clamped to the limits of the device
+	void init(vk::PhysicalDevice physicalDevice, vk::Device device, uint32_t textureCapacity, uint32_t bufferCapacity) {
+		this->device = device;
+
+		auto properties = physicalDevice.getProperties2<vk::PhysicalDeviceProperties2, vk::PhysicalDeviceDescriptorIndexingProperties>()
+			.get<vk::PhysicalDeviceDescriptorIndexingProperties>();
+		textures.capacity = std::min({ textureCapacity, properties.maxDescriptorSetUpdateAfterBindSampledImages,
+			properties.maxDescriptorSetUpdateAfterBindSamplers, properties.maxPerStageDescriptorUpdateAfterBindSampledImages,
+			properties.maxPerStageDescriptorUpdateAfterBindSamplers });
+		buffers.capacity = std::min({ bufferCapacity, properties.maxDescriptorSetUpdateAfterBindStorageBuffers,
+			properties.maxPerStageDescriptorUpdateAfterBindStorageBuffers });
+
+		vk::DescriptorSetLayoutBinding bindings[] = {
+			{ TEXTURE_BINDING, vk::DescriptorType::eCombinedImageSampler, textures.capacity, vk::ShaderStageFlagBits::eAllGraphics },
+			{ BUFFER_BINDING, vk::DescriptorType::eStorageBuffer, buffers.capacity, vk::ShaderStageFlagBits::eAllGraphics }
+		};
+		// Partially bound, as most of the table is empty. Unused descriptors may be written while frames are in flight.
+		vk::DescriptorBindingFlags flags = vk::DescriptorBindingFlagBits::ePartiallyBound | vk::DescriptorBindingFlagBits::eUpdateAfterBind
+			| vk::DescriptorBindingFlagBits::eUpdateUnusedWhilePending;
+		vk::DescriptorBindingFlags bindingFlags[] = { flags, flags };
+
+		vk::DescriptorSetLayoutBindingFlagsCreateInfo bindingFlagsInfo{};
+		bindingFlagsInfo.bindingCount = 2;
+		bindingFlagsInfo.pBindingFlags = bindingFlags;
+
+		vk::DescriptorSetLayoutCreateInfo layoutInfo{};
+		layoutInfo.flags = vk::DescriptorSetLayoutCreateFlagBits::eUpdateAfterBindPool;
+		layoutInfo.bindingCount = 2;
+		layoutInfo.pBindings = bindings;
+		layoutInfo.pNext = &bindingFlagsInfo;
+
+		vk::DescriptorPoolSize poolSizes[] = {
+			{ vk::DescriptorType::eCombinedImageSampler, textures.capacity },
+			{ vk::DescriptorType::eStorageBuffer, buffers.capacity }
+		};
+
+		vk::DescriptorPoolCreateInfo poolInfo{};
+		poolInfo.flags = vk::DescriptorPoolCreateFlagBits::eUpdateAfterBind;
+		poolInfo.maxSets = 1;
+		poolInfo.poolSizeCount = 2;
+		poolInfo.pPoolSizes = poolSizes;
+
+		try {
+			layout = device.createDescriptorSetLayoutUnique(layoutInfo);
+			pool = device.createDescriptorPoolUnique(poolInfo);
+
+			vk::DescriptorSetAllocateInfo allocateInfo{};
+			allocateInfo.descriptorPool = *pool;
+			allocateInfo.descriptorSetCount = 1;
+			allocateInfo.pSetLayouts = &*layout;
+			set = device.allocateDescriptorSets(allocateInfo)[0];
+		}
+		catch (vk::SystemError err) {
+			throw std::runtime_error("failed to create bindless descriptor table!");
+		}
+		statistics = {};
+	}
+
+	// The image has to be in layout when the descriptor is read
+	uint32_t addTexture(vk::ImageView view, vk::Sampler sampler, vk::ImageLayout layout = vk::ImageLayout::eShaderReadOnlyOptimal) {
+		uint32_t index = textures.acquire();
+		pendingImages.push_back({ index, vk::DescriptorImageInfo(sampler, view, layout) });
+		return index;
+	}
+
+	uint32_t addBuffer(vk::Buffer buffer, vk::DeviceSize offset, vk::DeviceSize range) {
+		uint32_t index = buffers.acquire();
+		pendingBuffers.push_back({ index, vk::DescriptorBufferInfo(buffer, offset, range) });
+		return index;
+	}
+
+	// retireValue is the last frame that may still use the index, as with SwapChain::recreate
+	void removeTexture(uint32_t index, uint64_t retireValue) {
+		textures.retired.push_back({ index, retireValue });
+	}
+
+	void removeBuffer(uint32_t index, uint64_t retireValue) {
+		buffers.retired.push_back({ index, retireValue });
+	}
+
+	// Makes the indices of the frames that completed available again
+	void releaseRetired(uint64_t completedValue) {
+		textures.release(completedValue);
+		buffers.release(completedValue);
+	}
+
+	// Writes the descriptors added since the last update, before the frame that uses them is submitted
+	void update() {
+		if (pendingImages.empty() && pendingBuffers.empty()) {
+			return;
+		}
+
+		writes.clear();
+		for (const auto& image : pendingImages) {
+			writes.push_back(vk::WriteDescriptorSet(set, TEXTURE_BINDING, image.index, 1, vk::DescriptorType::eCombinedImageSampler, &image.info));
+		}
+		for (const auto& buffer : pendingBuffers) {
+			writes.push_back(vk::WriteDescriptorSet(set, BUFFER_BINDING, buffer.index, 1, vk::DescriptorType::eStorageBuffer, nullptr, &buffer.info));
+		}
+		device.updateDescriptorSets(writes, nullptr);
+
+		statistics.writeCount += writes.size();
+		++statistics.updateCount;
+		pendingImages.clear();
+		pendingBuffers.clear();
+	}
+
+	vk::DescriptorSetLayout getLayout() const {
+		return *layout;
+	}
+
+	vk::DescriptorSet getSet() const {
+		return set;
+	}
+
+	Statistics getStatistics() const {
+		Statistics result = statistics;
+		result.textureCount = textures.getCount();
+		result.bufferCount = buffers.getCount();
+		result.textureCapacity = textures.capacity;
+		result.bufferCapacity = buffers.capacity;
+		return result;
+	}
+
+private:
+	struct RetiredIndex {
+		uint32_t index;
+		uint64_t retireValue;
+	};
+
+	// Indices of one array, handed out from the free list first
+	struct IndexAllocator {
+		uint32_t capacity = 0;
+		uint32_t nextIndex = 0;
+		std::vector<uint32_t> freeIndices;
+		std::deque<RetiredIndex> retired;
+
+		uint32_t acquire() {
+			if (!freeIndices.empty()) {
+				uint32_t index = freeIndices.back();
+				freeIndices.pop_back();
+				return index;
+			}
+			if (nextIndex == capacity) {
+				throw std::runtime_error("bindless descriptor table is full!");
+			}
+			return nextIndex++;
+		}
+
+		// Retired in frame order, so the completed ones are at the front
+		void release(uint64_t completedValue) {
+			while (!retired.empty() && retired.front().retireValue <= completedValue) {
+				freeIndices.push_back(retired.front().index);
+				retired.pop_front();
+			}
+		}
+
+		uint32_t getCount() const {
+			return nextIndex - static_cast<uint32_t>(freeIndices.size() + retired.size());
+		}
+	};
+
+	struct PendingImage {
+		uint32_t index;
+		vk::DescriptorImageInfo info;
+	};
+
+	struct PendingBuffer {
+		uint32_t index;
+		vk::DescriptorBufferInfo info;
+	};
+
+	vk::Device device;
+	vk::UniqueDescriptorSetLayout layout;
+	// Freeing the pool frees the set
+	vk::UniqueDescriptorPool pool;
+	vk::DescriptorSet set;
+
+	IndexAllocator textures, buffers;
+	std::vector<PendingImage> pendingImages;
+	std::vector<PendingBuffer> pendingBuffers;
+	std::vector<vk::WriteDescriptorSet> writes;
+	Statistics statistics;
+};
\ No newline at end of file
@@ -0,0 +1,168 @@
+#pragma once
+#include <vulkan/vulkan.hpp>
+
+#include <algorithm>
+#include <functional>
+#include <stdexcept>
+#include <vector>
+#include "WorkerPool.h"
+
+// Records the commands of a frame every frame. Each recording thread owns one command pool per frame in flight, the
+// pools are reset when their frame slot comes around again instead of freeing and reallocating buffers. Draws are
+// split into contiguous ranges on the threads of the worker pool, every range is recorded into the secondary command
+// buffer of its recording thread and the primary buffer executes them in order, so the draw order is the same as with
+// a single thread.
+class CommandRecorder {
+
+public:
+	// threadIndex identifies the recording thread, for per thread resources like descriptor pools. It is below the
+	// thread count passed to init, though the range may run on any thread of the pool.
+	using RecordFunction = std::function<void(vk::CommandBuffer commandBuffer, uint32_t threadIndex, uint32_t begin, uint32_t end)>;
+
+	CommandRecorder() = default;
+
+	CommandRecorder(const CommandRecorder&) = delete;
+	CommandRecorder& operator=(const CommandRecorder&) = delete;
+
+	// Records on up to threadCount threads of the pool, the pool has to outlive the recorder
+	void init(vk::Device device, uint32_t queueFamilyIndex, WorkerPool& workers, uint32_t threadCount, uint32_t framesInFlight) {
+		shutdown();
+
+		this->device = device;
+		this->workers = &workers;
+		threadCount = std::clamp(threadCount, 1u, workers.getThreadCount());
+
+		threads.resize(threadCount);
+		for (auto& thread : threads) {
+			thread.frames.resize(framesInFlight);
+			for (auto& frame : thread.frames) {
+				vk::CommandPoolCreateInfo poolInfo{};
+				poolInfo.flags = vk::CommandPoolCreateFlagBits::eTransient;
+				poolInfo.queueFamilyIndex = queueFamilyIndex;
+
+				try {
+					frame.pool = device.createCommandPoolUnique(poolInfo);
+				}
+				catch (vk::SystemError err) {
+					throw std::runtime_error("failed to create command pool!");
+				}
+
+				vk::CommandBufferAllocateInfo allocateInfo{};
+				allocateInfo.commandPool = *frame.pool;
+				allocateInfo.level = vk::CommandBufferLevel::eSecondary;
+				allocateInfo.commandBufferCount = 1;
+
+				try {
+					frame.secondary = std::move(device.allocateCommandBuffersUnique(allocateInfo)[0]);
+				}
+				catch (vk::SystemError err) {
+					throw std::runtime_error("failed to allocate command buffers!");
+				}
+			}
+		}
+
+		// The primary buffers come from the pools of thread 0
+		for (auto& frame : threads[0].frames) {
+			vk::CommandBufferAllocateInfo allocateInfo{};
+			allocateInfo.commandPool = *frame.pool;
+			allocateInfo.level = vk::CommandBufferLevel::ePrimary;
+			allocateInfo.commandBufferCount = 1;
+
+			try {
+				frame.primary = std::move(device.allocateCommandBuffersUnique(allocateInfo)[0]);
+			}
+			catch (vk::SystemError err) {
+				throw std::runtime_error("failed to allocate command buffers!");
+			}
+		}
+	}
+
+	void shutdown() {
+		threads.clear();
+	}
+
+	// Resets the pools of the frame slot and begins its primary buffer. The GPU has to be done with everything that
+	// was recorded the last time this slot was used, i.e. its fence has been waited on.
+	vk::CommandBuffer beginFrame(uint32_t frame) {
+		currentFrame = frame;
+		for (auto& thread : threads) {
+			device.resetCommandPool(*thread.frames[frame].pool, vk::CommandPoolResetFlags());
+		}
+
+		vk::CommandBuffer primary = *threads[0].frames[frame].primary;
+		vk::CommandBufferBeginInfo beginInfo{};
+		beginInfo.flags = vk::CommandBufferUsageFlagBits::eOneTimeSubmit;
+
+		try {
+			primary.begin(beginInfo);
+		}
+		catch (vk::SystemError err) {
+			throw std::runtime_error("failed to begin recording command buffer!");
+		}
+		return primary;
+	}
+
+	// Records drawCount draws in parallel secondary buffers and executes them in the primary buffer. Has to be called
+	// inside a render pass that was begun with vk::SubpassContents::eSecondaryCommandBuffers.
+	void recordDraws(const vk::CommandBufferInheritanceInfo& inheritance, uint32_t drawCount, const RecordFunction& record) {
+		uint32_t threadCount = static_cast<uint32_t>(threads.size());
+		// Below a minimum range the wake up costs more than recording the draws, above it the ranges are sized so
+		// there are no more of them than recording threads
+		uint32_t minDraws = std::max(MIN_DRAWS_PER_THREAD, (drawCount + threadCount - 1) / threadCount);
+
+		uint32_t activeThreads = workers->run(drawCount, minDraws, [&](uint32_t threadIndex, uint32_t begin, uint32_t end) {
+			vk::CommandBuffer secondary = *threads[threadIndex].frames[currentFrame].secondary;
+
+			vk::CommandBufferBeginInfo beginInfo{};
+			beginInfo.flags = vk::CommandBufferUsageFlagBits::eOneTimeSubmit | vk::CommandBufferUsageFlagBits::eRenderPassContinue;
+			beginInfo.pInheritanceInfo = &inheritance;
+			secondary.begin(beginInfo);
+
+			if (begin < end) {
+				record(secondary, threadIndex, begin, end);
+			}
+
+			secondary.end();
+		});
+
+		std::vector<vk::CommandBuffer> secondaries(activeThreads);
+		for (uint32_t i = 0; i < activeThreads; ++i) {
+			secondaries[i] = *threads[i].frames[currentFrame].secondary;
+		}
+		threads[0].frames[currentFrame].primary->executeCommands(secondaries);
+	}
+
+	vk::CommandBuffer endFrame() {
+		vk::CommandBuffer primary = *threads[0].frames[currentFrame].primary;
+		try {
+			primary.end();
+		}
+		catch (vk::SystemError err) {
+			throw std::runtime_error("failed to record command buffer!");
+		}
+		return primary;
+	}
+
+	uint32_t getThreadCount() const {
+		return static_cast<uint32_t>(threads.size());
+	}
+
+private:
+	static constexpr uint32_t MIN_DRAWS_PER_THREAD = 256;
+
+	struct ThreadFrame {
+		vk::UniqueCommandPool pool;
+		vk::UniqueCommandBuffer secondary;
+		vk::UniqueCommandBuffer primary;
+	};
+
+	struct RecordingThread {
+		// Unique buffers are declared after their pool, so they are freed before it is destroyed
+		std::vector<ThreadFrame> frames;
+	};
+
+	vk::Device device;
+	WorkerPool* workers = nullptr;
+	std::vector<RecordingThread> threads;
+	uint32_t currentFrame = 0;
+};
\ No newline at end of file
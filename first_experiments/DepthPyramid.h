@@ -0,0 +1,227 @@
+#pragma once
+#include <vulkan/vulkan.hpp>
+
+#include <algorithm>
+#include <array>
+#include <stdexcept>
+#include <vector>
+
+#include "GpuAllocator.h"
+
+// Hierarchical depth buffer for occlusion culling. Every texel holds the farthest depth of the area it covers, so an
+// object whose nearest depth lies behind it is hidden. Level 0 is the largest power of two size that fits into the
+// depth buffer and is reduced from it by a compute shader, every further level halves the one before, down to 1x1.
+// The pyramid stays in the general layout, it is written by build and read by compute shaders through getView.
+class DepthPyramid {
+
+public:
+	static constexpr uint32_t WORKGROUP_SIZE = 8;
+
+	DepthPyramid() = default;
+
+	DepthPyramid(const DepthPyramid&) = delete;
+	DepthPyramid& operator=(const DepthPyramid&) = delete;
+
+	// The depth image is sampled through depthView, it has to be created with the sampled usage. Called again for a
+	// resized depth buffer once no pending frame uses the pyramid.
+	void init(vk::Device device, GpuAllocator& allocator, vk::Image depthImage, vk::ImageView depthView, vk::Extent2D depthExtent,
+		vk::ShaderModule reduceShader, vk::PipelineCache pipelineCache) {
+		// The views of a previous pyramid go before its image
+		view.reset();
+		levelViews.clear();
+
+		this->device = device;
+		this->depthImage = depthImage;
+		extent = vk::Extent2D(previousPowerOfTwo(depthExtent.width), previousPowerOfTwo(depthExtent.height));
+		levelCount = 1;
+		while ((std::max(extent.width, extent.height) >> levelCount) > 0) {
+			++levelCount;
+		}
+
+		vk::ImageCreateInfo imageInfo{};
+		imageInfo.imageType = vk::ImageType::e2D;
+		imageInfo.format = vk::Format::eR32Sfloat;
+		imageInfo.extent = vk::Extent3D(extent.width, extent.height, 1);
+		imageInfo.mipLevels = levelCount;
+		imageInfo.arrayLayers = 1;
+		imageInfo.samples = vk::SampleCountFlagBits::e1;
+		imageInfo.tiling = vk::ImageTiling::eOptimal;
+		imageInfo.usage = vk::ImageUsageFlagBits::eStorage | vk::ImageUsageFlagBits::eSampled | vk::ImageUsageFlagBits::eTransferDst;
+		imageInfo.sharingMode = vk::SharingMode::eExclusive;
+		imageInfo.initialLayout = vk::ImageLayout::eUndefined;
+		image = allocator.createImage(imageInfo, vk::MemoryPropertyFlagBits::eDeviceLocal);
+
+		// Texels are fetched, the sampler only has to exist for the combined image samplers
+		vk::SamplerCreateInfo samplerInfo{};
+		samplerInfo.magFilter = vk::Filter::eNearest;
+		samplerInfo.minFilter = vk::Filter::eNearest;
+		samplerInfo.mipmapMode = vk::SamplerMipmapMode::eNearest;
+		samplerInfo.addressModeU = vk::SamplerAddressMode::eClampToEdge;
+		samplerInfo.addressModeV = vk::SamplerAddressMode::eClampToEdge;
+		samplerInfo.addressModeW = vk::SamplerAddressMode::eClampToEdge;
+		samplerInfo.maxLod = VK_LOD_CLAMP_NONE;
+
+		vk::DescriptorSetLayoutBinding bindings[] = {
+			{ 0, vk::DescriptorType::eCombinedImageSampler, 1, vk::ShaderStageFlagBits::eCompute },
+			{ 1, vk::DescriptorType::eStorageImage, 1, vk::ShaderStageFlagBits::eCompute }
+		};
+		vk::DescriptorSetLayoutCreateInfo layoutInfo{};
+		layoutInfo.bindingCount = 2;
+		layoutInfo.pBindings = bindings;
+
+		vk::DescriptorPoolSize poolSizes[] = {
+			{ vk::DescriptorType::eCombinedImageSampler, levelCount },
+			{ vk::DescriptorType::eStorageImage, levelCount }
+		};
+		vk::DescriptorPoolCreateInfo poolInfo{};
+		poolInfo.maxSets = levelCount;
+		poolInfo.poolSizeCount = 2;
+		poolInfo.pPoolSizes = poolSizes;
+
+		try {
+			sampler = device.createSamplerUnique(samplerInfo);
+			view = device.createImageViewUnique(vk::ImageViewCreateInfo(vk::ImageViewCreateFlags(), image.get(), vk::ImageViewType::e2D,
+				imageInfo.format, {}, { vk::ImageAspectFlagBits::eColor, 0, levelCount, 0, 1 }));
+			levelViews.clear();
+			for (uint32_t level = 0; level < levelCount; ++level) {
+				levelViews.push_back(device.createImageViewUnique(vk::ImageViewCreateInfo(vk::ImageViewCreateFlags(), image.get(), vk::ImageViewType::e2D,
+					imageInfo.format, {}, { vk::ImageAspectFlagBits::eColor, level, 1, 0, 1 })));
+			}
+			setLayout = device.createDescriptorSetLayoutUnique(layoutInfo);
+			pool = device.createDescriptorPoolUnique(poolInfo);
+		}
+		catch (vk::SystemError err) {
+			throw std::runtime_error("failed to create depth pyramid!");
+		}
+
+		// Level 0 reads the depth buffer, every other level the one before
+		std::vector<vk::DescriptorSetLayout> setLayouts(levelCount, *setLayout);
+		sets = device.allocateDescriptorSets(vk::DescriptorSetAllocateInfo(*pool, levelCount, setLayouts.data()));
+		for (uint32_t level = 0; level < levelCount; ++level) {
+			vk::DescriptorImageInfo sourceInfo = level == 0
+				? vk::DescriptorImageInfo(*sampler, depthView, vk::ImageLayout::eShaderReadOnlyOptimal)
+				: vk::DescriptorImageInfo(*sampler, *levelViews[level - 1], vk::ImageLayout::eGeneral);
+			vk::DescriptorImageInfo destinationInfo({}, *levelViews[level], vk::ImageLayout::eGeneral);
+			std::array<vk::WriteDescriptorSet, 2> writes = {
+				vk::WriteDescriptorSet(sets[level], 0, 0, 1, vk::DescriptorType::eCombinedImageSampler, &sourceInfo),
+				vk::WriteDescriptorSet(sets[level], 1, 0, 1, vk::DescriptorType::eStorageImage, &destinationInfo)
+			};
+			device.updateDescriptorSets(writes, nullptr);
+		}
+
+		vk::PipelineLayoutCreateInfo pipelineLayoutInfo{};
+		pipelineLayoutInfo.setLayoutCount = 1;
+		pipelineLayoutInfo.pSetLayouts = &*setLayout;
+
+		vk::ComputePipelineCreateInfo pipelineInfo{};
+		pipelineInfo.stage = vk::PipelineShaderStageCreateInfo(vk::PipelineShaderStageCreateFlags(), vk::ShaderStageFlagBits::eCompute, reduceShader, "main");
+
+		try {
+			pipelineLayout = device.createPipelineLayoutUnique(pipelineLayoutInfo);
+			pipelineInfo.layout = *pipelineLayout;
+			pipeline = std::move(device.createComputePipelineUnique(pipelineCache, pipelineInfo).value);
+		}
+		catch (vk::SystemError err) {
+			throw std::runtime_error("failed to create depth pyramid pipeline!");
+		}
+		initialized = false;
+	}
+
+	// Moves the pyramid into the general layout and fills it with the far plane, which hides nothing, so it can be
+	// read before the first build. Recorded once, before anything reads it.
+	void initialize(vk::CommandBuffer commandBuffer) {
+		vk::ImageSubresourceRange range(vk::ImageAspectFlagBits::eColor, 0, levelCount, 0, 1);
+		vk::ImageMemoryBarrier barrier(vk::AccessFlags(), vk::AccessFlagBits::eTransferWrite, vk::ImageLayout::eUndefined, vk::ImageLayout::eGeneral,
+			VK_QUEUE_FAMILY_IGNORED, VK_QUEUE_FAMILY_IGNORED, image.get(), range);
+		commandBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eTopOfPipe, vk::PipelineStageFlagBits::eTransfer,
+			vk::DependencyFlags(), nullptr, nullptr, barrier);
+
+		commandBuffer.clearColorImage(image.get(), vk::ImageLayout::eGeneral, vk::ClearColorValue(std::array<float, 4>{ 1.0f, 1.0f, 1.0f, 1.0f }), range);
+
+		vk::MemoryBarrier clearBarrier(vk::AccessFlagBits::eTransferWrite, vk::AccessFlagBits::eShaderRead | vk::AccessFlagBits::eShaderWrite);
+		commandBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eTransfer, vk::PipelineStageFlagBits::eComputeShader,
+			vk::DependencyFlags(), clearBarrier, nullptr, nullptr);
+		initialized = true;
+	}
+
+	bool isInitialized() const {
+		return initialized;
+	}
+
+	// Reduces the depth buffer, which the render pass left in the depth attachment layout and gets back in it. The
+	// pyramid is readable by the compute shaders recorded after it, also in later frames.
+	void build(vk::CommandBuffer commandBuffer) {
+		vk::ImageSubresourceRange depthRange(vk::ImageAspectFlagBits::eDepth, 0, 1, 0, 1);
+
+		// Also waits for the reads of the last pyramid before overwriting it
+		vk::ImageMemoryBarrier depthBarrier(vk::AccessFlagBits::eDepthStencilAttachmentWrite, vk::AccessFlagBits::eShaderRead,
+			vk::ImageLayout::eDepthStencilAttachmentOptimal, vk::ImageLayout::eShaderReadOnlyOptimal,
+			VK_QUEUE_FAMILY_IGNORED, VK_QUEUE_FAMILY_IGNORED, depthImage, depthRange);
+		commandBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eLateFragmentTests | vk::PipelineStageFlagBits::eComputeShader,
+			vk::PipelineStageFlagBits::eComputeShader, vk::DependencyFlags(), nullptr, nullptr, depthBarrier);
+
+		commandBuffer.bindPipeline(vk::PipelineBindPoint::eCompute, *pipeline);
+		vk::MemoryBarrier levelBarrier(vk::AccessFlagBits::eShaderWrite, vk::AccessFlagBits::eShaderRead);
+		for (uint32_t level = 0; level < levelCount; ++level) {
+			if (level > 0) {
+				commandBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eComputeShader, vk::PipelineStageFlagBits::eComputeShader,
+					vk::DependencyFlags(), levelBarrier, nullptr, nullptr);
+			}
+			uint32_t width = std::max(extent.width >> level, 1u), height = std::max(extent.height >> level, 1u);
+			commandBuffer.bindDescriptorSets(vk::PipelineBindPoint::eCompute, *pipelineLayout, 0, sets[level], nullptr);
+			commandBuffer.dispatch((width + WORKGROUP_SIZE - 1) / WORKGROUP_SIZE, (height + WORKGROUP_SIZE - 1) / WORKGROUP_SIZE, 1);
+		}
+
+		depthBarrier.srcAccessMask = vk::AccessFlags();
+		depthBarrier.dstAccessMask = vk::AccessFlagBits::eDepthStencilAttachmentRead | vk::AccessFlagBits::eDepthStencilAttachmentWrite;
+		depthBarrier.oldLayout = vk::ImageLayout::eShaderReadOnlyOptimal;
+		depthBarrier.newLayout = vk::ImageLayout::eDepthStencilAttachmentOptimal;
+		commandBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eComputeShader,
+			vk::PipelineStageFlagBits::eComputeShader | vk::PipelineStageFlagBits::eEarlyFragmentTests | vk::PipelineStageFlagBits::eLateFragmentTests,
+			vk::DependencyFlags(), levelBarrier, nullptr, depthBarrier);
+	}
+
+	// All levels, for a combined image sampler in the general layout
+	vk::ImageView getView() const {
+		return *view;
+	}
+
+	vk::Sampler getSampler() const {
+		return *sampler;
+	}
+
+	// Of level 0
+	vk::Extent2D getExtent() const {
+		return extent;
+	}
+
+	uint32_t getLevelCount() const {
+		return levelCount;
+	}
+
+private:
+	vk::Device device;
+	vk::Image depthImage;
+	vk::Extent2D extent;
+	uint32_t levelCount = 0;
+	bool initialized = false;
+
+	GpuImage image;
+	vk::UniqueImageView view;
+	std::vector<vk::UniqueImageView> levelViews;
+	vk::UniqueSampler sampler;
+	vk::UniqueDescriptorSetLayout setLayout;
+	// Freeing the pool frees the sets
+	vk::UniqueDescriptorPool pool;
+	std::vector<vk::DescriptorSet> sets;
+	vk::UniquePipelineLayout pipelineLayout;
+	vk::UniquePipeline pipeline;
+
+	static uint32_t previousPowerOfTwo(uint32_t value) {
+		uint32_t result = 1;
+		while (result * 2 <= value) {
+			result *= 2;
+		}
+		return result;
+	}
+};
\ No newline at end of file
@@ -0,0 +1,134 @@
+#pragma once
+#include <vulkan/vulkan.hpp>
+
+#include <algorithm>
+#include <stdexcept>
+#include <vector>
+
+// Descriptor sets that only live for one frame. Every recording thread owns a list of pools per frame in flight and
+// allocates linearly from the current one, a full pool moves it on to the next, which is created the first time it is
+// needed. Sets are never freed one by one, beginFrame resets all pools of the frame slot at once and keeps them for
+// the next time the slot comes around.
+class DescriptorAllocator {
+
+public:
+	// Over all threads and frame slots
+	struct Statistics {
+		uint64_t allocationCount = 0;
+		uint64_t resetCount = 0;
+		uint32_t poolCount = 0;
+	};
+
+	DescriptorAllocator() = default;
+
+	DescriptorAllocator(const DescriptorAllocator&) = delete;
+	DescriptorAllocator& operator=(const DescriptorAllocator&) = delete;
+
+	// setSizes are the descriptors of one set, every pool holds setsPerPool of them
+	void init(vk::Device device, uint32_t framesInFlight, uint32_t threadCount, const std::vector<vk::DescriptorPoolSize>& setSizes, uint32_t setsPerPool) {
+		this->device = device;
+		this->setsPerPool = std::max(setsPerPool, 1u);
+
+		poolSizes = setSizes;
+		for (auto& size : poolSizes) {
+			size.descriptorCount *= this->setsPerPool;
+		}
+
+		threads.clear();
+		threads.resize(std::max(threadCount, 1u));
+		for (auto& thread : threads) {
+			thread.frames.resize(framesInFlight);
+		}
+		resetCount = 0;
+	}
+
+	// The GPU has to be done with the sets allocated the last time this slot was used, i.e. its fence has been waited on
+	void beginFrame(uint32_t frame) {
+		currentFrame = frame;
+		for (auto& thread : threads) {
+			ThreadFrame& threadFrame = thread.frames[frame];
+			// Up to and including the current pool, the ones after it were not needed last time
+			size_t usedPools = std::min<size_t>(threadFrame.currentPool + 1, threadFrame.pools.size());
+			for (size_t i = 0; i < usedPools; ++i) {
+				device.resetDescriptorPool(*threadFrame.pools[i]);
+			}
+			resetCount += usedPools;
+			threadFrame.currentPool = 0;
+		}
+	}
+
+	// Only called by the recording thread threadIndex, the threads share nothing
+	vk::DescriptorSet allocate(uint32_t threadIndex, vk::DescriptorSetLayout layout) {
+		Thread& thread = threads[threadIndex];
+		ThreadFrame& threadFrame = thread.frames[currentFrame];
+
+		vk::DescriptorSetAllocateInfo allocateInfo{};
+		allocateInfo.descriptorSetCount = 1;
+		allocateInfo.pSetLayouts = &layout;
+
+		// A fresh pool fits any set, so the second attempt only fails for a layout that is larger than setSizes
+		for (int attempt = 0; attempt < 2; ++attempt) {
+			if (threadFrame.currentPool == threadFrame.pools.size()) {
+				threadFrame.pools.push_back(createPool());
+			}
+			allocateInfo.descriptorPool = *threadFrame.pools[threadFrame.currentPool];
+
+			vk::DescriptorSet set;
+			vk::Result result = device.allocateDescriptorSets(&allocateInfo, &set);
+			if (result == vk::Result::eSuccess) {
+				++thread.allocationCount;
+				return set;
+			}
+			if (result != vk::Result::eErrorOutOfPoolMemory && result != vk::Result::eErrorFragmentedPool) {
+				break;
+			}
+			++threadFrame.currentPool;
+		}
+		throw std::runtime_error("failed to allocate descriptor set!");
+	}
+
+	Statistics getStatistics() const {
+		Statistics statistics;
+		statistics.resetCount = resetCount;
+		for (const auto& thread : threads) {
+			statistics.allocationCount += thread.allocationCount;
+			for (const auto& threadFrame : thread.frames) {
+				statistics.poolCount += static_cast<uint32_t>(threadFrame.pools.size());
+			}
+		}
+		return statistics;
+	}
+
+private:
+	struct ThreadFrame {
+		std::vector<vk::UniqueDescriptorPool> pools;
+		// Pools before it are full, it is the one allocated from
+		uint32_t currentPool = 0;
+	};
+
+	struct Thread {
+		std::vector<ThreadFrame> frames;
+		uint64_t allocationCount = 0;
+	};
+
+	vk::Device device;
+	std::vector<vk::DescriptorPoolSize> poolSizes;
+	uint32_t setsPerPool = 0;
+	std::vector<Thread> threads;
+	uint32_t currentFrame = 0;
+	uint64_t resetCount = 0;
+
+	vk::UniqueDescriptorPool createPool() {
+		vk::DescriptorPoolCreateInfo poolInfo{};
+		poolInfo.maxSets = setsPerPool;
+		poolInfo.poolSizeCount = static_cast<uint32_t>(poolSizes.size());
+		poolInfo.pPoolSizes = poolSizes.data();
+
+		try {
+			return device.createDescriptorPoolUnique(poolInfo);
+		}
+		catch (vk::SystemError err) {
+			throw std::runtime_error("failed to create descriptor pool!");
+		}
+	}
+};
\ No newline at end of file
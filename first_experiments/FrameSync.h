@@ -0,0 +1,239 @@
+#pragma once
+#include <vulkan/vulkan.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <limits>
+#include <stdexcept>
+#include <vector>
+
+// Paces the frames in flight with one timeline semaphore instead of a fence per frame. Frame n signals the value n
+// when its submission has completed, so frame n may reuse the resources of its slot once the value n - framesInFlight
+// is reached. beginFrame never blocks, CPU work that does not touch the slot's GPU resources can run before
+// waitForSlot. Binary semaphores are only used towards the swap chain, which does not accept timeline semaphores.
+// Other queues order their work against the frames through the timelines, see addWait and getTimeline.
+class FrameSync {
+
+public:
+	static constexpr uint32_t MIN_FRAMES_IN_FLIGHT = 1;
+	static constexpr uint32_t MAX_FRAMES_IN_FLIGHT = 4;
+
+	// imageCount is the number of swap chain images to present, 0 without a swap chain
+	void init(vk::Device device, uint32_t framesInFlight, uint32_t imageCount) {
+		if (framesInFlight < MIN_FRAMES_IN_FLIGHT || framesInFlight > MAX_FRAMES_IN_FLIGHT) {
+			throw std::runtime_error("frames in flight have to be between 1 and 4!");
+		}
+		this->device = device;
+		this->framesInFlight = framesInFlight;
+		frameValue = 0;
+
+		vk::SemaphoreTypeCreateInfo typeInfo{};
+		typeInfo.semaphoreType = vk::SemaphoreType::eTimeline;
+		typeInfo.initialValue = 0;
+
+		vk::SemaphoreCreateInfo timelineInfo{};
+		timelineInfo.pNext = &typeInfo;
+
+		vk::SemaphoreCreateInfo semaphoreInfo{};
+
+		try {
+			timeline = device.createSemaphoreUnique(timelineInfo);
+
+			imageAvailableSemaphores.clear();
+			renderFinishedSemaphores.clear();
+			if (imageCount > 0) {
+				// The acquire semaphore is free again once the frame that waited on it has completed
+				for (uint32_t i = 0; i < framesInFlight; ++i) {
+					imageAvailableSemaphores.push_back(device.createSemaphoreUnique(semaphoreInfo));
+				}
+			}
+		}
+		catch (vk::SystemError err) {
+			throw std::runtime_error("failed to create semaphores!");
+		}
+		setImageCount(imageCount);
+	}
+
+	// The present of an image has to be done with its semaphore before the image is acquired again, so there is one
+	// per image. Only ever grows, a recreated swap chain reuses the semaphores of the old one.
+	void setImageCount(uint32_t imageCount) {
+		vk::SemaphoreCreateInfo semaphoreInfo{};
+		try {
+			while (renderFinishedSemaphores.size() < imageCount) {
+				renderFinishedSemaphores.push_back(device.createSemaphoreUnique(semaphoreInfo));
+			}
+		}
+		catch (vk::SystemError err) {
+			throw std::runtime_error("failed to create semaphores!");
+		}
+	}
+
+	// Starts the next frame without waiting for the GPU and returns its slot
+	uint32_t beginFrame() {
+		++frameValue;
+		stallSeconds = 0.0;
+		return getSlot();
+	}
+
+	// Blocks until the GPU is done with the last frame that used the current slot
+	void waitForSlot() {
+		if (frameValue > framesInFlight) {
+			waitForValue(frameValue - framesInFlight);
+		}
+	}
+
+	// Waits for the frame with the given value, e.g. before reading back its results
+	void waitForValue(uint64_t value) {
+		if (completedValue >= value) {
+			return;
+		}
+		completedValue = device.getSemaphoreCounterValue(*timeline);
+		if (completedValue >= value) {
+			return;
+		}
+
+		vk::SemaphoreWaitInfo waitInfo{};
+		waitInfo.semaphoreCount = 1;
+		waitInfo.pSemaphores = &*timeline;
+		waitInfo.pValues = &value;
+
+		auto waitStart = std::chrono::steady_clock::now();
+		if (device.waitSemaphores(waitInfo, std::numeric_limits<uint64_t>::max()) != vk::Result::eSuccess) {
+			throw std::runtime_error("failed to wait for frame!");
+		}
+		stallSeconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - waitStart).count();
+		completedValue = value;
+	}
+
+	// Acquired by the current frame, nullptr without a swap chain
+	vk::Semaphore getImageAvailableSemaphore() const {
+		return imageAvailableSemaphores.empty() ? vk::Semaphore() : *imageAvailableSemaphores[getSlot()];
+	}
+
+	vk::Semaphore getRenderFinishedSemaphore(uint32_t imageIndex) const {
+		return renderFinishedSemaphores.empty() ? vk::Semaphore() : *renderFinishedSemaphores[imageIndex];
+	}
+
+	// Makes the next submit wait at stage until the timeline semaphore of another queue reaches value, e.g. for work
+	// the frame reads. Waits on the same semaphore are merged, keeping the highest value.
+	void addWait(vk::Semaphore semaphore, uint64_t value, vk::PipelineStageFlags stage) {
+		for (size_t i = 0; i < waitSemaphores.size(); ++i) {
+			if (waitSemaphores[i] == semaphore) {
+				waitValues[i] = std::max(waitValues[i], value);
+				waitStages[i] |= stage;
+				return;
+			}
+		}
+		waitSemaphores.push_back(semaphore);
+		waitValues.push_back(value);
+		waitStages.push_back(stage);
+	}
+
+	// Submits the frame's command buffer and signals the frame's timeline value. With a swap chain the submission
+	// waits for the acquired image and signals the render finished semaphore of imageIndex for the present.
+	void submit(vk::Queue queue, vk::CommandBuffer commandBuffer, uint32_t imageIndex) {
+		bool presenting = !imageAvailableSemaphores.empty();
+
+		// Values of binary semaphores are ignored
+		if (presenting) {
+			addWait(getImageAvailableSemaphore(), 0, vk::PipelineStageFlagBits::eColorAttachmentOutput);
+		}
+		vk::Semaphore signalSemaphores[] = { *timeline, getRenderFinishedSemaphore(imageIndex) };
+		uint64_t signalValues[] = { frameValue, 0 };
+
+		vk::TimelineSemaphoreSubmitInfo timelineInfo{};
+		timelineInfo.waitSemaphoreValueCount = static_cast<uint32_t>(waitValues.size());
+		timelineInfo.pWaitSemaphoreValues = waitValues.data();
+		timelineInfo.signalSemaphoreValueCount = presenting ? 2 : 1;
+		timelineInfo.pSignalSemaphoreValues = signalValues;
+
+		vk::SubmitInfo submitInfo{};
+		submitInfo.pNext = &timelineInfo;
+		submitInfo.waitSemaphoreCount = static_cast<uint32_t>(waitSemaphores.size());
+		submitInfo.pWaitSemaphores = waitSemaphores.data();
+		submitInfo.pWaitDstStageMask = waitStages.data();
+		submitInfo.commandBufferCount = 1;
+		submitInfo.pCommandBuffers = &commandBuffer;
+		submitInfo.signalSemaphoreCount = presenting ? 2 : 1;
+		submitInfo.pSignalSemaphores = signalSemaphores;
+
+		try {
+			queue.submit(submitInfo, nullptr);
+		}
+		catch (vk::SystemError err) {
+			throw std::runtime_error("failed to submit draw command buffer!");
+		}
+		waitSemaphores.clear();
+		waitValues.clear();
+		waitStages.clear();
+	}
+
+	// Signals the frame's timeline value without rendering, for frames that could not acquire an image
+	void skipFrame(vk::Queue queue) {
+		vk::TimelineSemaphoreSubmitInfo timelineInfo{};
+		timelineInfo.signalSemaphoreValueCount = 1;
+		timelineInfo.pSignalSemaphoreValues = &frameValue;
+
+		vk::SubmitInfo submitInfo{};
+		submitInfo.pNext = &timelineInfo;
+		submitInfo.signalSemaphoreCount = 1;
+		submitInfo.pSignalSemaphores = &*timeline;
+
+		try {
+			queue.submit(submitInfo, nullptr);
+		}
+		catch (vk::SystemError err) {
+			throw std::runtime_error("failed to submit draw command buffer!");
+		}
+	}
+
+	// Last frame the GPU has completed
+	uint64_t getCompletedValue() {
+		completedValue = device.getSemaphoreCounterValue(*timeline);
+		return completedValue;
+	}
+
+	// Adds time blocked outside of FrameSync, e.g. in the image acquisition, to the current frame's stall
+	void addStall(double seconds) {
+		stallSeconds += seconds;
+	}
+
+	// Time the current frame blocked on the GPU so far
+	double getStallMs() const {
+		return stallSeconds * 1000.0;
+	}
+
+	uint32_t getSlot() const {
+		return static_cast<uint32_t>((frameValue - 1) % framesInFlight);
+	}
+
+	uint32_t getFramesInFlight() const {
+		return framesInFlight;
+	}
+
+	// Timeline value of the current frame, the first frame is 1
+	uint64_t getFrameValue() const {
+		return frameValue;
+	}
+
+	// Reaches the value of every frame once its submission has completed, for other queues to wait on
+	vk::Semaphore getTimeline() const {
+		return *timeline;
+	}
+
+private:
+	vk::Device device;
+	uint32_t framesInFlight = 0;
+
+	vk::UniqueSemaphore timeline;
+	std::vector<vk::UniqueSemaphore> imageAvailableSemaphores, renderFinishedSemaphores;
+	// Of the next submit
+	std::vector<vk::Semaphore> waitSemaphores;
+	std::vector<uint64_t> waitValues;
+	std::vector<vk::PipelineStageFlags> waitStages;
+
+	uint64_t frameValue = 0;
+	// Last value known to be reached, saves querying the semaphore when the GPU is far enough ahead
+	uint64_t completedValue = 0;
+	double stallSeconds = 0.0;
+};
\ No newline at end of file
@@ -0,0 +1,412 @@
+#pragma once
+#include <vulkan/vulkan.hpp>
+
+#include <memory>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include "TlsfAllocator.h"
+
+class GpuAllocator;
+
+struct GpuAllocation {
+	vk::DeviceMemory memory;
+	vk::DeviceSize offset = 0;
+	vk::DeviceSize size = 0;
+	// Persistently mapped pointer to offset, nullptr unless the memory is host visible
+	void* mapped = nullptr;
+
+	uint32_t memoryTypeIndex = 0;
+	// Buffers and linear images live in other blocks than optimal images
+	bool linearResource = true;
+	uint32_t blockIndex = 0;
+	// INVALID_NODE for dedicated allocations, which own their whole vk::DeviceMemory
+	uint32_t node = TlsfAllocator::INVALID_NODE;
+
+	explicit operator bool() const {
+		return static_cast<bool>(memory);
+	}
+};
+
+// Buffer and the memory bound to it, the memory is returned to the allocator when the buffer is destroyed
+class GpuBuffer {
+
+public:
+	GpuBuffer() = default;
+
+	GpuBuffer(GpuAllocator* allocator, vk::UniqueBuffer buffer, const GpuAllocation& allocation)
+		: allocator(allocator), buffer(std::move(buffer)), allocation(allocation) {}
+
+	GpuBuffer(GpuBuffer&& other) noexcept
+		: allocator(std::exchange(other.allocator, nullptr)), buffer(std::move(other.buffer)), allocation(std::exchange(other.allocation, {})) {}
+
+	GpuBuffer& operator=(GpuBuffer&& other) noexcept {
+		reset();
+		allocator = std::exchange(other.allocator, nullptr);
+		buffer = std::move(other.buffer);
+		allocation = std::exchange(other.allocation, {});
+		return *this;
+	}
+
+	~GpuBuffer() {
+		reset();
+	}
+
+	void reset();
+
+	vk::Buffer get() const {
+		return *buffer;
+	}
+
+	const GpuAllocation& getAllocation() const {
+		return allocation;
+	}
+
+	void* getMapped() const {
+		return allocation.mapped;
+	}
+
+private:
+	GpuAllocator* allocator = nullptr;
+	vk::UniqueBuffer buffer;
+	GpuAllocation allocation;
+};
+
+// Same for images
+class GpuImage {
+
+public:
+	GpuImage() = default;
+
+	GpuImage(GpuAllocator* allocator, vk::UniqueImage image, const GpuAllocation& allocation)
+		: allocator(allocator), image(std::move(image)), allocation(allocation) {}
+
+	GpuImage(GpuImage&& other) noexcept
+		: allocator(std::exchange(other.allocator, nullptr)), image(std::move(other.image)), allocation(std::exchange(other.allocation, {})) {}
+
+	GpuImage& operator=(GpuImage&& other) noexcept {
+		reset();
+		allocator = std::exchange(other.allocator, nullptr);
+		image = std::move(other.image);
+		allocation = std::exchange(other.allocation, {});
+		return *this;
+	}
+
+	~GpuImage() {
+		reset();
+	}
+
+	void reset();
+
+	vk::Image get() const {
+		return *image;
+	}
+
+	const GpuAllocation& getAllocation() const {
+		return allocation;
+	}
+
+private:
+	GpuAllocator* allocator = nullptr;
+	vk::UniqueImage image;
+	GpuAllocation allocation;
+};
+
+// Sub-allocates resources from large vk::DeviceMemory blocks, one list of blocks per memory type, so the number of
+// vkAllocateMemory calls stays far below maxMemoryAllocationCount. Each block is managed by a TlsfAllocator. Host
+// visible blocks are mapped once for their whole lifetime. Buffers and optimal tiling images are kept in separate
+// blocks, so bufferImageGranularity never has to be padded for.
+class GpuAllocator {
+
+public:
+	static constexpr vk::DeviceSize DEFAULT_BLOCK_SIZE = 64 * 1024 * 1024;
+
+	struct Statistics {
+		uint32_t memoryAllocationCount = 0;
+		uint32_t maxMemoryAllocationCount = 0;
+		uint32_t blockCount = 0;
+		uint32_t dedicatedAllocationCount = 0;
+		uint32_t allocationCount = 0;
+		vk::DeviceSize reservedSize = 0;
+		vk::DeviceSize usedSize = 0;
+		// Largest free range of any block, and the fragmentation of the free space of all blocks combined
+		vk::DeviceSize largestFreeRange = 0;
+		uint32_t freeRangeCount = 0;
+		double fragmentation = 0.0;
+	};
+
+	GpuAllocator() = default;
+
+	GpuAllocator(const GpuAllocator&) = delete;
+	GpuAllocator& operator=(const GpuAllocator&) = delete;
+
+	void init(vk::Device device, vk::PhysicalDevice physicalDevice, vk::DeviceSize blockSize = DEFAULT_BLOCK_SIZE) {
+		this->device = device;
+		this->blockSize = blockSize;
+		memoryProperties = physicalDevice.getMemoryProperties();
+		maxMemoryAllocationCount = physicalDevice.getProperties().limits.maxMemoryAllocationCount;
+		blocks.clear();
+		blocks.resize(memoryProperties.memoryTypeCount * 2);
+	}
+
+	// Picks the memory type with all required and as many preferred property flags as possible
+	GpuAllocation allocate(const vk::MemoryRequirements& requirements, vk::MemoryPropertyFlags required,
+		vk::MemoryPropertyFlags preferred = {}, bool linearResource = true) {
+		uint32_t memoryTypeIndex = findMemoryType(requirements.memoryTypeBits, required, preferred);
+
+		// Big resources would waste most of a block, they get their own memory
+		if (requirements.size > blockSize / 2) {
+			return allocateDedicated(requirements.size, memoryTypeIndex);
+		}
+
+		auto& typeBlocks = blocks[memoryTypeIndex * 2 + (linearResource ? 0 : 1)];
+		for (uint32_t i = 0; i < typeBlocks.size(); ++i) {
+			if (!typeBlocks[i]) {
+				continue;
+			}
+			TlsfAllocator::Allocation range;
+			if (typeBlocks[i]->ranges.allocate(requirements.size, requirements.alignment, range)) {
+				return makeAllocation(*typeBlocks[i], memoryTypeIndex, linearResource, i, range, requirements.size);
+			}
+		}
+
+		uint32_t blockIndex = createBlock(typeBlocks, memoryTypeIndex);
+		TlsfAllocator::Allocation range;
+		if (!typeBlocks[blockIndex]->ranges.allocate(requirements.size, requirements.alignment, range)) {
+			throw std::runtime_error("failed to sub-allocate gpu memory!");
+		}
+		return makeAllocation(*typeBlocks[blockIndex], memoryTypeIndex, linearResource, blockIndex, range, requirements.size);
+	}
+
+	void free(GpuAllocation& allocation) {
+		if (!allocation) {
+			return;
+		}
+
+		if (allocation.node == TlsfAllocator::INVALID_NODE) {
+			device.freeMemory(allocation.memory);
+			--memoryAllocationCount;
+			--dedicatedAllocationCount;
+			dedicatedSize -= allocation.size;
+		}
+		else {
+			auto& typeBlocks = blocks[allocation.memoryTypeIndex * 2 + (allocation.linearResource ? 0 : 1)];
+			auto& block = typeBlocks[allocation.blockIndex];
+			block->ranges.free(allocation.node);
+
+			// Keep one empty block per memory type around, so a single resource being recreated doesn't
+			// allocate and free a whole block every time
+			if (block->ranges.isEmpty() && countBlocks(typeBlocks) > 1) {
+				block.reset();
+				--memoryAllocationCount;
+			}
+		}
+		allocation = {};
+	}
+
+	GpuBuffer createBuffer(vk::DeviceSize size, vk::BufferUsageFlags usage, vk::MemoryPropertyFlags required, vk::MemoryPropertyFlags preferred = {}) {
+		vk::BufferCreateInfo bufferInfo{};
+		bufferInfo.size = size;
+		bufferInfo.usage = usage;
+		bufferInfo.sharingMode = vk::SharingMode::eExclusive;
+
+		vk::UniqueBuffer buffer;
+		try {
+			buffer = device.createBufferUnique(bufferInfo);
+		}
+		catch (vk::SystemError err) {
+			throw std::runtime_error("failed to create buffer!");
+		}
+
+		GpuAllocation allocation = allocate(device.getBufferMemoryRequirements(*buffer), required, preferred, true);
+		device.bindBufferMemory(*buffer, allocation.memory, allocation.offset);
+		return GpuBuffer(this, std::move(buffer), allocation);
+	}
+
+	GpuImage createImage(const vk::ImageCreateInfo& imageInfo, vk::MemoryPropertyFlags required, vk::MemoryPropertyFlags preferred = {}) {
+		vk::UniqueImage image;
+		try {
+			image = device.createImageUnique(imageInfo);
+		}
+		catch (vk::SystemError err) {
+			throw std::runtime_error("failed to create image!");
+		}
+
+		GpuAllocation allocation = allocate(device.getImageMemoryRequirements(*image), required, preferred, imageInfo.tiling == vk::ImageTiling::eLinear);
+		device.bindImageMemory(*image, allocation.memory, allocation.offset);
+		return GpuImage(this, std::move(image), allocation);
+	}
+
+	Statistics getStatistics() const {
+		Statistics statistics;
+		statistics.memoryAllocationCount = memoryAllocationCount;
+		statistics.maxMemoryAllocationCount = maxMemoryAllocationCount;
+		statistics.dedicatedAllocationCount = dedicatedAllocationCount;
+		statistics.allocationCount = dedicatedAllocationCount;
+		statistics.reservedSize = dedicatedSize;
+		statistics.usedSize = dedicatedSize;
+
+		vk::DeviceSize freeSize = 0;
+		for (const auto& typeBlocks : blocks) {
+			for (const auto& block : typeBlocks) {
+				if (!block) {
+					continue;
+				}
+				auto blockStatistics = block->ranges.getStatistics();
+				++statistics.blockCount;
+				statistics.allocationCount += blockStatistics.allocationCount;
+				statistics.reservedSize += blockStatistics.size;
+				statistics.usedSize += blockStatistics.usedSize;
+				statistics.freeRangeCount += blockStatistics.freeRangeCount;
+				statistics.largestFreeRange = std::max(statistics.largestFreeRange, blockStatistics.largestFreeRange);
+				freeSize += blockStatistics.freeSize;
+			}
+		}
+		statistics.fragmentation = freeSize == 0 ? 0.0 : 1.0 - double(statistics.largestFreeRange) / double(freeSize);
+		return statistics;
+	}
+
+private:
+	struct MemoryBlock {
+		vk::UniqueDeviceMemory memory;
+		void* mapped = nullptr;
+		TlsfAllocator ranges;
+	};
+
+	vk::Device device;
+	vk::DeviceSize blockSize = DEFAULT_BLOCK_SIZE;
+	vk::PhysicalDeviceMemoryProperties memoryProperties;
+
+	// Two lists per memory type, buffers and linear images first, optimal images second
+	std::vector<std::vector<std::unique_ptr<MemoryBlock>>> blocks;
+
+	uint32_t maxMemoryAllocationCount = 0;
+	uint32_t memoryAllocationCount = 0;
+	uint32_t dedicatedAllocationCount = 0;
+	vk::DeviceSize dedicatedSize = 0;
+
+	uint32_t findMemoryType(uint32_t typeFilter, vk::MemoryPropertyFlags required, vk::MemoryPropertyFlags preferred) const {
+		uint32_t bestType = ~0u;
+		int bestScore = -1;
+
+		for (uint32_t i = 0; i < memoryProperties.memoryTypeCount; ++i) {
+			auto flags = memoryProperties.memoryTypes[i].propertyFlags;
+			if (!(typeFilter & (1 << i)) || (flags & required) != required) {
+				continue;
+			}
+
+			int score = 0;
+			for (uint32_t bit = 0; bit < 32; ++bit) {
+				auto flag = static_cast<vk::MemoryPropertyFlagBits>(1u << bit);
+				if ((preferred & flag) && (flags & flag)) {
+					++score;
+				}
+			}
+			if (score > bestScore) {
+				bestType = i;
+				bestScore = score;
+			}
+		}
+
+		if (bestType == ~0u) {
+			throw std::runtime_error("failed to find suitable memory type!");
+		}
+		return bestType;
+	}
+
+	bool isHostVisible(uint32_t memoryTypeIndex) const {
+		return static_cast<bool>(memoryProperties.memoryTypes[memoryTypeIndex].propertyFlags & vk::MemoryPropertyFlagBits::eHostVisible);
+	}
+
+	vk::DeviceMemory allocateMemory(vk::DeviceSize size, uint32_t memoryTypeIndex) {
+		if (memoryAllocationCount >= maxMemoryAllocationCount) {
+			throw std::runtime_error("exceeded maxMemoryAllocationCount!");
+		}
+
+		vk::MemoryAllocateInfo allocateInfo{};
+		allocateInfo.allocationSize = size;
+		allocateInfo.memoryTypeIndex = memoryTypeIndex;
+
+		try {
+			vk::DeviceMemory memory = device.allocateMemory(allocateInfo);
+			++memoryAllocationCount;
+			return memory;
+		}
+		catch (vk::SystemError err) {
+			throw std::runtime_error("failed to allocate gpu memory!");
+		}
+	}
+
+	GpuAllocation allocateDedicated(vk::DeviceSize size, uint32_t memoryTypeIndex) {
+		GpuAllocation allocation;
+		allocation.memory = allocateMemory(size, memoryTypeIndex);
+		allocation.size = size;
+		allocation.memoryTypeIndex = memoryTypeIndex;
+		if (isHostVisible(memoryTypeIndex)) {
+			allocation.mapped = device.mapMemory(allocation.memory, 0, VK_WHOLE_SIZE);
+		}
+
+		++dedicatedAllocationCount;
+		dedicatedSize += size;
+		return allocation;
+	}
+
+	uint32_t createBlock(std::vector<std::unique_ptr<MemoryBlock>>& typeBlocks, uint32_t memoryTypeIndex) {
+		auto block = std::make_unique<MemoryBlock>();
+		block->memory = vk::UniqueDeviceMemory(allocateMemory(blockSize, memoryTypeIndex), device);
+		if (isHostVisible(memoryTypeIndex)) {
+			block->mapped = device.mapMemory(*block->memory, 0, VK_WHOLE_SIZE);
+		}
+		block->ranges.reset(blockSize);
+
+		// Reuse the slot of a freed block, so the block index of live allocations never changes
+		for (uint32_t i = 0; i < typeBlocks.size(); ++i) {
+			if (!typeBlocks[i]) {
+				typeBlocks[i] = std::move(block);
+				return i;
+			}
+		}
+		typeBlocks.push_back(std::move(block));
+		return static_cast<uint32_t>(typeBlocks.size() - 1);
+	}
+
+	GpuAllocation makeAllocation(const MemoryBlock& block, uint32_t memoryTypeIndex, bool linearResource, uint32_t blockIndex,
+		const TlsfAllocator::Allocation& range, vk::DeviceSize size) {
+		GpuAllocation allocation;
+		allocation.memory = *block.memory;
+		allocation.offset = range.offset;
+		allocation.size = size;
+		allocation.mapped = block.mapped ? static_cast<char*>(block.mapped) + range.offset : nullptr;
+		allocation.memoryTypeIndex = memoryTypeIndex;
+		allocation.linearResource = linearResource;
+		allocation.blockIndex = blockIndex;
+		allocation.node = range.node;
+		return allocation;
+	}
+
+	static uint32_t countBlocks(const std::vector<std::unique_ptr<MemoryBlock>>& typeBlocks) {
+		uint32_t count = 0;
+		for (const auto& block : typeBlocks) {
+			count += block ? 1 : 0;
+		}
+		return count;
+	}
+};
+
+inline void GpuBuffer::reset() {
+	// The buffer has to be gone before its memory can be reused
+	buffer.reset();
+	if (allocator) {
+		allocator->free(allocation);
+	}
+	allocator = nullptr;
+}
+
+inline void GpuImage::reset() {
+	image.reset();
+	if (allocator) {
+		allocator->free(allocation);
+	}
+	allocator = nullptr;
+}
\ No newline at end of file
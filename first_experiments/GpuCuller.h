@@ -0,0 +1,378 @@
+#pragma once
+#include <vulkan/vulkan.hpp>
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstring>
+#include <stdexcept>
+#include <vector>
+
+#include "DepthPyramid.h"
+#include "GpuAllocator.h"
+#include "StagingRing.h"
+#include "Math/Frustum.h"
+
+// World space box of an object, laid out as the std430 array the shaders read
+struct ObjectBounds {
+	float center[4];
+	// Half the size along every axis
+	float extent[4];
+
+	// For the CPU side tests, Warp::Math::Frustum::intersects is the same test as cull.comp
+	Warp::Math::Aabb toAabb() const {
+		return { { center[0], center[1], center[2] }, { extent[0], extent[1], extent[2] } };
+	}
+};
+
+// Frustum culling on the GPU. A compute shader tests the bounds of every object and appends a
+// vk::DrawIndexedIndirectCommand for each visible one, with the object index as firstInstance, plus the number of
+// commands written. draw then issues all of them with a single vkCmdDrawIndexedIndirectCount, so the CPU cost of a
+// frame no longer depends on the number of objects. The object buffer is also what the vertex shader reads through
+// gl_InstanceIndex, its descriptor set is shared with the graphics pipelines. Every frame in flight has its own
+// command and count buffers, the count is copied back so the visible objects can be reported.
+//
+// With a depth pyramid culling takes two phases, cull_occlusion.comp instead of cull.comp. cull tests the objects
+// against the frustum and the pyramid of the last frame, draw draws the visible ones and the occluded ones are kept
+// for cullLate. That tests them against the pyramid rebuilt from what draw drew, drawLate draws those that came back
+// into view. Objects only hidden by something that moved away are late for one phase, never missing for a frame.
+class GpuCuller {
+
+public:
+	static constexpr uint32_t WORKGROUP_SIZE = 64;
+	static constexpr uint32_t OBJECT_BINDING = 0, COMMAND_BINDING = 1, COUNT_BINDING = 2, RETEST_BINDING = 3, PYRAMID_BINDING = 4;
+
+	struct Statistics {
+		uint32_t objectCount = 0;
+		bool occlusion = false;
+		uint64_t dispatchCount = 0;
+		// Of the last frame that was read back, framesInFlight frames late
+		uint32_t visibleCount = 0;
+		// Summed over every frame read back. Objects outside the frustum, drawn by draw and by drawLate, and hidden from both.
+		uint64_t frameCount = 0;
+		uint64_t frustumCulledCount = 0;
+		uint64_t earlyDrawnCount = 0;
+		uint64_t lateDrawnCount = 0;
+		uint64_t occludedCount = 0;
+	};
+
+	GpuCuller() = default;
+
+	GpuCuller(const GpuCuller&) = delete;
+	GpuCuller& operator=(const GpuCuller&) = delete;
+
+	// The cull shaders pass the object index to the vertex shader as firstInstance of its draw command
+	static bool isSupported(vk::PhysicalDevice physicalDevice) {
+		auto chain = physicalDevice.getFeatures2<vk::PhysicalDeviceFeatures2, vk::PhysicalDeviceVulkan12Features>();
+		return chain.get<vk::PhysicalDeviceFeatures2>().features.drawIndirectFirstInstance
+			&& chain.get<vk::PhysicalDeviceVulkan12Features>().drawIndirectCount;
+	}
+
+	// Turns on what culling on the GPU needs in the features passed to the device create info
+	static void enableFeatures(vk::PhysicalDeviceFeatures& coreFeatures, vk::PhysicalDeviceVulkan12Features& features) {
+		coreFeatures.drawIndirectFirstInstance = VK_TRUE;
+		features.drawIndirectCount = VK_TRUE;
+	}
+
+	// Every object is drawn with indices [0, indexCount). The objects never change, they are uploaded once through the
+	// staging ring into device local memory, so its next flush has to be recorded before the first cull or draw. Without
+	// a cull shader only the objects and their descriptor sets are created, e.g. when culling on the CPU. With a pyramid
+	// the cull shader is cull_occlusion.comp, the pyramid has to outlive the culler.
+	void init(vk::Device device, GpuAllocator& allocator, StagingRing& stagingRing, uint32_t framesInFlight, const std::vector<ObjectBounds>& objects,
+		uint32_t indexCount, vk::ShaderModule cullShader = {}, vk::PipelineCache pipelineCache = {}, const DepthPyramid* pyramid = nullptr) {
+		this->device = device;
+		this->indexCount = indexCount;
+		this->pyramid = pyramid;
+		objectCount = static_cast<uint32_t>(objects.size());
+		statistics = {};
+		statistics.objectCount = objectCount;
+		statistics.occlusion = pyramid != nullptr;
+		uint32_t bindingCount = pyramid ? 5 : 3;
+
+		vk::DeviceSize objectSize = std::max<vk::DeviceSize>(sizeof(ObjectBounds) * objects.size(), sizeof(ObjectBounds));
+		objectBuffer = allocator.createBuffer(objectSize, vk::BufferUsageFlagBits::eStorageBuffer | vk::BufferUsageFlagBits::eTransferDst,
+			vk::MemoryPropertyFlagBits::eDeviceLocal);
+		if (!objects.empty()) {
+			stagingRing.upload(objectBuffer.get(), 0, objects.data(), sizeof(ObjectBounds) * objects.size());
+		}
+
+		vk::DescriptorSetLayoutBinding bindings[] = {
+			{ OBJECT_BINDING, vk::DescriptorType::eStorageBuffer, 1, vk::ShaderStageFlagBits::eCompute | vk::ShaderStageFlagBits::eVertex },
+			{ COMMAND_BINDING, vk::DescriptorType::eStorageBuffer, 1, vk::ShaderStageFlagBits::eCompute },
+			{ COUNT_BINDING, vk::DescriptorType::eStorageBuffer, 1, vk::ShaderStageFlagBits::eCompute },
+			{ RETEST_BINDING, vk::DescriptorType::eStorageBuffer, 1, vk::ShaderStageFlagBits::eCompute },
+			{ PYRAMID_BINDING, vk::DescriptorType::eCombinedImageSampler, 1, vk::ShaderStageFlagBits::eCompute }
+		};
+		vk::DescriptorSetLayoutCreateInfo layoutInfo{};
+		layoutInfo.bindingCount = bindingCount;
+		layoutInfo.pBindings = bindings;
+
+		vk::DescriptorPoolSize poolSizes[] = {
+			{ vk::DescriptorType::eStorageBuffer, (pyramid ? 4 : 3) * framesInFlight },
+			{ vk::DescriptorType::eCombinedImageSampler, framesInFlight }
+		};
+		vk::DescriptorPoolCreateInfo poolInfo{};
+		poolInfo.maxSets = framesInFlight;
+		poolInfo.poolSizeCount = pyramid ? 2 : 1;
+		poolInfo.pPoolSizes = poolSizes;
+
+		try {
+			setLayout = device.createDescriptorSetLayoutUnique(layoutInfo);
+			pool = device.createDescriptorPoolUnique(poolInfo);
+		}
+		catch (vk::SystemError err) {
+			throw std::runtime_error("failed to create culling descriptor sets!");
+		}
+
+		// Counts are copied to the host after every frame's culling, one set per frame slot
+		readbackBuffer = allocator.createBuffer(sizeof(Counts) * framesInFlight, vk::BufferUsageFlagBits::eTransferDst,
+			vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent);
+		std::memset(readbackBuffer.getMapped(), 0, sizeof(Counts) * framesInFlight);
+
+		frames.clear();
+		frames.resize(framesInFlight);
+		std::vector<vk::DescriptorSetLayout> setLayouts(framesInFlight, *setLayout);
+		vk::DescriptorSetAllocateInfo allocateInfo(*pool, framesInFlight, setLayouts.data());
+		std::vector<vk::DescriptorSet> sets = device.allocateDescriptorSets(allocateInfo);
+
+		// Room for the commands of both phases, the late ones start at objectCount
+		vk::DeviceSize commandSize = sizeof(vk::DrawIndexedIndirectCommand) * std::max(objectCount, 1u) * (pyramid ? 2 : 1);
+		vk::DeviceSize retestSize = sizeof(uint32_t) * std::max(objectCount, 1u);
+		for (uint32_t i = 0; i < framesInFlight; ++i) {
+			Frame& frame = frames[i];
+			frame.set = sets[i];
+			frame.commandBuffer = allocator.createBuffer(commandSize, vk::BufferUsageFlagBits::eStorageBuffer | vk::BufferUsageFlagBits::eIndirectBuffer,
+				vk::MemoryPropertyFlagBits::eDeviceLocal);
+			frame.countBuffer = allocator.createBuffer(sizeof(Counts), vk::BufferUsageFlagBits::eStorageBuffer | vk::BufferUsageFlagBits::eIndirectBuffer
+				| vk::BufferUsageFlagBits::eTransferDst | vk::BufferUsageFlagBits::eTransferSrc, vk::MemoryPropertyFlagBits::eDeviceLocal);
+			if (pyramid) {
+				frame.retestBuffer = allocator.createBuffer(retestSize, vk::BufferUsageFlagBits::eStorageBuffer, vk::MemoryPropertyFlagBits::eDeviceLocal);
+			}
+
+			vk::DescriptorBufferInfo bufferInfos[] = {
+				{ objectBuffer.get(), 0, VK_WHOLE_SIZE },
+				{ frame.commandBuffer.get(), 0, VK_WHOLE_SIZE },
+				{ frame.countBuffer.get(), 0, VK_WHOLE_SIZE },
+				{ pyramid ? frame.retestBuffer.get() : vk::Buffer(), 0, VK_WHOLE_SIZE }
+			};
+			vk::DescriptorImageInfo pyramidInfo;
+			std::vector<vk::WriteDescriptorSet> writes;
+			for (uint32_t binding = 0; binding < (pyramid ? 4u : 3u); ++binding) {
+				writes.push_back(vk::WriteDescriptorSet(frame.set, binding, 0, 1, vk::DescriptorType::eStorageBuffer, nullptr, &bufferInfos[binding]));
+			}
+			if (pyramid) {
+				pyramidInfo = vk::DescriptorImageInfo(pyramid->getSampler(), pyramid->getView(), vk::ImageLayout::eGeneral);
+				writes.push_back(vk::WriteDescriptorSet(frame.set, PYRAMID_BINDING, 0, 1, vk::DescriptorType::eCombinedImageSampler, &pyramidInfo));
+			}
+			device.updateDescriptorSets(writes, nullptr);
+		}
+
+		if (cullShader) {
+			createPipeline(cullShader, pipelineCache);
+		}
+	}
+
+	// The fence of the frame slot has to be waited on, which makes the count of its last dispatch readable. Returns
+	// whether there was one.
+	bool beginFrame(uint32_t frame) {
+		currentFrame = frame;
+		if (!frames[frame].dispatched) {
+			return false;
+		}
+		const Counts& counts = static_cast<const Counts*>(readbackBuffer.getMapped())[frame];
+		statistics.visibleCount = counts.early + counts.late;
+		++statistics.frameCount;
+		statistics.frustumCulledCount += objectCount - counts.early - counts.retest;
+		statistics.earlyDrawnCount += counts.early;
+		statistics.lateDrawnCount += counts.late;
+		statistics.occludedCount += counts.retest - counts.late;
+		frames[frame].dispatched = false;
+		return true;
+	}
+
+	// Culls the objects against the frustum, and the pyramid if there is one, outside of a render pass. The commands
+	// are ready for the draw indirect stage of everything recorded after it, the counts show up in the statistics once
+	// the frame slot comes around. The column major view projection matrix is only used with a pyramid.
+	void cull(vk::CommandBuffer commandBuffer, const Warp::Math::Frustum& frustum, const float* viewProjection) {
+		Frame& frame = frames[currentFrame];
+
+		commandBuffer.fillBuffer(frame.countBuffer.get(), 0, sizeof(Counts), 0);
+		vk::MemoryBarrier clearBarrier(vk::AccessFlagBits::eTransferWrite, vk::AccessFlagBits::eShaderRead | vk::AccessFlagBits::eShaderWrite);
+		commandBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eTransfer, vk::PipelineStageFlagBits::eComputeShader,
+			vk::DependencyFlags(), clearBarrier, nullptr, nullptr);
+
+		commandBuffer.bindPipeline(vk::PipelineBindPoint::eCompute, *pipeline);
+		commandBuffer.bindDescriptorSets(vk::PipelineBindPoint::eCompute, *pipelineLayout, 0, frame.set, nullptr);
+		if (pyramid) {
+			std::memcpy(occlusionConstants.viewProjection, viewProjection, sizeof(occlusionConstants.viewProjection));
+			occlusionConstants.pyramidSize[0] = float(pyramid->getExtent().width);
+			occlusionConstants.pyramidSize[1] = float(pyramid->getExtent().height);
+			occlusionConstants.objectCount = objectCount;
+			occlusionConstants.indexCount = indexCount;
+			occlusionConstants.levelCount = pyramid->getLevelCount();
+			occlusionConstants.phase = 0;
+			commandBuffer.pushConstants(*pipelineLayout, vk::ShaderStageFlagBits::eCompute, 0, sizeof(occlusionConstants), &occlusionConstants);
+		}
+		else {
+			CullConstants constants;
+			for (uint32_t i = 0; i < Warp::Math::Frustum::PLANE_COUNT; ++i) {
+				frustum.planes[i].store(constants.planes[i]);
+			}
+			constants.objectCount = objectCount;
+			constants.indexCount = indexCount;
+			commandBuffer.pushConstants(*pipelineLayout, vk::ShaderStageFlagBits::eCompute, 0, sizeof(constants), &constants);
+		}
+		commandBuffer.dispatch((objectCount + WORKGROUP_SIZE - 1) / WORKGROUP_SIZE, 1, 1);
+		++statistics.dispatchCount;
+
+		if (pyramid) {
+			// The retest list is read by cullLate
+			vk::MemoryBarrier cullBarrier(vk::AccessFlagBits::eShaderWrite, vk::AccessFlagBits::eIndirectCommandRead | vk::AccessFlagBits::eShaderRead);
+			commandBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eComputeShader, vk::PipelineStageFlagBits::eDrawIndirect | vk::PipelineStageFlagBits::eComputeShader,
+				vk::DependencyFlags(), cullBarrier, nullptr, nullptr);
+			return;
+		}
+		finishFrame(commandBuffer);
+	}
+
+	// Tests the objects cull found occluded against the pyramid, which has been rebuilt since, outside of a render pass
+	void cullLate(vk::CommandBuffer commandBuffer) {
+		Frame& frame = frames[currentFrame];
+
+		occlusionConstants.phase = 1;
+		commandBuffer.bindPipeline(vk::PipelineBindPoint::eCompute, *pipeline);
+		commandBuffer.bindDescriptorSets(vk::PipelineBindPoint::eCompute, *pipelineLayout, 0, frame.set, nullptr);
+		commandBuffer.pushConstants(*pipelineLayout, vk::ShaderStageFlagBits::eCompute, 0, sizeof(occlusionConstants), &occlusionConstants);
+		commandBuffer.dispatch((objectCount + WORKGROUP_SIZE - 1) / WORKGROUP_SIZE, 1, 1);
+		++statistics.dispatchCount;
+
+		finishFrame(commandBuffer);
+	}
+
+	// Draws the visible objects with the index and vertex buffers, pipeline and object set already bound, in a render
+	// pass recorded after cull
+	void draw(vk::CommandBuffer commandBuffer) const {
+		const Frame& frame = frames[currentFrame];
+		commandBuffer.drawIndexedIndirectCount(frame.commandBuffer.get(), 0, frame.countBuffer.get(), offsetof(Counts, early), objectCount,
+			sizeof(vk::DrawIndexedIndirectCommand));
+	}
+
+	// Draws the objects cullLate found visible again, like draw, in a render pass recorded after cullLate
+	void drawLate(vk::CommandBuffer commandBuffer) const {
+		const Frame& frame = frames[currentFrame];
+		commandBuffer.drawIndexedIndirectCount(frame.commandBuffer.get(), sizeof(vk::DrawIndexedIndirectCommand) * objectCount,
+			frame.countBuffer.get(), offsetof(Counts, late), objectCount, sizeof(vk::DrawIndexedIndirectCommand));
+	}
+
+	// Points the descriptor sets at the pyramid again after it has been recreated, e.g. for a resized depth buffer. No
+	// frame using the sets may still be pending.
+	void updatePyramid() {
+		vk::DescriptorImageInfo pyramidInfo(pyramid->getSampler(), pyramid->getView(), vk::ImageLayout::eGeneral);
+		std::vector<vk::WriteDescriptorSet> writes;
+		for (const Frame& frame : frames) {
+			writes.push_back(vk::WriteDescriptorSet(frame.set, PYRAMID_BINDING, 0, 1, vk::DescriptorType::eCombinedImageSampler, &pyramidInfo));
+		}
+		device.updateDescriptorSets(writes, nullptr);
+	}
+
+	// Binding OBJECT_BINDING holds the objects, the others belong to the cull shader
+	vk::DescriptorSetLayout getSetLayout() const {
+		return *setLayout;
+	}
+
+	vk::DescriptorSet getSet() const {
+		return frames[currentFrame].set;
+	}
+
+	const Statistics& getStatistics() const {
+		return statistics;
+	}
+
+private:
+	// Push constants of cull.comp
+	struct CullConstants {
+		float planes[Warp::Math::Frustum::PLANE_COUNT][4];
+		uint32_t objectCount;
+		uint32_t indexCount;
+	};
+
+	// Push constants of cull_occlusion.comp
+	struct OcclusionConstants {
+		float viewProjection[16];
+		float pyramidSize[2];
+		uint32_t objectCount;
+		uint32_t indexCount;
+		uint32_t levelCount;
+		uint32_t phase;
+	};
+
+	// Contents of a count buffer, without a pyramid only early is written
+	struct Counts {
+		uint32_t early;
+		uint32_t retest;
+		uint32_t late;
+		uint32_t padding;
+	};
+
+	struct Frame {
+		vk::DescriptorSet set;
+		GpuBuffer commandBuffer;
+		GpuBuffer countBuffer;
+		GpuBuffer retestBuffer;
+		bool dispatched = false;
+	};
+
+	vk::Device device;
+	const DepthPyramid* pyramid = nullptr;
+	OcclusionConstants occlusionConstants = {};
+	uint32_t objectCount = 0;
+	uint32_t indexCount = 0;
+	GpuBuffer objectBuffer;
+	GpuBuffer readbackBuffer;
+	vk::UniqueDescriptorSetLayout setLayout;
+	// Freeing the pool frees the sets
+	vk::UniqueDescriptorPool pool;
+	vk::UniquePipelineLayout pipelineLayout;
+	vk::UniquePipeline pipeline;
+	std::vector<Frame> frames;
+	uint32_t currentFrame = 0;
+	Statistics statistics;
+
+	// Makes the commands ready for the draw indirect stage and copies the counts back
+	void finishFrame(vk::CommandBuffer commandBuffer) {
+		Frame& frame = frames[currentFrame];
+
+		vk::MemoryBarrier cullBarrier(vk::AccessFlagBits::eShaderWrite, vk::AccessFlagBits::eIndirectCommandRead | vk::AccessFlagBits::eTransferRead);
+		commandBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eComputeShader, vk::PipelineStageFlagBits::eDrawIndirect | vk::PipelineStageFlagBits::eTransfer,
+			vk::DependencyFlags(), cullBarrier, nullptr, nullptr);
+
+		commandBuffer.copyBuffer(frame.countBuffer.get(), readbackBuffer.get(), vk::BufferCopy(0, sizeof(Counts) * currentFrame, sizeof(Counts)));
+		vk::MemoryBarrier readbackBarrier(vk::AccessFlagBits::eTransferWrite, vk::AccessFlagBits::eHostRead);
+		commandBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eTransfer, vk::PipelineStageFlagBits::eHost,
+			vk::DependencyFlags(), readbackBarrier, nullptr, nullptr);
+
+		frame.dispatched = true;
+	}
+
+	void createPipeline(vk::ShaderModule cullShader, vk::PipelineCache pipelineCache) {
+		vk::PushConstantRange pushConstantRange(vk::ShaderStageFlagBits::eCompute, 0,
+			pyramid ? sizeof(OcclusionConstants) : sizeof(CullConstants));
+		vk::PipelineLayoutCreateInfo pipelineLayoutInfo{};
+		pipelineLayoutInfo.setLayoutCount = 1;
+		pipelineLayoutInfo.pSetLayouts = &*setLayout;
+		pipelineLayoutInfo.pushConstantRangeCount = 1;
+		pipelineLayoutInfo.pPushConstantRanges = &pushConstantRange;
+
+		vk::ComputePipelineCreateInfo pipelineInfo{};
+		pipelineInfo.stage = vk::PipelineShaderStageCreateInfo(vk::PipelineShaderStageCreateFlags(), vk::ShaderStageFlagBits::eCompute, cullShader, "main");
+
+		try {
+			pipelineLayout = device.createPipelineLayoutUnique(pipelineLayoutInfo);
+			pipelineInfo.layout = *pipelineLayout;
+			pipeline = std::move(device.createComputePipelineUnique(pipelineCache, pipelineInfo).value);
+		}
+		catch (vk::SystemError err) {
+			throw std::runtime_error("failed to create culling pipeline!");
+		}
+	}
+};
\ No newline at end of file
@@ -0,0 +1,382 @@
+#pragma once
+#include <vulkan/vulkan.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <ostream>
+#include <stdexcept>
+#include <vector>
+
+// Span on the steady clock in nanoseconds, the clock Warp::Profiler records its CPU zones with
+struct TraceEvent {
+	const char* name;
+	uint64_t start;
+	uint64_t end;
+};
+
+// Times zones of the GPU work with timestamp queries and counts the work of some of them with pipeline statistics
+// queries. Every frame slot has its own query pools, their results are read when the slot comes around again, i.e.
+// frame n reads frame n - framesInFlight, whose timeline value has already been waited on, so reading never stalls.
+// GPU timestamps are mapped onto the steady clock with an offset measured by calibrate, which lets the zones be
+// written into one trace together with CPU events.
+class GpuProfiler {
+
+public:
+	// Timestamp zones and pipeline statistics zones per frame, further zones of the frame are dropped
+	static constexpr uint32_t MAX_ZONES = 64;
+	static constexpr uint32_t MAX_STATISTICS_ZONES = 4;
+	static constexpr uint32_t NO_ZONE = ~0u;
+
+	struct PipelineStatistics {
+		uint64_t inputAssemblyVertices = 0;
+		uint64_t inputAssemblyPrimitives = 0;
+		uint64_t vertexShaderInvocations = 0;
+		uint64_t clippingPrimitives = 0;
+		uint64_t fragmentShaderInvocations = 0;
+	};
+
+	// All frames of one zone name that have been read back
+	struct Zone {
+		const char* name;
+		// One sample per frame the zone was recorded in, oldest first
+		std::vector<double> ms;
+		// Summed over the statisticsFrames frames that counted the zone's pipeline statistics
+		PipelineStatistics statistics;
+		uint64_t statisticsFrames = 0;
+	};
+
+	// RAII zone, ends on the same command buffer it began on
+	class Scope {
+
+	public:
+		Scope(GpuProfiler& profiler, vk::CommandBuffer commandBuffer, const char* name, bool pipelineStatistics = false)
+			: profiler(profiler), commandBuffer(commandBuffer), zone(profiler.beginZone(commandBuffer, name, pipelineStatistics)) {}
+
+		~Scope() {
+			profiler.endZone(commandBuffer, zone);
+		}
+
+		Scope(const Scope&) = delete;
+		Scope& operator=(const Scope&) = delete;
+
+	private:
+		GpuProfiler& profiler;
+		vk::CommandBuffer commandBuffer;
+		uint32_t zone;
+	};
+
+	// Without timestamp support on the queue family every zone is a no-op. Pipeline statistics need the
+	// pipelineStatisticsQuery and, for zones around secondary command buffers, the inheritedQueries feature enabled.
+	void init(vk::PhysicalDevice physicalDevice, vk::Device device, uint32_t queueFamilyIndex, uint32_t framesInFlight, bool pipelineStatistics) {
+		this->device = device;
+		this->queueFamilyIndex = queueFamilyIndex;
+
+		uint32_t validBits = physicalDevice.getQueueFamilyProperties()[queueFamilyIndex].timestampValidBits;
+		timestampPeriod = physicalDevice.getProperties().limits.timestampPeriod;
+		timestampMask = validBits >= 64 ? ~0ull : (1ull << validBits) - 1;
+		enabled = validBits > 0;
+		statisticsFlags = pipelineStatistics && enabled ? STATISTICS_FLAGS : vk::QueryPipelineStatisticFlags();
+
+		slots.clear();
+		slots.resize(framesInFlight);
+		zones.clear();
+		traceEvents.clear();
+		droppedZones = 0;
+		if (!enabled) {
+			return;
+		}
+
+		try {
+			for (auto& slot : slots) {
+				slot.timestamps = device.createQueryPoolUnique({ vk::QueryPoolCreateFlags(), vk::QueryType::eTimestamp, 2 * MAX_ZONES });
+				if (statisticsFlags) {
+					slot.statistics = device.createQueryPoolUnique({ vk::QueryPoolCreateFlags(), vk::QueryType::ePipelineStatistics,
+						MAX_STATISTICS_ZONES, statisticsFlags });
+				}
+			}
+		}
+		catch (vk::SystemError err) {
+			throw std::runtime_error("failed to create query pools!");
+		}
+	}
+
+	// Writes one timestamp on an otherwise idle queue and pairs it with the steady clock once the queue is idle again.
+	// The wake up after the wait makes the GPU zones appear up to a few microseconds late relative to the CPU.
+	void calibrate(vk::Queue queue) {
+		if (!enabled) {
+			return;
+		}
+
+		vk::UniqueCommandPool pool;
+		vk::UniqueCommandBuffer commandBuffer;
+		try {
+			pool = device.createCommandPoolUnique({ vk::CommandPoolCreateFlagBits::eTransient, queueFamilyIndex });
+			commandBuffer = std::move(device.allocateCommandBuffersUnique({ *pool, vk::CommandBufferLevel::ePrimary, 1 })[0]);
+
+			commandBuffer->begin({ vk::CommandBufferUsageFlagBits::eOneTimeSubmit });
+			commandBuffer->resetQueryPool(*slots[0].timestamps, 0, 1);
+			commandBuffer->writeTimestamp(vk::PipelineStageFlagBits::eBottomOfPipe, *slots[0].timestamps, 0);
+			commandBuffer->end();
+
+			vk::SubmitInfo submitInfo{};
+			submitInfo.commandBufferCount = 1;
+			submitInfo.pCommandBuffers = &*commandBuffer;
+			queue.waitIdle();
+			queue.submit(submitInfo, nullptr);
+			queue.waitIdle();
+		}
+		catch (vk::SystemError err) {
+			throw std::runtime_error("failed to calibrate gpu timestamps!");
+		}
+		calibrationCpu = now();
+
+		if (device.getQueryPoolResults(*slots[0].timestamps, 0, 1, sizeof(calibrationGpu), &calibrationGpu, sizeof(uint64_t),
+			vk::QueryResultFlagBits::e64 | vk::QueryResultFlagBits::eWait) != vk::Result::eSuccess) {
+			throw std::runtime_error("failed to read calibration timestamp!");
+		}
+		calibrationGpu &= timestampMask;
+	}
+
+	// Keeps every zone read from now on as a trace event, see writeChromeTrace
+	void setCapture(bool capture) {
+		capturing = capture;
+	}
+
+	// Reads the results the slot's previous frame left behind and resets its queries. The GPU has to be done with that
+	// frame, and commandBuffer has to be outside of a render pass.
+	void beginFrame(vk::CommandBuffer commandBuffer, uint32_t slot) {
+		currentSlot = slot;
+		Slot& frame = slots[slot];
+		readSlot(frame);
+		frame.frame = ++frameCount;
+		if (!enabled) {
+			return;
+		}
+
+		commandBuffer.resetQueryPool(*frame.timestamps, 0, 2 * MAX_ZONES);
+		if (statisticsFlags) {
+			commandBuffer.resetQueryPool(*frame.statistics, 0, MAX_STATISTICS_ZONES);
+		}
+		activeStatistics = false;
+	}
+
+	// name has to outlive the profiler, e.g. a string literal. Only one pipeline statistics zone can be open at a
+	// time, and it has to begin and end outside of a render pass.
+	uint32_t beginZone(vk::CommandBuffer commandBuffer, const char* name, bool pipelineStatistics = false) {
+		Slot& frame = slots[currentSlot];
+		if (!enabled) {
+			return NO_ZONE;
+		}
+		if (frame.zones.size() == MAX_ZONES) {
+			++droppedZones;
+			return NO_ZONE;
+		}
+
+		uint32_t statisticsQuery = NO_ZONE;
+		if (pipelineStatistics && statisticsFlags) {
+			if (activeStatistics) {
+				throw std::runtime_error("pipeline statistics zones cannot overlap!");
+			}
+			if (frame.statisticsCount < MAX_STATISTICS_ZONES) {
+				statisticsQuery = frame.statisticsCount++;
+				commandBuffer.beginQuery(*frame.statistics, statisticsQuery, vk::QueryControlFlags());
+				activeStatistics = true;
+			}
+		}
+
+		uint32_t zone = static_cast<uint32_t>(frame.zones.size());
+		frame.zones.push_back({ name, statisticsQuery });
+		commandBuffer.writeTimestamp(vk::PipelineStageFlagBits::eTopOfPipe, *frame.timestamps, 2 * zone);
+		return zone;
+	}
+
+	void endZone(vk::CommandBuffer commandBuffer, uint32_t zone) {
+		if (zone == NO_ZONE) {
+			return;
+		}
+		Slot& frame = slots[currentSlot];
+		commandBuffer.writeTimestamp(vk::PipelineStageFlagBits::eBottomOfPipe, *frame.timestamps, 2 * zone + 1);
+		if (frame.zones[zone].statisticsQuery != NO_ZONE) {
+			commandBuffer.endQuery(*frame.statistics, frame.zones[zone].statisticsQuery);
+			activeStatistics = false;
+		}
+	}
+
+	// Reads the frames still in flight, oldest first. The GPU has to be idle.
+	void readPendingFrames() {
+		std::vector<Slot*> pending;
+		for (auto& slot : slots) {
+			if (!slot.zones.empty()) {
+				pending.push_back(&slot);
+			}
+		}
+		std::sort(pending.begin(), pending.end(), [](const Slot* left, const Slot* right) { return left->frame < right->frame; });
+		for (Slot* slot : pending) {
+			readSlot(*slot);
+		}
+	}
+
+	// Writes the CPU events on the main thread and the captured GPU zones on the graphics queue as chrome://tracing and
+	// Perfetto compatible trace_event JSON, the same format Warp::Profiler captures
+	void writeChromeTrace(std::ostream& out, const std::vector<TraceEvent>& cpuEvents) const {
+		uint64_t origin = ~0ull;
+		for (const auto& event : cpuEvents) {
+			origin = std::min(origin, event.start);
+		}
+		for (const auto& event : traceEvents) {
+			origin = std::min(origin, event.start);
+		}
+
+		out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+		out << "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":0,\"args\":{\"name\":\"CPU\"}},\n";
+		out << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":0,\"args\":{\"name\":\"Main thread\"}},\n";
+		out << "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"args\":{\"name\":\"GPU\"}},\n";
+		out << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":0,\"args\":{\"name\":\"Graphics queue\"}}";
+
+		// trace_event timestamps are microseconds
+		auto writeEvents = [&](const std::vector<TraceEvent>& events, uint32_t pid) {
+			for (const auto& event : events) {
+				out << ",\n{\"name\":\"" << event.name << "\",\"ph\":\"X\",\"pid\":" << pid << ",\"tid\":0"
+					<< ",\"ts\":" << (event.start - origin) / 1000.0
+					<< ",\"dur\":" << (event.end - event.start) / 1000.0 << "}";
+			}
+		};
+		writeEvents(cpuEvents, 0);
+		writeEvents(traceEvents, 1);
+		out << "\n]}\n";
+	}
+
+	static uint64_t now() {
+		return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+	}
+
+	// Flags to inherit into secondary command buffers executed inside a pipeline statistics zone, empty without support
+	vk::QueryPipelineStatisticFlags getPipelineStatisticsFlags() const {
+		return statisticsFlags;
+	}
+
+	const std::vector<Zone>& getZones() const {
+		return zones;
+	}
+
+	bool isEnabled() const {
+		return enabled;
+	}
+
+	// Nanoseconds per timestamp tick
+	float getTimestampPeriod() const {
+		return timestampPeriod;
+	}
+
+	// Zones that did not fit into their frame
+	uint64_t getDroppedZoneCount() const {
+		return droppedZones;
+	}
+
+private:
+	// In the order the statistics are written, which is the order of the flag bits
+	static constexpr vk::QueryPipelineStatisticFlags STATISTICS_FLAGS = vk::QueryPipelineStatisticFlagBits::eInputAssemblyVertices
+		| vk::QueryPipelineStatisticFlagBits::eInputAssemblyPrimitives
+		| vk::QueryPipelineStatisticFlagBits::eVertexShaderInvocations
+		| vk::QueryPipelineStatisticFlagBits::eClippingPrimitives
+		| vk::QueryPipelineStatisticFlagBits::eFragmentShaderInvocations;
+
+	struct PendingZone {
+		const char* name;
+		uint32_t statisticsQuery;
+	};
+
+	struct Slot {
+		vk::UniqueQueryPool timestamps, statistics;
+		// Zones recorded the last time the slot was used and not read yet
+		std::vector<PendingZone> zones;
+		uint32_t statisticsCount = 0;
+		// Order the slots were begun in
+		uint64_t frame = 0;
+	};
+
+	vk::Device device;
+	uint32_t queueFamilyIndex = 0;
+	bool enabled = false;
+	float timestampPeriod = 1.0f;
+	uint64_t timestampMask = ~0ull;
+	vk::QueryPipelineStatisticFlags statisticsFlags;
+
+	// Steady clock time the GPU timestamp calibrationGpu was taken at
+	uint64_t calibrationCpu = 0;
+	uint64_t calibrationGpu = 0;
+
+	std::vector<Slot> slots;
+	uint32_t currentSlot = 0;
+	uint64_t frameCount = 0;
+	bool activeStatistics = false;
+
+	std::vector<Zone> zones;
+	bool capturing = false;
+	std::vector<TraceEvent> traceEvents;
+	uint64_t droppedZones = 0;
+
+	std::vector<uint64_t> timestampResults;
+	std::vector<PipelineStatistics> statisticsResults;
+
+	// Maps a timestamp to the steady clock, ticks wrap around after timestampValidBits bits
+	uint64_t toCpuTime(uint64_t ticks) const {
+		return calibrationCpu + static_cast<uint64_t>(((ticks - calibrationGpu) & timestampMask) * double(timestampPeriod));
+	}
+
+	Zone& getZone(const char* name) {
+		for (auto& zone : zones) {
+			if (zone.name == name) {
+				return zone;
+			}
+		}
+		zones.push_back({ name });
+		return zones.back();
+	}
+
+	void readSlot(Slot& slot) {
+		if (slot.zones.empty()) {
+			return;
+		}
+		uint32_t zoneCount = static_cast<uint32_t>(slot.zones.size());
+
+		// Without eWait, eNotReady would mean the frame is not done yet, which the caller rules out
+		timestampResults.resize(2 * zoneCount);
+		vk::Result result = device.getQueryPoolResults(*slot.timestamps, 0, 2 * zoneCount, timestampResults.size() * sizeof(uint64_t),
+			timestampResults.data(), sizeof(uint64_t), vk::QueryResultFlagBits::e64);
+		if (result == vk::Result::eSuccess && slot.statisticsCount > 0) {
+			statisticsResults.resize(slot.statisticsCount);
+			result = device.getQueryPoolResults(*slot.statistics, 0, slot.statisticsCount, statisticsResults.size() * sizeof(PipelineStatistics),
+				statisticsResults.data(), sizeof(PipelineStatistics), vk::QueryResultFlagBits::e64);
+		}
+		if (result != vk::Result::eSuccess) {
+			throw std::runtime_error("failed to read gpu profiler queries!");
+		}
+
+		for (uint32_t i = 0; i < zoneCount; ++i) {
+			const PendingZone& pending = slot.zones[i];
+			uint64_t start = timestampResults[2 * i] & timestampMask;
+			uint64_t end = timestampResults[2 * i + 1] & timestampMask;
+			uint64_t ticks = (end - start) & timestampMask;
+
+			Zone& zone = getZone(pending.name);
+			zone.ms.push_back(ticks * double(timestampPeriod) / 1e6);
+			if (pending.statisticsQuery != NO_ZONE) {
+				const PipelineStatistics& statistics = statisticsResults[pending.statisticsQuery];
+				zone.statistics.inputAssemblyVertices += statistics.inputAssemblyVertices;
+				zone.statistics.inputAssemblyPrimitives += statistics.inputAssemblyPrimitives;
+				zone.statistics.vertexShaderInvocations += statistics.vertexShaderInvocations;
+				zone.statistics.clippingPrimitives += statistics.clippingPrimitives;
+				zone.statistics.fragmentShaderInvocations += statistics.fragmentShaderInvocations;
+				++zone.statisticsFrames;
+			}
+			if (capturing) {
+				uint64_t cpuStart = toCpuTime(start);
+				traceEvents.push_back({ pending.name, cpuStart, cpuStart + static_cast<uint64_t>(ticks * double(timestampPeriod)) });
+			}
+		}
+		slot.zones.clear();
+		slot.statisticsCount = 0;
+	}
+};
\ No newline at end of file
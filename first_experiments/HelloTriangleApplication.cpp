@@ -1,6 +1,24 @@
 #include <vulkan/vulkan.hpp>
 #include <GLFW/glfw3.h>
 
+#include "AssetArchive.h"
+#include "AsyncQueue.h"
+#include "BindlessTable.h"
+#include "CommandRecorder.h"
+#include "DepthPyramid.h"
+#include "DescriptorAllocator.h"
+#include "FrameSync.h"
+#include "GpuAllocator.h"
+#include "GpuCuller.h"
+#include "GpuProfiler.h"
+#include "PipelineCache.h"
+#include "PipelineManager.h"
+#include "QuadBatch.h"
+#include "RenderGraph.h"
+#include "StagingRing.h"
+#include "SwapChain.h"
+#include "WorkerPool.h"
+
 #include <iostream>
 #include <stdexcept>
 #include <vector>
@@ -10,14 +28,111 @@
 #include <optional>
 #include <algorithm>
 #include <fstream>
+#include <chrono>
+#include <array>
+#include <cstddef>
+#include <cmath>
+#include <random>
 
 const uint32_t WIDTH = 800, HEIGHT = 600;
-const int MAX_FRAMES_IN_FLIGHT = 2;
+// Render targets cycled through in headless mode, in place of the swap chain images
+const uint32_t OFFSCREEN_IMAGE_COUNT = 3;
+// Of the depth buffer occlusion culling draws the objects into and samples for the depth pyramid
+const vk::Format DEPTH_FORMAT = vk::Format::eD32Sfloat;
 
 const std::vector<const char*> validationLayers = {
 	"VK_LAYER_KHRONOS_validation"
 };
 
+// Ring space for the uploads of all frames in flight
+const vk::DeviceSize STAGING_RING_SIZE = 4 * 1024 * 1024;
+
+struct Vertex {
+	float position[2];
+	float color[3];
+
+	static vk::VertexInputBindingDescription getBindingDescription() {
+		return vk::VertexInputBindingDescription(0, sizeof(Vertex), vk::VertexInputRate::eVertex);
+	}
+
+	static std::array<vk::VertexInputAttributeDescription, 2> getAttributeDescriptions() {
+		return {
+			vk::VertexInputAttributeDescription(0, 0, vk::Format::eR32G32Sfloat, offsetof(Vertex, position)),
+			vk::VertexInputAttributeDescription(1, 0, vk::Format::eR32G32B32Sfloat, offsetof(Vertex, color))
+		};
+	}
+};
+
+const std::vector<Vertex> vertices = {
+	{ { -1.0f, -1.0f }, { 0.0f, 0.0f, 1.0f } },
+	{ { 0.0f, -1.0f }, { 0.0f, 1.0f, 0.0f } },
+	{ { 0.0f, 0.0f }, { 1.0f, 0.0f, 0.0f } },
+	{ { 1.0f, 1.0f }, { 0.0f, 0.0f, 1.0f } },
+	{ { 0.0f, 0.0f }, { 0.0f, 1.0f, 0.0f } },
+	{ { 0.0f, 1.0f }, { 1.0f, 0.0f, 0.0f } }
+};
+
+const std::vector<uint16_t> indices = {
+	0, 1, 2, 3, 4, 5
+};
+
+// Pipelines the quad batch is drawn with, indexed by the pipeline a quad is added with
+const uint32_t QUAD_PIPELINE_OPAQUE = 0, QUAD_PIPELINE_BLENDED = 1;
+// Texture indices the generated quads are spread across
+const uint32_t QUAD_TEXTURE_COUNT = 4;
+
+// Textures and materials the triangle draws cycle through, draw i uses texture i % DRAW_TEXTURE_COUNT and material
+// i % MATERIAL_COUNT. The textures are cleared to a single color each, a material is one tint color.
+const uint32_t DRAW_TEXTURE_COUNT = 4, MATERIAL_COUNT = 16;
+const uint32_t DRAW_TEXTURE_SIZE = 4;
+
+// Room in the bindless table, far more than the draws use
+const uint32_t BINDLESS_TEXTURE_CAPACITY = 4096, BINDLESS_BUFFER_CAPACITY = 4096;
+// Per draw sets in every pool of the per frame descriptor allocator
+const uint32_t DESCRIPTOR_SETS_PER_POOL = 1024;
+
+// Of the render graph sample
+const uint32_t SHADOW_MAP_SIZE = 2048;
+
+// Particles of the background compute work, each dispatch integrates all of them over this many steps
+const uint32_t BACKGROUND_PARTICLE_COUNT = 65536;
+const uint32_t BACKGROUND_STEPS = 256;
+
+// The culled objects are spread over a cube of this half size around the camera, each a square of a random size
+const float OBJECT_FIELD_EXTENT = 100.0f;
+const float OBJECT_MIN_SIZE = 0.25f, OBJECT_MAX_SIZE = 1.0f;
+// The first objects are large squares on a ring around the camera, which hide much of what lies behind them
+const uint32_t OCCLUDER_COUNT = 32;
+const float OCCLUDER_DISTANCE = 20.0f, OCCLUDER_SIZE = 8.0f;
+// Of the camera looking at the objects, in radians
+const float OBJECT_CAMERA_FOV = 1.0f;
+const float OBJECT_CAMERA_TURN_PER_FRAME = 0.01f;
+
+// Storage buffer contents of a material
+struct Material {
+	float tint[4];
+};
+
+// Push constants of the object draws, the squares are turned towards the camera along its right and up vectors
+struct ObjectCamera {
+	float viewProjection[16];
+	float right[4];
+	float up[4];
+};
+
+// Push constants of the background compute work
+struct BackgroundWork {
+	uint32_t count;
+	uint32_t steps;
+	float time;
+};
+
+// Push constants of a triangle draw when the resources are bindless
+struct DrawIndices {
+	uint32_t textureIndex;
+	uint32_t materialIndex;
+};
+
 const std::vector<const char*> deviceExtensions = {
 	VK_KHR_SWAPCHAIN_EXTENSION_NAME
 };
@@ -30,92 +145,439 @@ const bool enableValidationLayers = true;
 
 struct QueueFamilyIndices {
 	std::optional<uint32_t> graphicsFamily, presentFamily;
+	// Families without graphics, for work next to the frames, the transfer family has no compute either
+	std::optional<uint32_t> computeFamily, transferFamily;
+
+	bool isComplete(bool presentRequired = true) {
+		return graphicsFamily.has_value() && (!presentRequired || presentFamily.has_value());
+	}
+};
+
+// How the triangle draws get their texture and material
+enum class DescriptorMode {
+	// Vertex colors only, no descriptor sets at all
+	None,
+	// One descriptor set per draw, allocated from the per frame pools, written and bound for every draw
+	PerDraw,
+	// The bindless table is bound once, every draw pushes the indices of its resources
+	Bindless
+};
+
+inline const char* toString(DescriptorMode mode) {
+	switch (mode) {
+	case DescriptorMode::None: return "none";
+	case DescriptorMode::PerDraw: return "per-draw";
+	case DescriptorMode::Bindless: return "bindless";
+	}
+	return "unknown";
+}
+
+// Where the objects are culled against the camera frustum
+enum class CullingMode {
+	// Every frame on the main thread, every visible object is one draw recorded by the recording threads
+	Cpu,
+	// By a compute shader writing the draws, all objects are drawn with one indirect draw
+	Gpu
+};
 
-	bool isComplete() {
-		return graphicsFamily.has_value() && presentFamily.has_value();
+inline const char* toString(CullingMode mode) {
+	switch (mode) {
+	case CullingMode::Cpu: return "cpu";
+	case CullingMode::Gpu: return "gpu";
 	}
+	return "unknown";
+}
+
+struct RenderSettings {
+	// Renders into offscreen images without a window, surface or swap chain
+	bool headless = false;
+	// Stops after this many frames, 0 runs until the window is closed
+	uint32_t frameCount = 0;
+	// Frames the CPU may run ahead of the GPU, 1 to 4
+	uint32_t framesInFlight = 2;
+	// Present mode and image count of the window's swap chain
+	SwapChainSettings swapChain;
+	// Pipeline cache file loaded at device creation and saved at shutdown, empty disables the cache
+	std::string pipelineCachePath = "pipeline_cache.bin";
+	// Variations of the triangle pipeline, requested at startup and used round robin by the draws, up to 360 differ
+	uint32_t pipelinePermutations = 0;
+	// Compilations of the variations and the blended quad pipeline running at once on the worker pool while the first
+	// frames are drawn with their fallbacks, 0 compiles everything before the first frame
+	uint32_t pipelineThreads = 2;
+	// Creates the variations as derivatives of the pipeline they fall back to
+	bool pipelineDerivatives = true;
+	// Bindless falls back to per draw sets on devices without the descriptor indexing features
+	DescriptorMode descriptorMode = DescriptorMode::Bindless;
+	// Packed by AssetPacker from the compiled shaders, see shaders/compile.bat
+	std::string assetArchivePath = "shaders/shaders.wpak";
+	// Draws recorded every frame, split across the recording threads
+	uint32_t drawCount = 1;
+	uint32_t recordThreads = 1;
+	// Objects scattered around a turning camera, culled and drawn after the triangle draws, 0 disables them
+	uint32_t objectCount = 0;
+	// Gpu falls back to Cpu on devices without drawIndirectCount or drawIndirectFirstInstance
+	CullingMode cullingMode = CullingMode::Gpu;
+	// Culls the objects hidden behind others too, in two phases against a depth pyramid, only when culling on the GPU.
+	// Not with the render graph, whose passes have no place for the culling and the pyramid.
+	bool occlusionCulling = false;
+	// Animated quads generated and drawn through the quad batch every frame, 0 disables the batch
+	uint32_t quadCount = 0;
+	// Threads filling and copying the quad instances
+	uint32_t batchThreads = 1;
+	// CPU and GPU zones of every frame written as trace_event JSON at shutdown, empty disables the trace
+	std::string tracePath;
+	// Builds the frame with the render graph sample, shadow, G-buffer, lighting, tonemapping and composite passes in
+	// front of the scene. A resize of the window waits for the device and declares the graph again at the new size.
+	bool renderGraph = false;
+	// Background work of every frame that the frame after acquires, stand ins for a simulation and for streaming:
+	// dispatches of a compute shader and bytes copied into a device local buffer. 0 disables either.
+	uint32_t backgroundDispatches = 0;
+	uint32_t backgroundUploadBytes = 0;
+	// Submits the background work to a compute only and a transfer only queue, where the device has such families,
+	// so it overlaps with the frames. Uploads go to the compute queue without a transfer family. Otherwise the work
+	// is recorded into the frame's command buffer.
+	bool asyncQueues = true;
 };
 
-struct SwapChainSupportDetails {
-	vk::SurfaceCapabilitiesKHR capabilities;
-	std::vector<vk::SurfaceFormatKHR> formats;
-	std::vector<vk::PresentModeKHR> presentModes;
+// Per frame CPU timings in milliseconds, collected by mainLoop
+struct FrameTimings {
+	std::string deviceName;
+	double totalSeconds = 0.0;
+
+	// Whole drawFrame call
+	std::vector<double> cpuFrameMs;
+	// Filling and sorting the quad instances
+	std::vector<double> batchMs;
+	// Culling the objects on the CPU, or only setting up the GPU culling
+	std::vector<double> cullMs;
+	// Recording the frame's command buffers
+	std::vector<double> recordMs;
+	// Time spent inside vkQueueSubmit
+	std::vector<double> submitMs;
+	// From acquiring the swap chain image until its present call returned, empty when headless
+	std::vector<double> acquireToPresentMs;
+	// Time blocked waiting for the GPU to free the frame slot and in the image acquisition
+	std::vector<double> stallMs;
+
+	// Present mode and image count the swap chain ended up with and how often it was recreated, e.g. for resizes
+	std::string presentMode;
+	uint32_t swapChainImages = 0;
+	uint32_t swapChainRecreations = 0;
+
+	// Startup time spent creating pipelines, warm if the pipeline cache was loaded from disk
+	double pipelineCreationMs = 0.0;
+	bool pipelineCacheWarm = false;
+	// From the start of run until the first frame was submitted
+	double timeToFirstFrameMs = 0.0;
+	// Frames drawn, partly with fallback pipelines, before every pipeline was compiled, and the time until then
+	uint32_t pipelinesReadyFrame = 0;
+	double pipelinesReadyMs = 0.0;
+	PipelineManager::Statistics pipelines;
+
+	// The mode the draws ended up with and the descriptor work of the whole run
+	DescriptorMode descriptorMode = DescriptorMode::None;
+	DescriptorAllocator::Statistics descriptorSets;
+	BindlessTable::Statistics bindless;
+
+	// The mode the objects ended up with and the objects that passed culling, per frame. GPU counts are read back
+	// framesInFlight frames late, so the last frames are missing. The culler's statistics tell whether the objects
+	// were occlusion culled and how many each phase kept.
+	CullingMode cullingMode = CullingMode::Cpu;
+	std::vector<double> visibleObjects;
+	GpuCuller::Statistics culler;
+
+	// Whether the background work ended up on async queues and what they did, the upload queue may be the compute one
+	bool asyncCompute = false;
+	bool asyncUpload = false;
+	AsyncQueue::Statistics computeQueue, transferQueue;
 };
 
 class HelloTriangleApplication {
 
 public:
+	explicit HelloTriangleApplication(const RenderSettings& settings = {}) : settings(settings) {}
+
 	void run() {
-		initWindow();
+		if (settings.headless && settings.frameCount == 0) {
+			throw std::runtime_error("headless rendering needs a frame count!");
+		}
+		if (settings.framesInFlight < FrameSync::MIN_FRAMES_IN_FLIGHT || settings.framesInFlight > FrameSync::MAX_FRAMES_IN_FLIGHT) {
+			throw std::runtime_error("frames in flight have to be between 1 and 4!");
+		}
+		if (settings.occlusionCulling && settings.renderGraph) {
+			throw std::runtime_error("occlusion culling does not work with the render graph!");
+		}
+
+		runStart = Clock::now();
+		if (!settings.headless) {
+			initWindow();
+		}
 		initVulkan();
 		mainLoop();
 		cleanup();
 	}
+
+	const FrameTimings& getFrameTimings() const {
+		return frameTimings;
+	}
+
+	GpuAllocator::Statistics getGpuMemoryStatistics() const {
+		return gpuAllocator.getStatistics();
+	}
+
+	const StagingRing::Statistics& getStagingStatistics() const {
+		return stagingRing.getStatistics();
+	}
+
+	const QuadBatch::Statistics& getQuadStatistics() const {
+		return quadBatch.getStatistics();
+	}
+
+	const GpuProfiler& getGpuProfiler() const {
+		return gpuProfiler;
+	}
+
+	const RenderGraph::Statistics& getRenderGraphStatistics() const {
+		return renderGraph.getStatistics();
+	}
 	
 private:
+	using Clock = std::chrono::steady_clock;
 
-	GLFWwindow* window;
+	RenderSettings settings;
+	FrameTimings frameTimings;
+
+	AssetArchive assetArchive;
+
+	GLFWwindow* window = nullptr;
 
 	vk::UniqueInstance vkInstance;
 	vk::UniqueSurfaceKHR vkSurface;
 
 	vk::PhysicalDevice vkPhysicalDevice;
 	vk::UniqueDevice vkDevice;
+	// Pipeline statistics queries and inheriting them into secondary command buffers are both supported
+	bool pipelineStatisticsSupported = false;
+	// Of the draws, the requested one unless the device lacks descriptor indexing
+	DescriptorMode descriptorMode = DescriptorMode::None;
+	// Of the objects, the requested one unless the device lacks drawIndirectCount or drawIndirectFirstInstance
+	CullingMode cullingMode = CullingMode::Cpu;
+	// Requested and culling on the GPU
+	bool occlusionCulling = false;
+	PipelineCache pipelineCache;
+	BindlessTable bindlessTable;
+	DescriptorAllocator descriptorAllocator;
+	vk::UniqueDescriptorSetLayout drawSetLayout;
+	vk::UniqueSampler textureSampler;
+	// Declared before everything allocated from it, so it is destroyed last
+	GpuAllocator gpuAllocator;
+	StagingRing stagingRing;
+	GpuBuffer vertexBuffer, indexBuffer;
+	// Draw textures and the materials, one tint per materialStride bytes
+	std::vector<GpuImage> drawTextures;
+	std::vector<vk::UniqueImageView> drawTextureViews;
+	bool drawTexturesCleared = false;
+	GpuBuffer materialBuffer;
+	vk::DeviceSize materialStride = 0;
+	// Indices into the bindless table
+	std::vector<uint32_t> drawTextureIndices, materialIndices;
+	// Shared by the quad batch, the pipeline manager and the command recorder, declared before them so it outlives them
+	WorkerPool workerPool;
+	QuadBatch quadBatch;
+	GpuProfiler gpuProfiler;
+	// Read by the culler, so declared before it
+	DepthPyramid depthPyramid;
+	// Owns the object buffer in both culling modes
+	GpuCuller culler;
+	std::vector<ObjectBounds> objects;
+	// Camera of the current frame and the objects that passed culling on the CPU
+	ObjectCamera objectCamera = {};
+	Warp::Math::Frustum objectFrustum = {};
+	std::vector<uint32_t> visibleObjects;
 
 	vk::Queue graphicsQueue, presentQueue;
+	// Dedicated queues of the background work, only created when it uses them
+	AsyncQueue computeQueue, transferQueue;
+	AsyncQueue* uploadQueue = nullptr;
+	uint32_t graphicsFamily = 0;
+
+	std::vector<GpuImage> offscreenImages;
 	 
-	vk::UniqueSwapchainKHR swapChain;
-	std::vector<vk::Image> swapChainImages;
-	std::vector<vk::UniqueImageView> swapChainImageViews;
-	std::vector<vk::UniqueFramebuffer> swapChainFramebuffers;
+	// Windowed rendering goes through the swap chain, headless rendering into the offscreen images
+	SwapChain swapChain;
+	bool framebufferResized = false;
+	std::vector<vk::UniqueImageView> offscreenImageViews;
+	std::vector<vk::UniqueFramebuffer> offscreenFramebuffers;
+	// Shared by all offscreen or swap chain images, only with occlusion culling
+	GpuImage depthImage;
+	vk::UniqueImageView depthImageView;
+	// Of the images currently rendered to
 	vk::Format swapChainImageFormat;
 	vk::Extent2D swapChainExtent;
 
-	vk::UniqueRenderPass renderPass;
+	// The scene's render pass, hand built or taken from the render graph. With occlusion culling the late pass draws
+	// the objects of the second phase on top.
+	vk::UniqueRenderPass renderPass, lateRenderPass;
+	RenderGraph renderGraph;
+	RenderGraph::ResourceId graphOutput = 0;
+	RenderGraph::PassId scenePass = 0;
 	vk::UniquePipelineLayout pipelineLayout;
-	vk::UniquePipeline graphicsPipeline;
-	vk::UniqueCommandPool commandPool;
-	std::vector<vk::UniqueCommandBuffer> commandBuffers;
-
-	std::vector<vk::UniqueSemaphore> imageAvailableSemaphores, renderFinishedSemaphores;
-	std::vector<vk::UniqueFence> inFlightFences;
-	std::vector<vk::Fence> imagesInFlight;
-	size_t currentFrame = 0;
+	// Referenced by pipelines still being compiled, so they live as long as the pipeline manager
+	vk::UniqueShaderModule vertShaderModule, fragShaderModule;
+	vk::UniqueShaderModule quadVertShaderModule, quadFragShaderModule;
+	vk::UniqueShaderModule objectVertShaderModule, objectFragShaderModule, cullShaderModule, depthPyramidShaderModule;
+	vk::UniquePipelineLayout objectPipelineLayout;
+	PipelineManager pipelineManager;
+	PipelineManager::PipelineId graphicsPipeline = 0;
+	PipelineManager::PipelineId objectPipeline = 0;
+	std::vector<PipelineManager::PipelineId> permutationPipelines;
+	std::vector<PipelineManager::PipelineId> quadPipelines;
+	// Pipelines of the quad batch for the current frame, fallbacks until the compiled ones are ready
+	std::vector<vk::Pipeline> quadPipelineHandles;
+	bool pipelinesReady = false;
+	CommandRecorder commandRecorder;
+
+	FrameSync frameSync;
+	// Slot of the current frame, indexes the per frame resources
+	uint32_t currentFrame = 0;
+	uint32_t frameNumber = 0;
+	Clock::time_point runStart;
+	// CPU side of the trace, only collected with a trace path
+	std::vector<TraceEvent> cpuTraceEvents;
+
+	// Results of the background work, written by frame n into slot n % (framesInFlight + 1) and acquired by frame
+	// n + 1, so the slot is written again only once that frame has completed
+	struct BackgroundSlot {
+		GpuBuffer particles;
+		vk::DescriptorSet set;
+		GpuBuffer uploadSource, uploadDestination;
+		// Frame that wrote the slot last and the values of the async queues signalled by it
+		uint64_t frame = 0;
+		uint64_t computeValue = 0, uploadValue = 0;
+	};
+	std::vector<BackgroundSlot> backgroundSlots;
+	vk::UniqueShaderModule backgroundShaderModule;
+	vk::UniqueDescriptorSetLayout backgroundSetLayout;
+	// Freeing the pool frees the sets
+	vk::UniqueDescriptorPool backgroundPool;
+	vk::UniquePipelineLayout backgroundPipelineLayout;
+	vk::UniquePipeline backgroundPipeline;
 
 	void initWindow() {
 		glfwInit();
 
 		glfwWindowHint(GLFW_CLIENT_API, GLFW_NO_API);
-		glfwWindowHint(GLFW_RESIZABLE, GLFW_FALSE);
 
 		window = glfwCreateWindow(WIDTH, HEIGHT, "TestApplication", nullptr, nullptr);
+		glfwSetWindowUserPointer(window, this);
+		glfwSetFramebufferSizeCallback(window, framebufferResizeCallback);
+	}
+
+	static void framebufferResizeCallback(GLFWwindow* window, int width, int height) {
+		auto app = reinterpret_cast<HelloTriangleApplication*>(glfwGetWindowUserPointer(window));
+		app->framebufferResized = true;
 	}
 
 	void initVulkan() {
+		assetArchive.open(settings.assetArchivePath);
+
 		createInstance();
 		setupDebugMessenger();
-		createSurface();
+		if (!settings.headless) {
+			createSurface();
+		}
 		pickPhysicalDevice();
 		createLogicalDevice();
-		createSwapChain();
-		createImageViews();
+		pipelineCache.load(*vkDevice, vkPhysicalDevice, settings.pipelineCachePath);
+		// Compilations run next to the main thread, which records and fills on the pool as well
+		workerPool.init(std::max({ settings.recordThreads, settings.batchThreads, settings.pipelineThreads + 1 }));
+		pipelineManager.init(*vkDevice, pipelineCache.get(), workerPool, settings.pipelineThreads, settings.pipelineDerivatives);
+		gpuAllocator.init(*vkDevice, vkPhysicalDevice);
+		if (settings.headless) {
+			createOffscreenImages();
+			createImageViews();
+		}
+		else {
+			createSwapChain();
+		}
+		createDepthResources();
 		createRenderPass();
+		createDescriptorLayouts();
+		createStagingRing();
+		createObjects();
+
+		auto creationStart = Clock::now();
 		createGraphicsPipeline();
+		if (settings.objectCount > 0) {
+			createObjectPipeline();
+		}
+		if (settings.quadCount > 0) {
+			createQuadPipelines();
+		}
+		frameTimings.pipelineCreationMs = std::chrono::duration<double, std::milli>(Clock::now() - creationStart).count();
+		frameTimings.pipelineCacheWarm = pipelineCache.isWarm();
 		createFrameBuffers();
-		createCommandPool();
-		createCommandBuffers();
+		createCommandRecorder();
+		createVertexBuffers();
+		createDrawResources();
+		quadBatch.init(gpuAllocator, workerPool, settings.framesInFlight, settings.batchThreads);
+		createBackgroundWork();
 		createSyncObjects();
+		createGpuProfiler();
 	}
 
 	void mainLoop() {
-		while (!glfwWindowShouldClose(window)) {
-			glfwPollEvents();
+		frameTimings.deviceName = vkPhysicalDevice.getProperties().deviceName.data();
+
+		auto start = Clock::now();
+		for (uint32_t frame = 0; settings.frameCount == 0 || frame < settings.frameCount; ++frame) {
+			if (!settings.headless) {
+				if (glfwWindowShouldClose(window)) {
+					break;
+				}
+				glfwPollEvents();
+			}
 			drawFrame();
+			if (frame == 0) {
+				frameTimings.timeToFirstFrameMs = std::chrono::duration<double, std::milli>(Clock::now() - runStart).count();
+			}
 		}
 		vkDevice->waitIdle();
+		frameTimings.pipelines = pipelineManager.getStatistics();
+		frameTimings.descriptorMode = descriptorMode;
+		frameTimings.descriptorSets = descriptorAllocator.getStatistics();
+		frameTimings.bindless = bindlessTable.getStatistics();
+		frameTimings.cullingMode = cullingMode;
+		frameTimings.culler = culler.getStatistics();
+		frameTimings.asyncCompute = computeQueue.isValid() && settings.backgroundDispatches > 0;
+		frameTimings.asyncUpload = uploadQueue != nullptr && settings.backgroundUploadBytes > 0;
+		frameTimings.computeQueue = computeQueue.getStatistics();
+		frameTimings.transferQueue = transferQueue.getStatistics();
+		// Still compiling when the run ended, so every frame may have used fallbacks
+		if (!pipelinesReady) {
+			frameTimings.pipelinesReadyFrame = frameNumber;
+		}
+		gpuProfiler.readPendingFrames();
+		if (!settings.tracePath.empty()) {
+			writeTrace();
+		}
+
+		if (!settings.headless) {
+			frameTimings.presentMode = vk::to_string(swapChain.getPresentMode());
+			frameTimings.swapChainImages = swapChain.getImageCount();
+			frameTimings.swapChainRecreations = swapChain.getRecreateCount() - 1;
+		}
+		frameTimings.totalSeconds = std::chrono::duration<double>(Clock::now() - start).count();
 	}
 
 	void cleanup() {
+		// Compilations still running finish into the cache before it is saved
+		pipelineManager.shutdown();
+		pipelineCache.save();
+
+		if (!window) {
+			return;
+		}
 		glfwDestroyWindow(window);
 
 		glfwTerminate();
@@ -131,7 +593,7 @@ private:
 			VK_MAKE_VERSION(1, 0, 0),
 			"No Engine",
 			VK_MAKE_VERSION(1, 0, 0),
-			VK_API_VERSION_1_0
+			VK_API_VERSION_1_2
 		};
 
 		auto glfwExtensions = getRequiredExtensions();
@@ -172,51 +634,145 @@ private:
 	}
 
 	void drawFrame() {
-		vkDevice->waitForFences(1, &*inFlightFences[currentFrame], VK_TRUE, std::numeric_limits<uint64_t>::max());
+		auto frameStart = Clock::now();
+		currentFrame = frameSync.beginFrame();
+		updatePipelines(frameStart);
+
+		// Filling the quads only touches CPU memory, so it overlaps with the GPU still working on the slot
+		fillQuads();
+		auto fillEnd = Clock::now();
 
-		uint32_t imageIndex = vkDevice->acquireNextImageKHR(*swapChain, std::numeric_limits<uint64_t>::max(), *imageAvailableSemaphores[currentFrame]).value;
+		frameSync.waitForSlot();
 
-		if (imagesInFlight[imageIndex] != VK_NULL_HANDLE) {
-			vkDevice->waitForFences(1, &imagesInFlight[imageIndex], VK_TRUE, std::numeric_limits<uint64_t>::max());
+		// Offscreen images are simply used round robin, there is nothing to acquire. Reusing an image needs no
+		// wait on the CPU, the submissions run in order and the render pass orders the attachment writes.
+		uint32_t imageIndex;
+		if (settings.headless) {
+			imageIndex = frameNumber % static_cast<uint32_t>(offscreenImages.size());
+		}
+		else {
+			auto acquireStart = Clock::now();
+			bool acquired = acquireImage(imageIndex);
+			frameSync.addStall(std::chrono::duration<double>(Clock::now() - acquireStart).count());
+
+			// Minimized or out of date twice in a row, the frame still has to reach its timeline value
+			if (!acquired) {
+				frameSync.skipFrame(graphicsQueue);
+				++frameNumber;
+				return;
+			}
 		}
-		imagesInFlight[imageIndex] = *inFlightFences[currentFrame];
+		auto waitEnd = Clock::now();
 
-		vk::SubmitInfo submitInfo{};
+		stagingRing.beginFrame(currentFrame);
+		updateDescriptors();
+		if (settings.quadCount > 0) {
+			quadBatch.build();
+		}
+		auto batchEnd = Clock::now();
 
-		vk::Semaphore waitSemaphores[] = { *imageAvailableSemaphores[currentFrame] };
-		vk::PipelineStageFlags waitStages[] = { vk::PipelineStageFlagBits::eColorAttachmentOutput };
-		
-		submitInfo.waitSemaphoreCount = 1;
-		submitInfo.pWaitSemaphores = waitSemaphores;
-		submitInfo.pWaitDstStageMask = waitStages;
+		cullObjects();
+		submitBackgroundWork();
+		auto cullEnd = Clock::now();
 
-		submitInfo.commandBufferCount = 1;
-		submitInfo.pCommandBuffers = &*commandBuffers[imageIndex];
+		vk::CommandBuffer commandBuffer = recordCommandBuffer(imageIndex);
+		auto recordEnd = Clock::now();
 
-		vk::Semaphore signalSemaphores[] = { *renderFinishedSemaphores[currentFrame] };
-		submitInfo.signalSemaphoreCount = 1;
-		submitInfo.pSignalSemaphores = signalSemaphores;
+		auto submitStart = Clock::now();
+		frameSync.submit(graphicsQueue, commandBuffer, imageIndex);
+		auto submitEnd = Clock::now();
 
-		vkDevice->resetFences(1, &*inFlightFences[currentFrame]);
-		try {
-			graphicsQueue.submit(submitInfo, *inFlightFences[currentFrame]);
+		if (!settings.headless) {
+			swapChain.present(presentQueue, imageIndex, frameSync.getRenderFinishedSemaphore(imageIndex));
+			frameTimings.acquireToPresentMs.push_back(swapChain.getLastAcquireToPresentMs());
 		}
-		catch (vk::SystemError err) {
-			throw std::runtime_error("failed to submit draw command buffer!");
+
+		++frameNumber;
+
+		auto frameEnd = Clock::now();
+		if (!settings.tracePath.empty()) {
+			addTraceEvent("drawFrame", frameStart, frameEnd);
+			addTraceEvent("Fill quads", frameStart, fillEnd);
+			addTraceEvent("Wait for frame slot", fillEnd, waitEnd);
+			addTraceEvent("Build quad batch", waitEnd, batchEnd);
+			addTraceEvent("Cull objects", batchEnd, cullEnd);
+			addTraceEvent("Record", cullEnd, recordEnd);
+			addTraceEvent("Submit", submitStart, submitEnd);
+			addTraceEvent("Present", submitEnd, frameEnd);
 		}
+		frameTimings.cpuFrameMs.push_back(std::chrono::duration<double, std::milli>(frameEnd - frameStart).count());
+		frameTimings.batchMs.push_back(std::chrono::duration<double, std::milli>((fillEnd - frameStart) + (batchEnd - waitEnd)).count());
+		frameTimings.cullMs.push_back(std::chrono::duration<double, std::milli>(cullEnd - batchEnd).count());
+		frameTimings.recordMs.push_back(std::chrono::duration<double, std::milli>(recordEnd - cullEnd).count());
+		frameTimings.submitMs.push_back(std::chrono::duration<double, std::milli>(submitEnd - submitStart).count());
+		frameTimings.stallMs.push_back(frameSync.getStallMs());
+	}
 
-		vk::PresentInfoKHR presentInfo{};
-		presentInfo.waitSemaphoreCount = 1;
-		presentInfo.pWaitSemaphores = signalSemaphores;
+	void addTraceEvent(const char* name, Clock::time_point start, Clock::time_point end) {
+		cpuTraceEvents.push_back({ name,
+			static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(start.time_since_epoch()).count()),
+			static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(end.time_since_epoch()).count()) });
+	}
 
-		vk::SwapchainKHR swapChains[] = { *swapChain };
-		presentInfo.swapchainCount = 1;
-		presentInfo.pSwapchains = swapChains;
-		presentInfo.pImageIndices = &imageIndex;
+	void writeTrace() {
+		std::ofstream file(settings.tracePath, std::ios::trunc);
+		if (!file.is_open()) {
+			throw std::runtime_error("failed to open trace file!");
+		}
+		gpuProfiler.writeChromeTrace(file, cpuTraceEvents);
+	}
 
-		presentQueue.presentKHR(presentInfo);
+	// Recreates the swap chain first if the window was resized or it went out of date
+	bool acquireImage(uint32_t& imageIndex) {
+		swapChain.releaseRetired(frameSync.getCompletedValue());
 
-		currentFrame = ++currentFrame % MAX_FRAMES_IN_FLIGHT;
+		if ((framebufferResized || swapChain.isOutOfDate()) && !recreateSwapChain()) {
+			return false;
+		}
+		if (swapChain.acquire(frameSync.getImageAvailableSemaphore(), imageIndex)) {
+			return true;
+		}
+		// Went out of date during the acquire, which leaves the semaphore unsignaled, so it can be used again
+		return recreateSwapChain() && swapChain.acquire(frameSync.getImageAvailableSemaphore(), imageIndex);
+	}
+
+	// The previous frames may still render into the old images, the old swap chain lives on until they completed
+	bool recreateSwapChain() {
+		int width, height;
+		glfwGetFramebufferSize(window, &width, &height);
+
+		if (!swapChain.recreate(vk::Extent2D(static_cast<uint32_t>(width), static_cast<uint32_t>(height)), frameSync.getFrameValue() - 1)) {
+			return false;
+		}
+		framebufferResized = false;
+
+		if (swapChain.getFormat() != swapChainImageFormat) {
+			throw std::runtime_error("swap chain format changed!");
+		}
+		vk::Extent2D previousExtent = swapChainExtent;
+		swapChainExtent = swapChain.getExtent();
+		frameSync.setImageCount(swapChain.getImageCount());
+
+		// The graph's framebuffers hold the old image views and its transient images the old size. Pipelines still
+		// compiling use the scene's render pass, which is replaced by a compatible one.
+		if (settings.renderGraph) {
+			vkDevice->waitIdle();
+			pipelineManager.waitIdle();
+			renderGraph.clear();
+			createRenderGraph();
+		}
+
+		// The swap chain leaves its framebuffers to us with a depth attachment. The depth buffer, the pyramid and the
+		// culler's sets pointing at it are shared by all frames, so they can only be replaced once nothing uses them.
+		if (occlusionCulling) {
+			if (swapChainExtent != previousExtent) {
+				vkDevice->waitIdle();
+				createDepthResources();
+				culler.updatePyramid();
+			}
+			swapChain.setRenderPass(*renderPass, *depthImageView);
+		}
+		return true;
 	}
 
 	void createSurface() {
@@ -251,7 +807,21 @@ private:
 		QueueFamilyIndices indices = findQueueFamilies(vkPhysicalDevice);
 
 		std::vector<vk::DeviceQueueCreateInfo> queueCreateInfos;
-		std::set<uint32_t> uniqueQueueFamilies = { indices.graphicsFamily.value(), indices.presentFamily.value() };
+		std::set<uint32_t> uniqueQueueFamilies = { indices.graphicsFamily.value() };
+		if (indices.presentFamily.has_value()) {
+			uniqueQueueFamilies.insert(indices.presentFamily.value());
+		}
+
+		// Uploads fall back to the compute queue, and either work into the frame without its queue
+		bool asyncCompute = settings.asyncQueues && indices.computeFamily.has_value()
+			&& (settings.backgroundDispatches > 0 || (settings.backgroundUploadBytes > 0 && !indices.transferFamily.has_value()));
+		bool asyncTransfer = settings.asyncQueues && indices.transferFamily.has_value() && settings.backgroundUploadBytes > 0;
+		if (asyncCompute) {
+			uniqueQueueFamilies.insert(indices.computeFamily.value());
+		}
+		if (asyncTransfer) {
+			uniqueQueueFamilies.insert(indices.transferFamily.value());
+		}
 
 		float queuePriority = 1.0f;
 		for (auto queueFamily : uniqueQueueFamilies) {
@@ -260,12 +830,41 @@ private:
 
 		auto deviceFeatures = vk::PhysicalDeviceFeatures();
 
+		// Optional, the GPU profiler counts the work of the render pass with them
+		auto supportedFeatures = vkPhysicalDevice.getFeatures();
+		pipelineStatisticsSupported = supportedFeatures.pipelineStatisticsQuery && supportedFeatures.inheritedQueries;
+		deviceFeatures.pipelineStatisticsQuery = pipelineStatisticsSupported ? VK_TRUE : VK_FALSE;
+		deviceFeatures.inheritedQueries = pipelineStatisticsSupported ? VK_TRUE : VK_FALSE;
+
+		// All Vulkan 1.2 features in one struct, it must not be chained together with the structs of the single features
+		vk::PhysicalDeviceVulkan12Features vulkan12Features{};
+		vulkan12Features.timelineSemaphore = VK_TRUE;
+
+		descriptorMode = settings.descriptorMode;
+		if (descriptorMode == DescriptorMode::Bindless && !BindlessTable::isSupported(vkPhysicalDevice)) {
+			descriptorMode = DescriptorMode::PerDraw;
+		}
+		if (descriptorMode == DescriptorMode::Bindless) {
+			BindlessTable::enableFeatures(deviceFeatures, vulkan12Features);
+		}
+
+		cullingMode = settings.cullingMode;
+		if (cullingMode == CullingMode::Gpu && !GpuCuller::isSupported(vkPhysicalDevice)) {
+			cullingMode = CullingMode::Cpu;
+		}
+		if (cullingMode == CullingMode::Gpu && settings.objectCount > 0) {
+			GpuCuller::enableFeatures(deviceFeatures, vulkan12Features);
+		}
+		occlusionCulling = settings.occlusionCulling && cullingMode == CullingMode::Gpu && settings.objectCount > 0;
+
+		// Without a surface there is no swap chain, so headless devices need no extensions
 		auto deviceCreateInfo = vk::DeviceCreateInfo(
 			vk::DeviceCreateFlags(),
 			static_cast<uint32_t>(queueCreateInfos.size()), queueCreateInfos.data(),
 			0, nullptr, // Layers
-			static_cast<uint32_t>(deviceExtensions.size()), deviceExtensions.data(),
+			settings.headless ? 0 : static_cast<uint32_t>(deviceExtensions.size()), deviceExtensions.data(),
 			&deviceFeatures);
+		deviceCreateInfo.pNext = &vulkan12Features;
 
 		if (enableValidationLayers) {
 			deviceCreateInfo.enabledLayerCount = static_cast<uint32_t>(validationLayers.size());
@@ -280,74 +879,72 @@ private:
 		}
 
 		graphicsQueue = vkDevice->getQueue(indices.graphicsFamily.value(), 0);
-		presentQueue = vkDevice->getQueue(indices.presentFamily.value(), 0);
-	}
-
-	void createSwapChain() {
-		auto swapChainSupport = querySwapChainSupport(vkPhysicalDevice);
-
-		vk::SurfaceFormatKHR surfaceFormat = chooseSwapSurfaceFormat(swapChainSupport.formats);
-		vk::PresentModeKHR presentMode = chooseSwapPresentMode(swapChainSupport.presentModes);
-		vk::Extent2D extent = chooseSwapExtend(swapChainSupport.capabilities);
-
-		uint32_t imageCount = swapChainSupport.capabilities.minImageCount + 1;
-
-		if (swapChainSupport.capabilities.maxImageCount > 0 && imageCount > swapChainSupport.capabilities.maxImageCount) {
-			imageCount = swapChainSupport.capabilities.maxImageCount;
+		if (indices.presentFamily.has_value()) {
+			presentQueue = vkDevice->getQueue(indices.presentFamily.value(), 0);
 		}
+		graphicsFamily = indices.graphicsFamily.value();
 
-		auto createInfo = vk::SwapchainCreateInfoKHR(
-			vk::SwapchainCreateFlagsKHR(),
-			*vkSurface,
-			imageCount,
-			surfaceFormat.format,
-			surfaceFormat.colorSpace,
-			extent,
-			1,
-			vk::ImageUsageFlagBits::eColorAttachment
-		);
-
-		QueueFamilyIndices indicies = findQueueFamilies(vkPhysicalDevice);
-		uint32_t queueFamilyIndicies[] = { indicies.graphicsFamily.value(), indicies.presentFamily.value() };
-
-		if (indicies.graphicsFamily != indicies.presentFamily) {
-			createInfo.imageSharingMode = vk::SharingMode::eConcurrent;
-			createInfo.queueFamilyIndexCount = 2;
-			createInfo.pQueueFamilyIndices = queueFamilyIndicies;
+		// One submission per frame and queue, a slot is free again once the frame acquiring its results completed
+		uint32_t asyncSlotCount = settings.framesInFlight + 1;
+		if (asyncCompute) {
+			computeQueue.init(*vkDevice, vkDevice->getQueue(indices.computeFamily.value(), 0), indices.computeFamily.value(), asyncSlotCount);
 		}
-		else {
-			createInfo.imageSharingMode = vk::SharingMode::eExclusive;
-			createInfo.queueFamilyIndexCount = 0;
-			createInfo.pQueueFamilyIndices = nullptr;
+		if (asyncTransfer) {
+			transferQueue.init(*vkDevice, vkDevice->getQueue(indices.transferFamily.value(), 0), indices.transferFamily.value(), asyncSlotCount);
 		}
+		if (settings.backgroundUploadBytes > 0) {
+			uploadQueue = asyncTransfer ? &transferQueue : asyncCompute ? &computeQueue : nullptr;
+		}
+	}
 
-		createInfo.preTransform = swapChainSupport.capabilities.currentTransform;
-		createInfo.compositeAlpha = vk::CompositeAlphaFlagBitsKHR::eOpaque;
-		createInfo.presentMode = presentMode;
-		createInfo.clipped = VK_TRUE;
-
-		createInfo.oldSwapchain = vk::SwapchainKHR(nullptr);
-
-		try {
-			swapChain = vkDevice->createSwapchainKHRUnique(createInfo);
+	void createSwapChain() {
+		QueueFamilyIndices indices = findQueueFamilies(vkPhysicalDevice);
+		SwapChainSettings swapChainSettings = settings.swapChain;
+		// The composite pass of the render graph copies into the images
+		if (settings.renderGraph) {
+			swapChainSettings.imageUsage |= vk::ImageUsageFlagBits::eTransferDst;
 		}
-		catch (vk::SystemError err) {
+		swapChain.init(vkPhysicalDevice, *vkDevice, *vkSurface, indices.graphicsFamily.value(), indices.presentFamily.value(), swapChainSettings);
+
+		int width, height;
+		glfwGetFramebufferSize(window, &width, &height);
+		if (!swapChain.recreate(vk::Extent2D(static_cast<uint32_t>(width), static_cast<uint32_t>(height)), 0)) {
 			throw std::runtime_error("failed to create swap chain!");
 		}
 
-		swapChainImages = vkDevice->getSwapchainImagesKHR(*swapChain);
+		swapChainImageFormat = swapChain.getFormat();
+		swapChainExtent = swapChain.getExtent();
+	}
 
-		swapChainImageFormat = surfaceFormat.format;
-		swapChainExtent = extent;
+	void createOffscreenImages() {
+		swapChainImageFormat = vk::Format::eR8G8B8A8Unorm;
+		swapChainExtent = vk::Extent2D(WIDTH, HEIGHT);
+
+		for (uint32_t i = 0; i < OFFSCREEN_IMAGE_COUNT; ++i) {
+			vk::ImageCreateInfo imageInfo{};
+			imageInfo.imageType = vk::ImageType::e2D;
+			imageInfo.format = swapChainImageFormat;
+			imageInfo.extent = vk::Extent3D(swapChainExtent.width, swapChainExtent.height, 1);
+			imageInfo.mipLevels = 1;
+			imageInfo.arrayLayers = 1;
+			imageInfo.samples = vk::SampleCountFlagBits::e1;
+			imageInfo.tiling = vk::ImageTiling::eOptimal;
+			// Transfer source, so the result can be read back for comparisons
+			imageInfo.usage = vk::ImageUsageFlagBits::eColorAttachment | vk::ImageUsageFlagBits::eTransferSrc | vk::ImageUsageFlagBits::eTransferDst;
+			imageInfo.sharingMode = vk::SharingMode::eExclusive;
+			imageInfo.initialLayout = vk::ImageLayout::eUndefined;
+
+			offscreenImages.push_back(gpuAllocator.createImage(imageInfo, vk::MemoryPropertyFlagBits::eDeviceLocal));
+		}
 	}
 
 	void createImageViews() {
-		swapChainImageViews.resize(swapChainImages.size());
+		offscreenImageViews.resize(offscreenImages.size());
 
-		for (size_t i = 0; i < swapChainImages.size(); ++i) {
+		for (size_t i = 0; i < offscreenImages.size(); ++i) {
 			auto createInfo = vk::ImageViewCreateInfo(
 				vk::ImageViewCreateFlags(),
-				swapChainImages[i],
+				offscreenImages[i].get(),
 				vk::ImageViewType::e2D,
 				swapChainImageFormat,
 				{vk::ComponentSwizzle::eIdentity, vk::ComponentSwizzle::eIdentity, vk::ComponentSwizzle::eIdentity, vk::ComponentSwizzle::eIdentity},
@@ -360,7 +957,7 @@ private:
 				}
 			);
 			try {
-				swapChainImageViews[i] = vkDevice->createImageViewUnique(createInfo);
+				offscreenImageViews[i] = vkDevice->createImageViewUnique(createInfo);
 			}
 			catch (vk::SystemError err) {
 				throw std::runtime_error("failed to create image views!");
@@ -368,141 +965,241 @@ private:
 		}
 	}
 
+	// The depth buffer the objects are drawn with and the pyramid built from it, only with occlusion culling
+	void createDepthResources() {
+		if (!occlusionCulling) {
+			return;
+		}
+
+		vk::ImageCreateInfo imageInfo{};
+		imageInfo.imageType = vk::ImageType::e2D;
+		imageInfo.format = DEPTH_FORMAT;
+		imageInfo.extent = vk::Extent3D(swapChainExtent.width, swapChainExtent.height, 1);
+		imageInfo.mipLevels = 1;
+		imageInfo.arrayLayers = 1;
+		imageInfo.samples = vk::SampleCountFlagBits::e1;
+		imageInfo.tiling = vk::ImageTiling::eOptimal;
+		imageInfo.usage = vk::ImageUsageFlagBits::eDepthStencilAttachment | vk::ImageUsageFlagBits::eSampled;
+		imageInfo.sharingMode = vk::SharingMode::eExclusive;
+		imageInfo.initialLayout = vk::ImageLayout::eUndefined;
+		// Called again when the swap chain is resized, the old view goes before the image it belongs to
+		depthImageView.reset();
+		depthImage = gpuAllocator.createImage(imageInfo, vk::MemoryPropertyFlagBits::eDeviceLocal);
+
+		try {
+			depthImageView = vkDevice->createImageViewUnique(vk::ImageViewCreateInfo(vk::ImageViewCreateFlags(), depthImage.get(), vk::ImageViewType::e2D,
+				DEPTH_FORMAT, {}, { vk::ImageAspectFlagBits::eDepth, 0, 1, 0, 1 }));
+		}
+		catch (vk::SystemError err) {
+			throw std::runtime_error("failed to create image views!");
+		}
+
+		if (!depthPyramidShaderModule) {
+			depthPyramidShaderModule = createShaderModule(assetArchive.get("depth_pyramid_comp.spv"));
+		}
+		depthPyramid.init(*vkDevice, gpuAllocator, depthImage.get(), *depthImageView, swapChainExtent, *depthPyramidShaderModule, pipelineCache.get());
+	}
+
 	void createRenderPass() {
-		vk::AttachmentDescription colorAttachment{};
+		if (settings.renderGraph) {
+			createRenderGraph();
+			return;
+		}
+
+		vk::ImageLayout finalLayout = settings.headless ? vk::ImageLayout::eTransferSrcOptimal : vk::ImageLayout::ePresentSrcKHR;
+		if (!occlusionCulling) {
+			renderPass = createScenePass(false, vk::ImageLayout::eUndefined, finalLayout);
+			return;
+		}
+		renderPass = createScenePass(false, vk::ImageLayout::eUndefined, vk::ImageLayout::eColorAttachmentOptimal);
+		lateRenderPass = createScenePass(true, vk::ImageLayout::eColorAttachmentOptimal, finalLayout);
+	}
+
+	// Clears color and depth, or loads what the first pass left when late. The depth attachment only exists with
+	// occlusion culling, the late pass leaves it behind as the pyramid has already been built from it.
+	vk::UniqueRenderPass createScenePass(bool late, vk::ImageLayout initialLayout, vk::ImageLayout finalLayout) {
+		vk::AttachmentDescription attachments[2] = {};
+		vk::AttachmentDescription& colorAttachment = attachments[0];
 		colorAttachment.format = swapChainImageFormat;
 		colorAttachment.samples = vk::SampleCountFlagBits::e1;
-		colorAttachment.loadOp = vk::AttachmentLoadOp::eClear;
+		colorAttachment.loadOp = late ? vk::AttachmentLoadOp::eLoad : vk::AttachmentLoadOp::eClear;
 		colorAttachment.storeOp = vk::AttachmentStoreOp::eStore;
 		colorAttachment.stencilLoadOp = vk::AttachmentLoadOp::eDontCare;
 		colorAttachment.stencilStoreOp = vk::AttachmentStoreOp::eDontCare;
 
-		colorAttachment.initialLayout = vk::ImageLayout::eUndefined;
-		colorAttachment.finalLayout = vk::ImageLayout::ePresentSrcKHR;
+		colorAttachment.initialLayout = initialLayout;
+		colorAttachment.finalLayout = finalLayout;
+
+		vk::AttachmentDescription& depthAttachment = attachments[1];
+		depthAttachment.format = DEPTH_FORMAT;
+		depthAttachment.samples = vk::SampleCountFlagBits::e1;
+		depthAttachment.loadOp = late ? vk::AttachmentLoadOp::eLoad : vk::AttachmentLoadOp::eClear;
+		depthAttachment.storeOp = late ? vk::AttachmentStoreOp::eDontCare : vk::AttachmentStoreOp::eStore;
+		depthAttachment.stencilLoadOp = vk::AttachmentLoadOp::eDontCare;
+		depthAttachment.stencilStoreOp = vk::AttachmentStoreOp::eDontCare;
+		depthAttachment.initialLayout = late ? vk::ImageLayout::eDepthStencilAttachmentOptimal : vk::ImageLayout::eUndefined;
+		depthAttachment.finalLayout = vk::ImageLayout::eDepthStencilAttachmentOptimal;
 
 		vk::AttachmentReference colorAttachmentRef{};
 		colorAttachmentRef.attachment = 0;
 		colorAttachmentRef.layout = vk::ImageLayout::eColorAttachmentOptimal;
 
+		vk::AttachmentReference depthAttachmentRef{};
+		depthAttachmentRef.attachment = 1;
+		depthAttachmentRef.layout = vk::ImageLayout::eDepthStencilAttachmentOptimal;
+
 		vk::SubpassDescription subpass{};
 		subpass.pipelineBindPoint = vk::PipelineBindPoint::eGraphics;
 		subpass.colorAttachmentCount = 1;
 		subpass.pColorAttachments = &colorAttachmentRef;
+		subpass.pDepthStencilAttachment = occlusionCulling ? &depthAttachmentRef : nullptr;
 
+		// The late pass also waits for the color writes of the first one
 		vk::SubpassDependency dependency{};
 		dependency.srcSubpass = VK_SUBPASS_EXTERNAL;
 		dependency.dstSubpass = 0;
 		dependency.srcStageMask = vk::PipelineStageFlagBits::eColorAttachmentOutput;
-		dependency.srcAccessMask = vk::AccessFlags();
+		dependency.srcAccessMask = late ? vk::AccessFlagBits::eColorAttachmentWrite : vk::AccessFlags();
 		dependency.dstStageMask = vk::PipelineStageFlagBits::eColorAttachmentOutput;
 		dependency.dstAccessMask = vk::AccessFlagBits::eColorAttachmentWrite;
+		if (late) {
+			dependency.dstAccessMask |= vk::AccessFlagBits::eColorAttachmentRead;
+		}
+		if (occlusionCulling) {
+			dependency.srcStageMask |= vk::PipelineStageFlagBits::eLateFragmentTests;
+			dependency.srcAccessMask |= vk::AccessFlagBits::eDepthStencilAttachmentWrite;
+			dependency.dstStageMask |= vk::PipelineStageFlagBits::eEarlyFragmentTests | vk::PipelineStageFlagBits::eLateFragmentTests;
+			dependency.dstAccessMask |= vk::AccessFlagBits::eDepthStencilAttachmentRead | vk::AccessFlagBits::eDepthStencilAttachmentWrite;
+		}
 
 		vk::RenderPassCreateInfo renderPassInfo{};
-		renderPassInfo.attachmentCount = 1;
-		renderPassInfo.pAttachments = &colorAttachment;
+		renderPassInfo.attachmentCount = occlusionCulling ? 2 : 1;
+		renderPassInfo.pAttachments = attachments;
 		renderPassInfo.subpassCount = 1;
 		renderPassInfo.pSubpasses = &subpass;
 		renderPassInfo.dependencyCount = 1;
 		renderPassInfo.pDependencies = &dependency;
 
 		try {
-			renderPass = vkDevice->createRenderPassUnique(renderPassInfo);
+			return vkDevice->createRenderPassUnique(renderPassInfo);
 		}
 		catch (vk::SystemError err) {
 			throw std::runtime_error("failed to create render pass!");
 		}
 	}
 
-	void createGraphicsPipeline() {
-		auto vertShaderModule = createShaderModule(readFile("shaders/vert.spv"));
-		auto fragShaderModule = createShaderModule(readFile("shaders/frag.spv"));
-
-		vk::PipelineShaderStageCreateInfo shaderStages[] = { 
-			{
-				vk::PipelineShaderStageCreateFlags(),
-				vk::ShaderStageFlagBits::eVertex,
-				*vertShaderModule,
-				"main"
-			},
-			{
-				vk::PipelineShaderStageCreateFlags(),
-				vk::ShaderStageFlagBits::eFragment,
-				*fragShaderModule,
-				"main"
-			} 
-		};
+	// Stand ins for a deferred renderer in front of the scene. The passes only clear their attachments and copy, there
+	// are no shaders for them, but the images, barriers and memory are those of the real thing. The debug view is never
+	// read and culled, the scene draws on top of the composited image.
+	void createRenderGraph() {
+		using Usage = RenderGraph::Usage;
+		vk::Extent2D extent = swapChainExtent;
+		vk::ClearValue black(vk::ClearColorValue(std::array<float, 4>{ 0.0f, 0.0f, 0.0f, 1.0f }));
+		vk::ClearValue farDepth(vk::ClearDepthStencilValue(1.0f, 0));
+		auto nothing = [](vk::CommandBuffer, const RenderGraph::PassContext&) {};
+
+		vk::ImageLayout outputLayout = settings.headless ? vk::ImageLayout::eTransferSrcOptimal : vk::ImageLayout::ePresentSrcKHR;
+		graphOutput = renderGraph.importImage("Output", swapChainImageFormat, extent, vk::ImageLayout::eUndefined, outputLayout);
+		auto shadowMap = renderGraph.createImage("Shadow map", vk::Format::eD32Sfloat, vk::Extent2D(SHADOW_MAP_SIZE, SHADOW_MAP_SIZE));
+		auto albedo = renderGraph.createImage("Albedo", vk::Format::eR8G8B8A8Unorm, extent);
+		auto normal = renderGraph.createImage("Normal", vk::Format::eR16G16B16A16Sfloat, extent);
+		auto depth = renderGraph.createImage("Depth", vk::Format::eD32Sfloat, extent);
+		auto hdr = renderGraph.createImage("HDR", vk::Format::eR16G16B16A16Sfloat, extent);
+		auto tonemapped = renderGraph.createImage("Tonemapped", swapChainImageFormat, extent);
+		auto debugView = renderGraph.createImage("Debug view", vk::Format::eR8G8B8A8Unorm, extent);
+
+		auto shadowPass = renderGraph.addPass("Shadow", nothing);
+		renderGraph.write(shadowPass, shadowMap, Usage::DepthAttachment, farDepth);
+
+		auto gBufferPass = renderGraph.addPass("G-buffer", nothing);
+		renderGraph.write(gBufferPass, albedo, Usage::ColorAttachment, black);
+		renderGraph.write(gBufferPass, normal, Usage::ColorAttachment, black);
+		renderGraph.write(gBufferPass, depth, Usage::DepthAttachment, farDepth);
+
+		auto debugPass = renderGraph.addPass("Debug view", nothing);
+		renderGraph.read(debugPass, normal, Usage::Sampled);
+		renderGraph.write(debugPass, debugView, Usage::ColorAttachment, black);
+
+		auto lightingPass = renderGraph.addPass("Lighting", nothing);
+		renderGraph.read(lightingPass, albedo, Usage::Sampled);
+		renderGraph.read(lightingPass, normal, Usage::Sampled);
+		renderGraph.read(lightingPass, shadowMap, Usage::Sampled);
+		renderGraph.write(lightingPass, hdr, Usage::ColorAttachment, black);
+
+		auto tonemapPass = renderGraph.addPass("Tonemap", nothing);
+		renderGraph.read(tonemapPass, hdr, Usage::Sampled);
+		renderGraph.write(tonemapPass, tonemapped, Usage::ColorAttachment, black);
+
+		auto compositePass = renderGraph.addPass("Composite", [this, tonemapped, extent](vk::CommandBuffer commandBuffer, const RenderGraph::PassContext&) {
+			vk::ImageSubresourceLayers layers(vk::ImageAspectFlagBits::eColor, 0, 0, 1);
+			vk::ImageCopy region(layers, vk::Offset3D(0, 0, 0), layers, vk::Offset3D(0, 0, 0), vk::Extent3D(extent.width, extent.height, 1));
+			commandBuffer.copyImage(renderGraph.getImage(tonemapped), vk::ImageLayout::eTransferSrcOptimal,
+				renderGraph.getImage(graphOutput), vk::ImageLayout::eTransferDstOptimal, region);
+		});
+		renderGraph.read(compositePass, tonemapped, Usage::TransferSource);
+		renderGraph.write(compositePass, graphOutput, Usage::TransferDestination);
+
+		scenePass = renderGraph.addPass("Scene", [this](vk::CommandBuffer, const RenderGraph::PassContext& context) {
+			recordScene(context.renderPass, context.framebuffer);
+		}, true);
+		renderGraph.write(scenePass, graphOutput, Usage::ColorAttachment);
+
+		renderGraph.compile(*vkDevice, gpuAllocator);
+	}
 
-		auto vertexInputInfo = vk::PipelineVertexInputStateCreateInfo(
-			vk::PipelineVertexInputStateCreateFlags(),
-			0, nullptr,	// Binding descriptions
-			0, nullptr	// Attribute descriptions
-		);
+	vk::RenderPass getSceneRenderPass() const {
+		return settings.renderGraph ? renderGraph.getRenderPass(scenePass) : *renderPass;
+	}
 
-		auto inputAssembly = vk::PipelineInputAssemblyStateCreateInfo(
-			vk::PipelineInputAssemblyStateCreateFlags(),
-			vk::PrimitiveTopology::eTriangleList,
-			VK_FALSE	// primitiveRestartEnable
-		);
+	// The bindless table, or the layout of the per draw sets and the per frame pools they are allocated from
+	void createDescriptorLayouts() {
+		if (descriptorMode == DescriptorMode::Bindless) {
+			bindlessTable.init(vkPhysicalDevice, *vkDevice, BINDLESS_TEXTURE_CAPACITY, BINDLESS_BUFFER_CAPACITY);
+			return;
+		}
+		if (descriptorMode == DescriptorMode::None) {
+			return;
+		}
 
-		auto viewport = vk::Viewport(
-			0.0f,	// x
-			0.0f,	// y
-			(float) swapChainExtent.width,
-			(float) swapChainExtent.height,
-			0.0f,	// minDepth
-			1.0f	// maxDepth
-		);
+		vk::DescriptorSetLayoutBinding bindings[] = {
+			{ 0, vk::DescriptorType::eCombinedImageSampler, 1, vk::ShaderStageFlagBits::eFragment },
+			{ 1, vk::DescriptorType::eStorageBuffer, 1, vk::ShaderStageFlagBits::eFragment }
+		};
 
-		auto scissor = vk::Rect2D(
-			{ 0, 0 },
-			swapChainExtent
-		);
+		vk::DescriptorSetLayoutCreateInfo layoutInfo{};
+		layoutInfo.bindingCount = 2;
+		layoutInfo.pBindings = bindings;
 
-		auto viewportState = vk::PipelineViewportStateCreateInfo(
-			vk::PipelineViewportStateCreateFlags(),
-			1, &viewport,
-			1, &scissor
-		);
+		try {
+			drawSetLayout = vkDevice->createDescriptorSetLayoutUnique(layoutInfo);
+		}
+		catch (vk::SystemError err) {
+			throw std::runtime_error("failed to create descriptor set layout!");
+		}
 
-		auto rasterizer = vk::PipelineRasterizationStateCreateInfo(
-			vk::PipelineRasterizationStateCreateFlags(),
-			VK_FALSE,	// depthClamp
-			VK_FALSE,	// rasterizerDiscard
-			vk::PolygonMode::eFill,
-			vk::CullModeFlagBits::eBack,
-			vk::FrontFace::eCounterClockwise,
-			VK_FALSE,	// depthBias
-			0.0f, 0.0f, 0.0f,	// depthBiasValues
-			1.0f		// lineWidth
-		);
+		descriptorAllocator.init(*vkDevice, settings.framesInFlight, settings.recordThreads,
+			{ { vk::DescriptorType::eCombinedImageSampler, 1 }, { vk::DescriptorType::eStorageBuffer, 1 } }, DESCRIPTOR_SETS_PER_POOL);
+	}
 
-		auto multisampling = vk::PipelineMultisampleStateCreateInfo(
-			vk::PipelineMultisampleStateCreateFlags(),
-			vk::SampleCountFlagBits::e1,
-			VK_FALSE,	// sampleShading
-			1.0f,		// minSampleShading
-			nullptr,	// pSampleMask
-			VK_FALSE,	// alphaToCoverage
-			VK_FALSE	// alphaToOne
-		);
+	void createGraphicsPipeline() {
+		const char* fragShaderName = descriptorMode == DescriptorMode::Bindless ? "frag_bindless.spv"
+			: descriptorMode == DescriptorMode::PerDraw ? "frag_descriptor.spv" : "frag.spv";
+		vertShaderModule = createShaderModule(assetArchive.get("vert.spv"));
+		fragShaderModule = createShaderModule(assetArchive.get(fragShaderName));
+
+		// Set 0 is the bindless table or the per draw set, the quad pipelines share the layout without using it
+		vk::DescriptorSetLayout setLayout = descriptorMode == DescriptorMode::Bindless ? bindlessTable.getLayout() : *drawSetLayout;
+		vk::PushConstantRange pushConstantRange(vk::ShaderStageFlagBits::eFragment, 0, sizeof(DrawIndices));
 
-		vk::PipelineColorBlendAttachmentState colorBlendAttachment{};
-		colorBlendAttachment.blendEnable = VK_FALSE;
-		colorBlendAttachment.colorWriteMask = vk::ColorComponentFlagBits::eR | vk::ColorComponentFlagBits::eG | vk::ColorComponentFlagBits::eB | vk::ColorComponentFlagBits::eA;
-
-		vk::PipelineColorBlendStateCreateInfo colorBlending{};
-		colorBlending.logicOpEnable = VK_FALSE;
-		colorBlending.logicOp = vk::LogicOp::eCopy;
-		colorBlending.attachmentCount = 1;
-		colorBlending.pAttachments = &colorBlendAttachment;
-		colorBlending.blendConstants[0] = 0.0f;
-		colorBlending.blendConstants[1] = 0.0f;
-		colorBlending.blendConstants[2] = 0.0f;
-		colorBlending.blendConstants[3] = 0.0f;
-
-		// for uniform values like transformation matricies that can be changed ad drawing time
 		vk::PipelineLayoutCreateInfo pipelineLayoutInfo{};
-		pipelineLayoutInfo.setLayoutCount = 0;
+		if (descriptorMode != DescriptorMode::None) {
+			pipelineLayoutInfo.setLayoutCount = 1;
+			pipelineLayoutInfo.pSetLayouts = &setLayout;
+		}
+		if (descriptorMode == DescriptorMode::Bindless) {
+			pipelineLayoutInfo.pushConstantRangeCount = 1;
+			pipelineLayoutInfo.pPushConstantRanges = &pushConstantRange;
+		}
 
 		try {
 			pipelineLayout = vkDevice->createPipelineLayoutUnique(pipelineLayoutInfo);
@@ -511,49 +1208,140 @@ private:
 			throw std::runtime_error("failed to create pipeline layout!");
 		}
 
-		vk::GraphicsPipelineCreateInfo pipelineInfo{};
-		pipelineInfo.stageCount = 2;
-		pipelineInfo.pStages = shaderStages;
+		auto bindingDescription = Vertex::getBindingDescription();
+		auto attributeDescriptions = Vertex::getAttributeDescriptions();
+
+		PipelineState state;
+		state.vertexShader = *vertShaderModule;
+		state.fragmentShader = *fragShaderModule;
+		state.layout = *pipelineLayout;
+		state.renderPass = getSceneRenderPass();
+		state.bindings = { bindingDescription };
+		state.attributes.assign(attributeDescriptions.begin(), attributeDescriptions.end());
+		graphicsPipeline = pipelineManager.createNow(state);
+
+		// Only the fixed function state varies, which still makes the driver compile every one of them. The triangle
+		// pipeline is their fallback, the one without any changes is the triangle pipeline itself.
+		const vk::CullModeFlags cullModes[] = { vk::CullModeFlagBits::eBack, vk::CullModeFlagBits::eNone, vk::CullModeFlagBits::eFront };
+		permutationPipelines.clear();
+		for (uint32_t i = 0; i < settings.pipelinePermutations; ++i) {
+			PipelineState permutation = state;
+			uint32_t variation = i % 360;
+			permutation.colorWriteMask = vk::ColorComponentFlags(15 - variation % 15);
+			permutation.blend = (variation / 15) % 2 == 1;
+			permutation.frontFace = (variation / 30) % 2 == 0 ? vk::FrontFace::eCounterClockwise : vk::FrontFace::eClockwise;
+			permutation.cullMode = cullModes[(variation / 60) % 3];
+			permutation.topology = variation < 180 ? vk::PrimitiveTopology::eTriangleList : vk::PrimitiveTopology::eTriangleStrip;
+			permutationPipelines.push_back(pipelineManager.request(permutation, graphicsPipeline));
+		}
+	}
+
+	// Opaque and alpha blended pipeline for the quad batch, the quad corners are generated in the vertex shader.
+	// Blending is the only difference, so the blended one is derived from the opaque one and falls back to it.
+	void createQuadPipelines() {
+		quadVertShaderModule = createShaderModule(assetArchive.get("quad_vert.spv"));
+		quadFragShaderModule = createShaderModule(assetArchive.get("quad_frag.spv"));
+
+		auto bindingDescription = QuadInstance::getBindingDescription();
+		auto attributeDescriptions = QuadInstance::getAttributeDescriptions();
+
+		PipelineState state;
+		state.vertexShader = *quadVertShaderModule;
+		state.fragmentShader = *quadFragShaderModule;
+		state.layout = *pipelineLayout;
+		state.renderPass = getSceneRenderPass();
+		state.bindings = { bindingDescription };
+		state.attributes.assign(attributeDescriptions.begin(), attributeDescriptions.end());
+		state.cullMode = vk::CullModeFlagBits::eNone;
+
+		quadPipelines.clear();
+		quadPipelines.push_back(pipelineManager.createNow(state));
+		state.blend = true;
+		quadPipelines.push_back(pipelineManager.request(state, quadPipelines[QUAD_PIPELINE_OPAQUE]));
+		quadPipelineHandles.resize(quadPipelines.size());
+	}
 
-		pipelineInfo.pVertexInputState = &vertexInputInfo;
-		pipelineInfo.pInputAssemblyState = &inputAssembly;
-		pipelineInfo.pViewportState = &viewportState;
-		pipelineInfo.pRasterizationState = &rasterizer;
-		pipelineInfo.pMultisampleState = &multisampling;
-		pipelineInfo.pDepthStencilState = nullptr;
-		pipelineInfo.pColorBlendState = &colorBlending;
-		pipelineInfo.pDynamicState = nullptr;
+	// The square drawn at every object, which the vertex shader reads from the object buffer by gl_InstanceIndex
+	void createObjectPipeline() {
+		objectVertShaderModule = createShaderModule(assetArchive.get("object_vert.spv"));
+		objectFragShaderModule = createShaderModule(assetArchive.get("frag.spv"));
 
-		pipelineInfo.layout = *pipelineLayout;
-		pipelineInfo.renderPass = *renderPass;
-		pipelineInfo.subpass = 0;
+		vk::DescriptorSetLayout setLayout = culler.getSetLayout();
+		vk::PushConstantRange pushConstantRange(vk::ShaderStageFlagBits::eVertex, 0, sizeof(ObjectCamera));
+
+		vk::PipelineLayoutCreateInfo pipelineLayoutInfo{};
+		pipelineLayoutInfo.setLayoutCount = 1;
+		pipelineLayoutInfo.pSetLayouts = &setLayout;
+		pipelineLayoutInfo.pushConstantRangeCount = 1;
+		pipelineLayoutInfo.pPushConstantRanges = &pushConstantRange;
 
 		try {
-			graphicsPipeline = vkDevice->createGraphicsPipelineUnique(nullptr, pipelineInfo).value;
+			objectPipelineLayout = vkDevice->createPipelineLayoutUnique(pipelineLayoutInfo);
 		}
 		catch (vk::SystemError err) {
-			throw std::runtime_error("failed to create graphics pipeline!");
+			throw std::runtime_error("failed to create pipeline layout!");
 		}
+
+		// No vertex input, the corners are picked by the vertex index
+		PipelineState state;
+		state.vertexShader = *objectVertShaderModule;
+		state.fragmentShader = *objectFragShaderModule;
+		state.layout = *objectPipelineLayout;
+		state.renderPass = getSceneRenderPass();
+		state.cullMode = vk::CullModeFlagBits::eNone;
+		// The depth pyramid is built from what the objects leave in the depth buffer
+		state.depthTest = occlusionCulling;
+		objectPipeline = pipelineManager.createNow(state);
+	}
+
+	// Swaps in the pipelines compiled since the last frame and notes when the last one arrived
+	void updatePipelines(Clock::time_point frameStart) {
+		for (size_t i = 0; i < quadPipelines.size(); ++i) {
+			quadPipelineHandles[i] = pipelineManager.get(quadPipelines[i]);
+		}
+
+		if (!pipelinesReady && pipelineManager.getPendingCount() == 0) {
+			pipelinesReady = true;
+			frameTimings.pipelinesReadyFrame = frameNumber;
+			frameTimings.pipelinesReadyMs = std::chrono::duration<double, std::milli>(frameStart - runStart).count();
+		}
+	}
+
+	vk::Pipeline getTrianglePipeline(uint32_t draw) const {
+		if (permutationPipelines.empty()) {
+			return pipelineManager.get(graphicsPipeline);
+		}
+		return pipelineManager.get(permutationPipelines[draw % permutationPipelines.size()]);
 	}
 
 	void createFrameBuffers() {
-		swapChainFramebuffers.resize(swapChainImageViews.size());
+		// The render graph creates its own
+		if (settings.renderGraph) {
+			return;
+		}
+		if (!settings.headless) {
+			swapChain.setRenderPass(*renderPass, occlusionCulling ? *depthImageView : vk::ImageView());
+			return;
+		}
 
-		for (size_t i = 0; i < swapChainImageViews.size(); ++i) {
+		offscreenFramebuffers.resize(offscreenImageViews.size());
+
+		for (size_t i = 0; i < offscreenImageViews.size(); ++i) {
 			vk::ImageView attachments[] = {
-				*swapChainImageViews[i]
+				*offscreenImageViews[i],
+				*depthImageView
 			};
 
 			vk::FramebufferCreateInfo framebufferInfo = {};
 			framebufferInfo.renderPass = *renderPass;
-			framebufferInfo.attachmentCount = 1;
+			framebufferInfo.attachmentCount = occlusionCulling ? 2 : 1;
 			framebufferInfo.pAttachments = attachments;
 			framebufferInfo.width = swapChainExtent.width;
 			framebufferInfo.height = swapChainExtent.height;
 			framebufferInfo.layers = 1;
 
 			try {
-				swapChainFramebuffers[i] = vkDevice->createFramebufferUnique(framebufferInfo); 
+				offscreenFramebuffers[i] = vkDevice->createFramebufferUnique(framebufferInfo); 
 			}
 			catch (vk::SystemError err) {
 				throw std::runtime_error("failed to create frame buffer!");
@@ -561,106 +1349,622 @@ private:
 		}
 	}
 
-	void createCommandPool() {
+	vk::Framebuffer getFramebuffer(uint32_t imageIndex) const {
+		return settings.headless ? *offscreenFramebuffers[imageIndex] : swapChain.getFramebuffer(imageIndex);
+	}
+
+	void createCommandRecorder() {
 		QueueFamilyIndices queueFamilyIndices = findQueueFamilies(vkPhysicalDevice);
 
-		vk::CommandPoolCreateInfo poolInfo = {};
-		poolInfo.queueFamilyIndex = queueFamilyIndices.graphicsFamily.value();
+		commandRecorder.init(*vkDevice, queueFamilyIndices.graphicsFamily.value(), workerPool, settings.recordThreads, settings.framesInFlight);
+	}
+
+	// Large enough for everything the first frame uploads, the bounds of the objects are the bulk of it
+	void createStagingRing() {
+		vk::DeviceSize objectSize = vk::DeviceSize(settings.objectCount) * sizeof(ObjectBounds);
+		stagingRing.init(gpuAllocator, STAGING_RING_SIZE + objectSize, settings.framesInFlight);
+	}
+
+	// Device local buffers, filled through the staging ring by the first frame's command buffer
+	void createVertexBuffers() {
+		vk::DeviceSize vertexSize = sizeof(vertices[0]) * vertices.size();
+		vertexBuffer = gpuAllocator.createBuffer(vertexSize, vk::BufferUsageFlagBits::eVertexBuffer | vk::BufferUsageFlagBits::eTransferDst,
+			vk::MemoryPropertyFlagBits::eDeviceLocal);
+		stagingRing.upload(vertexBuffer.get(), 0, vertices.data(), vertexSize);
+
+		vk::DeviceSize indexSize = sizeof(indices[0]) * indices.size();
+		indexBuffer = gpuAllocator.createBuffer(indexSize, vk::BufferUsageFlagBits::eIndexBuffer | vk::BufferUsageFlagBits::eTransferDst,
+			vk::MemoryPropertyFlagBits::eDeviceLocal);
+		stagingRing.upload(indexBuffer.get(), 0, indices.data(), indexSize);
+	}
+
+	// Textures and materials of the triangle draws. The textures are cleared by the first frame, the materials are
+	// uploaded through the staging ring. With the bindless table they are added to it once and never change.
+	void createDrawResources() {
+		if (descriptorMode == DescriptorMode::None) {
+			return;
+		}
+
+		vk::SamplerCreateInfo samplerInfo{};
+		samplerInfo.magFilter = vk::Filter::eNearest;
+		samplerInfo.minFilter = vk::Filter::eNearest;
+		samplerInfo.addressModeU = vk::SamplerAddressMode::eClampToEdge;
+		samplerInfo.addressModeV = vk::SamplerAddressMode::eClampToEdge;
+		samplerInfo.addressModeW = vk::SamplerAddressMode::eClampToEdge;
 
 		try {
-			commandPool = vkDevice->createCommandPoolUnique(poolInfo);
+			textureSampler = vkDevice->createSamplerUnique(samplerInfo);
 		}
 		catch (vk::SystemError err) {
-			throw std::runtime_error("failed to create command pool!");
+			throw std::runtime_error("failed to create texture sampler!");
+		}
+
+		for (uint32_t i = 0; i < DRAW_TEXTURE_COUNT; ++i) {
+			vk::ImageCreateInfo imageInfo{};
+			imageInfo.imageType = vk::ImageType::e2D;
+			imageInfo.format = vk::Format::eR8G8B8A8Unorm;
+			imageInfo.extent = vk::Extent3D(DRAW_TEXTURE_SIZE, DRAW_TEXTURE_SIZE, 1);
+			imageInfo.mipLevels = 1;
+			imageInfo.arrayLayers = 1;
+			imageInfo.samples = vk::SampleCountFlagBits::e1;
+			imageInfo.tiling = vk::ImageTiling::eOptimal;
+			imageInfo.usage = vk::ImageUsageFlagBits::eSampled | vk::ImageUsageFlagBits::eTransferDst;
+			imageInfo.sharingMode = vk::SharingMode::eExclusive;
+			imageInfo.initialLayout = vk::ImageLayout::eUndefined;
+			drawTextures.push_back(gpuAllocator.createImage(imageInfo, vk::MemoryPropertyFlagBits::eDeviceLocal));
+
+			auto viewInfo = vk::ImageViewCreateInfo(
+				vk::ImageViewCreateFlags(),
+				drawTextures.back().get(),
+				vk::ImageViewType::e2D,
+				imageInfo.format,
+				{},
+				{ vk::ImageAspectFlagBits::eColor, 0, 1, 0, 1 }
+			);
+			try {
+				drawTextureViews.push_back(vkDevice->createImageViewUnique(viewInfo));
+			}
+			catch (vk::SystemError err) {
+				throw std::runtime_error("failed to create image views!");
+			}
+		}
+
+		// Every material starts at an offset a storage buffer can be bound at
+		vk::DeviceSize alignment = std::max<vk::DeviceSize>(vkPhysicalDevice.getProperties().limits.minStorageBufferOffsetAlignment, 1);
+		materialStride = (sizeof(Material) + alignment - 1) / alignment * alignment;
+
+		std::vector<char> materials(materialStride * MATERIAL_COUNT);
+		for (uint32_t i = 0; i < MATERIAL_COUNT; ++i) {
+			float t = float(i) / (MATERIAL_COUNT - 1);
+			Material material = { { 0.5f + 0.5f * t, 1.0f - 0.5f * t, 0.75f, 1.0f } };
+			std::memcpy(materials.data() + i * materialStride, &material, sizeof(material));
+		}
+		materialBuffer = gpuAllocator.createBuffer(materials.size(), vk::BufferUsageFlagBits::eStorageBuffer | vk::BufferUsageFlagBits::eTransferDst,
+			vk::MemoryPropertyFlagBits::eDeviceLocal);
+		stagingRing.upload(materialBuffer.get(), 0, materials.data(), materials.size());
+
+		if (descriptorMode == DescriptorMode::Bindless) {
+			for (const auto& view : drawTextureViews) {
+				drawTextureIndices.push_back(bindlessTable.addTexture(*view, *textureSampler));
+			}
+			for (uint32_t i = 0; i < MATERIAL_COUNT; ++i) {
+				materialIndices.push_back(bindlessTable.addBuffer(materialBuffer.get(), i * materialStride, sizeof(Material)));
+			}
+		}
+	}
+
+	// Fills the draw textures with their color and moves them into shader read layout, once before the first draws
+	void clearDrawTextures(vk::CommandBuffer commandBuffer) {
+		const std::array<float, 4> colors[DRAW_TEXTURE_COUNT] = {
+			{ 1.0f, 1.0f, 1.0f, 1.0f }, { 1.0f, 0.6f, 0.6f, 1.0f }, { 0.6f, 1.0f, 0.6f, 1.0f }, { 0.6f, 0.6f, 1.0f, 1.0f }
+		};
+		vk::ImageSubresourceRange range(vk::ImageAspectFlagBits::eColor, 0, 1, 0, 1);
+
+		std::vector<vk::ImageMemoryBarrier> barriers;
+		for (const auto& texture : drawTextures) {
+			barriers.push_back(vk::ImageMemoryBarrier(vk::AccessFlags(), vk::AccessFlagBits::eTransferWrite,
+				vk::ImageLayout::eUndefined, vk::ImageLayout::eTransferDstOptimal, VK_QUEUE_FAMILY_IGNORED, VK_QUEUE_FAMILY_IGNORED, texture.get(), range));
+		}
+		commandBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eTopOfPipe, vk::PipelineStageFlagBits::eTransfer,
+			vk::DependencyFlags(), nullptr, nullptr, barriers);
+
+		for (size_t i = 0; i < drawTextures.size(); ++i) {
+			commandBuffer.clearColorImage(drawTextures[i].get(), vk::ImageLayout::eTransferDstOptimal, vk::ClearColorValue(colors[i]), range);
+		}
+
+		for (auto& barrier : barriers) {
+			barrier.srcAccessMask = vk::AccessFlagBits::eTransferWrite;
+			barrier.dstAccessMask = vk::AccessFlagBits::eShaderRead;
+			barrier.oldLayout = vk::ImageLayout::eTransferDstOptimal;
+			barrier.newLayout = vk::ImageLayout::eShaderReadOnlyOptimal;
+		}
+		commandBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eTransfer, vk::PipelineStageFlagBits::eFragmentShader,
+			vk::DependencyFlags(), nullptr, nullptr, barriers);
+		drawTexturesCleared = true;
+	}
+
+	// The fence of the frame slot has been waited on, so its per draw sets can be reused. Bindless descriptors added
+	// since the last frame are written before it is recorded.
+	void updateDescriptors() {
+		if (descriptorMode == DescriptorMode::PerDraw) {
+			descriptorAllocator.beginFrame(currentFrame);
+		}
+		else if (descriptorMode == DescriptorMode::Bindless) {
+			bindlessTable.releaseRetired(frameSync.getCompletedValue());
+			bindlessTable.update();
+		}
+	}
+
+	// Texture and material of a triangle draw, pushed as bindless indices or written into a set of its own. The per
+	// draw set is what the bindless table saves: an allocation, a descriptor write and a bind for every draw.
+	void bindDrawResources(vk::CommandBuffer commandBuffer, uint32_t threadIndex, uint32_t draw) {
+		uint32_t texture = draw % DRAW_TEXTURE_COUNT, material = draw % MATERIAL_COUNT;
+
+		if (descriptorMode == DescriptorMode::Bindless) {
+			DrawIndices indices = { drawTextureIndices[texture], materialIndices[material] };
+			commandBuffer.pushConstants(*pipelineLayout, vk::ShaderStageFlagBits::eFragment, 0, sizeof(indices), &indices);
+		}
+		else if (descriptorMode == DescriptorMode::PerDraw) {
+			vk::DescriptorSet set = descriptorAllocator.allocate(threadIndex, *drawSetLayout);
+
+			vk::DescriptorImageInfo imageInfo(*textureSampler, *drawTextureViews[texture], vk::ImageLayout::eShaderReadOnlyOptimal);
+			vk::DescriptorBufferInfo bufferInfo(materialBuffer.get(), material * materialStride, sizeof(Material));
+			std::array<vk::WriteDescriptorSet, 2> writes = {
+				vk::WriteDescriptorSet(set, 0, 0, 1, vk::DescriptorType::eCombinedImageSampler, &imageInfo),
+				vk::WriteDescriptorSet(set, 1, 0, 1, vk::DescriptorType::eStorageBuffer, nullptr, &bufferInfo)
+			};
+			vkDevice->updateDescriptorSets(writes, nullptr);
+			commandBuffer.bindDescriptorSets(vk::PipelineBindPoint::eGraphics, *pipelineLayout, 0, set, nullptr);
+		}
+	}
+
+	// Random objects in a cube around the camera, which turns on the spot and sees less than a tenth of them, behind a
+	// ring of occluders. The cull shader is only needed when culling on the GPU.
+	void createObjects() {
+		if (settings.objectCount == 0) {
+			return;
 		}
+
+		std::mt19937 random(1);
+		std::uniform_real_distribution<float> position(-OBJECT_FIELD_EXTENT, OBJECT_FIELD_EXTENT);
+		std::uniform_real_distribution<float> size(OBJECT_MIN_SIZE, OBJECT_MAX_SIZE);
+		objects.resize(settings.objectCount);
+		for (uint32_t i = 0; i < objects.size(); ++i) {
+			if (i < OCCLUDER_COUNT) {
+				float angle = 2.0f * 3.14159265f * i / OCCLUDER_COUNT;
+				objects[i] = { { std::sin(angle) * OCCLUDER_DISTANCE, 0.0f, std::cos(angle) * OCCLUDER_DISTANCE, 0.0f },
+					{ OCCLUDER_SIZE, OCCLUDER_SIZE, OCCLUDER_SIZE, 0.0f } };
+				continue;
+			}
+			float extent = size(random);
+			objects[i] = { { position(random), position(random), position(random), 0.0f }, { extent, extent, extent, 0.0f } };
+		}
+
+		vk::ShaderModule cullShader;
+		if (cullingMode == CullingMode::Gpu) {
+			cullShaderModule = createShaderModule(assetArchive.get(occlusionCulling ? "cull_occlusion_comp.spv" : "cull_comp.spv"));
+			cullShader = *cullShaderModule;
+		}
+		culler.init(*vkDevice, gpuAllocator, stagingRing, settings.framesInFlight, objects, static_cast<uint32_t>(indices.size()), cullShader, pipelineCache.get(),
+			occlusionCulling ? &depthPyramid : nullptr);
 	}
 
-	void createCommandBuffers() {
-		commandBuffers.resize(swapChainFramebuffers.size());
+	// Turns the camera and culls the objects against it on the CPU, the GPU culling is recorded with the frame
+	void cullObjects() {
+		if (settings.objectCount == 0) {
+			return;
+		}
 
-		vk::CommandBufferAllocateInfo allocateInfo{};
-		allocateInfo.commandPool = *commandPool;
-		allocateInfo.level = vk::CommandBufferLevel::ePrimary;
-		allocateInfo.commandBufferCount = (uint32_t)commandBuffers.size();
+		// Column major, the camera sits at the origin and turns around the y axis. Clip space y points down and depth
+		// goes from 0 at the near plane to 1 at the far plane, which lies beyond the corners of the cube.
+		float yaw = frameNumber * OBJECT_CAMERA_TURN_PER_FRAME;
+		float c = std::cos(yaw), s = std::sin(yaw);
+		float f = 1.0f / std::tan(OBJECT_CAMERA_FOV / 2.0f);
+		float aspect = float(swapChainExtent.width) / float(swapChainExtent.height);
+		float nearPlane = 0.1f, farPlane = 2.0f * OBJECT_FIELD_EXTENT;
+		float a = farPlane / (nearPlane - farPlane), b = nearPlane * farPlane / (nearPlane - farPlane);
+		const float viewProjection[16] = {
+			f / aspect * c, 0.0f, a * s, -s,
+			0.0f, -f, 0.0f, 0.0f,
+			-f / aspect * s, 0.0f, a * c, -c,
+			0.0f, 0.0f, b, 0.0f
+		};
+		const float right[4] = { c, 0.0f, -s, 0.0f }, up[4] = { 0.0f, 1.0f, 0.0f, 0.0f };
+		std::memcpy(objectCamera.viewProjection, viewProjection, sizeof(viewProjection));
+		std::memcpy(objectCamera.right, right, sizeof(right));
+		std::memcpy(objectCamera.up, up, sizeof(up));
+		objectFrustum = Warp::Math::Frustum::fromMatrix({ Warp::Math::Vec4::load(viewProjection), Warp::Math::Vec4::load(viewProjection + 4),
+			Warp::Math::Vec4::load(viewProjection + 8), Warp::Math::Vec4::load(viewProjection + 12) });
+
+		if (culler.beginFrame(currentFrame)) {
+			frameTimings.visibleObjects.push_back(culler.getStatistics().visibleCount);
+		}
+		if (cullingMode == CullingMode::Gpu) {
+			return;
+		}
+
+		visibleObjects.clear();
+		for (uint32_t i = 0; i < objects.size(); ++i) {
+			if (objectFrustum.intersects(objects[i].toAabb())) {
+				visibleObjects.push_back(i);
+			}
+		}
+		frameTimings.visibleObjects.push_back(static_cast<double>(visibleObjects.size()));
+	}
+
+	// Buffers of the background work in every slot, and its compute pipeline when it dispatches
+	void createBackgroundWork() {
+		if (settings.backgroundDispatches == 0 && settings.backgroundUploadBytes == 0) {
+			return;
+		}
+
+		uint32_t slotCount = settings.framesInFlight + 1;
+		backgroundSlots.clear();
+		backgroundSlots.resize(slotCount);
+		for (auto& slot : backgroundSlots) {
+			// Stands in for streamed data, written once and copied by every frame using the slot
+			if (settings.backgroundUploadBytes > 0) {
+				slot.uploadSource = gpuAllocator.createBuffer(settings.backgroundUploadBytes, vk::BufferUsageFlagBits::eTransferSrc,
+					vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent);
+				std::memset(slot.uploadSource.getMapped(), 0x5a, settings.backgroundUploadBytes);
+				slot.uploadDestination = gpuAllocator.createBuffer(settings.backgroundUploadBytes,
+					vk::BufferUsageFlagBits::eStorageBuffer | vk::BufferUsageFlagBits::eTransferDst, vk::MemoryPropertyFlagBits::eDeviceLocal);
+			}
+			if (settings.backgroundDispatches > 0) {
+				slot.particles = gpuAllocator.createBuffer(sizeof(float) * 4 * BACKGROUND_PARTICLE_COUNT, vk::BufferUsageFlagBits::eStorageBuffer,
+					vk::MemoryPropertyFlagBits::eDeviceLocal);
+			}
+		}
+		if (settings.backgroundDispatches == 0) {
+			return;
+		}
+
+		vk::DescriptorSetLayoutBinding binding(0, vk::DescriptorType::eStorageBuffer, 1, vk::ShaderStageFlagBits::eCompute);
+		vk::DescriptorSetLayoutCreateInfo layoutInfo(vk::DescriptorSetLayoutCreateFlags(), 1, &binding);
+		vk::DescriptorPoolSize poolSize(vk::DescriptorType::eStorageBuffer, slotCount);
+		vk::DescriptorPoolCreateInfo poolInfo(vk::DescriptorPoolCreateFlags(), slotCount, 1, &poolSize);
+		vk::PushConstantRange pushConstantRange(vk::ShaderStageFlagBits::eCompute, 0, sizeof(BackgroundWork));
+
+		backgroundShaderModule = createShaderModule(assetArchive.get("background_comp.spv"));
+		vk::ComputePipelineCreateInfo pipelineInfo{};
+		pipelineInfo.stage = vk::PipelineShaderStageCreateInfo(vk::PipelineShaderStageCreateFlags(), vk::ShaderStageFlagBits::eCompute, *backgroundShaderModule, "main");
 
 		try {
-			commandBuffers = vkDevice->allocateCommandBuffersUnique(allocateInfo);
+			backgroundSetLayout = vkDevice->createDescriptorSetLayoutUnique(layoutInfo);
+			backgroundPool = vkDevice->createDescriptorPoolUnique(poolInfo);
+			backgroundPipelineLayout = vkDevice->createPipelineLayoutUnique({ vk::PipelineLayoutCreateFlags(), 1, &*backgroundSetLayout, 1, &pushConstantRange });
+			pipelineInfo.layout = *backgroundPipelineLayout;
+			backgroundPipeline = std::move(vkDevice->createComputePipelineUnique(pipelineCache.get(), pipelineInfo).value);
 		}
 		catch (vk::SystemError err) {
-			throw std::runtime_error("failed to allocate command buffers!");
+			throw std::runtime_error("failed to create background pipeline!");
 		}
 
-		for (int i = 0; i < commandBuffers.size(); ++i) {
-			vk::CommandBufferBeginInfo beginInfo{};
+		std::vector<vk::DescriptorSetLayout> setLayouts(slotCount, *backgroundSetLayout);
+		std::vector<vk::DescriptorSet> sets = vkDevice->allocateDescriptorSets(vk::DescriptorSetAllocateInfo(*backgroundPool, slotCount, setLayouts.data()));
+		for (uint32_t i = 0; i < slotCount; ++i) {
+			backgroundSlots[i].set = sets[i];
+			vk::DescriptorBufferInfo bufferInfo(backgroundSlots[i].particles.get(), 0, VK_WHOLE_SIZE);
+			vkDevice->updateDescriptorSets(vk::WriteDescriptorSet(sets[i], 0, 0, 1, vk::DescriptorType::eStorageBuffer, nullptr, &bufferInfo), nullptr);
+		}
+	}
 
-			try {
-				commandBuffers[i]->begin(beginInfo);
+	// Submits the frame's background work to the async queues, the frame after acquires the results. Work without
+	// an async queue is recorded into the frame by recordBackgroundWork.
+	void submitBackgroundWork() {
+		if (backgroundSlots.empty()) {
+			return;
+		}
+
+		uint64_t frame = frameSync.getFrameValue();
+		BackgroundSlot& slot = backgroundSlots[frame % backgroundSlots.size()];
+		slot.frame = frame;
+		slot.computeValue = 0;
+		slot.uploadValue = 0;
+
+		// The frame that acquired the slot's last results, usually long done as the CPU waited for it in waitForSlot.
+		// Their contents are overwritten, so the buffers are not released back by the graphics family.
+		uint64_t lastReader = frame > backgroundSlots.size() ? frame - backgroundSlots.size() + 1 : 0;
+
+		bool dispatching = settings.backgroundDispatches > 0 && computeQueue.isValid();
+		bool computeUploads = uploadQueue == &computeQueue;
+		if (dispatching || computeUploads) {
+			vk::CommandBuffer commandBuffer = computeQueue.begin();
+			if (dispatching) {
+				recordBackgroundCompute(commandBuffer, slot);
+				computeQueue.releaseBuffer(commandBuffer, slot.particles.get(), graphicsFamily,
+					vk::PipelineStageFlagBits::eComputeShader, vk::AccessFlagBits::eShaderWrite);
 			}
-			catch (vk::SystemError err) {
-				throw std::runtime_error("failed to being recording command buffer!");
+			if (computeUploads) {
+				recordBackgroundUpload(commandBuffer, slot);
+				computeQueue.releaseBuffer(commandBuffer, slot.uploadDestination.get(), graphicsFamily,
+					vk::PipelineStageFlagBits::eTransfer, vk::AccessFlagBits::eTransferWrite);
+			}
+			uint64_t value = computeQueue.submit(frameSync.getTimeline(), lastReader);
+			slot.computeValue = dispatching ? value : 0;
+			slot.uploadValue = computeUploads ? value : 0;
+		}
+		if (uploadQueue == &transferQueue) {
+			vk::CommandBuffer commandBuffer = transferQueue.begin();
+			recordBackgroundUpload(commandBuffer, slot);
+			transferQueue.releaseBuffer(commandBuffer, slot.uploadDestination.get(), graphicsFamily,
+				vk::PipelineStageFlagBits::eTransfer, vk::AccessFlagBits::eTransferWrite);
+			slot.uploadValue = transferQueue.submit(frameSync.getTimeline(), lastReader, vk::PipelineStageFlagBits::eTransfer);
+		}
+	}
+
+	// Acquires the previous frame's results from the async queues and records the background work that has none, the
+	// results are made visible to the vertex shaders as a consumer would read them
+	void recordBackgroundWork(vk::CommandBuffer commandBuffer) {
+		if (backgroundSlots.empty()) {
+			return;
+		}
+
+		uint64_t frame = frameSync.getFrameValue();
+		const BackgroundSlot& previous = backgroundSlots[(frame - 1) % backgroundSlots.size()];
+		if (frame > 1 && previous.frame == frame - 1) {
+			if (previous.computeValue > 0) {
+				AsyncQueue::acquireBuffer(commandBuffer, previous.particles.get(), computeQueue.getFamily(), graphicsFamily,
+					vk::PipelineStageFlagBits::eVertexShader, vk::AccessFlagBits::eShaderRead);
+				frameSync.addWait(computeQueue.getSemaphore(), previous.computeValue, vk::PipelineStageFlagBits::eVertexShader);
 			}
+			if (previous.uploadValue > 0) {
+				AsyncQueue::acquireBuffer(commandBuffer, previous.uploadDestination.get(), uploadQueue->getFamily(), graphicsFamily,
+					vk::PipelineStageFlagBits::eVertexShader, vk::AccessFlagBits::eShaderRead);
+				frameSync.addWait(uploadQueue->getSemaphore(), previous.uploadValue, vk::PipelineStageFlagBits::eVertexShader);
+			}
+		}
+
+		BackgroundSlot& slot = backgroundSlots[frame % backgroundSlots.size()];
+		if (settings.backgroundDispatches > 0 && !computeQueue.isValid()) {
+			GpuProfiler::Scope computeZone(gpuProfiler, commandBuffer, "Background compute");
+			recordBackgroundCompute(commandBuffer, slot);
+			vk::BufferMemoryBarrier barrier(vk::AccessFlagBits::eShaderWrite, vk::AccessFlagBits::eShaderRead,
+				VK_QUEUE_FAMILY_IGNORED, VK_QUEUE_FAMILY_IGNORED, slot.particles.get(), 0, VK_WHOLE_SIZE);
+			commandBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eComputeShader, vk::PipelineStageFlagBits::eVertexShader,
+				vk::DependencyFlags(), nullptr, barrier, nullptr);
+		}
+		if (settings.backgroundUploadBytes > 0 && !uploadQueue) {
+			GpuProfiler::Scope uploadZone(gpuProfiler, commandBuffer, "Background upload");
+			recordBackgroundUpload(commandBuffer, slot);
+			vk::BufferMemoryBarrier barrier(vk::AccessFlagBits::eTransferWrite, vk::AccessFlagBits::eShaderRead,
+				VK_QUEUE_FAMILY_IGNORED, VK_QUEUE_FAMILY_IGNORED, slot.uploadDestination.get(), 0, VK_WHOLE_SIZE);
+			commandBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eTransfer, vk::PipelineStageFlagBits::eVertexShader,
+				vk::DependencyFlags(), nullptr, barrier, nullptr);
+		}
+	}
+
+	// Every dispatch integrates all particles again, ordered after the one before as they write the same buffer
+	void recordBackgroundCompute(vk::CommandBuffer commandBuffer, const BackgroundSlot& slot) {
+		BackgroundWork work = { BACKGROUND_PARTICLE_COUNT, BACKGROUND_STEPS, frameNumber * 0.01f };
+		commandBuffer.bindPipeline(vk::PipelineBindPoint::eCompute, *backgroundPipeline);
+		commandBuffer.bindDescriptorSets(vk::PipelineBindPoint::eCompute, *backgroundPipelineLayout, 0, slot.set, nullptr);
+		commandBuffer.pushConstants(*backgroundPipelineLayout, vk::ShaderStageFlagBits::eCompute, 0, sizeof(work), &work);
+
+		vk::MemoryBarrier barrier(vk::AccessFlagBits::eShaderWrite, vk::AccessFlagBits::eShaderWrite);
+		for (uint32_t i = 0; i < settings.backgroundDispatches; ++i) {
+			if (i > 0) {
+				commandBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eComputeShader, vk::PipelineStageFlagBits::eComputeShader,
+					vk::DependencyFlags(), barrier, nullptr, nullptr);
+			}
+			commandBuffer.dispatch((BACKGROUND_PARTICLE_COUNT + 63) / 64, 1, 1);
+		}
+	}
+
+	void recordBackgroundUpload(vk::CommandBuffer commandBuffer, const BackgroundSlot& slot) {
+		commandBuffer.copyBuffer(slot.uploadSource.get(), slot.uploadDestination.get(), vk::BufferCopy(0, 0, settings.backgroundUploadBytes));
+	}
 
+	// Fills the quad batch with a grid of quads that sway from side to side, split into one run per pipeline and texture
+	void fillQuads() {
+		quadBatch.beginFrame(currentFrame);
+		if (settings.quadCount == 0) {
+			return;
+		}
+
+		uint32_t quadCount = settings.quadCount;
+		uint32_t columns = static_cast<uint32_t>(std::ceil(std::sqrt(double(quadCount))));
+		float cellSize = 2.0f / columns;
+		float time = frameNumber * 0.05f;
+		uint32_t groupCount = 2 * QUAD_TEXTURE_COUNT;
+
+		quadBatch.fill(quadCount, [=](QuadBatch::Writer& writer, uint32_t begin, uint32_t end) {
+			for (uint32_t i = begin; i < end; ++i) {
+				uint32_t column = i % columns, row = i / columns;
+				uint32_t group = static_cast<uint32_t>(uint64_t(i) * groupCount / quadCount);
+
+				QuadInstance quad;
+				quad.position[0] = -1.0f + (column + 0.5f) * cellSize + std::sin(time + row * 0.1f) * cellSize * 0.25f;
+				quad.position[1] = -1.0f + (row + 0.5f) * cellSize;
+				quad.size[0] = cellSize * 0.8f;
+				quad.size[1] = cellSize * 0.8f;
+				quad.textureIndex = group % QUAD_TEXTURE_COUNT;
+
+				uint32_t pipeline = group < QUAD_TEXTURE_COUNT ? QUAD_PIPELINE_OPAQUE : QUAD_PIPELINE_BLENDED;
+				uint32_t alpha = pipeline == QUAD_PIPELINE_OPAQUE ? 0xFF : 0x80;
+				quad.color = (i * 2654435761u & 0x00FFFFFF) | (alpha << 24);
+
+				writer.add(pipeline, quad);
+			}
+		});
+	}
+
+	// Records the frame from scratch, the fence of the current frame slot has already been waited on
+	vk::CommandBuffer recordCommandBuffer(uint32_t imageIndex) {
+		vk::CommandBuffer commandBuffer = commandRecorder.beginFrame(currentFrame);
+		gpuProfiler.beginFrame(commandBuffer, currentFrame);
+		uint32_t frameZone = gpuProfiler.beginZone(commandBuffer, "Frame");
+
+		{
+			GpuProfiler::Scope uploadZone(gpuProfiler, commandBuffer, "Upload");
+			stagingRing.flush(commandBuffer);
+			if (!drawTexturesCleared && !drawTextures.empty()) {
+				clearDrawTextures(commandBuffer);
+			}
+			if (occlusionCulling && !depthPyramid.isInitialized()) {
+				depthPyramid.initialize(commandBuffer);
+			}
+		}
+		recordBackgroundWork(commandBuffer);
+		if (settings.objectCount > 0 && cullingMode == CullingMode::Gpu) {
+			GpuProfiler::Scope cullZone(gpuProfiler, commandBuffer, "Cull");
+			culler.cull(commandBuffer, objectFrustum, objectCamera.viewProjection);
+		}
+
+		// Pipeline statistics queries have to begin outside of the render pass
+		uint32_t renderPassZone = gpuProfiler.beginZone(commandBuffer, settings.renderGraph ? "Render graph" : "Render pass", true);
+		if (settings.renderGraph) {
+			if (settings.headless) {
+				renderGraph.setImportedImage(graphOutput, offscreenImages[imageIndex].get(), *offscreenImageViews[imageIndex]);
+			}
+			else {
+				renderGraph.setImportedImage(graphOutput, swapChain.getImage(imageIndex), swapChain.getImageView(imageIndex));
+			}
+			renderGraph.execute(commandBuffer);
+		}
+		else {
 			vk::RenderPassBeginInfo renderPassInfo{};
 			renderPassInfo.renderPass = *renderPass;
-			renderPassInfo.framebuffer = *swapChainFramebuffers[i];
+			renderPassInfo.framebuffer = getFramebuffer(imageIndex);
 
 			renderPassInfo.renderArea.offset = vk::Offset2D( 0, 0 );
 			renderPassInfo.renderArea.extent = swapChainExtent;
 
-			vk::ClearValue clearColor = { std::array<float, 4>{0.0f, 0.0f, 0.0f, 1.0f} };
-			renderPassInfo.clearValueCount = 1;
-			renderPassInfo.pClearValues = &clearColor;
+			vk::ClearValue clearValues[] = {
+				vk::ClearColorValue(std::array<float, 4>{0.0f, 0.0f, 0.0f, 1.0f}),
+				vk::ClearDepthStencilValue(1.0f, 0)
+			};
+			renderPassInfo.clearValueCount = occlusionCulling ? 2 : 1;
+			renderPassInfo.pClearValues = clearValues;
 
-			commandBuffers[i]->beginRenderPass(renderPassInfo, vk::SubpassContents::eInline);
+			commandBuffer.beginRenderPass(renderPassInfo, vk::SubpassContents::eSecondaryCommandBuffers);
+			recordScene(*renderPass, getFramebuffer(imageIndex));
+			commandBuffer.endRenderPass();
+		}
+		gpuProfiler.endZone(commandBuffer, renderPassZone);
+		if (occlusionCulling) {
+			recordLateObjects(commandBuffer, imageIndex);
+		}
 
-			commandBuffers[i]->bindPipeline(vk::PipelineBindPoint::eGraphics, *graphicsPipeline);
+		gpuProfiler.endZone(commandBuffer, frameZone);
+		return commandRecorder.endFrame();
+	}
 
-			commandBuffers[i]->draw(6, 1, 0, 0);
-			
-			commandBuffers[i]->endRenderPass();
+	// Records the draws into secondary buffers and executes them, inside the scene's render pass
+	void recordScene(vk::RenderPass sceneRenderPass, vk::Framebuffer framebuffer) {
+		vk::CommandBufferInheritanceInfo inheritanceInfo{};
+		inheritanceInfo.renderPass = sceneRenderPass;
+		inheritanceInfo.subpass = 0;
+		inheritanceInfo.framebuffer = framebuffer;
+		inheritanceInfo.pipelineStatistics = gpuProfiler.getPipelineStatisticsFlags();
+
+		// The triangle draws come first, followed by the objects, one draw per visible object or a single indirect draw,
+		// and one draw per quad batch. Pipeline state is not inherited, every secondary buffer binds it again.
+		uint32_t triangleDraws = settings.drawCount;
+		uint32_t objectDraws = settings.objectCount == 0 ? 0
+			: cullingMode == CullingMode::Gpu ? 1 : static_cast<uint32_t>(visibleObjects.size());
+		uint32_t objectEnd = triangleDraws + objectDraws;
+		uint32_t quadDraws = static_cast<uint32_t>(quadBatch.getBatches().size());
+		vk::Viewport viewport(0.0f, 0.0f, (float) swapChainExtent.width, (float) swapChainExtent.height, 0.0f, 1.0f);
+		vk::Rect2D scissor({ 0, 0 }, swapChainExtent);
+		commandRecorder.recordDraws(inheritanceInfo, objectEnd + quadDraws, [&, triangleDraws, objectEnd](vk::CommandBuffer secondary, uint32_t threadIndex, uint32_t begin, uint32_t end) {
+			secondary.setViewport(0, viewport);
+			secondary.setScissor(0, scissor);
+
+			if (begin < triangleDraws) {
+				secondary.bindVertexBuffers(0, vertexBuffer.get(), vk::DeviceSize(0));
+				secondary.bindIndexBuffer(indexBuffer.get(), 0, vk::IndexType::eUint16);
+				if (descriptorMode == DescriptorMode::Bindless) {
+					secondary.bindDescriptorSets(vk::PipelineBindPoint::eGraphics, *pipelineLayout, 0, bindlessTable.getSet(), nullptr);
+				}
 
-			try {
-				commandBuffers[i]->end();
+				vk::Pipeline boundPipeline;
+				for (uint32_t draw = begin; draw < std::min(end, triangleDraws); ++draw) {
+					vk::Pipeline pipeline = getTrianglePipeline(draw);
+					if (pipeline != boundPipeline) {
+						secondary.bindPipeline(vk::PipelineBindPoint::eGraphics, pipeline);
+						boundPipeline = pipeline;
+					}
+					bindDrawResources(secondary, threadIndex, draw);
+					secondary.drawIndexed(static_cast<uint32_t>(indices.size()), 1, 0, 0, draw);
+				}
 			}
-			catch (vk::SystemError err) {
-				throw std::runtime_error("failed to record command buffer!");
+
+			if (begin < objectEnd && end > triangleDraws) {
+				secondary.bindPipeline(vk::PipelineBindPoint::eGraphics, pipelineManager.get(objectPipeline));
+				secondary.bindIndexBuffer(indexBuffer.get(), 0, vk::IndexType::eUint16);
+				secondary.bindDescriptorSets(vk::PipelineBindPoint::eGraphics, *objectPipelineLayout, 0, culler.getSet(), nullptr);
+				secondary.pushConstants(*objectPipelineLayout, vk::ShaderStageFlagBits::eVertex, 0, sizeof(objectCamera), &objectCamera);
+
+				if (cullingMode == CullingMode::Gpu) {
+					culler.draw(secondary);
+				}
+				else {
+					for (uint32_t draw = std::max(begin, triangleDraws); draw < std::min(end, objectEnd); ++draw) {
+						secondary.drawIndexed(static_cast<uint32_t>(indices.size()), 1, 0, 0, visibleObjects[draw - triangleDraws]);
+					}
+				}
 			}
+
+			if (end > objectEnd) {
+				quadBatch.record(secondary, quadPipelineHandles.data(), std::max(begin, objectEnd) - objectEnd, end - objectEnd);
+			}
+		});
+	}
+
+	// Second phase of the occlusion culling, after the scene's render pass. The depth pyramid is rebuilt from what the
+	// first phase drew, the objects it found hidden are tested against it again and those visible now drawn on top.
+	void recordLateObjects(vk::CommandBuffer commandBuffer, uint32_t imageIndex) {
+		{
+			GpuProfiler::Scope pyramidZone(gpuProfiler, commandBuffer, "Depth pyramid");
+			depthPyramid.build(commandBuffer);
+		}
+		{
+			GpuProfiler::Scope cullZone(gpuProfiler, commandBuffer, "Late cull");
+			culler.cullLate(commandBuffer);
 		}
 
+		GpuProfiler::Scope renderPassZone(gpuProfiler, commandBuffer, "Late render pass", true);
+		vk::RenderPassBeginInfo renderPassInfo{};
+		renderPassInfo.renderPass = *lateRenderPass;
+		renderPassInfo.framebuffer = getFramebuffer(imageIndex);
+		renderPassInfo.renderArea = vk::Rect2D({ 0, 0 }, swapChainExtent);
+		commandBuffer.beginRenderPass(renderPassInfo, vk::SubpassContents::eInline);
+
+		commandBuffer.setViewport(0, vk::Viewport(0.0f, 0.0f, (float) swapChainExtent.width, (float) swapChainExtent.height, 0.0f, 1.0f));
+		commandBuffer.setScissor(0, vk::Rect2D({ 0, 0 }, swapChainExtent));
+		commandBuffer.bindPipeline(vk::PipelineBindPoint::eGraphics, pipelineManager.get(objectPipeline));
+		commandBuffer.bindIndexBuffer(indexBuffer.get(), 0, vk::IndexType::eUint16);
+		commandBuffer.bindDescriptorSets(vk::PipelineBindPoint::eGraphics, *objectPipelineLayout, 0, culler.getSet(), nullptr);
+		commandBuffer.pushConstants(*objectPipelineLayout, vk::ShaderStageFlagBits::eVertex, 0, sizeof(objectCamera), &objectCamera);
+		culler.drawLate(commandBuffer);
+
+		commandBuffer.endRenderPass();
 	}
 
 	void createSyncObjects() {
-		imageAvailableSemaphores.resize(MAX_FRAMES_IN_FLIGHT);
-		renderFinishedSemaphores.resize(MAX_FRAMES_IN_FLIGHT);
-		inFlightFences.resize(MAX_FRAMES_IN_FLIGHT);
-		vk::SemaphoreCreateInfo semaphoreInfo{};
-		imagesInFlight.resize(swapChainImages.size());
+		frameSync.init(*vkDevice, settings.framesInFlight, settings.headless ? 0 : swapChain.getImageCount());
+	}
 
-		for (size_t i = 0; i < swapChainImages.size(); ++i) {
-			imagesInFlight[i] = nullptr;
-		}
+	void createGpuProfiler() {
+		QueueFamilyIndices indices = findQueueFamilies(vkPhysicalDevice);
 
-		vk::FenceCreateInfo fenceInfo{};
-		fenceInfo.flags = vk::FenceCreateFlagBits::eSignaled;
-		
-		for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; ++i) {
-			try {
-				imageAvailableSemaphores[i] = vkDevice->createSemaphoreUnique(semaphoreInfo);
-				renderFinishedSemaphores[i] = vkDevice->createSemaphoreUnique(semaphoreInfo);
-				inFlightFences[i] = vkDevice->createFenceUnique(fenceInfo);
-			}
-			catch (vk::SystemError err) {
-				throw std::runtime_error("failed to create semaphores!");
-			}
-		}
+		gpuProfiler.init(vkPhysicalDevice, *vkDevice, indices.graphicsFamily.value(), settings.framesInFlight, pipelineStatisticsSupported);
+		gpuProfiler.calibrate(graphicsQueue);
+		gpuProfiler.setCapture(!settings.tracePath.empty());
 	}
 
 	std::vector<const char*> getRequiredExtensions() {
-		uint32_t glfwExtensionCount = 0;
-		const char** glfwExtensions;
-		glfwExtensions = glfwGetRequiredInstanceExtensions(&glfwExtensionCount);
+		std::vector<const char*> extensions;
+
+		// Surface extensions are only needed to present into a window
+		if (!settings.headless) {
+			uint32_t glfwExtensionCount = 0;
+			const char** glfwExtensions;
+			glfwExtensions = glfwGetRequiredInstanceExtensions(&glfwExtensionCount);
 
-		std::vector<const char*> extensions(glfwExtensions, glfwExtensions + glfwExtensionCount);
+			extensions.assign(glfwExtensions, glfwExtensions + glfwExtensionCount);
+		}
 
 		if (enableValidationLayers) {
 			extensions.push_back(VK_EXT_DEBUG_UTILS_EXTENSION_NAME);
@@ -687,11 +1991,21 @@ private:
 	bool isDeviceSuitable(const vk::PhysicalDevice& device) {
 		QueueFamilyIndices indices = findQueueFamilies(device);
 
+		// Frames are paced with a timeline semaphore
+		if (device.getProperties().apiVersion < VK_API_VERSION_1_2
+			|| !device.getFeatures2<vk::PhysicalDeviceFeatures2, vk::PhysicalDeviceTimelineSemaphoreFeatures>().get<vk::PhysicalDeviceTimelineSemaphoreFeatures>().timelineSemaphore) {
+			return false;
+		}
+
+		if (settings.headless) {
+			return indices.isComplete(false);
+		}
+
 		bool extensionsSupported = checkDeviceExtensionSupport(device);
 
 		bool swapChainAdequate = false;
 		if (extensionsSupported) {
-			SwapChainSupportDetails swapChainSupport = querySwapChainSupport(device);
+			SwapChainSupportDetails swapChainSupport = SwapChain::querySupport(device, *vkSurface);
 			swapChainAdequate = !swapChainSupport.formats.empty() && !swapChainSupport.presentModes.empty();
 		}
 
@@ -705,14 +2019,22 @@ private:
 
 		int i = 0;
 		for (const auto& family : families) {
-			if (family.queueCount > 0 && family.queueFlags & vk::QueueFlagBits::eGraphics) {
-				indices.graphicsFamily = i;
-			}
-			if (family.queueCount > 0 && device.getSurfaceSupportKHR(i, *vkSurface)) {
-				indices.presentFamily = i;
+			if (family.queueCount > 0 && !indices.isComplete(!settings.headless)) {
+				if (family.queueFlags & vk::QueueFlagBits::eGraphics) {
+					indices.graphicsFamily = i;
+				}
+				if (vkSurface && device.getSurfaceSupportKHR(i, *vkSurface)) {
+					indices.presentFamily = i;
+				}
 			}
-			if (indices.isComplete()) {
-				break;
+			// The first family of each kind, usually there is only one
+			if (family.queueCount > 0 && !(family.queueFlags & vk::QueueFlagBits::eGraphics)) {
+				if (!indices.computeFamily && family.queueFlags & vk::QueueFlagBits::eCompute) {
+					indices.computeFamily = i;
+				}
+				if (!indices.transferFamily && family.queueFlags & vk::QueueFlagBits::eTransfer && !(family.queueFlags & vk::QueueFlagBits::eCompute)) {
+					indices.transferFamily = i;
+				}
 			}
 			
 			++i;
@@ -720,46 +2042,6 @@ private:
 		return indices;
 	}
 
-	SwapChainSupportDetails querySwapChainSupport(const vk::PhysicalDevice& device) {
-		return {
-			device.getSurfaceCapabilitiesKHR(*vkSurface),
-			device.getSurfaceFormatsKHR(*vkSurface),
-			device.getSurfacePresentModesKHR(*vkSurface)
-		};
-	}
-
-	vk::SurfaceFormatKHR chooseSwapSurfaceFormat(const std::vector<vk::SurfaceFormatKHR>& availableFormats) {
-		for (const auto& availableFormat : availableFormats) {
-			if (availableFormat.format == vk::Format::eB8G8R8A8Srgb && availableFormat.colorSpace == vk::ColorSpaceKHR::eSrgbNonlinear) {
-				return availableFormat;
-			}
-		}
-		return availableFormats[0];
-	}
-
-	vk::PresentModeKHR chooseSwapPresentMode(const std::vector<vk::PresentModeKHR>& availablePresentModes) {
-		for (const auto& availablePresentMode : availablePresentModes) {
-			if (availablePresentMode == vk::PresentModeKHR::eMailbox) {
-				return availablePresentMode;
-			}
-		}
-
-		return vk::PresentModeKHR::eFifo;
-	}
-
-	vk::Extent2D chooseSwapExtend(const vk::SurfaceCapabilitiesKHR& capabilities) {
-		if (capabilities.currentExtent.width != INT32_MAX) {
-			return capabilities.currentExtent;
-		}
-		int width, height;
-		glfwGetFramebufferSize(window, &width, &height);
-
-		return {
-			std::clamp(static_cast<uint32_t>(width), capabilities.minImageExtent.width, capabilities.maxImageExtent.width),
-			std::clamp(static_cast<uint32_t>(height), capabilities.minImageExtent.height, capabilities.maxImageExtent.height)
-		};
-	}
-
 	bool checkDeviceExtensionSupport(const vk::PhysicalDevice& device) {
 		auto availableExtensions = device.enumerateDeviceExtensionProperties();
 
@@ -772,12 +2054,17 @@ private:
 		return requiredExtensions.empty();
 	}
 
-	vk::UniqueShaderModule createShaderModule(const std::vector<char>& code) {
+	// The code points straight into the mapped archive, blobs there are aligned for SPIR-V words
+	vk::UniqueShaderModule createShaderModule(const AssetSpan& code) {
+		if (code.size % sizeof(uint32_t) != 0) {
+			throw std::runtime_error("shader code is not a multiple of 4 bytes!");
+		}
+
 		try {
 			return vkDevice->createShaderModuleUnique({
 				vk::ShaderModuleCreateFlags(),
-				code.size(),
-				reinterpret_cast<const uint32_t*>(code.data())
+				code.size,
+				reinterpret_cast<const uint32_t*>(code.data)
 				});
 		}
 		catch (vk::SystemError err) {
@@ -785,23 +2072,6 @@ private:
 		}
 	}
 
-	static std::vector<char> readFile(const std::string& filename) {
-		std::ifstream file(filename, std::ios::ate | std::ios::binary);
-
-		if (!file.is_open()) {
-			throw std::runtime_error("failed to open file!");
-		}
-
-		size_t fileSize = (size_t) file.tellg();
-		std::vector<char> buffer(fileSize);
-
-		file.seekg(0);
-		file.read(buffer.data(), fileSize);
-		file.close();
-
-		return buffer;
-	}
-
 	static VKAPI_ATTR VkBool32 VKAPI_CALL debugCallback(VkDebugUtilsMessageSeverityFlagBitsEXT messageSeverity, VkDebugUtilsMessageTypeFlagsEXT messageType, const VkDebugUtilsMessengerCallbackDataEXT* pCallbackData, void* pUserData) {
 
 		std::cerr << "validation layer: " << pCallbackData->pMessage << std::endl;
@@ -0,0 +1,155 @@
+#pragma once
+#include <vulkan/vulkan.hpp>
+
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+// vk::PipelineCache that is loaded from and saved to disk. The file starts with our own header identifying the
+// device and driver that produced the data, a cache from any other device or driver version is discarded.
+class PipelineCache {
+
+public:
+	void load(vk::Device device, vk::PhysicalDevice physicalDevice, const std::string& path) {
+		this->device = device;
+		this->path = path;
+		properties = physicalDevice.getProperties();
+
+		std::vector<char> data;
+		if (!path.empty()) {
+			data = readValidated();
+		}
+		loadedFromDisk = !data.empty();
+
+		vk::PipelineCacheCreateInfo createInfo{};
+		createInfo.initialDataSize = data.size();
+		createInfo.pInitialData = data.data();
+
+		try {
+			cache = device.createPipelineCacheUnique(createInfo);
+		}
+		catch (vk::SystemError err) {
+			if (!loadedFromDisk) {
+				throw std::runtime_error("failed to create pipeline cache!");
+			}
+			// The driver rejected the data after all, start over empty
+			loadedFromDisk = false;
+			cache = device.createPipelineCacheUnique(vk::PipelineCacheCreateInfo{});
+		}
+	}
+
+	void save() {
+		if (!cache || path.empty()) {
+			return;
+		}
+
+		auto data = device.getPipelineCacheData(*cache);
+
+		FileHeader header = makeHeader();
+		header.dataSize = data.size();
+		header.dataHash = hash(data.data(), data.size());
+
+		// Written to a temporary file first, so a crash while saving never leaves a truncated cache behind
+		std::string temporaryPath = path + ".tmp";
+		{
+			std::ofstream file(temporaryPath, std::ios::binary | std::ios::trunc);
+			if (!file.is_open()) {
+				return;
+			}
+			file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+			file.write(reinterpret_cast<const char*>(data.data()), data.size());
+			if (!file) {
+				return;
+			}
+		}
+
+		std::error_code error;
+		std::filesystem::rename(temporaryPath, path, error);
+	}
+
+	vk::PipelineCache get() const {
+		return *cache;
+	}
+
+	// True if the cache was created from a valid file, i.e. pipelines are created warm
+	bool isWarm() const {
+		return loadedFromDisk;
+	}
+
+private:
+	static constexpr uint32_t MAGIC = 0x43505057; // "WPPC"
+	static constexpr uint32_t VERSION = 1;
+
+	struct FileHeader {
+		uint32_t magic;
+		uint32_t version;
+		uint32_t vendorID;
+		uint32_t deviceID;
+		uint32_t driverVersion;
+		uint8_t pipelineCacheUUID[VK_UUID_SIZE];
+		uint64_t dataSize;
+		uint64_t dataHash;
+	};
+
+	vk::Device device;
+	std::string path;
+	vk::PhysicalDeviceProperties properties;
+
+	vk::UniquePipelineCache cache;
+	bool loadedFromDisk = false;
+
+	FileHeader makeHeader() const {
+		FileHeader header{};
+		header.magic = MAGIC;
+		header.version = VERSION;
+		header.vendorID = properties.vendorID;
+		header.deviceID = properties.deviceID;
+		header.driverVersion = properties.driverVersion;
+		std::memcpy(header.pipelineCacheUUID, properties.pipelineCacheUUID.data(), VK_UUID_SIZE);
+		return header;
+	}
+
+	// Returns the cache data, or nothing if the file is missing or was written for another device or driver
+	std::vector<char> readValidated() const {
+		std::ifstream file(path, std::ios::ate | std::ios::binary);
+		if (!file.is_open()) {
+			return {};
+		}
+
+		size_t fileSize = (size_t) file.tellg();
+		if (fileSize < sizeof(FileHeader)) {
+			return {};
+		}
+		file.seekg(0);
+
+		FileHeader header;
+		file.read(reinterpret_cast<char*>(&header), sizeof(header));
+
+		FileHeader expected = makeHeader();
+		if (header.magic != expected.magic || header.version != expected.version ||
+			header.vendorID != expected.vendorID || header.deviceID != expected.deviceID ||
+			header.driverVersion != expected.driverVersion ||
+			std::memcmp(header.pipelineCacheUUID, expected.pipelineCacheUUID, VK_UUID_SIZE) != 0 ||
+			header.dataSize != fileSize - sizeof(FileHeader)) {
+			return {};
+		}
+
+		std::vector<char> data(header.dataSize);
+		file.read(data.data(), data.size());
+		if (!file || hash(data.data(), data.size()) != header.dataHash) {
+			return {};
+		}
+		return data;
+	}
+
+	// FNV-1a, only guards against truncated or corrupted files
+	static uint64_t hash(const void* data, size_t size) {
+		uint64_t value = 14695981039346656037ull;
+		for (size_t i = 0; i < size; ++i) {
+			value = (value ^ static_cast<const uint8_t*>(data)[i]) * 1099511628211ull;
+		}
+		return value;
+	}
+};
\ No newline at end of file
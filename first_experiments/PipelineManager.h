@@ -0,0 +1,442 @@
+#pragma once
+#include <vulkan/vulkan.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <unordered_map>
+#include <vector>
+#include "WorkerPool.h"
+
+// Shaders and fixed function state of a graphics pipeline. Viewport and scissor are always dynamic, so pipelines
+// survive a resize of the swap chain.
+struct PipelineState {
+	vk::ShaderModule vertexShader;
+	vk::ShaderModule fragmentShader;
+	vk::PipelineLayout layout;
+	vk::RenderPass renderPass;
+	uint32_t subpass = 0;
+	std::vector<vk::VertexInputBindingDescription> bindings;
+	std::vector<vk::VertexInputAttributeDescription> attributes;
+	vk::PrimitiveTopology topology = vk::PrimitiveTopology::eTriangleList;
+	vk::CullModeFlags cullMode = vk::CullModeFlagBits::eBack;
+	vk::FrontFace frontFace = vk::FrontFace::eCounterClockwise;
+	// Blends with the source alpha
+	bool blend = false;
+	// Tests and writes depth with less, needs a render pass with a depth attachment
+	bool depthTest = false;
+	vk::ColorComponentFlags colorWriteMask = vk::ColorComponentFlagBits::eR | vk::ColorComponentFlagBits::eG |
+		vk::ColorComponentFlagBits::eB | vk::ColorComponentFlagBits::eA;
+
+	bool operator==(const PipelineState& other) const {
+		return vertexShader == other.vertexShader && fragmentShader == other.fragmentShader && layout == other.layout &&
+			renderPass == other.renderPass && subpass == other.subpass && bindings == other.bindings && attributes == other.attributes &&
+			topology == other.topology && cullMode == other.cullMode && frontFace == other.frontFace && blend == other.blend &&
+			depthTest == other.depthTest && colorWriteMask == other.colorWriteMask;
+	}
+
+	// FNV-1a over every member, the descriptions have no padding
+	uint64_t hash() const {
+		uint64_t value = 14695981039346656037ull;
+		auto add = [&](const void* data, size_t size) {
+			for (size_t i = 0; i < size; ++i) {
+				value = (value ^ static_cast<const uint8_t*>(data)[i]) * 1099511628211ull;
+			}
+		};
+		auto addValue = [&](const auto& member) {
+			add(&member, sizeof(member));
+		};
+
+		addValue(static_cast<VkShaderModule>(vertexShader));
+		addValue(static_cast<VkShaderModule>(fragmentShader));
+		addValue(static_cast<VkPipelineLayout>(layout));
+		addValue(static_cast<VkRenderPass>(renderPass));
+		addValue(subpass);
+		add(bindings.data(), bindings.size() * sizeof(vk::VertexInputBindingDescription));
+		add(attributes.data(), attributes.size() * sizeof(vk::VertexInputAttributeDescription));
+		addValue(topology);
+		addValue(static_cast<VkCullModeFlags>(cullMode));
+		addValue(frontFace);
+		addValue(blend);
+		addValue(depthTest);
+		addValue(static_cast<VkColorComponentFlags>(colorWriteMask));
+		return value;
+	}
+};
+
+// Creates graphics pipelines by state, each state only once. Pipelines needed right away are created on the calling
+// thread, everything else is requested together with such a pipeline as fallback and compiled by tasks on the worker
+// pool. Until it is ready, get returns the fallback, so drawing never waits for the driver's shader compiler, it just
+// looks wrong for a few frames. The fallback has to be compatible with the request, i.e. share its layout, render pass
+// and vertex input. Requests are also created as derivatives of their fallback, which drivers may use to compile only
+// the difference, most ignore it. All threads create pipelines through the same vk::PipelineCache, which the driver
+// synchronizes internally.
+class PipelineManager {
+
+public:
+	using PipelineId = uint32_t;
+
+	// Ids index a fixed array, so get can read it while requests add pipelines
+	static constexpr uint32_t MAX_PIPELINES = 4096;
+
+	struct Statistics {
+		uint32_t pipelineCount = 0;
+		uint32_t derivativeCount = 0;
+		uint32_t failedCount = 0;
+		// Requests of a state that had been requested before
+		uint64_t reusedCount = 0;
+		// Time spent creating each pipeline, in the background or not
+		std::vector<double> createMs;
+	};
+
+	PipelineManager() = default;
+
+	~PipelineManager() {
+		shutdown();
+	}
+
+	PipelineManager(const PipelineManager&) = delete;
+	PipelineManager& operator=(const PipelineManager&) = delete;
+
+	// Up to threadCount requests are compiled at once on the pool, which has to outlive the manager. With threadCount 0
+	// requests are created right away on the requesting thread, like createNow.
+	void init(vk::Device device, vk::PipelineCache cache, WorkerPool& workers, uint32_t threadCount, bool useDerivatives) {
+		shutdown();
+
+		this->device = device;
+		this->cache = cache;
+		this->workers = &workers;
+		this->threadCount = threadCount;
+		this->useDerivatives = useDerivatives;
+		entries.reset(new Entry[MAX_PIPELINES]);
+		entryCount = 0;
+		statistics = {};
+		running = true;
+	}
+
+	// Drops the requests not started yet, waits for the ones being compiled and destroys every pipeline
+	void shutdown() {
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			running = false;
+			queue.clear();
+			// Tasks still queued on the pool find the queue empty and return right away
+			idle.wait(lock, [this] { return taskCount == 0; });
+		}
+
+		for (uint32_t i = 0; i < entryCount; ++i) {
+			VkPipeline pipeline = entries[i].pipeline.load(std::memory_order_acquire);
+			if (pipeline != VK_NULL_HANDLE) {
+				device.destroyPipeline(vk::Pipeline(pipeline));
+			}
+		}
+		entries.reset();
+		entryCount = 0;
+		lookup.clear();
+	}
+
+	// Blocks until the pipeline is created, e.g. for the fallbacks
+	PipelineId createNow(const PipelineState& state) {
+		bool created;
+		PipelineId id = add(state, NO_FALLBACK, created);
+		if (created) {
+			create(id);
+			if (entries[id].pipeline.load(std::memory_order_acquire) == VK_NULL_HANDLE) {
+				throw std::runtime_error("failed to create graphics pipeline!");
+			}
+		}
+		else if (!isReady(id)) {
+			// Requested before in the background, which has to finish first
+			waitIdle();
+			if (!isReady(id)) {
+				throw std::runtime_error("failed to create graphics pipeline!");
+			}
+		}
+		return id;
+	}
+
+	// Returns at once, the pipeline is compiled in the background and the fallback stands in for it until then.
+	// Pipelines that fail to compile keep their fallback.
+	PipelineId request(const PipelineState& state, PipelineId fallback) {
+		bool created;
+		PipelineId id = add(state, fallback, created);
+		if (!created) {
+			return id;
+		}
+
+		if (threadCount == 0) {
+			create(id);
+			return id;
+		}
+
+		bool startTask;
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			queue.push_back(id);
+			startTask = taskCount < threadCount;
+			taskCount += startTask ? 1 : 0;
+		}
+		// Outside of the lock, a pool without workers runs the task right here
+		if (startTask) {
+			workers->submit([this] { compileQueued(); });
+		}
+		return id;
+	}
+
+	// The pipeline if it is ready, its fallback otherwise. Safe to call from any thread, e.g. while recording.
+	vk::Pipeline get(PipelineId id) const {
+		const Entry& entry = entries[id];
+		VkPipeline pipeline = entry.pipeline.load(std::memory_order_acquire);
+		if (pipeline == VK_NULL_HANDLE && entry.fallback != NO_FALLBACK) {
+			pipeline = entries[entry.fallback].pipeline.load(std::memory_order_acquire);
+		}
+		return vk::Pipeline(pipeline);
+	}
+
+	bool isReady(PipelineId id) const {
+		return entries[id].pipeline.load(std::memory_order_acquire) != VK_NULL_HANDLE;
+	}
+
+	// Requests waiting for or being compiled
+	uint32_t getPendingCount() const {
+		std::lock_guard<std::mutex> lock(mutex);
+		return static_cast<uint32_t>(queue.size()) + busyCount;
+	}
+
+	void waitIdle() {
+		std::unique_lock<std::mutex> lock(mutex);
+		idle.wait(lock, [this] { return queue.empty() && busyCount == 0; });
+	}
+
+	Statistics getStatistics() const {
+		std::lock_guard<std::mutex> lock(mutex);
+		return statistics;
+	}
+
+	uint32_t getThreadCount() const {
+		return threadCount;
+	}
+
+private:
+	using Clock = std::chrono::steady_clock;
+
+	static constexpr PipelineId NO_FALLBACK = ~0u;
+
+	struct Entry {
+		PipelineState state;
+		PipelineId fallback = NO_FALLBACK;
+		// Written once by the thread that created it
+		std::atomic<VkPipeline> pipeline{ VK_NULL_HANDLE };
+	};
+
+	vk::Device device;
+	vk::PipelineCache cache;
+	bool useDerivatives = true;
+
+	std::unique_ptr<Entry[]> entries;
+	uint32_t entryCount = 0;
+	std::unordered_multimap<uint64_t, PipelineId> lookup;
+
+	WorkerPool* workers = nullptr;
+	uint32_t threadCount = 0;
+	mutable std::mutex mutex;
+	std::condition_variable idle;
+	std::deque<PipelineId> queue;
+	// Tasks submitted to the pool and not finished yet, and requests they are compiling
+	uint32_t taskCount = 0;
+	uint32_t busyCount = 0;
+	bool running = false;
+	Statistics statistics;
+
+	// Returns the existing id if the state was added before
+	PipelineId add(const PipelineState& state, PipelineId fallback, bool& created) {
+		std::lock_guard<std::mutex> lock(mutex);
+		if (fallback != NO_FALLBACK && (fallback >= entryCount || !isReady(fallback))) {
+			throw std::runtime_error("pipeline fallbacks have to be created with createNow!");
+		}
+
+		uint64_t hash = state.hash();
+		auto range = lookup.equal_range(hash);
+		for (auto it = range.first; it != range.second; ++it) {
+			if (entries[it->second].state == state) {
+				++statistics.reusedCount;
+				created = false;
+				return it->second;
+			}
+		}
+
+		if (entryCount == MAX_PIPELINES) {
+			throw std::runtime_error("too many pipelines!");
+		}
+		PipelineId id = entryCount;
+		entries[id].state = state;
+		entries[id].fallback = fallback;
+		lookup.emplace(hash, id);
+		// Published last, get and the workers only see complete entries
+		entryCount = id + 1;
+		created = true;
+		return id;
+	}
+
+	// Runs on the pool until the queue is empty, request starts another one while fewer than threadCount are running
+	void compileQueued() {
+		std::unique_lock<std::mutex> lock(mutex);
+
+		while (running && !queue.empty()) {
+			PipelineId id = queue.front();
+			queue.pop_front();
+			++busyCount;
+
+			lock.unlock();
+			create(id);
+			lock.lock();
+
+			--busyCount;
+		}
+
+		--taskCount;
+		idle.notify_all();
+	}
+
+	void create(PipelineId id) {
+		Entry& entry = entries[id];
+		const PipelineState& state = entry.state;
+
+		vk::PipelineShaderStageCreateInfo shaderStages[] = {
+			{
+				vk::PipelineShaderStageCreateFlags(),
+				vk::ShaderStageFlagBits::eVertex,
+				state.vertexShader,
+				"main"
+			},
+			{
+				vk::PipelineShaderStageCreateFlags(),
+				vk::ShaderStageFlagBits::eFragment,
+				state.fragmentShader,
+				"main"
+			}
+		};
+
+		auto vertexInputInfo = vk::PipelineVertexInputStateCreateInfo(
+			vk::PipelineVertexInputStateCreateFlags(),
+			static_cast<uint32_t>(state.bindings.size()), state.bindings.data(),
+			static_cast<uint32_t>(state.attributes.size()), state.attributes.data()
+		);
+
+		auto inputAssembly = vk::PipelineInputAssemblyStateCreateInfo(
+			vk::PipelineInputAssemblyStateCreateFlags(),
+			state.topology,
+			VK_FALSE	// primitiveRestartEnable
+		);
+
+		auto viewportState = vk::PipelineViewportStateCreateInfo(
+			vk::PipelineViewportStateCreateFlags(),
+			1, nullptr,
+			1, nullptr
+		);
+
+		vk::DynamicState dynamicStates[] = { vk::DynamicState::eViewport, vk::DynamicState::eScissor };
+		auto dynamicState = vk::PipelineDynamicStateCreateInfo(
+			vk::PipelineDynamicStateCreateFlags(),
+			2, dynamicStates
+		);
+
+		auto rasterizer = vk::PipelineRasterizationStateCreateInfo(
+			vk::PipelineRasterizationStateCreateFlags(),
+			VK_FALSE,	// depthClamp
+			VK_FALSE,	// rasterizerDiscard
+			vk::PolygonMode::eFill,
+			state.cullMode,
+			state.frontFace,
+			VK_FALSE,	// depthBias
+			0.0f, 0.0f, 0.0f,	// depthBiasValues
+			1.0f		// lineWidth
+		);
+
+		auto multisampling = vk::PipelineMultisampleStateCreateInfo(
+			vk::PipelineMultisampleStateCreateFlags(),
+			vk::SampleCountFlagBits::e1,
+			VK_FALSE,	// sampleShading
+			1.0f,		// minSampleShading
+			nullptr,	// pSampleMask
+			VK_FALSE,	// alphaToCoverage
+			VK_FALSE	// alphaToOne
+		);
+
+		vk::PipelineColorBlendAttachmentState colorBlendAttachment{};
+		colorBlendAttachment.blendEnable = state.blend ? VK_TRUE : VK_FALSE;
+		colorBlendAttachment.srcColorBlendFactor = vk::BlendFactor::eSrcAlpha;
+		colorBlendAttachment.dstColorBlendFactor = vk::BlendFactor::eOneMinusSrcAlpha;
+		colorBlendAttachment.colorBlendOp = vk::BlendOp::eAdd;
+		colorBlendAttachment.srcAlphaBlendFactor = vk::BlendFactor::eOne;
+		colorBlendAttachment.dstAlphaBlendFactor = vk::BlendFactor::eZero;
+		colorBlendAttachment.alphaBlendOp = vk::BlendOp::eAdd;
+		colorBlendAttachment.colorWriteMask = state.colorWriteMask;
+
+		vk::PipelineColorBlendStateCreateInfo colorBlending{};
+		colorBlending.logicOpEnable = VK_FALSE;
+		colorBlending.logicOp = vk::LogicOp::eCopy;
+		colorBlending.attachmentCount = 1;
+		colorBlending.pAttachments = &colorBlendAttachment;
+
+		// Always given, render passes with a depth attachment need it even when nothing tests against it
+		vk::PipelineDepthStencilStateCreateInfo depthStencil{};
+		depthStencil.depthTestEnable = state.depthTest ? VK_TRUE : VK_FALSE;
+		depthStencil.depthWriteEnable = state.depthTest ? VK_TRUE : VK_FALSE;
+		depthStencil.depthCompareOp = vk::CompareOp::eLess;
+
+		vk::GraphicsPipelineCreateInfo pipelineInfo{};
+		pipelineInfo.stageCount = 2;
+		pipelineInfo.pStages = shaderStages;
+
+		pipelineInfo.pVertexInputState = &vertexInputInfo;
+		pipelineInfo.pInputAssemblyState = &inputAssembly;
+		pipelineInfo.pViewportState = &viewportState;
+		pipelineInfo.pRasterizationState = &rasterizer;
+		pipelineInfo.pMultisampleState = &multisampling;
+		pipelineInfo.pDepthStencilState = &depthStencil;
+		pipelineInfo.pColorBlendState = &colorBlending;
+		pipelineInfo.pDynamicState = &dynamicState;
+
+		pipelineInfo.layout = state.layout;
+		pipelineInfo.renderPass = state.renderPass;
+		pipelineInfo.subpass = state.subpass;
+
+		// Fallbacks may become the base of derivatives, requests are derived from their fallback
+		bool derivative = useDerivatives && entry.fallback != NO_FALLBACK;
+		if (useDerivatives && entry.fallback == NO_FALLBACK) {
+			pipelineInfo.flags = vk::PipelineCreateFlagBits::eAllowDerivatives;
+		}
+		if (derivative) {
+			pipelineInfo.flags = vk::PipelineCreateFlagBits::eDerivative;
+			pipelineInfo.basePipelineHandle = vk::Pipeline(entries[entry.fallback].pipeline.load(std::memory_order_acquire));
+			pipelineInfo.basePipelineIndex = -1;
+		}
+
+		auto start = Clock::now();
+		vk::Pipeline pipeline;
+		try {
+			pipeline = device.createGraphicsPipeline(cache, pipelineInfo).value;
+		}
+		catch (vk::SystemError err) {
+			pipeline = nullptr;
+		}
+		double ms = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+
+		entry.pipeline.store(static_cast<VkPipeline>(pipeline), std::memory_order_release);
+
+		std::lock_guard<std::mutex> lock(mutex);
+		if (pipeline) {
+			++statistics.pipelineCount;
+			statistics.derivativeCount += derivative ? 1 : 0;
+			statistics.createMs.push_back(ms);
+		}
+		else {
+			++statistics.failedCount;
+		}
+	}
+};
\ No newline at end of file
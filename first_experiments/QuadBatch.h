@@ -0,0 +1,236 @@
+#pragma once
+#include <vulkan/vulkan.hpp>
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstring>
+#include <functional>
+#include <vector>
+
+#include "GpuAllocator.h"
+#include "WorkerPool.h"
+
+struct QuadInstance {
+	// Center and extent in normalized device coordinates
+	float position[2];
+	float size[2];
+	// RGBA8, red in the lowest byte
+	uint32_t color;
+	uint32_t textureIndex;
+
+	static vk::VertexInputBindingDescription getBindingDescription() {
+		return vk::VertexInputBindingDescription(0, sizeof(QuadInstance), vk::VertexInputRate::eInstance);
+	}
+
+	static std::array<vk::VertexInputAttributeDescription, 4> getAttributeDescriptions() {
+		return {
+			vk::VertexInputAttributeDescription(0, 0, vk::Format::eR32G32Sfloat, offsetof(QuadInstance, position)),
+			vk::VertexInputAttributeDescription(1, 0, vk::Format::eR32G32Sfloat, offsetof(QuadInstance, size)),
+			vk::VertexInputAttributeDescription(2, 0, vk::Format::eR8G8B8A8Unorm, offsetof(QuadInstance, color)),
+			vk::VertexInputAttributeDescription(3, 0, vk::Format::eR32Uint, offsetof(QuadInstance, textureIndex))
+		};
+	}
+};
+
+// Collects the quads of a frame on several threads and draws them with one instanced draw per pipeline and texture.
+// Every thread appends into its own writer, consecutive quads with the same pipeline and texture form a run. build
+// sorts the runs, not the quads, and copies them in parallel into the persistently mapped instance buffer of the
+// frame slot, so quads that are submitted grouped cost one memcpy per run and keep their submission order.
+class QuadBatch {
+
+public:
+	// Quads of one pipeline and texture, drawn as instances [firstInstance, firstInstance + instanceCount)
+	struct Batch {
+		uint32_t pipeline;
+		uint32_t textureIndex;
+		uint32_t firstInstance;
+		uint32_t instanceCount;
+	};
+
+	// Of the last frame that was built
+	struct Statistics {
+		uint64_t quadCount = 0;
+		uint32_t runCount = 0;
+		uint32_t batchCount = 0;
+		uint32_t pipelineChangeCount = 0;
+		// Instance buffers of all frame slots
+		vk::DeviceSize instanceBufferSize = 0;
+	};
+
+	class Writer {
+
+	public:
+		void add(uint32_t pipeline, const QuadInstance& quad) {
+			uint64_t key = (uint64_t(pipeline) << 32) | quad.textureIndex;
+			if (runs.empty() || runs.back().key != key) {
+				runs.push_back({ key, static_cast<uint32_t>(quads.size()), 0 });
+			}
+			++runs.back().count;
+			quads.push_back(quad);
+		}
+
+	private:
+		friend class QuadBatch;
+
+		struct Run {
+			uint64_t key;
+			uint32_t first;
+			uint32_t count;
+		};
+
+		std::vector<QuadInstance> quads;
+		std::vector<Run> runs;
+	};
+
+	using FillFunction = std::function<void(Writer& writer, uint32_t begin, uint32_t end)>;
+
+	// Fills and copies on up to threadCount threads of the pool, the pool has to outlive the batch
+	void init(GpuAllocator& allocator, WorkerPool& workers, uint32_t framesInFlight, uint32_t threadCount) {
+		this->allocator = &allocator;
+		this->workers = &workers;
+		writers.assign(std::clamp(threadCount, 1u, workers.getThreadCount()), Writer());
+		frames.clear();
+		frames.resize(framesInFlight);
+		statistics = {};
+	}
+
+	// The fence of the frame slot has to be waited on, its instance buffer is overwritten by build
+	void beginFrame(uint32_t frame) {
+		currentFrame = frame;
+		for (auto& writer : writers) {
+			writer.quads.clear();
+			writer.runs.clear();
+		}
+		batches.clear();
+	}
+
+	// Calls fill for [0, count) split into contiguous chunks across the threads, each chunk appends to its own
+	// writer. Quads added by the first chunk are drawn before those of the second and so on.
+	void fill(uint32_t count, const FillFunction& fill) {
+		workers->run(count, getMinChunkSize(count), [this, &fill](uint32_t chunk, uint32_t begin, uint32_t end) {
+			fill(writers[chunk], begin, end);
+		});
+	}
+
+	void build() {
+		sortedRuns.clear();
+		for (uint32_t writer = 0; writer < writers.size(); ++writer) {
+			for (const auto& run : writers[writer].runs) {
+				sortedRuns.push_back({ run.key, writer, run.first, run.count, 0 });
+			}
+		}
+		// Stable, so the runs of one key stay in submission order
+		std::stable_sort(sortedRuns.begin(), sortedRuns.end(), [](const SortedRun& left, const SortedRun& right) {
+			return left.key < right.key;
+		});
+
+		uint32_t quadCount = 0;
+		statistics.pipelineChangeCount = 0;
+		for (auto& run : sortedRuns) {
+			run.destination = quadCount;
+			quadCount += run.count;
+
+			uint32_t pipeline = static_cast<uint32_t>(run.key >> 32);
+			if (!batches.empty() && batches.back().pipeline == pipeline && batches.back().textureIndex == static_cast<uint32_t>(run.key)) {
+				batches.back().instanceCount += run.count;
+				continue;
+			}
+			if (batches.empty() || batches.back().pipeline != pipeline) {
+				++statistics.pipelineChangeCount;
+			}
+			batches.push_back({ pipeline, static_cast<uint32_t>(run.key), run.destination, run.count });
+		}
+
+		Frame& frame = frames[currentFrame];
+		if (quadCount > frame.capacity) {
+			// The old buffer belongs to this frame slot, so the GPU is done with it
+			frame.capacity = std::max(quadCount, frame.capacity * 2);
+			frame.instanceBuffer = allocator->createBuffer(vk::DeviceSize(frame.capacity) * sizeof(QuadInstance),
+				vk::BufferUsageFlagBits::eVertexBuffer, vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent);
+		}
+
+		// Every thread copies one contiguous range of the destination, clipping the runs that overlap it
+		auto* destination = static_cast<QuadInstance*>(frame.instanceBuffer.getMapped());
+		workers->run(quadCount, getMinChunkSize(quadCount), [this, destination](uint32_t, uint32_t begin, uint32_t end) {
+			auto run = std::upper_bound(sortedRuns.begin(), sortedRuns.end(), begin, [](uint32_t position, const SortedRun& run) {
+				return position < run.destination + run.count;
+			});
+			for (; run != sortedRuns.end() && run->destination < end; ++run) {
+				uint32_t first = std::max(begin, run->destination);
+				uint32_t last = std::min(end, run->destination + run->count);
+				const QuadInstance* source = writers[run->writer].quads.data() + run->first + (first - run->destination);
+				std::memcpy(destination + first, source, size_t(last - first) * sizeof(QuadInstance));
+			}
+		});
+
+		statistics.quadCount = quadCount;
+		statistics.runCount = static_cast<uint32_t>(sortedRuns.size());
+		statistics.batchCount = static_cast<uint32_t>(batches.size());
+		statistics.instanceBufferSize = 0;
+		for (const auto& slot : frames) {
+			statistics.instanceBufferSize += vk::DeviceSize(slot.capacity) * sizeof(QuadInstance);
+		}
+	}
+
+	// Records the batches [begin, end), binding a pipeline only when it changes. The pipelines are indexed by
+	// the pipeline the quads were added with and have to use the QuadInstance vertex input.
+	void record(vk::CommandBuffer commandBuffer, const vk::Pipeline* pipelines, uint32_t begin, uint32_t end) const {
+		if (begin >= end) {
+			return;
+		}
+		commandBuffer.bindVertexBuffers(0, frames[currentFrame].instanceBuffer.get(), vk::DeviceSize(0));
+
+		uint32_t boundPipeline = ~0u;
+		for (uint32_t i = begin; i < end; ++i) {
+			const Batch& batch = batches[i];
+			if (batch.pipeline != boundPipeline) {
+				commandBuffer.bindPipeline(vk::PipelineBindPoint::eGraphics, pipelines[batch.pipeline]);
+				boundPipeline = batch.pipeline;
+			}
+			// The corners of the quad are generated in the vertex shader
+			commandBuffer.draw(6, batch.instanceCount, 0, batch.firstInstance);
+		}
+	}
+
+	const std::vector<Batch>& getBatches() const {
+		return batches;
+	}
+
+	const Statistics& getStatistics() const {
+		return statistics;
+	}
+
+private:
+	// Below this a thread costs more to wake up than the quads take to write
+	static constexpr uint32_t MIN_QUADS_PER_THREAD = 16 * 1024;
+
+	struct Frame {
+		GpuBuffer instanceBuffer;
+		uint32_t capacity = 0;
+	};
+
+	struct SortedRun {
+		uint64_t key;
+		uint32_t writer;
+		uint32_t first;
+		uint32_t count;
+		uint32_t destination;
+	};
+
+	GpuAllocator* allocator = nullptr;
+	WorkerPool* workers = nullptr;
+	std::vector<Writer> writers;
+	std::vector<Frame> frames;
+	uint32_t currentFrame = 0;
+
+	std::vector<SortedRun> sortedRuns;
+	std::vector<Batch> batches;
+	Statistics statistics;
+
+	// Large enough that there are no more chunks than writers
+	uint32_t getMinChunkSize(uint32_t count) const {
+		uint32_t writerCount = static_cast<uint32_t>(writers.size());
+		return std::max(MIN_QUADS_PER_THREAD, (count + writerCount - 1) / writerCount);
+	}
+};
\ No newline at end of file
@@ -0,0 +1,616 @@
+#include <iostream>
+#include <stdexcept>
+#include <cstdlib>
+#include <cstring>
+#include <sstream>
+#include <string>
+#include "HelloTriangleApplication.cpp"
+
+// Renders a fixed number of frames and reports the timings as JSON, headless unless --windowed is given.
+// Usage: RenderBenchmark [--frames <count>] [--warmup <count>] [--windowed] [--output <file>]
+//                        [--frames-in-flight <1-4>[,<1-4>...]]
+//                        [--pipeline-cache <file>] [--no-pipeline-cache]
+//                        [--draws <count>] [--record-threads <count>[,<count>...]]
+//                        [--quads <count>[,<count>...]] [--batch-threads <count>]
+//                        [--present-policy latency|tear-free|adaptive-vsync|vsync] [--images <count>]
+//                        [--trace <file>] [--pipelines <count>] [--pipeline-threads <count>] [--no-derivatives]
+//                        [--descriptors none|per-draw|bindless] [--render-graph]
+//                        [--objects <count>] [--culling cpu|gpu] [--occlusion off|on|both]
+//                        [--background-dispatches <count>] [--background-upload <MiB>] [--async-queues off|on|both]
+// Run twice to compare a cold start against one with a warm pipeline cache. Several recording thread counts run one
+// after another and are reported as {"runs": [...]}, e.g. --draws 10000 --record-threads 1,2,4,8, with recordSpeedup,
+// how many times faster than with the first count each further count recorded the frame.
+// Several quad counts are the batch stress test, e.g. --draws 0 --quads 10000,100000,1000000 --batch-threads 4, the
+// report then also holds the most quads per frame that still ran at 60 FPS.
+// Several frames in flight run every configuration with each and report how many times the frames per second of the
+// first count the others reached, the gain of the CPU working ahead of the GPU, e.g. --frames-in-flight 1,2,3.
+// --trace writes the CPU and GPU zones of every frame of the last run for chrome://tracing or Perfetto, GPU zone times
+// are reported either way.
+// --pipelines requests that many variations of the triangle pipeline at startup, drawn round robin, so use at least as
+// many draws, e.g. --draws 1000 --pipelines 200 --no-pipeline-cache --warmup 0. They compile in the background while
+// the first frames draw with the fallback, --pipeline-threads 0 compiles them before the first frame instead. Compare
+// timeToFirstFrameMs and compilingFrameMs, the frames drawn until the last pipeline was ready. hitchFrames counts those
+// that took more than twice the median frame after it.
+// --descriptors picks how the triangle draws get their texture and material, bindless unless the device lacks
+// descriptor indexing. recordUsPerDraw is the CPU cost of one draw, compare the modes with many draws, e.g.
+// --draws 20000 --descriptors per-draw against --draws 20000 --descriptors bindless.
+// --render-graph renders shadow, G-buffer, lighting, tonemapping and composite passes in front of the scene through the
+// render graph. renderGraph reports the barriers it placed and the memory its transient images share.
+// --objects scatters that many objects around a turning camera and frustum culls them every frame, on the CPU with one
+// draw per visible object or on the GPU with a compute shader and a single indirect draw, gpu unless the device lacks
+// drawIndirectCount or drawIndirectFirstInstance. Compare cullMs and recordMs of --draws 0 --objects 100000
+// --culling cpu against --culling gpu, the GPU side shows up as the Cull zone.
+// --occlusion also culls the objects hidden behind the ring of occluders around the camera, in two phases against a
+// depth pyramid of the last and the current frame, gpu culling only, not with --render-graph. occlusion reports the
+// share of the objects each phase culled and drew, both runs every configuration without and with it and reports how
+// much GPU time of the Frame zone it saved, e.g. --draws 0 --objects 1000000 --occlusion both.
+// --background-dispatches and --background-upload add work every frame that the next frame reads, a compute shader
+// dispatched that many times and that many MiB copied into device local memory. It runs on the dedicated compute and
+// transfer queues of the device where it has them, next to the frames, --async-queues off records it into the frames
+// instead. asyncQueues reports where it ran, both runs every configuration either way and reports how many times the
+// frames per second the async queues reached, e.g. --draws 10000 --background-dispatches 8 --background-upload 64
+// --async-queues both.
+
+static std::string escapeJson(const std::string& text) {
+	std::string escaped;
+	for (char c : text) {
+		if (c == '"' || c == '\\') {
+			escaped += '\\';
+		}
+		escaped += c;
+	}
+	return escaped;
+}
+
+static void writeSummary(std::ostream& out, const char* name, std::vector<double> samples, size_t warmup, const char* indent = "\t") {
+	samples.erase(samples.begin(), samples.begin() + std::min(warmup, samples.size()));
+	std::sort(samples.begin(), samples.end());
+
+	double sum = 0.0;
+	for (double sample : samples) {
+		sum += sample;
+	}
+	auto percentile = [&](size_t percent) {
+		return samples.empty() ? 0.0 : samples[std::min(samples.size() - 1, samples.size() * percent / 100)];
+	};
+
+	out << indent << "\"" << name << "\": { "
+		<< "\"avg\": " << (samples.empty() ? 0.0 : sum / samples.size())
+		<< ", \"min\": " << (samples.empty() ? 0.0 : samples.front())
+		<< ", \"p50\": " << percentile(50)
+		<< ", \"p99\": " << percentile(99)
+		<< ", \"max\": " << (samples.empty() ? 0.0 : samples.back())
+		<< " }";
+}
+
+static void writeReport(std::ostream& out, const RenderSettings& settings, const FrameTimings& timings,
+	const GpuAllocator::Statistics& memory, const StagingRing::Statistics& staging, const QuadBatch::Statistics& quads,
+	const RenderGraph::Statistics& graph, const GpuProfiler& gpuProfiler, size_t warmup) {
+	size_t frames = timings.cpuFrameMs.size();
+
+	out << "{\n";
+	out << "\t\"device\": \"" << escapeJson(timings.deviceName) << "\",\n";
+	out << "\t\"headless\": " << (settings.headless ? "true" : "false") << ",\n";
+	out << "\t\"frames\": " << frames << ",\n";
+	out << "\t\"framesInFlight\": " << settings.framesInFlight << ",\n";
+	if (!settings.headless) {
+		out << "\t\"presentMode\": \"" << timings.presentMode << "\",\n";
+		out << "\t\"swapChainImages\": " << timings.swapChainImages << ",\n";
+		out << "\t\"swapChainRecreations\": " << timings.swapChainRecreations << ",\n";
+		writeSummary(out, "acquireToPresentMs", timings.acquireToPresentMs, warmup);
+		out << ",\n";
+	}
+	out << "\t\"draws\": " << settings.drawCount << ",\n";
+	out << "\t\"recordThreads\": " << settings.recordThreads << ",\n";
+	out << "\t\"objects\": " << settings.objectCount << ",\n";
+	out << "\t\"quads\": " << settings.quadCount << ",\n";
+	out << "\t\"batchThreads\": " << settings.batchThreads << ",\n";
+	out << "\t\"warmupFrames\": " << std::min(warmup, frames) << ",\n";
+	out << "\t\"totalSeconds\": " << timings.totalSeconds << ",\n";
+	out << "\t\"framesPerSecond\": " << (timings.totalSeconds > 0.0 ? frames / timings.totalSeconds : 0.0) << ",\n";
+	out << "\t\"pipelineCache\": \"" << (timings.pipelineCacheWarm ? "warm" : "cold") << "\",\n";
+	out << "\t\"pipelineCreationMs\": " << timings.pipelineCreationMs << ",\n";
+	out << "\t\"timeToFirstFrameMs\": " << timings.timeToFirstFrameMs << ",\n";
+
+	// Warmup included, as the compilation happens during the first frames
+	size_t readyFrame = std::min<size_t>(timings.pipelinesReadyFrame, frames);
+	std::vector<double> compilingFrameMs(timings.cpuFrameMs.begin(), timings.cpuFrameMs.begin() + readyFrame);
+	// Frames drawn while compiling that took more than twice the median frame once everything was ready
+	std::vector<double> readyFrameMs(timings.cpuFrameMs.begin() + std::max(readyFrame, std::min(warmup, frames)), timings.cpuFrameMs.end());
+	uint32_t hitchFrames = 0;
+	if (!readyFrameMs.empty()) {
+		std::nth_element(readyFrameMs.begin(), readyFrameMs.begin() + readyFrameMs.size() / 2, readyFrameMs.end());
+		double medianMs = readyFrameMs[readyFrameMs.size() / 2];
+		hitchFrames = static_cast<uint32_t>(std::count_if(compilingFrameMs.begin(), compilingFrameMs.end(), [medianMs](double ms) {
+			return ms > 2.0 * medianMs;
+		}));
+	}
+
+	out << "\t\"pipelines\": { "
+		<< "\"permutations\": " << settings.pipelinePermutations
+		<< ", \"threads\": " << settings.pipelineThreads
+		<< ", \"derivatives\": " << (settings.pipelineDerivatives ? "true" : "false")
+		<< ", \"created\": " << timings.pipelines.pipelineCount
+		<< ", \"derived\": " << timings.pipelines.derivativeCount
+		<< ", \"failed\": " << timings.pipelines.failedCount
+		<< ", \"readyAfterFrames\": " << timings.pipelinesReadyFrame
+		<< ", \"readyAfterMs\": " << timings.pipelinesReadyMs
+		<< ", \"hitchFrames\": " << hitchFrames
+		<< " },\n";
+	writeSummary(out, "pipelineCreateMs", timings.pipelines.createMs, 0);
+	out << ",\n";
+	writeSummary(out, "compilingFrameMs", compilingFrameMs, 0);
+	out << ",\n";
+	writeSummary(out, "cpuFrameMs", timings.cpuFrameMs, warmup);
+	out << ",\n";
+	writeSummary(out, "batchMs", timings.batchMs, warmup);
+	out << ",\n";
+	writeSummary(out, "cullMs", timings.cullMs, warmup);
+	out << ",\n";
+	writeSummary(out, "recordMs", timings.recordMs, warmup);
+	out << ",\n";
+	std::vector<double> recordUsPerDraw;
+	for (double ms : timings.recordMs) {
+		recordUsPerDraw.push_back(ms * 1000.0 / std::max(settings.drawCount, 1u));
+	}
+	writeSummary(out, "recordUsPerDraw", recordUsPerDraw, warmup);
+	out << ",\n";
+	writeSummary(out, "submitMs", timings.submitMs, warmup);
+	out << ",\n";
+	writeSummary(out, "stallMs", timings.stallMs, warmup);
+	out << ",\n";
+	out << "\t\"descriptors\": { "
+		<< "\"requested\": \"" << toString(settings.descriptorMode) << "\""
+		<< ", \"mode\": \"" << toString(timings.descriptorMode) << "\""
+		<< ", \"setsAllocated\": " << timings.descriptorSets.allocationCount
+		<< ", \"pools\": " << timings.descriptorSets.poolCount
+		<< ", \"poolResets\": " << timings.descriptorSets.resetCount
+		<< ", \"bindlessTextures\": " << timings.bindless.textureCount
+		<< ", \"bindlessBuffers\": " << timings.bindless.bufferCount
+		<< ", \"bindlessWrites\": " << timings.bindless.writeCount
+		<< " },\n";
+	out << "\t\"culling\": { "
+		<< "\"requested\": \"" << toString(settings.cullingMode) << "\""
+		<< ", \"mode\": \"" << toString(timings.cullingMode) << "\""
+		<< ", \"dispatches\": " << timings.culler.dispatchCount
+		<< " },\n";
+	// Shares of all objects over the frames read back, the late ones were hidden last frame and came into view
+	double objectFrames = double(timings.culler.objectCount) * double(timings.culler.frameCount);
+	auto share = [&](uint64_t count) {
+		return objectFrames > 0.0 ? count / objectFrames : 0.0;
+	};
+	out << "\t\"occlusion\": { "
+		<< "\"requested\": " << (settings.occlusionCulling ? "true" : "false")
+		<< ", \"enabled\": " << (timings.culler.occlusion ? "true" : "false")
+		<< ", \"frustumCulledRatio\": " << share(timings.culler.frustumCulledCount)
+		<< ", \"occlusionCulledRatio\": " << share(timings.culler.occludedCount)
+		<< ", \"earlyDrawnRatio\": " << share(timings.culler.earlyDrawnCount)
+		<< ", \"lateDrawnRatio\": " << share(timings.culler.lateDrawnCount)
+		<< " },\n";
+	writeSummary(out, "visibleObjects", timings.visibleObjects, warmup);
+	out << ",\n";
+	out << "\t\"gpuMemory\": { "
+		<< "\"memoryAllocations\": " << memory.memoryAllocationCount
+		<< ", \"maxMemoryAllocations\": " << memory.maxMemoryAllocationCount
+		<< ", \"blocks\": " << memory.blockCount
+		<< ", \"dedicatedAllocations\": " << memory.dedicatedAllocationCount
+		<< ", \"allocations\": " << memory.allocationCount
+		<< ", \"reservedBytes\": " << memory.reservedSize
+		<< ", \"usedBytes\": " << memory.usedSize
+		<< ", \"largestFreeRange\": " << memory.largestFreeRange
+		<< ", \"freeRanges\": " << memory.freeRangeCount
+		<< ", \"fragmentation\": " << memory.fragmentation
+		<< " },\n";
+	out << "\t\"staging\": { "
+		<< "\"uploads\": " << staging.uploadCount
+		<< ", \"uploadedBytes\": " << staging.uploadedBytes
+		<< ", \"copyCommands\": " << staging.copyCommandCount
+		<< ", \"flushes\": " << staging.flushCount
+		<< ", \"peakUsedBytes\": " << staging.peakUsedSize
+		<< " },\n";
+	out << "\t\"quadBatch\": { "
+		<< "\"quads\": " << quads.quadCount
+		<< ", \"runs\": " << quads.runCount
+		<< ", \"draws\": " << quads.batchCount
+		<< ", \"pipelineChanges\": " << quads.pipelineChangeCount
+		<< ", \"instanceBufferBytes\": " << quads.instanceBufferSize
+		<< " },\n";
+	out << "\t\"asyncQueues\": { "
+		<< "\"requested\": " << (settings.asyncQueues ? "true" : "false")
+		<< ", \"backgroundDispatches\": " << settings.backgroundDispatches
+		<< ", \"backgroundUploadBytes\": " << settings.backgroundUploadBytes
+		<< ", \"asyncCompute\": " << (timings.asyncCompute ? "true" : "false")
+		<< ", \"asyncUpload\": " << (timings.asyncUpload ? "true" : "false")
+		<< ", \"computeSubmits\": " << timings.computeQueue.submitCount
+		<< ", \"transferSubmits\": " << timings.transferQueue.submitCount
+		<< ", \"ownershipTransfers\": " << timings.computeQueue.ownershipTransferCount + timings.transferQueue.ownershipTransferCount
+		<< ", \"stallMs\": " << timings.computeQueue.stallMs + timings.transferQueue.stallMs
+		<< " },\n";
+	out << "\t\"renderGraph\": { "
+		<< "\"enabled\": " << (settings.renderGraph ? "true" : "false")
+		<< ", \"passes\": " << graph.passCount
+		<< ", \"culledPasses\": " << graph.culledPassCount
+		<< ", \"imageBarriers\": " << graph.imageBarrierCount
+		<< ", \"barrierBatches\": " << graph.pipelineBarrierCount
+		<< ", \"elidedBarriers\": " << graph.elidedBarrierCount
+		<< ", \"transientImages\": " << graph.transientImageCount
+		<< ", \"transientBytes\": " << graph.transientSize
+		<< ", \"aliasedBytes\": " << graph.aliasedSize
+		<< ", \"savedBytes\": " << (graph.transientSize - graph.aliasedSize)
+		<< " },\n";
+
+	// Per zone in the order the zones were first recorded, read back framesInFlight frames late
+	out << "\t\"gpuProfiler\": { "
+		<< "\"enabled\": " << (gpuProfiler.isEnabled() ? "true" : "false")
+		<< ", \"timestampPeriodNs\": " << gpuProfiler.getTimestampPeriod()
+		<< ", \"pipelineStatistics\": " << (gpuProfiler.getPipelineStatisticsFlags() ? "true" : "false")
+		<< ", \"droppedZones\": " << gpuProfiler.getDroppedZoneCount()
+		<< " },\n";
+	out << "\t\"gpuZonesMs\": {";
+	const auto& zones = gpuProfiler.getZones();
+	for (size_t i = 0; i < zones.size(); ++i) {
+		out << (i > 0 ? ",\n" : "\n");
+		writeSummary(out, zones[i].name, zones[i].ms, warmup, "\t\t");
+	}
+	out << (zones.empty() ? "},\n" : "\n\t},\n");
+
+	// Averaged per frame over every frame that was read back, warmup included
+	out << "\t\"gpuPipelineStatistics\": {";
+	bool first = true;
+	for (const auto& zone : zones) {
+		if (zone.statisticsFrames == 0) {
+			continue;
+		}
+		const GpuProfiler::PipelineStatistics& statistics = zone.statistics;
+		double frames = double(zone.statisticsFrames);
+		out << (first ? "\n" : ",\n") << "\t\t\"" << zone.name << "\": { "
+			<< "\"inputAssemblyVertices\": " << statistics.inputAssemblyVertices / frames
+			<< ", \"inputAssemblyPrimitives\": " << statistics.inputAssemblyPrimitives / frames
+			<< ", \"vertexShaderInvocations\": " << statistics.vertexShaderInvocations / frames
+			<< ", \"clippingPrimitives\": " << statistics.clippingPrimitives / frames
+			<< ", \"fragmentShaderInvocations\": " << statistics.fragmentShaderInvocations / frames
+			<< " }";
+		first = false;
+	}
+	out << (first ? "}" : "\n\t}");
+	out << "\n}\n";
+}
+
+// Average time of a GPU zone after the warmup, 0 if it was never recorded
+static double averageZoneMs(const GpuProfiler& gpuProfiler, const char* name, size_t warmup) {
+	for (const auto& zone : gpuProfiler.getZones()) {
+		if (strcmp(zone.name, name) != 0 || zone.ms.size() <= warmup) {
+			continue;
+		}
+		double sum = 0.0;
+		for (size_t i = warmup; i < zone.ms.size(); ++i) {
+			sum += zone.ms[i];
+		}
+		return sum / (zone.ms.size() - warmup);
+	}
+	return 0.0;
+}
+
+int main(int argc, char** argv) {
+	RenderSettings settings;
+	settings.headless = true;
+	settings.frameCount = 1000;
+	size_t warmup = 60;
+	std::string outputPath;
+	std::vector<uint32_t> framesInFlight = { settings.framesInFlight };
+	std::vector<uint32_t> recordThreads = { 1 };
+	std::vector<uint32_t> quadCounts = { 0 };
+	std::vector<bool> occlusionModes = { false };
+	std::vector<bool> asyncModes = { true };
+
+	for (int i = 1; i < argc; ++i) {
+		if (strcmp(argv[i], "--windowed") == 0) {
+			settings.headless = false;
+		}
+		else if (strcmp(argv[i], "--frames") == 0 && i + 1 < argc) {
+			settings.frameCount = static_cast<uint32_t>(std::strtoul(argv[++i], nullptr, 10));
+		}
+		else if (strcmp(argv[i], "--warmup") == 0 && i + 1 < argc) {
+			warmup = std::strtoul(argv[++i], nullptr, 10);
+		}
+		else if (strcmp(argv[i], "--output") == 0 && i + 1 < argc) {
+			outputPath = argv[++i];
+		}
+		else if (strcmp(argv[i], "--pipeline-cache") == 0 && i + 1 < argc) {
+			settings.pipelineCachePath = argv[++i];
+		}
+		else if (strcmp(argv[i], "--no-pipeline-cache") == 0) {
+			settings.pipelineCachePath.clear();
+		}
+		else if (strcmp(argv[i], "--frames-in-flight") == 0 && i + 1 < argc) {
+			framesInFlight.clear();
+			std::stringstream list(argv[++i]);
+			for (std::string count; std::getline(list, count, ',');) {
+				framesInFlight.push_back(static_cast<uint32_t>(std::strtoul(count.c_str(), nullptr, 10)));
+			}
+			if (framesInFlight.empty()) {
+				framesInFlight.push_back(settings.framesInFlight);
+			}
+		}
+		else if (strcmp(argv[i], "--present-policy") == 0 && i + 1 < argc) {
+			std::string policy = argv[++i];
+			if (policy == "latency") {
+				settings.swapChain.presentPolicy = PresentPolicy::LowestLatency;
+			}
+			else if (policy == "tear-free") {
+				settings.swapChain.presentPolicy = PresentPolicy::TearFree;
+			}
+			else if (policy == "adaptive-vsync") {
+				settings.swapChain.presentPolicy = PresentPolicy::AdaptiveVSync;
+			}
+			else if (policy == "vsync") {
+				settings.swapChain.presentPolicy = PresentPolicy::VSync;
+			}
+			else {
+				std::cerr << "unknown present policy " << policy << std::endl;
+				return EXIT_FAILURE;
+			}
+		}
+		else if (strcmp(argv[i], "--images") == 0 && i + 1 < argc) {
+			settings.swapChain.imageCount = static_cast<uint32_t>(std::strtoul(argv[++i], nullptr, 10));
+		}
+		else if (strcmp(argv[i], "--draws") == 0 && i + 1 < argc) {
+			settings.drawCount = static_cast<uint32_t>(std::strtoul(argv[++i], nullptr, 10));
+		}
+		else if (strcmp(argv[i], "--record-threads") == 0 && i + 1 < argc) {
+			recordThreads.clear();
+			std::stringstream list(argv[++i]);
+			for (std::string count; std::getline(list, count, ',');) {
+				recordThreads.push_back(std::max(1u, static_cast<uint32_t>(std::strtoul(count.c_str(), nullptr, 10))));
+			}
+			if (recordThreads.empty()) {
+				recordThreads.push_back(1);
+			}
+		}
+		else if (strcmp(argv[i], "--quads") == 0 && i + 1 < argc) {
+			quadCounts.clear();
+			std::stringstream list(argv[++i]);
+			for (std::string count; std::getline(list, count, ',');) {
+				quadCounts.push_back(static_cast<uint32_t>(std::strtoul(count.c_str(), nullptr, 10)));
+			}
+			if (quadCounts.empty()) {
+				quadCounts.push_back(0);
+			}
+		}
+		else if (strcmp(argv[i], "--trace") == 0 && i + 1 < argc) {
+			settings.tracePath = argv[++i];
+		}
+		else if (strcmp(argv[i], "--pipelines") == 0 && i + 1 < argc) {
+			settings.pipelinePermutations = static_cast<uint32_t>(std::strtoul(argv[++i], nullptr, 10));
+		}
+		else if (strcmp(argv[i], "--pipeline-threads") == 0 && i + 1 < argc) {
+			settings.pipelineThreads = static_cast<uint32_t>(std::strtoul(argv[++i], nullptr, 10));
+		}
+		else if (strcmp(argv[i], "--no-derivatives") == 0) {
+			settings.pipelineDerivatives = false;
+		}
+		else if (strcmp(argv[i], "--descriptors") == 0 && i + 1 < argc) {
+			std::string mode = argv[++i];
+			if (mode == "none") {
+				settings.descriptorMode = DescriptorMode::None;
+			}
+			else if (mode == "per-draw") {
+				settings.descriptorMode = DescriptorMode::PerDraw;
+			}
+			else if (mode == "bindless") {
+				settings.descriptorMode = DescriptorMode::Bindless;
+			}
+			else {
+				std::cerr << "unknown descriptor mode " << mode << std::endl;
+				return EXIT_FAILURE;
+			}
+		}
+		else if (strcmp(argv[i], "--objects") == 0 && i + 1 < argc) {
+			settings.objectCount = static_cast<uint32_t>(std::strtoul(argv[++i], nullptr, 10));
+		}
+		else if (strcmp(argv[i], "--culling") == 0 && i + 1 < argc) {
+			std::string mode = argv[++i];
+			if (mode == "cpu") {
+				settings.cullingMode = CullingMode::Cpu;
+			}
+			else if (mode == "gpu") {
+				settings.cullingMode = CullingMode::Gpu;
+			}
+			else {
+				std::cerr << "unknown culling mode " << mode << std::endl;
+				return EXIT_FAILURE;
+			}
+		}
+		else if (strcmp(argv[i], "--occlusion") == 0 && i + 1 < argc) {
+			std::string mode = argv[++i];
+			if (mode == "off") {
+				occlusionModes = { false };
+			}
+			else if (mode == "on") {
+				occlusionModes = { true };
+			}
+			else if (mode == "both") {
+				occlusionModes = { false, true };
+			}
+			else {
+				std::cerr << "unknown occlusion mode " << mode << std::endl;
+				return EXIT_FAILURE;
+			}
+		}
+		else if (strcmp(argv[i], "--background-dispatches") == 0 && i + 1 < argc) {
+			settings.backgroundDispatches = static_cast<uint32_t>(std::strtoul(argv[++i], nullptr, 10));
+		}
+		else if (strcmp(argv[i], "--background-upload") == 0 && i + 1 < argc) {
+			settings.backgroundUploadBytes = static_cast<uint32_t>(std::strtoul(argv[++i], nullptr, 10)) * 1024 * 1024;
+		}
+		else if (strcmp(argv[i], "--async-queues") == 0 && i + 1 < argc) {
+			std::string mode = argv[++i];
+			if (mode == "off") {
+				asyncModes = { false };
+			}
+			else if (mode == "on") {
+				asyncModes = { true };
+			}
+			else if (mode == "both") {
+				asyncModes = { false, true };
+			}
+			else {
+				std::cerr << "unknown async queue mode " << mode << std::endl;
+				return EXIT_FAILURE;
+			}
+		}
+		else if (strcmp(argv[i], "--render-graph") == 0) {
+			settings.renderGraph = true;
+		}
+		else if (strcmp(argv[i], "--batch-threads") == 0 && i + 1 < argc) {
+			settings.batchThreads = std::max(1u, static_cast<uint32_t>(std::strtoul(argv[++i], nullptr, 10)));
+		}
+	}
+
+	std::vector<std::string> reports;
+	// Largest quad count whose average frame, fence waits included, fit into 1/60 s
+	uint32_t quadsAt60Fps = 0;
+	// GPU time of the Frame zone occlusion culling saved, per configuration run without and with it
+	std::vector<double> occlusionSavedGpuMs;
+	// Frames per second with the background work on async queues over the ones with it in the frames, per configuration
+	std::vector<double> asyncSpeedup;
+	// Frames per second of every configuration with the first frames in flight, and of the others over them
+	std::vector<double> firstDepthFps;
+	std::vector<double> framesInFlightSpeedup;
+	// Recording time with the first thread count over the one with each further count, per configuration
+	std::vector<double> recordSpeedup;
+	for (size_t depth = 0; depth < framesInFlight.size(); ++depth) {
+		size_t configuration = 0;
+		for (uint32_t quads : quadCounts) {
+			// Per occlusion and async mode
+			std::vector<double> firstThreadsRecordMs;
+			for (size_t threadIndex = 0; threadIndex < recordThreads.size(); ++threadIndex) {
+				uint32_t threads = recordThreads[threadIndex];
+				size_t run = 0;
+				// Per async mode, as the background work in the frames adds to the Frame zone
+				std::vector<double> unoccludedGpuMs(asyncModes.size(), 0.0);
+				for (bool occlusion : occlusionModes) {
+					double inFrameFps = 0.0;
+					for (size_t mode = 0; mode < asyncModes.size(); ++mode) {
+						settings.framesInFlight = framesInFlight[depth];
+						settings.quadCount = quads;
+						settings.recordThreads = threads;
+						settings.occlusionCulling = occlusion;
+						settings.asyncQueues = asyncModes[mode];
+						auto app = HelloTriangleApplication(settings);
+
+						try {
+							app.run();
+						}
+						catch (const std::exception& e) {
+							std::cerr << e.what() << std::endl;
+							return EXIT_FAILURE;
+						}
+
+						const FrameTimings& timings = app.getFrameTimings();
+						std::ostringstream report;
+						writeReport(report, settings, timings, app.getGpuMemoryStatistics(), app.getStagingStatistics(), app.getQuadStatistics(),
+							app.getRenderGraphStatistics(), app.getGpuProfiler(), warmup);
+						reports.push_back(report.str());
+
+						size_t measured = timings.cpuFrameMs.size() - std::min(warmup, timings.cpuFrameMs.size());
+						double frameMs = 0.0, recordMs = 0.0;
+						for (size_t frame = timings.cpuFrameMs.size() - measured; frame < timings.cpuFrameMs.size(); ++frame) {
+							frameMs += timings.cpuFrameMs[frame] / measured;
+							recordMs += timings.recordMs[frame] / measured;
+						}
+						if (measured > 0 && frameMs <= 1000.0 / 60.0) {
+							quadsAt60Fps = std::max(quadsAt60Fps, quads);
+						}
+
+						double gpuFrameMs = averageZoneMs(app.getGpuProfiler(), "Frame", warmup);
+						if (!occlusion) {
+							unoccludedGpuMs[mode] = gpuFrameMs;
+						}
+						else if (occlusionModes.size() > 1) {
+							occlusionSavedGpuMs.push_back(unoccludedGpuMs[mode] - gpuFrameMs);
+						}
+
+						double fps = timings.totalSeconds > 0.0 ? timings.cpuFrameMs.size() / timings.totalSeconds : 0.0;
+						if (!asyncModes[mode]) {
+							inFrameFps = fps;
+						}
+						else if (asyncModes.size() > 1) {
+							asyncSpeedup.push_back(inFrameFps > 0.0 ? fps / inFrameFps : 0.0);
+						}
+
+						if (depth == 0) {
+							firstDepthFps.push_back(fps);
+						}
+						else {
+							framesInFlightSpeedup.push_back(firstDepthFps[configuration] > 0.0 ? fps / firstDepthFps[configuration] : 0.0);
+						}
+						++configuration;
+
+						if (threadIndex == 0) {
+							firstThreadsRecordMs.push_back(recordMs);
+						}
+						else {
+							recordSpeedup.push_back(recordMs > 0.0 ? firstThreadsRecordMs[run] / recordMs : 0.0);
+						}
+						++run;
+					}
+				}
+			}
+		}
+	}
+	std::ofstream file;
+	if (!outputPath.empty()) {
+		file.open(outputPath);
+		if (!file.is_open()) {
+			std::cerr << "failed to open " << outputPath << std::endl;
+			return EXIT_FAILURE;
+		}
+	}
+	std::ostream& out = outputPath.empty() ? std::cout : file;
+
+	if (reports.size() == 1) {
+		out << reports[0];
+	}
+	else {
+		out << "{ \"runs\": [\n";
+		for (size_t i = 0; i < reports.size(); ++i) {
+			out << (i > 0 ? ",\n" : "") << reports[i].substr(0, reports[i].size() - 1);
+		}
+		out << "\n]";
+		if (quadCounts.size() > 1) {
+			out << ", \"quadsAt60Fps\": " << quadsAt60Fps;
+		}
+		if (!occlusionSavedGpuMs.empty()) {
+			out << ", \"occlusionSavedGpuMs\": [";
+			for (size_t i = 0; i < occlusionSavedGpuMs.size(); ++i) {
+				out << (i > 0 ? ", " : "") << occlusionSavedGpuMs[i];
+			}
+			out << "]";
+		}
+		if (!asyncSpeedup.empty()) {
+			out << ", \"asyncSpeedup\": [";
+			for (size_t i = 0; i < asyncSpeedup.size(); ++i) {
+				out << (i > 0 ? ", " : "") << asyncSpeedup[i];
+			}
+			out << "]";
+		}
+		if (!recordSpeedup.empty()) {
+			out << ", \"recordSpeedup\": [";
+			for (size_t i = 0; i < recordSpeedup.size(); ++i) {
+				out << (i > 0 ? ", " : "") << recordSpeedup[i];
+			}
+			out << "]";
+		}
+		if (!framesInFlightSpeedup.empty()) {
+			out << ", \"framesInFlightSpeedup\": [";
+			for (size_t i = 0; i < framesInFlightSpeedup.size(); ++i) {
+				out << (i > 0 ? ", " : "") << framesInFlightSpeedup[i];
+			}
+			out << "]";
+		}
+		out << " }\n";
+	}
+
+	return EXIT_SUCCESS;
+}
\ No newline at end of file
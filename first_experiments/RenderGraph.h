@@ -0,0 +1,729 @@
+#pragma once
+#include <vulkan/vulkan.hpp>
+
+#include <algorithm>
+#include <functional>
+#include <map>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "GpuAllocator.h"
+
+// Describes a frame as passes that declare the images they read and write, everything in between is worked out by
+// the graph. Passes run in the order they were added. compile culls the passes whose results never reach an imported
+// image, computes the layout transitions and barriers in front of every pass and places the transient images whose
+// lifetimes don't overlap in the same memory. Passes with attachments get a render pass whose load and store ops
+// follow from the graph, attachments nobody reads afterwards are not stored. execute records all barriers of a pass
+// with one vkCmdPipelineBarrier, followed by the pass. The graph is static, compile runs once and execute every frame.
+class RenderGraph {
+
+public:
+	using ResourceId = uint32_t;
+	using PassId = uint32_t;
+
+	enum class Usage {
+		ColorAttachment,
+		DepthAttachment,
+		// Read by fragment shaders
+		Sampled,
+		TransferSource,
+		TransferDestination
+	};
+
+	// Handed to the pass when it is recorded, the render pass has already begun if the pass has attachments
+	struct PassContext {
+		vk::RenderPass renderPass;
+		vk::Framebuffer framebuffer;
+		vk::Extent2D extent;
+	};
+
+	using ExecuteFunction = std::function<void(vk::CommandBuffer commandBuffer, const PassContext& context)>;
+
+	struct Statistics {
+		uint32_t passCount = 0;
+		uint32_t culledPassCount = 0;
+		// Recorded every frame
+		uint32_t imageBarrierCount = 0;
+		uint32_t pipelineBarrierCount = 0;
+		// Reads that found the image in the right layout with the last write already visible to them
+		uint32_t elidedBarrierCount = 0;
+		uint32_t transientImageCount = 0;
+		// Of all transient images on their own, and of the memory they share
+		vk::DeviceSize transientSize = 0;
+		vk::DeviceSize aliasedSize = 0;
+	};
+
+	RenderGraph() = default;
+
+	~RenderGraph() {
+		reset();
+	}
+
+	RenderGraph(const RenderGraph&) = delete;
+	RenderGraph& operator=(const RenderGraph&) = delete;
+
+	// Created by compile, with the usage flags of all passes that use it
+	ResourceId createImage(const std::string& name, vk::Format format, vk::Extent2D extent) {
+		Resource resource;
+		resource.name = name;
+		resource.format = format;
+		resource.extent = extent;
+		resources.push_back(std::move(resource));
+		return static_cast<ResourceId>(resources.size() - 1);
+	}
+
+	// Created outside of the graph, e.g. the swap chain images, and set with setImportedImage before every execute.
+	// Imported images are the outputs of the graph, passes only survive culling if their results end up in one. The
+	// contents are discarded at the start of the frame if initialLayout is undefined, the frame leaves it in finalLayout.
+	ResourceId importImage(const std::string& name, vk::Format format, vk::Extent2D extent, vk::ImageLayout initialLayout, vk::ImageLayout finalLayout) {
+		ResourceId id = createImage(name, format, extent);
+		resources[id].imported = true;
+		resources[id].initialLayout = initialLayout;
+		resources[id].finalLayout = finalLayout;
+		return id;
+	}
+
+	// secondaryCommandBuffers begins the render pass for vk::CommandBuffer::executeCommands
+	PassId addPass(const std::string& name, ExecuteFunction execute, bool secondaryCommandBuffers = false) {
+		Pass pass;
+		pass.name = name;
+		pass.execute = std::move(execute);
+		pass.secondaryCommandBuffers = secondaryCommandBuffers;
+		passes.push_back(std::move(pass));
+		return static_cast<PassId>(passes.size() - 1);
+	}
+
+	void read(PassId pass, ResourceId resource, Usage usage) {
+		addAccess(pass, { resource, usage, false, std::nullopt });
+	}
+
+	// Attachments without a clear value keep what earlier passes wrote to them
+	void write(PassId pass, ResourceId resource, Usage usage, std::optional<vk::ClearValue> clearValue = std::nullopt) {
+		addAccess(pass, { resource, usage, true, clearValue });
+	}
+
+	void compile(vk::Device device, GpuAllocator& allocator) {
+		reset();
+		this->device = device;
+		this->allocator = &allocator;
+		statistics = {};
+		statistics.passCount = static_cast<uint32_t>(passes.size());
+
+		cullPasses();
+		computeLifetimes();
+		createTransientImages();
+		computeBarriers();
+		for (PassId pass = 0; pass < passes.size(); ++pass) {
+			if (!passes[pass].culled) {
+				createRenderPass(passes[pass]);
+			}
+		}
+	}
+
+	void setImportedImage(ResourceId resource, vk::Image image, vk::ImageView view) {
+		resources[resource].importedImage = image;
+		resources[resource].importedView = view;
+	}
+
+	void execute(vk::CommandBuffer commandBuffer) {
+		for (auto& pass : passes) {
+			if (pass.culled) {
+				continue;
+			}
+			recordBarriers(commandBuffer, pass.barriers);
+
+			PassContext context;
+			if (!pass.renderPass) {
+				pass.execute(commandBuffer, context);
+				continue;
+			}
+
+			context.renderPass = *pass.renderPass;
+			context.framebuffer = getFramebuffer(pass);
+			context.extent = pass.extent;
+
+			vk::RenderPassBeginInfo beginInfo{};
+			beginInfo.renderPass = context.renderPass;
+			beginInfo.framebuffer = context.framebuffer;
+			beginInfo.renderArea = vk::Rect2D({ 0, 0 }, pass.extent);
+			beginInfo.clearValueCount = static_cast<uint32_t>(pass.clearValues.size());
+			beginInfo.pClearValues = pass.clearValues.data();
+			commandBuffer.beginRenderPass(beginInfo, pass.secondaryCommandBuffers ? vk::SubpassContents::eSecondaryCommandBuffers : vk::SubpassContents::eInline);
+			pass.execute(commandBuffer, context);
+			commandBuffer.endRenderPass();
+		}
+		recordBarriers(commandBuffer, finalBarriers);
+	}
+
+	// For creating the pipelines of a pass, valid after compile
+	vk::RenderPass getRenderPass(PassId pass) const {
+		return *passes[pass].renderPass;
+	}
+
+	vk::Image getImage(ResourceId resource) const {
+		return resources[resource].imported ? resources[resource].importedImage : *resources[resource].image;
+	}
+
+	bool isCulled(PassId pass) const {
+		return passes[pass].culled;
+	}
+
+	const Statistics& getStatistics() const {
+		return statistics;
+	}
+
+	// Destroys everything compile created along with the passes and resources, so the graph can be declared again,
+	// e.g. for a resized swap chain
+	void clear() {
+		reset();
+		passes.clear();
+		resources.clear();
+	}
+
+	// Destroys everything compile created, the passes and resources stay declared
+	void reset() {
+		for (auto& pass : passes) {
+			pass.framebuffers.clear();
+			pass.renderPass.reset();
+			pass.attachments.clear();
+			pass.clearValues.clear();
+		}
+		for (auto& resource : resources) {
+			resource.view.reset();
+			resource.image.reset();
+		}
+		for (auto& allocation : memory) {
+			allocator->free(allocation);
+		}
+		memory.clear();
+	}
+
+private:
+	struct Access {
+		ResourceId resource;
+		Usage usage;
+		bool write;
+		std::optional<vk::ClearValue> clearValue;
+	};
+
+	struct UsageInfo {
+		vk::ImageLayout layout;
+		vk::PipelineStageFlags stages;
+		vk::AccessFlags readAccess;
+		vk::AccessFlags writeAccess;
+		vk::ImageUsageFlags imageUsage;
+	};
+
+	struct Resource {
+		std::string name;
+		vk::Format format = vk::Format::eUndefined;
+		vk::Extent2D extent;
+		bool imported = false;
+		vk::ImageLayout initialLayout = vk::ImageLayout::eUndefined;
+		vk::ImageLayout finalLayout = vk::ImageLayout::eUndefined;
+
+		// Over the passes that were not culled, firstPass is passes.size() for unused resources
+		uint32_t firstPass = 0;
+		uint32_t lastPass = 0;
+		vk::ImageUsageFlags usage;
+		// Of every access, what the first access of the next frame waits for
+		vk::PipelineStageFlags allStages;
+		vk::AccessFlags allWriteAccess;
+
+		// Transient images, placed at offset in memory[memoryIndex]
+		vk::UniqueImage image;
+		vk::UniqueImageView view;
+		vk::MemoryRequirements requirements;
+		uint32_t memoryIndex = 0;
+		vk::DeviceSize offset = 0;
+
+		vk::Image importedImage;
+		vk::ImageView importedView;
+	};
+
+	struct Barrier {
+		ResourceId resource;
+		vk::ImageLayout oldLayout;
+		vk::ImageLayout newLayout;
+		vk::AccessFlags srcAccess;
+		vk::AccessFlags dstAccess;
+	};
+
+	// Recorded as one vkCmdPipelineBarrier
+	struct BarrierBatch {
+		vk::PipelineStageFlags srcStages;
+		vk::PipelineStageFlags dstStages;
+		std::vector<Barrier> barriers;
+	};
+
+	struct Pass {
+		std::string name;
+		ExecuteFunction execute;
+		bool secondaryCommandBuffers = false;
+		std::vector<Access> accesses;
+		bool culled = false;
+		BarrierBatch barriers;
+
+		vk::UniqueRenderPass renderPass;
+		std::vector<ResourceId> attachments;
+		std::vector<vk::ClearValue> clearValues;
+		vk::Extent2D extent;
+		// Keyed by the attachment views, which change with the imported images
+		std::map<std::vector<VkImageView>, vk::UniqueFramebuffer> framebuffers;
+	};
+
+	// Where an image stands during the frame: its layout, the stages of the last write and the reads since, and
+	// what the last write has been made visible to
+	struct State {
+		vk::ImageLayout layout;
+		vk::PipelineStageFlags writeStages;
+		vk::AccessFlags writeAccess;
+		vk::PipelineStageFlags readStages;
+		vk::PipelineStageFlags visibleStages;
+		vk::AccessFlags visibleAccess;
+	};
+
+	std::vector<Resource> resources;
+	std::vector<Pass> passes;
+	BarrierBatch finalBarriers;
+
+	vk::Device device;
+	GpuAllocator* allocator = nullptr;
+	// One allocation per group of transient images with the same memory type bits
+	std::vector<GpuAllocation> memory;
+	Statistics statistics;
+
+	std::vector<vk::ImageMemoryBarrier> imageBarriers;
+
+	static UsageInfo getUsageInfo(Usage usage) {
+		switch (usage) {
+		case Usage::ColorAttachment:
+			return { vk::ImageLayout::eColorAttachmentOptimal, vk::PipelineStageFlagBits::eColorAttachmentOutput,
+				vk::AccessFlagBits::eColorAttachmentRead, vk::AccessFlagBits::eColorAttachmentWrite, vk::ImageUsageFlagBits::eColorAttachment };
+		case Usage::DepthAttachment:
+			return { vk::ImageLayout::eDepthStencilAttachmentOptimal, vk::PipelineStageFlagBits::eEarlyFragmentTests | vk::PipelineStageFlagBits::eLateFragmentTests,
+				vk::AccessFlagBits::eDepthStencilAttachmentRead, vk::AccessFlagBits::eDepthStencilAttachmentWrite, vk::ImageUsageFlagBits::eDepthStencilAttachment };
+		case Usage::Sampled:
+			return { vk::ImageLayout::eShaderReadOnlyOptimal, vk::PipelineStageFlagBits::eFragmentShader,
+				vk::AccessFlagBits::eShaderRead, vk::AccessFlags(), vk::ImageUsageFlagBits::eSampled };
+		case Usage::TransferSource:
+			return { vk::ImageLayout::eTransferSrcOptimal, vk::PipelineStageFlagBits::eTransfer,
+				vk::AccessFlagBits::eTransferRead, vk::AccessFlags(), vk::ImageUsageFlagBits::eTransferSrc };
+		case Usage::TransferDestination:
+			return { vk::ImageLayout::eTransferDstOptimal, vk::PipelineStageFlagBits::eTransfer,
+				vk::AccessFlags(), vk::AccessFlagBits::eTransferWrite, vk::ImageUsageFlagBits::eTransferDst };
+		}
+		throw std::runtime_error("unknown render graph usage!");
+	}
+
+	static vk::ImageAspectFlags getAspect(vk::Format format) {
+		switch (format) {
+		case vk::Format::eD16Unorm:
+		case vk::Format::eX8D24UnormPack32:
+		case vk::Format::eD32Sfloat:
+			return vk::ImageAspectFlagBits::eDepth;
+		case vk::Format::eD16UnormS8Uint:
+		case vk::Format::eD24UnormS8Uint:
+		case vk::Format::eD32SfloatS8Uint:
+			return vk::ImageAspectFlagBits::eDepth | vk::ImageAspectFlagBits::eStencil;
+		case vk::Format::eS8Uint:
+			return vk::ImageAspectFlagBits::eStencil;
+		default:
+			return vk::ImageAspectFlagBits::eColor;
+		}
+	}
+
+	static bool isAttachment(Usage usage) {
+		return usage == Usage::ColorAttachment || usage == Usage::DepthAttachment;
+	}
+
+	void addAccess(PassId pass, const Access& access) {
+		for (const auto& existing : passes[pass].accesses) {
+			if (existing.resource == access.resource) {
+				throw std::runtime_error("render graph pass " + passes[pass].name + " uses " + resources[access.resource].name + " twice!");
+			}
+		}
+		passes[pass].accesses.push_back(access);
+	}
+
+	// Walks the passes backwards from the imported images. A pass survives if it writes an image a later surviving
+	// pass still needs, its reads are then needed in turn. Clearing an image ends the need for what was written before.
+	void cullPasses() {
+		std::vector<bool> needed(resources.size());
+		for (ResourceId id = 0; id < resources.size(); ++id) {
+			needed[id] = resources[id].imported;
+		}
+
+		for (size_t i = passes.size(); i-- > 0;) {
+			Pass& pass = passes[i];
+			pass.culled = std::none_of(pass.accesses.begin(), pass.accesses.end(), [&](const Access& access) {
+				return access.write && needed[access.resource];
+			});
+			if (pass.culled) {
+				++statistics.culledPassCount;
+				continue;
+			}
+
+			for (const auto& access : pass.accesses) {
+				if (access.write && access.clearValue) {
+					needed[access.resource] = false;
+				}
+			}
+			for (const auto& access : pass.accesses) {
+				if (!access.write || !access.clearValue) {
+					needed[access.resource] = true;
+				}
+			}
+		}
+	}
+
+	void computeLifetimes() {
+		for (auto& resource : resources) {
+			resource.firstPass = static_cast<uint32_t>(passes.size());
+			resource.lastPass = 0;
+			resource.usage = vk::ImageUsageFlags();
+			resource.allStages = vk::PipelineStageFlags();
+			resource.allWriteAccess = vk::AccessFlags();
+		}
+
+		for (uint32_t pass = 0; pass < passes.size(); ++pass) {
+			if (passes[pass].culled) {
+				continue;
+			}
+			for (const auto& access : passes[pass].accesses) {
+				Resource& resource = resources[access.resource];
+				UsageInfo info = getUsageInfo(access.usage);
+
+				if (resource.firstPass == passes.size() && !access.write && !resource.imported) {
+					throw std::runtime_error("render graph pass " + passes[pass].name + " reads " + resource.name + " before it was written!");
+				}
+				resource.firstPass = std::min(resource.firstPass, pass);
+				resource.lastPass = pass;
+				resource.usage |= info.imageUsage;
+				resource.allStages |= info.stages;
+				if (access.write) {
+					resource.allWriteAccess |= info.writeAccess;
+				}
+			}
+		}
+	}
+
+	bool isUsed(const Resource& resource) const {
+		return resource.firstPass < passes.size();
+	}
+
+	bool livesOverlap(const Resource& left, const Resource& right) const {
+		return left.firstPass <= right.lastPass && right.firstPass <= left.lastPass;
+	}
+
+	bool memoryOverlaps(const Resource& left, const Resource& right) const {
+		return left.memoryIndex == right.memoryIndex
+			&& left.offset < right.offset + right.requirements.size && right.offset < left.offset + left.requirements.size;
+	}
+
+	// Largest first, every image goes to the lowest offset that doesn't collide with an image it lives alongside
+	void createTransientImages() {
+		std::vector<ResourceId> transients;
+		for (ResourceId id = 0; id < resources.size(); ++id) {
+			Resource& resource = resources[id];
+			if (resource.imported || !isUsed(resource)) {
+				continue;
+			}
+
+			vk::ImageCreateInfo imageInfo{};
+			imageInfo.imageType = vk::ImageType::e2D;
+			imageInfo.format = resource.format;
+			imageInfo.extent = vk::Extent3D(resource.extent.width, resource.extent.height, 1);
+			imageInfo.mipLevels = 1;
+			imageInfo.arrayLayers = 1;
+			imageInfo.samples = vk::SampleCountFlagBits::e1;
+			imageInfo.tiling = vk::ImageTiling::eOptimal;
+			imageInfo.usage = resource.usage;
+			imageInfo.sharingMode = vk::SharingMode::eExclusive;
+			imageInfo.initialLayout = vk::ImageLayout::eUndefined;
+
+			try {
+				resource.image = device.createImageUnique(imageInfo);
+			}
+			catch (vk::SystemError err) {
+				throw std::runtime_error("failed to create transient image " + resource.name + "!");
+			}
+			resource.requirements = device.getImageMemoryRequirements(*resource.image);
+			transients.push_back(id);
+			statistics.transientSize += resource.requirements.size;
+		}
+		statistics.transientImageCount = static_cast<uint32_t>(transients.size());
+
+		std::stable_sort(transients.begin(), transients.end(), [this](ResourceId left, ResourceId right) {
+			return resources[left].requirements.size > resources[right].requirements.size;
+		});
+
+		std::vector<uint32_t> memoryTypeBits;
+		std::vector<vk::MemoryRequirements> heaps;
+		std::vector<ResourceId> placed;
+		for (ResourceId id : transients) {
+			Resource& resource = resources[id];
+			auto heap = std::find(memoryTypeBits.begin(), memoryTypeBits.end(), resource.requirements.memoryTypeBits);
+			resource.memoryIndex = static_cast<uint32_t>(heap - memoryTypeBits.begin());
+			if (heap == memoryTypeBits.end()) {
+				memoryTypeBits.push_back(resource.requirements.memoryTypeBits);
+				heaps.push_back(vk::MemoryRequirements(0, 1, resource.requirements.memoryTypeBits));
+			}
+
+			// Candidates are the start of the heap and the ends of the images living at the same time
+			std::vector<vk::DeviceSize> candidates = { 0 };
+			for (ResourceId other : placed) {
+				if (resources[other].memoryIndex == resource.memoryIndex && livesOverlap(resource, resources[other])) {
+					candidates.push_back(resources[other].offset + resources[other].requirements.size);
+				}
+			}
+			std::sort(candidates.begin(), candidates.end());
+
+			vk::DeviceSize alignment = resource.requirements.alignment;
+			for (vk::DeviceSize candidate : candidates) {
+				resource.offset = (candidate + alignment - 1) / alignment * alignment;
+				bool collides = std::any_of(placed.begin(), placed.end(), [&](ResourceId other) {
+					return livesOverlap(resource, resources[other]) && memoryOverlaps(resource, resources[other]);
+				});
+				if (!collides) {
+					break;
+				}
+			}
+			placed.push_back(id);
+
+			vk::MemoryRequirements& heapRequirements = heaps[resource.memoryIndex];
+			heapRequirements.size = std::max(heapRequirements.size, resource.offset + resource.requirements.size);
+			heapRequirements.alignment = std::max(heapRequirements.alignment, alignment);
+		}
+
+		for (const auto& heapRequirements : heaps) {
+			memory.push_back(allocator->allocate(heapRequirements, vk::MemoryPropertyFlagBits::eDeviceLocal, {}, false));
+			statistics.aliasedSize += heapRequirements.size;
+		}
+
+		for (ResourceId id : transients) {
+			Resource& resource = resources[id];
+			const GpuAllocation& allocation = memory[resource.memoryIndex];
+			device.bindImageMemory(*resource.image, allocation.memory, allocation.offset + resource.offset);
+
+			auto viewInfo = vk::ImageViewCreateInfo(
+				vk::ImageViewCreateFlags(),
+				*resource.image,
+				vk::ImageViewType::e2D,
+				resource.format,
+				{},
+				{ getAspect(resource.format), 0, 1, 0, 1 }
+			);
+			try {
+				resource.view = device.createImageViewUnique(viewInfo);
+			}
+			catch (vk::SystemError err) {
+				throw std::runtime_error("failed to create image views!");
+			}
+		}
+	}
+
+	// Follows every image through the passes. Reads in the layout of an earlier read, which the last write was already
+	// made visible to, need no barrier. The first access of a frame waits for every access of the previous frame to the
+	// same memory, which includes the images aliasing it.
+	void computeBarriers() {
+		std::vector<State> states(resources.size());
+		for (ResourceId id = 0; id < resources.size(); ++id) {
+			const Resource& resource = resources[id];
+			State& state = states[id];
+			state.layout = resource.imported ? resource.initialLayout : vk::ImageLayout::eUndefined;
+			state.writeStages = resource.allStages;
+			state.writeAccess = resource.allWriteAccess;
+			if (resource.imported || !isUsed(resource)) {
+				continue;
+			}
+			for (const auto& other : resources) {
+				if (&other != &resource && !other.imported && isUsed(other) && memoryOverlaps(resource, other)) {
+					state.writeStages |= other.allStages;
+					state.writeAccess |= other.allWriteAccess;
+				}
+			}
+		}
+
+		for (auto& pass : passes) {
+			pass.barriers = {};
+			if (pass.culled) {
+				continue;
+			}
+			for (const auto& access : pass.accesses) {
+				State& state = states[access.resource];
+				UsageInfo info = getUsageInfo(access.usage);
+				vk::AccessFlags dstAccess = access.write ? info.readAccess | info.writeAccess : info.readAccess;
+				bool transition = state.layout != info.layout;
+
+				if (!access.write && !transition && (!state.writeStages
+					|| ((info.stages & ~state.visibleStages) == vk::PipelineStageFlags() && (dstAccess & ~state.visibleAccess) == vk::AccessFlags()))) {
+					state.readStages |= info.stages;
+					++statistics.elidedBarrierCount;
+					continue;
+				}
+
+				// Writes and layout transitions also have to wait for the reads since the last write
+				vk::PipelineStageFlags srcStages = state.writeStages;
+				if (access.write || transition) {
+					srcStages |= state.readStages;
+				}
+				pass.barriers.srcStages |= srcStages;
+				pass.barriers.dstStages |= info.stages;
+				pass.barriers.barriers.push_back({ access.resource, state.layout, info.layout, state.writeAccess, dstAccess });
+
+				if (access.write) {
+					state = { info.layout, info.stages, info.writeAccess, vk::PipelineStageFlags(), info.stages, dstAccess };
+				}
+				else if (transition) {
+					state = { info.layout, state.writeStages, state.writeAccess, info.stages, info.stages, dstAccess };
+				}
+				else {
+					state.readStages |= info.stages;
+					state.visibleStages |= info.stages;
+					state.visibleAccess |= dstAccess;
+				}
+			}
+			statistics.imageBarrierCount += static_cast<uint32_t>(pass.barriers.barriers.size());
+			statistics.pipelineBarrierCount += pass.barriers.barriers.empty() ? 0 : 1;
+		}
+
+		// Imported images are left in their final layout, whatever comes after the frame synchronizes with it
+		finalBarriers = {};
+		for (ResourceId id = 0; id < resources.size(); ++id) {
+			const Resource& resource = resources[id];
+			const State& state = states[id];
+			if (!resource.imported || !isUsed(resource) || state.layout == resource.finalLayout) {
+				continue;
+			}
+			finalBarriers.srcStages |= state.writeStages | state.readStages;
+			finalBarriers.dstStages |= vk::PipelineStageFlagBits::eBottomOfPipe;
+			finalBarriers.barriers.push_back({ id, state.layout, resource.finalLayout, state.writeAccess, vk::AccessFlags() });
+		}
+		statistics.imageBarrierCount += static_cast<uint32_t>(finalBarriers.barriers.size());
+		statistics.pipelineBarrierCount += finalBarriers.barriers.empty() ? 0 : 1;
+	}
+
+	// Attachments start and end in the layout of their usage, the transitions are done by the barriers. The contents
+	// are loaded if an earlier pass wrote them and stored if a later pass or the imported image needs them.
+	void createRenderPass(Pass& pass) {
+		std::vector<vk::AttachmentDescription> descriptions;
+		std::vector<vk::AttachmentReference> colorReferences;
+		std::optional<vk::AttachmentReference> depthReference;
+		uint32_t passIndex = static_cast<uint32_t>(&pass - passes.data());
+
+		for (const auto& access : pass.accesses) {
+			if (!isAttachment(access.usage)) {
+				continue;
+			}
+			const Resource& resource = resources[access.resource];
+			UsageInfo info = getUsageInfo(access.usage);
+
+			bool hasContents = resource.firstPass < passIndex || (resource.imported && resource.initialLayout != vk::ImageLayout::eUndefined);
+			bool contentsNeeded = resource.lastPass > passIndex || resource.imported;
+			vk::AttachmentLoadOp loadOp = access.clearValue ? vk::AttachmentLoadOp::eClear
+				: hasContents ? vk::AttachmentLoadOp::eLoad : vk::AttachmentLoadOp::eDontCare;
+			vk::AttachmentStoreOp storeOp = contentsNeeded ? vk::AttachmentStoreOp::eStore : vk::AttachmentStoreOp::eDontCare;
+
+			vk::AttachmentDescription description{};
+			description.format = resource.format;
+			description.samples = vk::SampleCountFlagBits::e1;
+			description.loadOp = loadOp;
+			description.storeOp = storeOp;
+			description.stencilLoadOp = getAspect(resource.format) & vk::ImageAspectFlagBits::eStencil ? loadOp : vk::AttachmentLoadOp::eDontCare;
+			description.stencilStoreOp = getAspect(resource.format) & vk::ImageAspectFlagBits::eStencil ? storeOp : vk::AttachmentStoreOp::eDontCare;
+			description.initialLayout = info.layout;
+			description.finalLayout = info.layout;
+
+			vk::AttachmentReference reference(static_cast<uint32_t>(descriptions.size()), info.layout);
+			if (access.usage == Usage::DepthAttachment) {
+				if (depthReference) {
+					throw std::runtime_error("render graph pass " + pass.name + " has more than one depth attachment!");
+				}
+				depthReference = reference;
+			}
+			else {
+				colorReferences.push_back(reference);
+			}
+
+			descriptions.push_back(description);
+			pass.attachments.push_back(access.resource);
+			pass.clearValues.push_back(access.clearValue.value_or(vk::ClearValue()));
+			if (pass.attachments.size() == 1) {
+				pass.extent = resource.extent;
+			}
+			else if (resource.extent != pass.extent) {
+				throw std::runtime_error("render graph pass " + pass.name + " has attachments of different sizes!");
+			}
+		}
+		if (descriptions.empty()) {
+			return;
+		}
+
+		vk::SubpassDescription subpass{};
+		subpass.pipelineBindPoint = vk::PipelineBindPoint::eGraphics;
+		subpass.colorAttachmentCount = static_cast<uint32_t>(colorReferences.size());
+		subpass.pColorAttachments = colorReferences.data();
+		subpass.pDepthStencilAttachment = depthReference ? &*depthReference : nullptr;
+
+		vk::RenderPassCreateInfo renderPassInfo{};
+		renderPassInfo.attachmentCount = static_cast<uint32_t>(descriptions.size());
+		renderPassInfo.pAttachments = descriptions.data();
+		renderPassInfo.subpassCount = 1;
+		renderPassInfo.pSubpasses = &subpass;
+
+		try {
+			pass.renderPass = device.createRenderPassUnique(renderPassInfo);
+		}
+		catch (vk::SystemError err) {
+			throw std::runtime_error("failed to create render pass for " + pass.name + "!");
+		}
+	}
+
+	vk::Framebuffer getFramebuffer(Pass& pass) {
+		std::vector<VkImageView> views;
+		for (ResourceId id : pass.attachments) {
+			const Resource& resource = resources[id];
+			views.push_back(static_cast<VkImageView>(resource.imported ? resource.importedView : *resource.view));
+		}
+
+		auto& framebuffer = pass.framebuffers[views];
+		if (!framebuffer) {
+			std::vector<vk::ImageView> attachments(views.begin(), views.end());
+
+			vk::FramebufferCreateInfo framebufferInfo{};
+			framebufferInfo.renderPass = *pass.renderPass;
+			framebufferInfo.attachmentCount = static_cast<uint32_t>(attachments.size());
+			framebufferInfo.pAttachments = attachments.data();
+			framebufferInfo.width = pass.extent.width;
+			framebufferInfo.height = pass.extent.height;
+			framebufferInfo.layers = 1;
+
+			try {
+				framebuffer = device.createFramebufferUnique(framebufferInfo);
+			}
+			catch (vk::SystemError err) {
+				throw std::runtime_error("failed to create frame buffer!");
+			}
+		}
+		return *framebuffer;
+	}
+
+	void recordBarriers(vk::CommandBuffer commandBuffer, const BarrierBatch& batch) {
+		if (batch.barriers.empty()) {
+			return;
+		}
+
+		imageBarriers.clear();
+		for (const auto& barrier : batch.barriers) {
+			const Resource& resource = resources[barrier.resource];
+			imageBarriers.push_back(vk::ImageMemoryBarrier(barrier.srcAccess, barrier.dstAccess, barrier.oldLayout, barrier.newLayout,
+				VK_QUEUE_FAMILY_IGNORED, VK_QUEUE_FAMILY_IGNORED, getImage(barrier.resource), { getAspect(resource.format), 0, 1, 0, 1 }));
+		}
+		// Nothing to wait for on the very first access of an image that nothing else uses
+		vk::PipelineStageFlags srcStages = batch.srcStages ? batch.srcStages : vk::PipelineStageFlags(vk::PipelineStageFlagBits::eTopOfPipe);
+		commandBuffer.pipelineBarrier(srcStages, batch.dstStages, vk::DependencyFlags(), nullptr, nullptr, imageBarriers);
+	}
+};
\ No newline at end of file
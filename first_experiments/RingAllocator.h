@@ -0,0 +1,80 @@
+#pragma once
+#include <cstdint>
+
+// Bump allocator over an abstract range [0, size), for memory that is written once and consumed by the GPU in order.
+// Linear mode fills the range once and is reset as a whole, ring mode wraps around and frees in allocation order.
+class RingAllocator {
+
+public:
+	enum class Mode {
+		Linear,
+		Ring
+	};
+
+	RingAllocator(uint64_t size = 0, Mode mode = Mode::Ring) : capacity(size), mode(mode) {}
+
+	// Returns false if the range is full until older allocations are released. The alignment has to be a power of two.
+	bool allocate(uint64_t size, uint64_t alignment, uint64_t& offset) {
+		// A default constructed allocator has no range, not even for empty allocations
+		if (capacity == 0 || size > capacity) {
+			return false;
+		}
+
+		uint64_t position = head % capacity;
+		uint64_t aligned = (position + alignment - 1) & ~(alignment - 1);
+		uint64_t skipped = aligned - position;
+		if (aligned + size > capacity) {
+			if (mode == Mode::Linear) {
+				return false;
+			}
+			// Not enough room before the end, continue at the start of the range
+			aligned = 0;
+			skipped = capacity - position;
+		}
+
+		if (head + skipped + size - tail > capacity) {
+			return false;
+		}
+
+		offset = aligned;
+		head += skipped + size;
+		return true;
+	}
+
+	// Marks the end of everything allocated so far, hand it to release once the GPU is done with those allocations
+	uint64_t getHead() const {
+		return head;
+	}
+
+	// Frees everything that was allocated before the head was at the given position
+	void release(uint64_t position) {
+		if (position > tail) {
+			tail = position;
+		}
+	}
+
+	void reset() {
+		head = 0;
+		tail = 0;
+	}
+
+	uint64_t getUsedSize() const {
+		return head - tail;
+	}
+
+	uint64_t getSize() const {
+		return capacity;
+	}
+
+	Mode getMode() const {
+		return mode;
+	}
+
+private:
+	uint64_t capacity;
+	Mode mode;
+
+	// Both grow monotonically, the offset into the range is head % capacity
+	uint64_t head = 0;
+	uint64_t tail = 0;
+};
\ No newline at end of file
@@ -0,0 +1,119 @@
+#pragma once
+#include <vulkan/vulkan.hpp>
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+#include <vector>
+
+#include "GpuAllocator.h"
+#include "RingAllocator.h"
+
+// Persistently mapped host visible buffer that uploads are copied into right away. The copies into their destination
+// buffers are batched and recorded once per frame by flush, one vkCmdCopyBuffer per destination. The ring space of a
+// frame is reused once the frame slot comes around again, i.e. after its fence has been waited on.
+class StagingRing {
+
+public:
+	struct Statistics {
+		uint64_t uploadCount = 0;
+		uint64_t uploadedBytes = 0;
+		uint64_t copyCommandCount = 0;
+		uint64_t flushCount = 0;
+		// Most ring space in use at once
+		uint64_t peakUsedSize = 0;
+	};
+
+	void init(GpuAllocator& allocator, vk::DeviceSize size, uint32_t framesInFlight) {
+		buffer = allocator.createBuffer(size, vk::BufferUsageFlagBits::eTransferSrc,
+			vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent);
+		ring = RingAllocator(size, RingAllocator::Mode::Ring);
+		frameHeads.assign(framesInFlight, 0);
+		pendingCopies.clear();
+		statistics = {};
+	}
+
+	// Releases the ring space of the uploads flushed the last time this frame slot was used
+	void beginFrame(uint32_t frame) {
+		currentFrame = frame;
+		ring.release(frameHeads[frame]);
+	}
+
+	// Copies the data into the ring now, the transfer into the destination is recorded by the next flush
+	void upload(vk::Buffer destination, vk::DeviceSize destinationOffset, const void* data, vk::DeviceSize size) {
+		uint64_t offset;
+		if (!ring.allocate(size, UPLOAD_ALIGNMENT, offset)) {
+			throw std::runtime_error("staging ring is full!");
+		}
+		std::memcpy(static_cast<char*>(buffer.getMapped()) + offset, data, size);
+
+		pendingCopies.push_back({ destination, vk::BufferCopy(offset, destinationOffset, size) });
+
+		++statistics.uploadCount;
+		statistics.uploadedBytes += size;
+		statistics.peakUsedSize = std::max(statistics.peakUsedSize, ring.getUsedSize());
+	}
+
+	// Records the pending copies followed by one barrier that makes them visible to vertex, index, uniform and storage
+	// buffer reads, storage buffers also to compute shaders. Has to be recorded outside of a render pass.
+	void flush(vk::CommandBuffer commandBuffer) {
+		frameHeads[currentFrame] = ring.getHead();
+		if (pendingCopies.empty()) {
+			return;
+		}
+
+		std::stable_sort(pendingCopies.begin(), pendingCopies.end(), [](const PendingCopy& left, const PendingCopy& right) {
+			return VkBuffer(left.destination) < VkBuffer(right.destination);
+		});
+
+		std::vector<vk::BufferCopy> regions;
+		for (size_t first = 0; first < pendingCopies.size();) {
+			size_t last = first;
+			regions.clear();
+			while (last < pendingCopies.size() && pendingCopies[last].destination == pendingCopies[first].destination) {
+				regions.push_back(pendingCopies[last].region);
+				++last;
+			}
+
+			commandBuffer.copyBuffer(buffer.get(), pendingCopies[first].destination, regions);
+			++statistics.copyCommandCount;
+			first = last;
+		}
+		pendingCopies.clear();
+
+		vk::MemoryBarrier barrier{};
+		barrier.srcAccessMask = vk::AccessFlagBits::eTransferWrite;
+		barrier.dstAccessMask = vk::AccessFlagBits::eVertexAttributeRead | vk::AccessFlagBits::eIndexRead | vk::AccessFlagBits::eUniformRead
+			| vk::AccessFlagBits::eShaderRead;
+		commandBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eTransfer,
+			vk::PipelineStageFlagBits::eVertexInput | vk::PipelineStageFlagBits::eVertexShader | vk::PipelineStageFlagBits::eFragmentShader
+			| vk::PipelineStageFlagBits::eComputeShader,
+			vk::DependencyFlags(), barrier, nullptr, nullptr);
+
+		++statistics.flushCount;
+	}
+
+	const Statistics& getStatistics() const {
+		return statistics;
+	}
+
+	vk::DeviceSize getSize() const {
+		return ring.getSize();
+	}
+
+private:
+	static constexpr uint64_t UPLOAD_ALIGNMENT = 16;
+
+	struct PendingCopy {
+		vk::Buffer destination;
+		vk::BufferCopy region;
+	};
+
+	GpuBuffer buffer;
+	RingAllocator ring;
+	std::vector<uint64_t> frameHeads;
+	uint32_t currentFrame = 0;
+
+	std::vector<PendingCopy> pendingCopies;
+	Statistics statistics;
+};
\ No newline at end of file
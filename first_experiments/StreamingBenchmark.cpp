@@ -0,0 +1,301 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+#include "AssetStreamer.h"
+
+// Loads thousands of small files the blocking way, one std::ifstream after another on the main thread, and through
+// the AssetStreamer with each backend available. The streamed runs simulate a frame loop: all requests are queued up
+// front, then every frame dispatches the completions and sleeps for the rest of the frame. Main thread stall is the
+// time spent queueing and dispatching, i.e. what a frame would lose to loading. The files are generated in a
+// temporary directory and read from the page cache unless --cold drops them from it before every run (Linux only).
+// Usage: StreamingBenchmark [--files <count>] [--size <bytes>] [--iterations <count>] [--frame-ms <ms>]
+//                           [--budget <MiB>] [--threads <count>] [--queue-depth <count>] [--cold] [--dir <path>]
+
+using Clock = std::chrono::steady_clock;
+
+struct BenchmarkSettings {
+	size_t fileCount = 4096;
+	// Files are between half and one and a half times this size
+	size_t fileSize = 16 * 1024;
+	size_t iterations = 5;
+	double frameMs = 1.0;
+	bool cold = false;
+	std::filesystem::path directory = std::filesystem::temp_directory_path() / "warp_streaming_benchmark";
+	AssetStreamer::Settings streamer;
+};
+
+struct RunResult {
+	std::vector<double> megabytesPerSecond;
+	std::vector<double> totalStallMs;
+	std::vector<double> frameStallMs;
+	AssetStreamer::Statistics statistics;
+};
+
+static double elapsedMs(Clock::time_point start) {
+	return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+static std::vector<char> readFile(const std::string& filename) {
+	std::ifstream file(filename, std::ios::ate | std::ios::binary);
+
+	if (!file.is_open()) {
+		throw std::runtime_error("failed to open file!");
+	}
+
+	size_t fileSize = (size_t) file.tellg();
+	std::vector<char> buffer(fileSize);
+
+	file.seekg(0);
+	file.read(buffer.data(), fileSize);
+	file.close();
+
+	return buffer;
+}
+
+static uint64_t consume(const char* data, size_t size) {
+	uint64_t sum = 0;
+	for (size_t i = 0; i < size; ++i) {
+		sum += static_cast<uint8_t>(data[i]);
+	}
+	return sum;
+}
+
+static std::vector<std::string> createFiles(const BenchmarkSettings& settings, size_t& totalBytes) {
+	std::filesystem::create_directories(settings.directory);
+
+	std::vector<std::string> files;
+	std::vector<char> data;
+	uint32_t random = 12345;
+	totalBytes = 0;
+
+	for (size_t i = 0; i < settings.fileCount; ++i) {
+		random = random * 1664525u + 1013904223u;
+		size_t size = settings.fileSize / 2 + random % (settings.fileSize + 1);
+		data.resize(size);
+		for (size_t j = 0; j < size; ++j) {
+			data[j] = static_cast<char>((i * 31 + j) & 0xFF);
+		}
+
+		std::string path = (settings.directory / ("asset_" + std::to_string(i) + ".bin")).string();
+		std::ofstream file(path, std::ios::binary | std::ios::trunc);
+		if (!file.write(data.data(), data.size())) {
+			throw std::runtime_error("failed to write " + path + "!");
+		}
+		files.push_back(path);
+		totalBytes += size;
+	}
+	return files;
+}
+
+// Written back first, as dirty pages cannot be dropped
+static void dropFromPageCache(const std::vector<std::string>& files) {
+#ifdef __linux__
+	for (const auto& path : files) {
+		int file = ::open(path.c_str(), O_RDONLY);
+		if (file >= 0) {
+			fdatasync(file);
+			posix_fadvise(file, 0, 0, POSIX_FADV_DONTNEED);
+			::close(file);
+		}
+	}
+#else
+	(void) files;
+#endif
+}
+
+static RunResult runBlocking(const BenchmarkSettings& settings, const std::vector<std::string>& files, size_t totalBytes, uint64_t& checksum) {
+	RunResult result;
+	for (size_t iteration = 0; iteration < settings.iterations; ++iteration) {
+		if (settings.cold) {
+			dropFromPageCache(files);
+		}
+
+		uint64_t sum = 0;
+		auto start = Clock::now();
+		for (const auto& file : files) {
+			auto data = readFile(file);
+			sum += consume(data.data(), data.size());
+		}
+		double ms = elapsedMs(start);
+
+		checksum = sum;
+		result.megabytesPerSecond.push_back(totalBytes / (1024.0 * 1024.0) / (ms / 1000.0));
+		result.totalStallMs.push_back(ms);
+		// Nothing else can run while the files load, so it is one long frame
+		result.frameStallMs.push_back(ms);
+	}
+	return result;
+}
+
+static RunResult runStreamer(const BenchmarkSettings& settings, AssetStreamer::Settings streamerSettings, const std::vector<std::string>& files,
+	size_t totalBytes, uint64_t expectedChecksum, AssetStreamer::Backend& backend) {
+	RunResult result;
+	// The main thread only queues and dispatches, so one worker per blocking read
+	WorkerPool workers;
+	workers.init(streamerSettings.threadCount + 1);
+	AssetStreamer streamer;
+	streamer.init(streamerSettings, workers);
+	backend = streamer.getBackend();
+
+	for (size_t iteration = 0; iteration < settings.iterations; ++iteration) {
+		if (settings.cold) {
+			dropFromPageCache(files);
+		}
+
+		uint64_t sum = 0;
+		size_t completedCount = 0;
+		auto start = Clock::now();
+
+		for (size_t i = 0; i < files.size(); ++i) {
+			auto priority = static_cast<AssetPriority>(i % ASSET_PRIORITY_COUNT);
+			streamer.load(files[i], priority, [&](LoadedAsset& asset) {
+				if (asset.status != AssetStatus::Loaded) {
+					throw std::runtime_error("failed to load " + asset.path + "!");
+				}
+				sum += consume(asset.data.data(), asset.data.size());
+				++completedCount;
+			});
+		}
+		double stallMs = elapsedMs(start);
+
+		while (completedCount < files.size()) {
+			auto frameStart = Clock::now();
+			streamer.dispatchCompletions();
+			double frameStall = elapsedMs(frameStart);
+
+			stallMs += frameStall;
+			result.frameStallMs.push_back(frameStall);
+			std::this_thread::sleep_for(std::chrono::duration<double, std::milli>(settings.frameMs));
+		}
+		double ms = elapsedMs(start);
+
+		if (sum != expectedChecksum) {
+			throw std::runtime_error("streamed contents differ from the files!");
+		}
+		result.megabytesPerSecond.push_back(totalBytes / (1024.0 * 1024.0) / (ms / 1000.0));
+		result.totalStallMs.push_back(stallMs);
+	}
+
+	result.statistics = streamer.getStatistics();
+	return result;
+}
+
+static void writeSummary(std::ostream& out, const char* name, std::vector<double> samples) {
+	std::sort(samples.begin(), samples.end());
+
+	double sum = 0.0;
+	for (double sample : samples) {
+		sum += sample;
+	}
+
+	out << "\t\t\"" << name << "\": { "
+		<< "\"avg\": " << sum / samples.size()
+		<< ", \"min\": " << samples.front()
+		<< ", \"p50\": " << samples[samples.size() / 2]
+		<< ", \"p99\": " << samples[std::min(samples.size() - 1, samples.size() * 99 / 100)]
+		<< ", \"max\": " << samples.back()
+		<< " }";
+}
+
+static void writeRun(std::ostream& out, const char* name, const RunResult& run, bool streamed) {
+	out << "\t\"" << name << "\": {\n";
+	writeSummary(out, "megabytesPerSecond", run.megabytesPerSecond);
+	out << ",\n";
+	writeSummary(out, "totalStallMs", run.totalStallMs);
+	out << ",\n";
+	writeSummary(out, "frameStallMs", run.frameStallMs);
+	if (streamed) {
+		out << ",\n";
+		out << "\t\t\"frames\": " << run.frameStallMs.size() << ",\n";
+		out << "\t\t\"peakInFlightBytes\": " << run.statistics.peakInFlightBytes << ",\n";
+		out << "\t\t\"budgetWaits\": " << run.statistics.budgetWaitCount << ",\n";
+		out << "\t\t\"submits\": " << run.statistics.submitCount;
+	}
+	out << "\n\t}";
+}
+
+int main(int argc, char** argv) {
+	BenchmarkSettings settings;
+
+	for (int i = 1; i < argc; ++i) {
+		std::string argument = argv[i];
+		bool hasValue = i + 1 < argc;
+		if (argument == "--files" && hasValue) {
+			settings.fileCount = std::max<size_t>(1, std::strtoul(argv[++i], nullptr, 10));
+		}
+		else if (argument == "--size" && hasValue) {
+			settings.fileSize = std::strtoul(argv[++i], nullptr, 10);
+		}
+		else if (argument == "--iterations" && hasValue) {
+			settings.iterations = std::max<size_t>(1, std::strtoul(argv[++i], nullptr, 10));
+		}
+		else if (argument == "--frame-ms" && hasValue) {
+			settings.frameMs = std::max(0.0, std::strtod(argv[++i], nullptr));
+		}
+		else if (argument == "--budget" && hasValue) {
+			settings.streamer.memoryBudget = std::strtoull(argv[++i], nullptr, 10) << 20;
+		}
+		else if (argument == "--threads" && hasValue) {
+			settings.streamer.threadCount = static_cast<uint32_t>(std::strtoul(argv[++i], nullptr, 10));
+		}
+		else if (argument == "--queue-depth" && hasValue) {
+			settings.streamer.queueDepth = static_cast<uint32_t>(std::strtoul(argv[++i], nullptr, 10));
+		}
+		else if (argument == "--dir" && hasValue) {
+			settings.directory = argv[++i];
+		}
+		else if (argument == "--cold") {
+			settings.cold = true;
+		}
+		else {
+			std::cerr << "usage: StreamingBenchmark [--files <count>] [--size <bytes>] [--iterations <count>] [--frame-ms <ms>] "
+				"[--budget <MiB>] [--threads <count>] [--queue-depth <count>] [--cold] [--dir <path>]" << std::endl;
+			return EXIT_FAILURE;
+		}
+	}
+
+	try {
+		size_t totalBytes;
+		std::vector<std::string> files = createFiles(settings, totalBytes);
+
+		uint64_t checksum = 0;
+		RunResult blocking = runBlocking(settings, files, totalBytes, checksum);
+
+		AssetStreamer::Backend threadPoolBackend, ioUringBackend;
+		AssetStreamer::Settings threadPoolSettings = settings.streamer;
+		threadPoolSettings.allowIoUring = false;
+		RunResult threadPool = runStreamer(settings, threadPoolSettings, files, totalBytes, checksum, threadPoolBackend);
+		RunResult ioUring = runStreamer(settings, settings.streamer, files, totalBytes, checksum, ioUringBackend);
+
+		std::cout << "{\n";
+		std::cout << "\t\"files\": " << files.size() << ",\n";
+		std::cout << "\t\"bytes\": " << totalBytes << ",\n";
+		std::cout << "\t\"iterations\": " << settings.iterations << ",\n";
+		std::cout << "\t\"cold\": " << (settings.cold ? "true" : "false") << ",\n";
+		std::cout << "\t\"frameMs\": " << settings.frameMs << ",\n";
+		std::cout << "\t\"memoryBudget\": " << settings.streamer.memoryBudget << ",\n";
+		writeRun(std::cout, "blocking", blocking, false);
+		std::cout << ",\n";
+		writeRun(std::cout, "threadPool", threadPool, true);
+		if (ioUringBackend == AssetStreamer::Backend::IoUring) {
+			std::cout << ",\n";
+			writeRun(std::cout, "ioUring", ioUring, true);
+		}
+		std::cout << "\n}\n";
+
+		std::filesystem::remove_all(settings.directory);
+	}
+	catch (const std::exception& e) {
+		std::cerr << e.what() << std::endl;
+		return EXIT_FAILURE;
+	}
+
+	return EXIT_SUCCESS;
+}
\ No newline at end of file
@@ -0,0 +1,364 @@
+#pragma once
+#include <vulkan/vulkan.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <deque>
+#include <limits>
+#include <stdexcept>
+#include <vector>
+
+struct SwapChainSupportDetails {
+	vk::SurfaceCapabilitiesKHR capabilities;
+	std::vector<vk::SurfaceFormatKHR> formats;
+	std::vector<vk::PresentModeKHR> presentModes;
+};
+
+enum class PresentPolicy {
+	// Present right away and accept tearing: IMMEDIATE, falls back to MAILBOX, FIFO_RELAXED and FIFO
+	LowestLatency,
+	// Never tear but replace queued images with newer ones: MAILBOX, falls back to FIFO
+	TearFree,
+	// Wait for the vertical blank, late frames tear instead of waiting for the next one: FIFO_RELAXED, falls back to FIFO
+	AdaptiveVSync,
+	// Every image is shown for at least one refresh: FIFO, which every device supports
+	VSync
+};
+
+struct SwapChainSettings {
+	PresentPolicy presentPolicy = PresentPolicy::TearFree;
+	// Requested number of images, 0 uses one more than the minimum. Clamped to what the surface supports.
+	uint32_t imageCount = 0;
+	// Usage of the images besides the color attachment, e.g. transfer destination to copy into them
+	vk::ImageUsageFlags imageUsage;
+};
+
+// Owns the swap chain with its image views and framebuffers and recreates them when the surface changes. The old
+// swap chain is handed to the new one as oldSwapchain and kept alive until the frames that used it have completed,
+// so a resize does not wait for the device to go idle. Frames are identified by the values of the frame timeline.
+class SwapChain {
+
+public:
+	static SwapChainSupportDetails querySupport(vk::PhysicalDevice physicalDevice, vk::SurfaceKHR surface) {
+		return {
+			physicalDevice.getSurfaceCapabilitiesKHR(surface),
+			physicalDevice.getSurfaceFormatsKHR(surface),
+			physicalDevice.getSurfacePresentModesKHR(surface)
+		};
+	}
+
+	static vk::PresentModeKHR choosePresentMode(PresentPolicy policy, const std::vector<vk::PresentModeKHR>& availablePresentModes) {
+		std::vector<vk::PresentModeKHR> preferred;
+		switch (policy) {
+		case PresentPolicy::LowestLatency:
+			preferred = { vk::PresentModeKHR::eImmediate, vk::PresentModeKHR::eMailbox, vk::PresentModeKHR::eFifoRelaxed };
+			break;
+		case PresentPolicy::TearFree:
+			preferred = { vk::PresentModeKHR::eMailbox };
+			break;
+		case PresentPolicy::AdaptiveVSync:
+			preferred = { vk::PresentModeKHR::eFifoRelaxed };
+			break;
+		case PresentPolicy::VSync:
+			break;
+		}
+
+		for (auto presentMode : preferred) {
+			if (std::find(availablePresentModes.begin(), availablePresentModes.end(), presentMode) != availablePresentModes.end()) {
+				return presentMode;
+			}
+		}
+		return vk::PresentModeKHR::eFifo;
+	}
+
+	void init(vk::PhysicalDevice physicalDevice, vk::Device device, vk::SurfaceKHR surface,
+		uint32_t graphicsFamily, uint32_t presentFamily, const SwapChainSettings& settings) {
+		this->physicalDevice = physicalDevice;
+		this->device = device;
+		this->surface = surface;
+		this->graphicsFamily = graphicsFamily;
+		this->presentFamily = presentFamily;
+		this->settings = settings;
+
+		auto support = querySupport(physicalDevice, surface);
+		surfaceFormat = chooseSurfaceFormat(support.formats);
+		presentMode = choosePresentMode(settings.presentPolicy, support.presentModes);
+	}
+
+	// Creates the swap chain for the framebuffer size of the window, replacing the current one. Returns false if the
+	// surface has no area, e.g. while the window is minimized, the current swap chain is kept in that case.
+	// retireValue is the last frame that may still use the current swap chain.
+	bool recreate(vk::Extent2D framebufferSize, uint64_t retireValue) {
+		auto capabilities = physicalDevice.getSurfaceCapabilitiesKHR(surface);
+		vk::Extent2D newExtent = chooseExtent(capabilities, framebufferSize);
+		if (newExtent.width == 0 || newExtent.height == 0) {
+			return false;
+		}
+
+		vk::ImageUsageFlags imageUsage = vk::ImageUsageFlagBits::eColorAttachment | settings.imageUsage;
+		if ((capabilities.supportedUsageFlags & imageUsage) != imageUsage) {
+			throw std::runtime_error("swap chain images do not support the requested usage!");
+		}
+
+		uint32_t imageCount = settings.imageCount > 0 ? settings.imageCount : capabilities.minImageCount + 1;
+		imageCount = std::max(imageCount, capabilities.minImageCount);
+		if (capabilities.maxImageCount > 0) {
+			imageCount = std::min(imageCount, capabilities.maxImageCount);
+		}
+
+		auto createInfo = vk::SwapchainCreateInfoKHR(
+			vk::SwapchainCreateFlagsKHR(),
+			surface,
+			imageCount,
+			surfaceFormat.format,
+			surfaceFormat.colorSpace,
+			newExtent,
+			1,
+			imageUsage
+		);
+
+		uint32_t queueFamilyIndices[] = { graphicsFamily, presentFamily };
+		if (graphicsFamily != presentFamily) {
+			createInfo.imageSharingMode = vk::SharingMode::eConcurrent;
+			createInfo.queueFamilyIndexCount = 2;
+			createInfo.pQueueFamilyIndices = queueFamilyIndices;
+		}
+		else {
+			createInfo.imageSharingMode = vk::SharingMode::eExclusive;
+		}
+
+		createInfo.preTransform = capabilities.currentTransform;
+		createInfo.compositeAlpha = vk::CompositeAlphaFlagBitsKHR::eOpaque;
+		createInfo.presentMode = presentMode;
+		createInfo.clipped = VK_TRUE;
+		// Lets the driver reuse resources of the old swap chain, it is retired either way
+		createInfo.oldSwapchain = current.swapChain ? *current.swapChain : vk::SwapchainKHR();
+
+		Generation next;
+		try {
+			next.swapChain = device.createSwapchainKHRUnique(createInfo);
+		}
+		catch (vk::SystemError err) {
+			throw std::runtime_error("failed to create swap chain!");
+		}
+		next.images = device.getSwapchainImagesKHR(*next.swapChain);
+
+		if (current.swapChain) {
+			current.retireValue = retireValue;
+			retired.push_back(std::move(current));
+		}
+		current = std::move(next);
+		extent = newExtent;
+		acquireTimes.assign(current.images.size(), Clock::now());
+		outOfDate = false;
+
+		createImageViews();
+		// A depth buffer has to be resized to the new extent first, setRenderPass creates the framebuffers then
+		if (renderPass && !depthView) {
+			createFramebuffers();
+		}
+		++recreateCount;
+		return true;
+	}
+
+	// Framebuffers are created for every swap chain from now on, the render pass has to use getFormat. A depth view
+	// becomes the second attachment of every framebuffer and has to cover getExtent. As it cannot follow a resize on
+	// its own, recreate leaves the framebuffers to the next call of setRenderPass with the resized depth buffer.
+	void setRenderPass(vk::RenderPass renderPass, vk::ImageView depthView = {}) {
+		this->renderPass = renderPass;
+		this->depthView = depthView;
+		createFramebuffers();
+	}
+
+	// Destroys the retired swap chains whose frames have all completed
+	void releaseRetired(uint64_t completedValue) {
+		while (!retired.empty() && retired.front().retireValue <= completedValue) {
+			retired.pop_front();
+		}
+	}
+
+	// Returns false if the swap chain is out of date and has to be recreated before the next try, the semaphore is
+	// not signaled then. A suboptimal swap chain is still used for this frame but recreated afterwards.
+	bool acquire(vk::Semaphore imageAvailable, uint32_t& imageIndex) {
+		if (outOfDate) {
+			return false;
+		}
+
+		vk::ResultValue<uint32_t> result(vk::Result::eSuccess, 0);
+		try {
+			result = device.acquireNextImageKHR(*current.swapChain, std::numeric_limits<uint64_t>::max(), imageAvailable);
+		}
+		catch (vk::OutOfDateKHRError err) {
+			outOfDate = true;
+			return false;
+		}
+		catch (vk::SystemError err) {
+			throw std::runtime_error("failed to acquire swap chain image!");
+		}
+
+		if (result.result == vk::Result::eSuboptimalKHR) {
+			outOfDate = true;
+		}
+		imageIndex = result.value;
+		acquireTimes[imageIndex] = Clock::now();
+		return true;
+	}
+
+	void present(vk::Queue presentQueue, uint32_t imageIndex, vk::Semaphore renderFinished) {
+		vk::PresentInfoKHR presentInfo{};
+		presentInfo.waitSemaphoreCount = 1;
+		presentInfo.pWaitSemaphores = &renderFinished;
+		presentInfo.swapchainCount = 1;
+		presentInfo.pSwapchains = &*current.swapChain;
+		presentInfo.pImageIndices = &imageIndex;
+
+		try {
+			if (presentQueue.presentKHR(presentInfo) == vk::Result::eSuboptimalKHR) {
+				outOfDate = true;
+			}
+		}
+		catch (vk::OutOfDateKHRError err) {
+			outOfDate = true;
+		}
+		catch (vk::SystemError err) {
+			throw std::runtime_error("failed to present swap chain image!");
+		}
+
+		lastAcquireToPresentMs = std::chrono::duration<double, std::milli>(Clock::now() - acquireTimes[imageIndex]).count();
+	}
+
+	// Set by acquire and present when the surface no longer matches, e.g. after a resize
+	bool isOutOfDate() const {
+		return outOfDate;
+	}
+
+	// CPU time from the last acquire of the presented image until its present call returned
+	double getLastAcquireToPresentMs() const {
+		return lastAcquireToPresentMs;
+	}
+
+	vk::Format getFormat() const {
+		return surfaceFormat.format;
+	}
+
+	vk::Extent2D getExtent() const {
+		return extent;
+	}
+
+	vk::PresentModeKHR getPresentMode() const {
+		return presentMode;
+	}
+
+	uint32_t getImageCount() const {
+		return static_cast<uint32_t>(current.images.size());
+	}
+
+	vk::Image getImage(uint32_t imageIndex) const {
+		return current.images[imageIndex];
+	}
+
+	vk::ImageView getImageView(uint32_t imageIndex) const {
+		return *current.imageViews[imageIndex];
+	}
+
+	vk::Framebuffer getFramebuffer(uint32_t imageIndex) const {
+		return *current.framebuffers[imageIndex];
+	}
+
+	uint32_t getRecreateCount() const {
+		return recreateCount;
+	}
+
+private:
+	using Clock = std::chrono::steady_clock;
+
+	struct Generation {
+		vk::UniqueSwapchainKHR swapChain;
+		std::vector<vk::Image> images;
+		// Destroyed before the swap chain their images belong to
+		std::vector<vk::UniqueImageView> imageViews;
+		std::vector<vk::UniqueFramebuffer> framebuffers;
+		uint64_t retireValue = 0;
+	};
+
+	vk::PhysicalDevice physicalDevice;
+	vk::Device device;
+	vk::SurfaceKHR surface;
+	uint32_t graphicsFamily = 0, presentFamily = 0;
+	SwapChainSettings settings;
+	vk::RenderPass renderPass;
+	vk::ImageView depthView;
+
+	vk::SurfaceFormatKHR surfaceFormat;
+	vk::PresentModeKHR presentMode = vk::PresentModeKHR::eFifo;
+	vk::Extent2D extent;
+
+	Generation current;
+	std::deque<Generation> retired;
+	bool outOfDate = false;
+	uint32_t recreateCount = 0;
+
+	// Per image, the same image is not acquired again before it was presented
+	std::vector<Clock::time_point> acquireTimes;
+	double lastAcquireToPresentMs = 0.0;
+
+	static vk::SurfaceFormatKHR chooseSurfaceFormat(const std::vector<vk::SurfaceFormatKHR>& availableFormats) {
+		for (const auto& availableFormat : availableFormats) {
+			if (availableFormat.format == vk::Format::eB8G8R8A8Srgb && availableFormat.colorSpace == vk::ColorSpaceKHR::eSrgbNonlinear) {
+				return availableFormat;
+			}
+		}
+		return availableFormats[0];
+	}
+
+	static vk::Extent2D chooseExtent(const vk::SurfaceCapabilitiesKHR& capabilities, vk::Extent2D framebufferSize) {
+		if (capabilities.currentExtent.width != std::numeric_limits<uint32_t>::max()) {
+			return capabilities.currentExtent;
+		}
+		return {
+			std::clamp(framebufferSize.width, capabilities.minImageExtent.width, capabilities.maxImageExtent.width),
+			std::clamp(framebufferSize.height, capabilities.minImageExtent.height, capabilities.maxImageExtent.height)
+		};
+	}
+
+	void createImageViews() {
+		for (auto image : current.images) {
+			auto createInfo = vk::ImageViewCreateInfo(
+				vk::ImageViewCreateFlags(),
+				image,
+				vk::ImageViewType::e2D,
+				surfaceFormat.format,
+				{ vk::ComponentSwizzle::eIdentity, vk::ComponentSwizzle::eIdentity, vk::ComponentSwizzle::eIdentity, vk::ComponentSwizzle::eIdentity },
+				{ vk::ImageAspectFlagBits::eColor, 0, 1, 0, 1 }
+			);
+			try {
+				current.imageViews.push_back(device.createImageViewUnique(createInfo));
+			}
+			catch (vk::SystemError err) {
+				throw std::runtime_error("failed to create image views!");
+			}
+		}
+	}
+
+	void createFramebuffers() {
+		current.framebuffers.clear();
+		for (const auto& imageView : current.imageViews) {
+			vk::ImageView attachments[] = { *imageView, depthView };
+
+			vk::FramebufferCreateInfo framebufferInfo{};
+			framebufferInfo.renderPass = renderPass;
+			framebufferInfo.attachmentCount = depthView ? 2 : 1;
+			framebufferInfo.pAttachments = attachments;
+			framebufferInfo.width = extent.width;
+			framebufferInfo.height = extent.height;
+			framebufferInfo.layers = 1;
+
+			try {
+				current.framebuffers.push_back(device.createFramebufferUnique(framebufferInfo));
+			}
+			catch (vk::SystemError err) {
+				throw std::runtime_error("failed to create frame buffer!");
+			}
+		}
+	}
+};
\ No newline at end of file
@@ -0,0 +1,312 @@
+#pragma once
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+// Two level segregated fit allocator over an abstract range [0, size). It only hands out offsets, GpuAllocator
+// places device memory behind them. Allocation and free are O(1): free ranges are kept in lists per size class, the
+// first level splits sizes by power of two, the second level splits every power of two into SL_COUNT linear steps.
+class TlsfAllocator {
+
+public:
+	static constexpr uint32_t INVALID_NODE = ~0u;
+
+	struct Allocation {
+		uint64_t offset = 0;
+		uint32_t node = INVALID_NODE;
+	};
+
+	struct Statistics {
+		uint64_t size = 0;
+		uint64_t usedSize = 0;
+		uint64_t freeSize = 0;
+		uint64_t largestFreeRange = 0;
+		uint32_t allocationCount = 0;
+		uint32_t freeRangeCount = 0;
+
+		// 0 if all free space is one range, approaches 1 as it is split into many small ranges
+		double getFragmentation() const {
+			return freeSize == 0 ? 0.0 : 1.0 - double(largestFreeRange) / double(freeSize);
+		}
+	};
+
+	explicit TlsfAllocator(uint64_t size = 0) {
+		reset(size);
+	}
+
+	void reset(uint64_t size) {
+		nodes.clear();
+		unusedNodes.clear();
+		firstLevelBitmap = 0;
+		std::fill(std::begin(secondLevelBitmaps), std::end(secondLevelBitmaps), 0u);
+		for (auto& level : freeHeads) {
+			std::fill(std::begin(level), std::end(level), INVALID_NODE);
+		}
+
+		totalSize = size;
+		usedSize = 0;
+		allocationCount = 0;
+
+		if (size > 0) {
+			// Node 0 always starts at offset 0, merging only ever removes the later of two neighbours
+			uint32_t node = createNode(0, size);
+			insertFree(node);
+		}
+	}
+
+	// Returns false if there is no free range that can hold the size at the alignment, which has to be a power of two
+	bool allocate(uint64_t size, uint64_t alignment, Allocation& allocation) {
+		size = std::max<uint64_t>(size, 1);
+		alignment = std::max<uint64_t>(alignment, 1);
+		if (size > totalSize || alignment > totalSize) {
+			return false;
+		}
+
+		uint32_t firstLevel, secondLevel;
+		mappingSearch(size + alignment - 1, firstLevel, secondLevel);
+		uint32_t node = findFree(firstLevel, secondLevel);
+		if (node == INVALID_NODE) {
+			return false;
+		}
+		removeFree(node);
+
+		uint64_t alignedOffset = (nodes[node].offset + alignment - 1) & ~(alignment - 1);
+		uint64_t padding = alignedOffset - nodes[node].offset;
+		if (padding > 0) {
+			// The physical neighbour before a free range is always in use, it absorbs the padding
+			// instead of leaving a tiny free range behind
+			uint32_t previous = nodes[node].previousPhysical;
+			nodes[previous].size += padding;
+			usedSize += padding;
+			nodes[node].offset += padding;
+			nodes[node].size -= padding;
+		}
+
+		uint64_t remaining = nodes[node].size - size;
+		if (remaining > 0) {
+			uint32_t rest = createNode(nodes[node].offset + size, remaining);
+			nodes[node].size = size;
+			linkPhysicalAfter(node, rest);
+			insertFree(rest);
+		}
+
+		nodes[node].free = false;
+		usedSize += nodes[node].size;
+		++allocationCount;
+
+		allocation.offset = nodes[node].offset;
+		allocation.node = node;
+		return true;
+	}
+
+	void free(uint32_t node) {
+		usedSize -= nodes[node].size;
+		--allocationCount;
+		nodes[node].free = true;
+
+		uint32_t next = nodes[node].nextPhysical;
+		if (next != INVALID_NODE && nodes[next].free) {
+			removeFree(next);
+			nodes[node].size += nodes[next].size;
+			unlinkPhysical(next);
+			releaseNode(next);
+		}
+
+		uint32_t previous = nodes[node].previousPhysical;
+		if (previous != INVALID_NODE && nodes[previous].free) {
+			removeFree(previous);
+			nodes[previous].size += nodes[node].size;
+			unlinkPhysical(node);
+			releaseNode(node);
+			node = previous;
+		}
+
+		insertFree(node);
+	}
+
+	bool isEmpty() const {
+		return allocationCount == 0;
+	}
+
+	uint64_t getSize() const {
+		return totalSize;
+	}
+
+	Statistics getStatistics() const {
+		Statistics statistics;
+		statistics.size = totalSize;
+		statistics.usedSize = usedSize;
+		statistics.freeSize = totalSize - usedSize;
+		statistics.allocationCount = allocationCount;
+
+		for (uint32_t node = nodes.empty() ? INVALID_NODE : 0; node != INVALID_NODE; node = nodes[node].nextPhysical) {
+			if (nodes[node].free) {
+				++statistics.freeRangeCount;
+				statistics.largestFreeRange = std::max(statistics.largestFreeRange, nodes[node].size);
+			}
+		}
+		return statistics;
+	}
+
+private:
+	static constexpr uint32_t SECOND_LEVEL_BITS = 5;
+	static constexpr uint32_t SL_COUNT = 1u << SECOND_LEVEL_BITS;
+	// Sizes below SL_COUNT all share first level 0, every larger power of two gets its own level
+	static constexpr uint32_t FL_COUNT = 64 - SECOND_LEVEL_BITS + 1;
+
+	struct Node {
+		uint64_t offset;
+		uint64_t size;
+		uint32_t previousPhysical, nextPhysical;
+		uint32_t previousFree, nextFree;
+		bool free;
+	};
+
+	std::vector<Node> nodes;
+	std::vector<uint32_t> unusedNodes;
+
+	uint64_t firstLevelBitmap = 0;
+	uint32_t secondLevelBitmaps[FL_COUNT] = {};
+	uint32_t freeHeads[FL_COUNT][SL_COUNT];
+
+	uint64_t totalSize = 0;
+	uint64_t usedSize = 0;
+	uint32_t allocationCount = 0;
+
+	static uint32_t lowestBit(uint64_t value) {
+#ifdef _MSC_VER
+		unsigned long index;
+		_BitScanForward64(&index, value);
+		return index;
+#else
+		return static_cast<uint32_t>(__builtin_ctzll(value));
+#endif
+	}
+
+	static uint32_t highestBit(uint64_t value) {
+#ifdef _MSC_VER
+		unsigned long index;
+		_BitScanReverse64(&index, value);
+		return index;
+#else
+		return 63 - static_cast<uint32_t>(__builtin_clzll(value));
+#endif
+	}
+
+	static void mapping(uint64_t size, uint32_t& firstLevel, uint32_t& secondLevel) {
+		if (size < SL_COUNT) {
+			firstLevel = 0;
+			secondLevel = static_cast<uint32_t>(size);
+			return;
+		}
+		uint32_t bit = highestBit(size);
+		firstLevel = bit - SECOND_LEVEL_BITS + 1;
+		secondLevel = static_cast<uint32_t>(size >> (bit - SECOND_LEVEL_BITS)) - SL_COUNT;
+	}
+
+	// Rounds up to the next size class, so every range in the class found is large enough
+	static void mappingSearch(uint64_t size, uint32_t& firstLevel, uint32_t& secondLevel) {
+		if (size >= SL_COUNT) {
+			size += (uint64_t(1) << (highestBit(size) - SECOND_LEVEL_BITS)) - 1;
+		}
+		mapping(size, firstLevel, secondLevel);
+	}
+
+	uint32_t findFree(uint32_t firstLevel, uint32_t secondLevel) const {
+		if (firstLevel >= FL_COUNT) {
+			return INVALID_NODE;
+		}
+
+		uint32_t secondLevelMap = secondLevelBitmaps[firstLevel] & (~0u << secondLevel);
+		if (secondLevelMap == 0) {
+			uint64_t firstLevelMap = firstLevel + 1 < 64 ? firstLevelBitmap & (~uint64_t(0) << (firstLevel + 1)) : 0;
+			if (firstLevelMap == 0) {
+				return INVALID_NODE;
+			}
+			firstLevel = lowestBit(firstLevelMap);
+			secondLevelMap = secondLevelBitmaps[firstLevel];
+		}
+		return freeHeads[firstLevel][lowestBit(secondLevelMap)];
+	}
+
+	void insertFree(uint32_t node) {
+		uint32_t firstLevel, secondLevel;
+		mapping(nodes[node].size, firstLevel, secondLevel);
+
+		uint32_t head = freeHeads[firstLevel][secondLevel];
+		nodes[node].free = true;
+		nodes[node].previousFree = INVALID_NODE;
+		nodes[node].nextFree = head;
+		if (head != INVALID_NODE) {
+			nodes[head].previousFree = node;
+		}
+		freeHeads[firstLevel][secondLevel] = node;
+
+		firstLevelBitmap |= uint64_t(1) << firstLevel;
+		secondLevelBitmaps[firstLevel] |= 1u << secondLevel;
+	}
+
+	void removeFree(uint32_t node) {
+		uint32_t firstLevel, secondLevel;
+		mapping(nodes[node].size, firstLevel, secondLevel);
+
+		uint32_t previous = nodes[node].previousFree, next = nodes[node].nextFree;
+		if (previous != INVALID_NODE) {
+			nodes[previous].nextFree = next;
+		}
+		else {
+			freeHeads[firstLevel][secondLevel] = next;
+		}
+		if (next != INVALID_NODE) {
+			nodes[next].previousFree = previous;
+		}
+
+		if (freeHeads[firstLevel][secondLevel] == INVALID_NODE) {
+			secondLevelBitmaps[firstLevel] &= ~(1u << secondLevel);
+			if (secondLevelBitmaps[firstLevel] == 0) {
+				firstLevelBitmap &= ~(uint64_t(1) << firstLevel);
+			}
+		}
+	}
+
+	uint32_t createNode(uint64_t offset, uint64_t size) {
+		uint32_t node;
+		if (!unusedNodes.empty()) {
+			node = unusedNodes.back();
+			unusedNodes.pop_back();
+		}
+		else {
+			node = static_cast<uint32_t>(nodes.size());
+			nodes.emplace_back();
+		}
+		nodes[node] = { offset, size, INVALID_NODE, INVALID_NODE, INVALID_NODE, INVALID_NODE, false };
+		return node;
+	}
+
+	void releaseNode(uint32_t node) {
+		unusedNodes.push_back(node);
+	}
+
+	void linkPhysicalAfter(uint32_t node, uint32_t next) {
+		nodes[next].previousPhysical = node;
+		nodes[next].nextPhysical = nodes[node].nextPhysical;
+		if (nodes[node].nextPhysical != INVALID_NODE) {
+			nodes[nodes[node].nextPhysical].previousPhysical = next;
+		}
+		nodes[node].nextPhysical = next;
+	}
+
+	void unlinkPhysical(uint32_t node) {
+		uint32_t previous = nodes[node].previousPhysical, next = nodes[node].nextPhysical;
+		if (previous != INVALID_NODE) {
+			nodes[previous].nextPhysical = next;
+		}
+		if (next != INVALID_NODE) {
+			nodes[next].previousPhysical = previous;
+		}
+	}
+};
\ No newline at end of file
@@ -0,0 +1,174 @@
+#pragma once
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// The persistent threads of the application, shared by everything that does CPU work off the main thread. run splits
+// per frame work into contiguous chunks, submit queues background tasks like pipeline compiles and file reads, which
+// the workers pick up whenever no run call needs them. The calling thread of run claims chunks as well, so a worker
+// busy with a task never holds up a frame, its chunks are simply run by someone else. A pool of one thread starts no
+// workers and runs everything inline.
+class WorkerPool {
+
+public:
+	using ChunkFunction = std::function<void(uint32_t chunk, uint32_t begin, uint32_t end)>;
+	using Task = std::function<void()>;
+
+	WorkerPool() = default;
+
+	~WorkerPool() {
+		shutdown();
+	}
+
+	WorkerPool(const WorkerPool&) = delete;
+	WorkerPool& operator=(const WorkerPool&) = delete;
+
+	void init(uint32_t threadCount) {
+		shutdown();
+
+		threadCount = std::max(threadCount, 1u);
+		errors.assign(threadCount, nullptr);
+
+		running = true;
+		for (uint32_t i = 1; i < threadCount; ++i) {
+			workers.emplace_back(&WorkerPool::workerLoop, this);
+		}
+	}
+
+	// Tasks still queued are dropped, the users of the pool have to wait for their own tasks before it shuts down
+	void shutdown() {
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			running = false;
+			tasks.clear();
+		}
+		workAvailable.notify_all();
+		for (auto& worker : workers) {
+			worker.join();
+		}
+		workers.clear();
+		errors.clear();
+	}
+
+	// Splits [0, count) into at most one contiguous chunk per thread, but never into chunks smaller than
+	// minChunkSize, and returns once all of them are done. The chunk index is below getThreadCount, so it can pick per
+	// chunk resources. Returns the number of chunks, exceptions of the chunks are rethrown on the calling thread. Only
+	// one thread may call run at a time, and never from inside a task.
+	uint32_t run(uint32_t count, uint32_t minChunkSize, const ChunkFunction& function) {
+		uint32_t threadCount = getThreadCount();
+		minChunkSize = std::max(minChunkSize, 1u);
+		uint32_t chunkCount = std::clamp((count + minChunkSize - 1) / minChunkSize, 1u, threadCount);
+
+		std::unique_lock<std::mutex> lock(mutex);
+		currentFunction = &function;
+		currentCount = count;
+		currentChunkCount = chunkCount;
+		nextChunk = 0;
+		finishedChunks = 0;
+		if (chunkCount > 1) {
+			workAvailable.notify_all();
+		}
+
+		while (nextChunk < currentChunkCount) {
+			uint32_t chunk = nextChunk++;
+			lock.unlock();
+			runChunk(chunk);
+			lock.lock();
+			++finishedChunks;
+		}
+		workFinished.wait(lock, [this] { return finishedChunks == currentChunkCount; });
+		lock.unlock();
+
+		for (auto& error : errors) {
+			if (error) {
+				std::exception_ptr rethrown = error;
+				error = nullptr;
+				std::rethrow_exception(rethrown);
+			}
+		}
+		return chunkCount;
+	}
+
+	// Queues a task for the workers, tasks start in submission order. Without workers the task runs right away on the
+	// calling thread, so it must not be submitted while holding a lock the task takes. Tasks must not throw.
+	void submit(Task task) {
+		if (workers.empty()) {
+			task();
+			return;
+		}
+
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			tasks.push_back(std::move(task));
+		}
+		workAvailable.notify_one();
+	}
+
+	uint32_t getThreadCount() const {
+		return static_cast<uint32_t>(workers.size()) + 1;
+	}
+
+private:
+	std::vector<std::thread> workers;
+	std::vector<std::exception_ptr> errors;
+
+	std::mutex mutex;
+	std::condition_variable workAvailable, workFinished;
+	bool running = false;
+	std::deque<Task> tasks;
+
+	// Work of the current run call, published to the workers through the mutex
+	const ChunkFunction* currentFunction = nullptr;
+	uint32_t currentCount = 0;
+	uint32_t currentChunkCount = 0;
+	uint32_t nextChunk = 0;
+	uint32_t finishedChunks = 0;
+
+	void runChunk(uint32_t chunk) {
+		try {
+			uint32_t begin = static_cast<uint32_t>(uint64_t(currentCount) * chunk / currentChunkCount);
+			uint32_t end = static_cast<uint32_t>(uint64_t(currentCount) * (chunk + 1) / currentChunkCount);
+			(*currentFunction)(chunk, begin, end);
+		}
+		catch (...) {
+			errors[chunk] = std::current_exception();
+		}
+	}
+
+	void workerLoop() {
+		std::unique_lock<std::mutex> lock(mutex);
+
+		while (true) {
+			workAvailable.wait(lock, [this] { return !running || nextChunk < currentChunkCount || !tasks.empty(); });
+			if (!running) {
+				return;
+			}
+
+			// Chunks first, the frame is waiting for them
+			if (nextChunk < currentChunkCount) {
+				uint32_t chunk = nextChunk++;
+				lock.unlock();
+				runChunk(chunk);
+				lock.lock();
+
+				if (++finishedChunks == currentChunkCount) {
+					workFinished.notify_one();
+				}
+				continue;
+			}
+
+			Task task = std::move(tasks.front());
+			tasks.pop_front();
+			lock.unlock();
+			task();
+			// Its captures are released outside of the lock, in case they take locks of their own
+			task = nullptr;
+			lock.lock();
+		}
+	}
+};
\ No newline at end of file
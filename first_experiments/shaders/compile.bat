@@ -1,3 +1,13 @@
 C:\VulkanSDK\1.2.170.0\Bin32\glslangValidator.exe -V shader.vert
 C:\VulkanSDK\1.2.170.0\Bin32\glslangValidator.exe -V shader.frag
+C:\VulkanSDK\1.2.170.0\Bin32\glslangValidator.exe -V shader_bindless.frag -o frag_bindless.spv
+C:\VulkanSDK\1.2.170.0\Bin32\glslangValidator.exe -V shader_descriptor.frag -o frag_descriptor.spv
+C:\VulkanSDK\1.2.170.0\Bin32\glslangValidator.exe -V quad.vert -o quad_vert.spv
+C:\VulkanSDK\1.2.170.0\Bin32\glslangValidator.exe -V quad.frag -o quad_frag.spv
+C:\VulkanSDK\1.2.170.0\Bin32\glslangValidator.exe -V object.vert -o object_vert.spv
+C:\VulkanSDK\1.2.170.0\Bin32\glslangValidator.exe -V cull.comp -o cull_comp.spv
+C:\VulkanSDK\1.2.170.0\Bin32\glslangValidator.exe -V cull_occlusion.comp -o cull_occlusion_comp.spv
+C:\VulkanSDK\1.2.170.0\Bin32\glslangValidator.exe -V depth_pyramid.comp -o depth_pyramid_comp.spv
+C:\VulkanSDK\1.2.170.0\Bin32\glslangValidator.exe -V background.comp -o background_comp.spv
+..\..\bin\Release-windows-x86_64\AssetPacker\AssetPacker.exe shaders.wpak vert.spv frag.spv frag_bindless.spv frag_descriptor.spv quad_vert.spv quad_frag.spv object_vert.spv cull_comp.spv cull_occlusion_comp.spv depth_pyramid_comp.spv background_comp.spv
 pause
\ No newline at end of file
@@ -0,0 +1,15 @@
+#!/bin/sh
+set -e
+cd "$(dirname "$0")"
+glslangValidator -V shader.vert
+glslangValidator -V shader.frag
+glslangValidator -V shader_bindless.frag -o frag_bindless.spv
+glslangValidator -V shader_descriptor.frag -o frag_descriptor.spv
+glslangValidator -V quad.vert -o quad_vert.spv
+glslangValidator -V quad.frag -o quad_frag.spv
+glslangValidator -V object.vert -o object_vert.spv
+glslangValidator -V cull.comp -o cull_comp.spv
+glslangValidator -V cull_occlusion.comp -o cull_occlusion_comp.spv
+glslangValidator -V depth_pyramid.comp -o depth_pyramid_comp.spv
+glslangValidator -V background.comp -o background_comp.spv
+../../bin/Release-linux-x86_64/AssetPacker/AssetPacker shaders.wpak vert.spv frag.spv frag_bindless.spv frag_descriptor.spv quad_vert.spv quad_frag.spv object_vert.spv cull_comp.spv cull_occlusion_comp.spv depth_pyramid_comp.spv background_comp.spv
@@ -0,0 +1,39 @@
+#version 450
+#extension GL_ARB_separate_shader_objects : enable
+#extension GL_KHR_vulkan_glsl : enable
+
+// A square facing the camera at an object of GpuCuller.h, firstInstance of the draw is the object index. There is no
+// vertex input, the six indices of the index buffer are 0 to 5 and pick the corners of the square's two triangles.
+struct Object {
+    vec4 center;
+    vec4 extent;
+};
+
+layout(std430, set = 0, binding = 0) readonly buffer Objects {
+    Object objects[];
+};
+
+layout(push_constant) uniform Camera {
+    mat4 viewProjection;
+    vec4 right;
+    vec4 up;
+} camera;
+
+layout(location = 0) out vec3 fragColor;
+
+const vec2 corners[6] = vec2[](
+    vec2(-1.0, -1.0), vec2(1.0, -1.0), vec2(1.0, 1.0),
+    vec2(1.0, 1.0), vec2(-1.0, 1.0), vec2(-1.0, -1.0)
+);
+
+void main() {
+    Object object = objects[gl_InstanceIndex];
+    vec2 corner = corners[gl_VertexIndex % 6];
+    // Scaled so the corners stay inside the bounds whichever way the square faces
+    float size = object.extent.x * 0.70710678;
+    vec3 position = object.center.xyz + (camera.right.xyz * corner.x + camera.up.xyz * corner.y) * size;
+    gl_Position = camera.viewProjection * vec4(position, 1.0);
+
+    uint hash = uint(gl_InstanceIndex) * 2654435761u;
+    fragColor = vec3(hash & 0xFFu, (hash >> 8) & 0xFFu, (hash >> 16) & 0xFFu) / 255.0 * (0.5 + 0.25 * (corner.y + 1.0));
+}
\ No newline at end of file
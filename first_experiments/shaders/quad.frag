@@ -0,0 +1,12 @@
+#version 450
+#extension GL_ARB_separate_shader_objects : enable
+
+layout(location = 0) in vec4 fragColor;
+layout(location = 1) flat in uint fragTextureIndex;
+
+layout(location = 0) out vec4 outColor;
+
+void main() {
+    // There are no textures to sample yet, the quads are batched by fragTextureIndex regardless
+    outColor = fragColor;
+}
\ No newline at end of file
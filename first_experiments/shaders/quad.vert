@@ -0,0 +1,26 @@
+#version 450
+#extension GL_ARB_separate_shader_objects : enable
+#extension GL_KHR_vulkan_glsl : enable
+
+layout(location = 0) in vec2 inPosition;
+layout(location = 1) in vec2 inSize;
+layout(location = 2) in vec4 inColor;
+layout(location = 3) in uint inTextureIndex;
+
+layout(location = 0) out vec4 fragColor;
+layout(location = 1) flat out uint fragTextureIndex;
+
+vec2 corners[6] = vec2[](
+    vec2(-0.5, -0.5),
+    vec2(0.5, -0.5),
+    vec2(0.5, 0.5),
+    vec2(0.5, 0.5),
+    vec2(-0.5, 0.5),
+    vec2(-0.5, -0.5)
+);
+
+void main() {
+    gl_Position = vec4(inPosition + corners[gl_VertexIndex] * inSize, 0.0, 1.0);
+    fragColor = inColor;
+    fragTextureIndex = inTextureIndex;
+}
\ No newline at end of file
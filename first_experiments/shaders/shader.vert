@@ -2,27 +2,12 @@
 #extension GL_ARB_separate_shader_objects : enable
 #extension GL_KHR_vulkan_glsl : enable
 
-layout(location = 0) out vec3 fragColor;
-
-vec2 positions[6] = vec2[](
-    vec2(-1.0, -1.0),
-    vec2(0, -1.0),
-    vec2(0.0, 0.0),
-    vec2(1.0, 1.0),
-    vec2(0.0, 0.0),
-    vec2(0, 1.0)
-);
+layout(location = 0) in vec2 inPosition;
+layout(location = 1) in vec3 inColor;
 
-vec3 colors[6] = vec3[](
-    vec3(0.0, 0.0, 1.0),
-    vec3(0.0, 1.0, 0.0),
-    vec3(1.0, 0.0, 0.0),
-    vec3(0.0, 0.0, 1.0),
-    vec3(0.0, 1.0, 0.0),
-    vec3(1.0, 0.0, 0.0)
-);
+layout(location = 0) out vec3 fragColor;
 
 void main() {
-    gl_Position = vec4(positions[gl_VertexIndex], 0.0, 1.0);
-    fragColor = colors[gl_VertexIndex];
+    gl_Position = vec4(inPosition, 0.0, 1.0);
+    fragColor = inColor;
 }
\ No newline at end of file
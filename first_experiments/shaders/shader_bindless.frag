@@ -0,0 +1,22 @@
+#version 450
+#extension GL_ARB_separate_shader_objects : enable
+#extension GL_EXT_nonuniform_qualifier : enable
+
+// The bindless table of BindlessTable.h, indexed with the push constants of the draw
+layout(set = 0, binding = 0) uniform sampler2D textures[];
+layout(set = 0, binding = 1) readonly buffer Material {
+    vec4 tint;
+} materials[];
+
+layout(push_constant) uniform DrawIndices {
+    uint textureIndex;
+    uint materialIndex;
+} draw;
+
+layout(location = 0) in vec3 fragColor;
+
+layout(location = 0) out vec4 outColor;
+
+void main() {
+    outColor = vec4(fragColor, 1.0) * texture(textures[draw.textureIndex], vec2(0.5)) * materials[draw.materialIndex].tint;
+}
\ No newline at end of file
@@ -0,0 +1,16 @@
+#version 450
+#extension GL_ARB_separate_shader_objects : enable
+
+// Fallback without descriptor indexing, one descriptor set per draw
+layout(set = 0, binding = 0) uniform sampler2D drawTexture;
+layout(set = 0, binding = 1) readonly buffer Material {
+    vec4 tint;
+} material;
+
+layout(location = 0) in vec3 fragColor;
+
+layout(location = 0) out vec4 outColor;
+
+void main() {
+    outColor = vec4(fragColor, 1.0) * texture(drawTexture, vec2(0.5)) * material.tint;
+}
\ No newline at end of file
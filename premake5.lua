@@ -8,6 +8,8 @@ outputdir = "%{cfg.buildcfg}-%{cfg.system}-%{cfg.architecture}"
 
 include "vendor/opengl_premake/libs/glfw.lua"
 
+VULKAN_SDK = os.getenv("VULKAN_SDK")
+
 project "Warp"
     kind "ConsoleApp"
     language "C++"
@@ -42,12 +44,267 @@ project "Warp"
 			"WARP_PLATFORM_WINDOWS"
 		}
 
+		links {
+			"winmm"
+		}
+
+    filter "system:linux"
+		defines {
+			"WARP_PLATFORM_LINUX"
+		}
+
+		links {
+			"pthread",
+			"dl"
+		}
+
+    filter "configurations:Debug"
+        defines { "DEBUG", "WP_LOG_ENABLE", "WP_ASSERT_ENABLE", "WP_PROFILE_ENABLE" }
+        symbols "On"
+    
+    filter "configurations:Release"
+        defines { "NDEBUG", "WP_LOG_ENABLE", "WP_ASSERT_ENABLE", "WP_PROFILE_ENABLE" }
+        symbols "On"
+        optimize "On"
+
+    filter "configurations:Dist"
+        defines { "NDEBUG" }
+        optimize "On"
+
+project "Benchmarks"
+    kind "ConsoleApp"
+    language "C++"
+    cppdialect "C++17"
+    staticruntime "on"
+
+    targetdir ("bin/" .. outputdir .. "/%{prj.name}")
+    objdir ("bin-int/" .. outputdir .. "/%{prj.name}")
+
+    pchheader "wppch.h"
+    pchsource "src/wppch.cpp"
+
+    files {
+        "src/**.h",
+        "src/**.cpp",
+        "bench/**.h",
+        "bench/**.cpp"
+    }
+
+    removefiles {
+        "src/EntryPoint.cpp"
+    }
+
+    includedirs {
+        "src",
+        "bench",
+        "vendor/spdlog/include",
+        "vendor/opengl_premake/libs/glfw/include"
+    }
+
+    links {
+        "GLFW"
+    }
+
+    filter "system:windows"
+		systemversion "latest"
+
+		defines {
+			"WARP_PLATFORM_WINDOWS"
+		}
+
+		links {
+			"winmm"
+		}
+
+    filter "system:linux"
+		defines {
+			"WARP_PLATFORM_LINUX"
+		}
+
+		links {
+			"pthread",
+			"dl"
+		}
+
+    filter "configurations:Debug"
+        defines { "DEBUG", "WP_LOG_ENABLE", "WP_ASSERT_ENABLE", "WP_PROFILE_ENABLE" }
+        symbols "On"
+    
+    filter "configurations:Release"
+        defines { "NDEBUG", "WP_LOG_ENABLE", "WP_ASSERT_ENABLE", "WP_PROFILE_ENABLE" }
+        symbols "On"
+        optimize "On"
+
+    filter "configurations:Dist"
+        defines { "NDEBUG" }
+        optimize "On"
+
+project "RenderBenchmark"
+    kind "ConsoleApp"
+    language "C++"
+    cppdialect "C++17"
+    staticruntime "on"
+
+    targetdir ("bin/" .. outputdir .. "/%{prj.name}")
+    objdir ("bin-int/" .. outputdir .. "/%{prj.name}")
+
+    -- Shaders are loaded relative to the working directory
+    debugdir "first_experiments"
+
+    -- HelloTriangleApplication.cpp is included by the entry point, not compiled on its own
+    files {
+        "first_experiments/RenderBenchmark.cpp"
+    }
+
+    -- src for the header only math library, Math/Frustum.h is shared with the engine
+    includedirs {
+        "first_experiments",
+        "src",
+        "vendor/opengl_premake/libs/glfw/include"
+    }
+
+    links {
+        "GLFW"
+    }
+
+    filter "system:windows"
+		systemversion "latest"
+
+		includedirs {
+			"%{VULKAN_SDK}/Include"
+		}
+
+		libdirs {
+			"%{VULKAN_SDK}/Lib"
+		}
+
+		links {
+			"vulkan-1"
+		}
+
+    filter "system:linux"
+		links {
+			"vulkan",
+			"pthread",
+			"dl"
+		}
+
     filter "configurations:Debug"
-        defines { "DEBUG", "WP_LOG_ENABLE", "WP_ASSERT_ENABLE" }
+        defines { "DEBUG" }
         symbols "On"
     
     filter "configurations:Release"
-        defines { "NDEBUG", "WP_LOG_ENABLE", "WP_ASSERT_ENABLE" }
+        defines { "NDEBUG" }
+        symbols "On"
+        optimize "On"
+
+    filter "configurations:Dist"
+        defines { "NDEBUG" }
+        optimize "On"
+
+project "AssetPacker"
+    kind "ConsoleApp"
+    language "C++"
+    cppdialect "C++17"
+    staticruntime "on"
+
+    targetdir ("bin/" .. outputdir .. "/%{prj.name}")
+    objdir ("bin-int/" .. outputdir .. "/%{prj.name}")
+
+    files {
+        "first_experiments/AssetArchive.h",
+        "first_experiments/AssetPacker.cpp"
+    }
+
+    includedirs {
+        "first_experiments"
+    }
+
+    filter "system:windows"
+		systemversion "latest"
+
+    filter "configurations:Debug"
+        defines { "DEBUG" }
+        symbols "On"
+    
+    filter "configurations:Release"
+        defines { "NDEBUG" }
+        symbols "On"
+        optimize "On"
+
+    filter "configurations:Dist"
+        defines { "NDEBUG" }
+        optimize "On"
+
+project "ArchiveBenchmark"
+    kind "ConsoleApp"
+    language "C++"
+    cppdialect "C++17"
+    staticruntime "on"
+
+    targetdir ("bin/" .. outputdir .. "/%{prj.name}")
+    objdir ("bin-int/" .. outputdir .. "/%{prj.name}")
+
+    debugdir "first_experiments/shaders"
+    debugargs { "shaders.wpak", "vert.spv", "frag.spv" }
+
+    files {
+        "first_experiments/AssetArchive.h",
+        "first_experiments/ArchiveBenchmark.cpp"
+    }
+
+    includedirs {
+        "first_experiments"
+    }
+
+    filter "system:windows"
+		systemversion "latest"
+
+    filter "configurations:Debug"
+        defines { "DEBUG" }
+        symbols "On"
+    
+    filter "configurations:Release"
+        defines { "NDEBUG" }
+        symbols "On"
+        optimize "On"
+
+    filter "configurations:Dist"
+        defines { "NDEBUG" }
+        optimize "On"
+
+project "StreamingBenchmark"
+    kind "ConsoleApp"
+    language "C++"
+    cppdialect "C++17"
+    staticruntime "on"
+
+    targetdir ("bin/" .. outputdir .. "/%{prj.name}")
+    objdir ("bin-int/" .. outputdir .. "/%{prj.name}")
+
+    files {
+        "first_experiments/AssetStreamer.h",
+        "first_experiments/StreamingBenchmark.cpp"
+    }
+
+    includedirs {
+        "first_experiments"
+    }
+
+    filter "system:windows"
+		systemversion "latest"
+
+    filter "system:linux"
+		links {
+			"pthread"
+		}
+
+    filter "configurations:Debug"
+        defines { "DEBUG" }
+        symbols "On"
+    
+    filter "configurations:Release"
+        defines { "NDEBUG" }
         symbols "On"
         optimize "On"
 
@@ -2,15 +2,135 @@
 #include "Application.h"
 #include "Window.h"
 
+#include <algorithm>
+#include <array>
+
 namespace Warp {
 
-	void Application::init() {
-		m_window = CreateCountedRef<Window>();
+	constexpr size_t FRAME_ALLOCATOR_SIZE = 8 * 1024 * 1024;
+	// Events handed to the layers at once, copied out of the queue onto the stack
+	constexpr size_t EVENT_BATCH_SIZE = 64;
+
+	Application::~Application() {
+		for (auto layer = m_layers.rbegin(); layer != m_layers.rend(); ++layer) {
+			(*layer)->onDetach();
+		}
+	}
+
+	void Application::init(const ApplicationSettings& settings) {
+		WP_PROFILE_FUNCTION();
+
+		m_settings = settings;
+		WP_ASSERTM(!settings.headless || settings.frameCount > 0, "A headless application needs a frame count to stop");
+
+		m_jobSystem = CreateScopedRef<JobSystem>();
+		m_window = CreateIntrusiveRef<Window>(settings.headless);
+		m_frameAllocator = CreateScopedRef<FrameAllocator>(FRAME_ALLOCATOR_SIZE);
+		m_world = CreateScopedRef<World>();
+	}
+
+	void Application::pushLayer(ScopedRef<Layer> layer) {
+		layer->onAttach();
+		m_layers.push_back(std::move(layer));
 	}
 
 	void Application::run() {
-		while (!m_window->shouldClose()) {
-			m_window->update();
+		m_framePacer.resetStats();
+		m_inputEvents = 0;
+		m_inputLatencySumNs = 0.0;
+		m_inputLatencyMaxNs = 0.0;
+		m_droppedEventsAtStart = m_window->getEventQueue().getDroppedCount();
+
+		for (uint64_t frame = 0; !m_window->shouldClose() && (m_settings.frameCount == 0 || frame < m_settings.frameCount); ++frame) {
+			WP_PROFILE_SCOPE("Application::frame");
+
+			const auto& pacing = m_framePacer.getSettings();
+			if (pacing.mode == FramePacingMode::Idle) {
+				m_window->waitEvents(pacing.idleTimeout);
+			}
+			else {
+				m_window->update();
+			}
+
+			double deltaTime = m_framePacer.beginFrame();
+			m_frameAllocator->beginFrame();
+			dispatchEvents();
+			while (m_framePacer.stepFixed()) {
+				fixedUpdate(pacing.fixedTimestep);
+			}
+			for (auto& layer : m_layers) {
+				layer->onUpdate(deltaTime);
+			}
+			update(deltaTime);
+			endInputLatency();
+
+			{
+				WP_PROFILE_SCOPE("FramePacer::endFrame");
+				m_framePacer.endFrame();
+			}
+			WP_PROFILE_END_FRAME();
 		}
+
+		[[maybe_unused]] auto stats = m_framePacer.getStats();
+		WP_LOG_INFO("Frame pacing: {0} frames, avg {1:.3f}ms, jitter {2:.3f}ms, max {3:.3f}ms, cpu {4:.1f}%",
+			stats.frameCount, stats.averageFrameMs, stats.jitterMs, stats.maxFrameMs, stats.cpuUsage * 100.0);
+		[[maybe_unused]] auto latency = getInputLatencyStats();
+		WP_LOG_INFO("Input latency: {0} events, avg {1:.3f}ms, max {2:.3f}ms, {3} dropped",
+			latency.eventCount, latency.averageMs, latency.maxMs, latency.droppedEvents);
+		WP_PROFILE_LOG_SUMMARY();
+	}
+
+	void Application::dispatchEvents() {
+		WP_PROFILE_FUNCTION();
+
+		std::array<Event, EVENT_BATCH_SIZE> batch;
+		EventQueue& queue = m_window->getEventQueue();
+		m_frameDrainTime = Event::now();
+
+		size_t count;
+		while ((count = queue.pop(batch.data(), batch.size())) > 0) {
+			EventMask batchMask = 0;
+			for (size_t i = 0; i < count; ++i) {
+				const Event& event = batch[i];
+				batchMask |= eventBit(event.type);
+				if (!event.isInput()) {
+					continue;
+				}
+				m_frameOldestInput = m_frameInputEvents == 0 ? event.timestamp : std::min(m_frameOldestInput, event.timestamp);
+				m_frameInputAgeSumNs += static_cast<double>(m_frameDrainTime - event.timestamp);
+				++m_frameInputEvents;
+			}
+
+			// Top to bottom, each layer only sees what the layers above left unhandled
+			for (auto layer = m_layers.rbegin(); layer != m_layers.rend(); ++layer) {
+				EventMask mask = (*layer)->getEventMask();
+				if ((mask & batchMask) != 0) {
+					(*layer)->onEvents(EventBatch(batch.data(), count, mask));
+				}
+			}
+		}
+	}
+
+	void Application::endInputLatency() {
+		if (m_frameInputEvents == 0) {
+			return;
+		}
+
+		int64_t frameEnd = Event::now();
+		m_inputLatencySumNs += m_frameInputAgeSumNs + static_cast<double>(frameEnd - m_frameDrainTime) * m_frameInputEvents;
+		m_inputLatencyMaxNs = std::max(m_inputLatencyMaxNs, static_cast<double>(frameEnd - m_frameOldestInput));
+		m_inputEvents += m_frameInputEvents;
+
+		m_frameInputEvents = 0;
+		m_frameInputAgeSumNs = 0.0;
+	}
+
+	InputLatencyStats Application::getInputLatencyStats() const {
+		InputLatencyStats stats;
+		stats.eventCount = m_inputEvents;
+		stats.averageMs = m_inputEvents > 0 ? m_inputLatencySumNs / m_inputEvents / 1e6 : 0.0;
+		stats.maxMs = m_inputLatencyMaxNs / 1e6;
+		stats.droppedEvents = m_window ? m_window->getEventQueue().getDroppedCount() - m_droppedEventsAtStart : 0;
+		return stats;
 	}
 }
\ No newline at end of file
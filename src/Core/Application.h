@@ -1,17 +1,94 @@
 #pragma once
 #include "Base.h"
+#include "FramePacer.h"
+#include "JobSystem.h"
+#include "Layer.h"
 #include "Window.h"
+#include "ECS/World.h"
+#include "Memory/FrameAllocator.h"
+
+#include <vector>
 
 namespace Warp {
 
+	struct ApplicationSettings {
+		// Runs without a window, e.g. for benchmarks on build machines
+		bool headless = false;
+		// Stops after this many frames, 0 runs until the window is closed
+		uint64_t frameCount = 0;
+	};
+
+	struct InputLatencyStats {
+		uint64_t eventCount = 0;
+		// From the window callback to the end of the update of the frame that dispatched the event
+		double averageMs = 0.0;
+		double maxMs = 0.0;
+		// Lost to a full event queue
+		uint64_t droppedEvents = 0;
+	};
+
 	class Application {
 
 	public:
-		void init();
+		virtual ~Application();
+
+		void init(const ApplicationSettings& settings = {});
 
 		void run();
+
+		void setFramePacing(const FramePacingSettings& settings) { m_framePacer.setSettings(settings); }
+
+		const FramePacer& getFramePacer() const { return m_framePacer; }
+
+		// Attaches the layer on top of the others, it is detached and destroyed with the application
+		void pushLayer(ScopedRef<Layer> layer);
+
+		Window& getWindow() { return *m_window; }
+
+		// Of the input events dispatched since run started
+		InputLatencyStats getInputLatencyStats() const;
+
+		// Scratch memory that is valid for the current and the next frame
+		FrameAllocator& getFrameAllocator() { return *m_frameAllocator; }
+
+		// Entities and components of the scene, systems iterate it with queries in update
+		World& getWorld() { return *m_world; }
+
+	protected:
+		// Called zero or more times per frame with the fixed timestep
+		virtual void fixedUpdate([[maybe_unused]] double timestep) {}
+
+		virtual void update([[maybe_unused]] double deltaTime) {}
 	
 	private:
-		CountedRef<Window> m_window;
+		// Drains the window's event queue in batches and hands every batch to the subscribed layers
+		void dispatchEvents();
+
+		// Ends the latency of the input events dispatched this frame
+		void endInputLatency();
+
+		ApplicationSettings m_settings;
+
+		ScopedRef<JobSystem> m_jobSystem;
+		IntrusiveRef<Window> m_window;
+		ScopedRef<FrameAllocator> m_frameAllocator;
+		// Declared after the job system, queries may still run parallel jobs while the world is alive
+		ScopedRef<World> m_world;
+		// Bottom to top, declared last as layers may use everything above
+		std::vector<ScopedRef<Layer>> m_layers;
+
+		FramePacer m_framePacer;
+
+		// Of the input events dispatched this frame, relative to when they were drained so nothing has to be stored
+		// per event
+		uint64_t m_frameInputEvents = 0;
+		int64_t m_frameDrainTime = 0;
+		double m_frameInputAgeSumNs = 0.0;
+		int64_t m_frameOldestInput = 0;
+
+		uint64_t m_inputEvents = 0;
+		double m_inputLatencySumNs = 0.0;
+		double m_inputLatencyMaxNs = 0.0;
+		uint64_t m_droppedEventsAtStart = 0;
 	};
 }
\ No newline at end of file
@@ -1,5 +1,7 @@
 #pragma once
 #include <memory>
+#include <type_traits>
+#include "RefCounted.h"
 
 namespace Warp {
 	template<class T>
@@ -10,8 +12,15 @@ namespace Warp {
 		return std::make_shared<T>(std::forward<args>(values)...);
 	}
 
-	template<class T>
-	using ScopedRef = std::unique_ptr<T>;
+	// For types deriving from RefCounted/LocalRefCounted, the count lives in the object
+	template<class T, class ... args>
+	IntrusiveRef<T> CreateIntrusiveRef(args&&... values) {
+		static_assert(IS_REF_COUNTED<T>, "IntrusiveRef needs a type deriving from RefCounted or LocalRefCounted");
+		return IntrusiveRef<T>(new T(std::forward<args>(values)...));
+	}
+
+	template<class T, class Deleter = std::default_delete<T>>
+	using ScopedRef = std::unique_ptr<T, Deleter>;
 
 	template<class T, class ... args>
 	constexpr ScopedRef<T> CreateScopedRef(args&&... values) {
@@ -21,6 +30,9 @@ namespace Warp {
 
 #if defined(WARP_PLATFORM_WINDOWS)
 #define WP_DEBUG_BREAK() __debugbreak();
+#elif defined(WARP_PLATFORM_LINUX)
+#include <csignal>
+#define WP_DEBUG_BREAK() std::raise(SIGTRAP);
 #else
 #error "Debug break not yet supported on this platform"
 #endif
\ No newline at end of file
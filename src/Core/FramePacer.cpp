@@ -0,0 +1,165 @@
+#include "wppch.h"
+#include "FramePacer.h"
+
+#include <algorithm>
+#include <cmath>
+#include <thread>
+
+#if !defined(WARP_PLATFORM_WINDOWS)
+#include <time.h>
+#endif
+
+namespace Warp {
+
+	static double toSeconds(FramePacer::Clock::duration duration) {
+		return std::chrono::duration<double>(duration).count();
+	}
+
+	FramePacer::FramePacer(const FramePacingSettings& settings) {
+#if defined(WARP_PLATFORM_WINDOWS)
+		// The default scheduler tick is ~15.6ms, far too coarse to hit a frame deadline
+		timeBeginPeriod(1);
+#endif
+		setSettings(settings);
+		resetStats();
+	}
+
+	FramePacer::~FramePacer() {
+#if defined(WARP_PLATFORM_WINDOWS)
+		timeEndPeriod(1);
+#endif
+	}
+
+	void FramePacer::setSettings(const FramePacingSettings& settings) {
+		WP_ASSERTM(settings.targetFps > 0.0, "Target fps has to be positive");
+		WP_ASSERTM(settings.fixedTimestep > 0.0, "Fixed timestep has to be positive");
+
+		m_settings = settings;
+		m_firstFrame = true;
+	}
+
+	double FramePacer::beginFrame() {
+		auto now = Clock::now();
+		if (m_firstFrame) {
+			m_frameStart = now;
+			m_nextFrame = now;
+			m_firstFrame = false;
+		}
+
+		double deltaTime = toSeconds(now - m_frameStart);
+		m_frameStart = now;
+
+		if (m_statFrames++ > 0) {
+			double frameMs = deltaTime * 1000.0;
+			m_statSum += frameMs;
+			m_statSquaredSum += frameMs * frameMs;
+			m_statMax = std::max(m_statMax, frameMs);
+		}
+
+		m_accumulator += deltaTime;
+		m_fixedSteps = 0;
+		return deltaTime;
+	}
+
+	bool FramePacer::stepFixed() {
+		if (m_accumulator < m_settings.fixedTimestep) {
+			return false;
+		}
+
+		if (m_fixedSteps == m_settings.maxFixedSteps) {
+			// Drop the time we can't catch up on instead of falling further behind every frame
+			m_accumulator = std::fmod(m_accumulator, m_settings.fixedTimestep);
+			return false;
+		}
+
+		m_accumulator -= m_settings.fixedTimestep;
+		++m_fixedSteps;
+		return true;
+	}
+
+	void FramePacer::endFrame() {
+		if (m_settings.mode != FramePacingMode::LimitFps) {
+			return;
+		}
+
+		auto frameDuration = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(1.0 / m_settings.targetFps));
+		m_nextFrame += frameDuration;
+
+		auto now = Clock::now();
+		if (m_nextFrame < now) {
+			// Missed the deadline, schedule from now instead of trying to catch up with short frames
+			m_nextFrame = now;
+			return;
+		}
+
+		preciseSleep(toSeconds(m_nextFrame - now));
+	}
+
+	FrameStats FramePacer::getStats() const {
+		FrameStats stats;
+		stats.frameCount = m_statFrames;
+
+		uint64_t intervals = m_statFrames > 1 ? m_statFrames - 1 : 0;
+		if (intervals > 0) {
+			stats.averageFrameMs = m_statSum / intervals;
+			double variance = m_statSquaredSum / intervals - stats.averageFrameMs * stats.averageFrameMs;
+			stats.jitterMs = std::sqrt(std::max(0.0, variance));
+			stats.maxFrameMs = m_statMax;
+		}
+
+		double wallTime = toSeconds(Clock::now() - m_statStart);
+		if (wallTime > 0.0) {
+			stats.cpuUsage = (getProcessCpuTime() - m_statCpuStart) / wallTime;
+		}
+		return stats;
+	}
+
+	void FramePacer::resetStats() {
+		m_statFrames = 0;
+		m_statSum = 0.0;
+		m_statSquaredSum = 0.0;
+		m_statMax = 0.0;
+		m_statStart = Clock::now();
+		m_statCpuStart = getProcessCpuTime();
+	}
+
+	void FramePacer::preciseSleep(double seconds) {
+		static thread_local double s_estimate = 5e-3;
+		static thread_local double s_mean = 5e-3;
+		static thread_local double s_squaredDeviation = 0.0;
+		static thread_local uint64_t s_count = 1;
+
+		while (seconds > s_estimate) {
+			auto start = Clock::now();
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+			double observed = toSeconds(Clock::now() - start);
+			seconds -= observed;
+
+			// Welford's running mean and variance of how long a 1ms sleep really takes
+			++s_count;
+			double delta = observed - s_mean;
+			s_mean += delta / s_count;
+			s_squaredDeviation += delta * (observed - s_mean);
+			s_estimate = s_mean + std::sqrt(s_squaredDeviation / (s_count - 1));
+		}
+
+		auto end = Clock::now() + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(std::max(0.0, seconds)));
+		while (Clock::now() < end) {
+		}
+	}
+
+	double FramePacer::getProcessCpuTime() {
+#if defined(WARP_PLATFORM_WINDOWS)
+		FILETIME creationTime, exitTime, kernelTime, userTime;
+		GetProcessTimes(GetCurrentProcess(), &creationTime, &exitTime, &kernelTime, &userTime);
+
+		auto toTicks = [](const FILETIME& time) { return (static_cast<uint64_t>(time.dwHighDateTime) << 32) | time.dwLowDateTime; };
+		// FILETIME counts 100ns ticks
+		return (toTicks(kernelTime) + toTicks(userTime)) * 1e-7;
+#else
+		timespec time;
+		clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &time);
+		return time.tv_sec + time.tv_nsec * 1e-9;
+#endif
+	}
+}
@@ -0,0 +1,88 @@
+#pragma once
+#include "Base.h"
+
+#include <chrono>
+
+namespace Warp {
+
+	enum class FramePacingMode {
+		// Runs as fast as possible, only useful for benchmarking
+		Unlimited,
+		// Sleeps, then spins, until the next frame is due
+		LimitFps,
+		// Blocks in the window until an event arrives or the idle timeout expires
+		Idle
+	};
+
+	struct FramePacingSettings {
+		FramePacingMode mode = FramePacingMode::LimitFps;
+		double targetFps = 60.0;
+
+		double fixedTimestep = 1.0 / 60.0;
+		// Upper bound of fixed updates per frame, so a long stall doesn't snowball
+		uint32_t maxFixedSteps = 8;
+
+		double idleTimeout = 0.25;
+	};
+
+	struct FrameStats {
+		uint64_t frameCount = 0;
+		double averageFrameMs = 0.0;
+		// Standard deviation of the frame time
+		double jitterMs = 0.0;
+		double maxFrameMs = 0.0;
+		// Process CPU time divided by wall time, 1.0 is one fully used core
+		double cpuUsage = 0.0;
+	};
+
+	class FramePacer {
+
+	public:
+		using Clock = std::chrono::steady_clock;
+
+		explicit FramePacer(const FramePacingSettings& settings = {});
+		~FramePacer();
+
+		void setSettings(const FramePacingSettings& settings);
+
+		const FramePacingSettings& getSettings() const { return m_settings; }
+
+		// Starts a new frame and returns the time since the previous one in seconds
+		double beginFrame();
+
+		// Takes one fixed timestep from the accumulator, call until it returns false
+		bool stepFixed();
+
+		// How far the frame is between the last and the next fixed step, for interpolation
+		double getFixedAlpha() const { return m_accumulator / m_settings.fixedTimestep; }
+
+		// Waits until the next frame is due when limiting the frame rate
+		void endFrame();
+
+		FrameStats getStats() const;
+
+		void resetStats();
+
+		// Sleeps for most of the duration and spins for the rest, the OS sleep granularity is learned on the fly
+		static void preciseSleep(double seconds);
+
+		static double getProcessCpuTime();
+
+	private:
+		FramePacingSettings m_settings;
+
+		Clock::time_point m_frameStart;
+		Clock::time_point m_nextFrame;
+		bool m_firstFrame = true;
+
+		double m_accumulator = 0.0;
+		uint32_t m_fixedSteps = 0;
+
+		uint64_t m_statFrames = 0;
+		double m_statSum = 0.0;
+		double m_statSquaredSum = 0.0;
+		double m_statMax = 0.0;
+		Clock::time_point m_statStart;
+		double m_statCpuStart = 0.0;
+	};
+}
@@ -0,0 +1,263 @@
+#include "wppch.h"
+#include "JobSystem.h"
+
+#include <algorithm>
+
+namespace Warp {
+
+	constexpr uint32_t IDLE_SPIN_COUNT = 64;
+	constexpr uint32_t NOT_A_WORKER = ~0u;
+
+	JobSystem* JobSystem::s_Instance = nullptr;
+
+	static thread_local uint32_t s_WorkerIndex = NOT_A_WORKER;
+
+	// Jobs are taken from a per-thread ring, a slot is reused once its job has finished
+	static thread_local ScopedRef<Job[]> s_JobPool;
+	static thread_local uint32_t s_JobPoolIndex = 0;
+
+	bool WorkStealingQueue::push(Job* job) {
+		int64_t bottom = m_bottom.load(std::memory_order_relaxed);
+		int64_t top = m_top.load(std::memory_order_acquire);
+		if (bottom - top >= CAPACITY) {
+			return false;
+		}
+
+		m_jobs[bottom & MASK].store(job, std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_release);
+		m_bottom.store(bottom + 1, std::memory_order_relaxed);
+		return true;
+	}
+
+	Job* WorkStealingQueue::pop() {
+		int64_t bottom = m_bottom.load(std::memory_order_relaxed) - 1;
+		m_bottom.store(bottom, std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		int64_t top = m_top.load(std::memory_order_relaxed);
+
+		if (top > bottom) {
+			m_bottom.store(bottom + 1, std::memory_order_relaxed);
+			return nullptr;
+		}
+
+		Job* job = m_jobs[bottom & MASK].load(std::memory_order_relaxed);
+		if (top == bottom) {
+			// Last job in the queue, race against stealing workers
+			if (!m_top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+				job = nullptr;
+			}
+			m_bottom.store(bottom + 1, std::memory_order_relaxed);
+		}
+		return job;
+	}
+
+	Job* WorkStealingQueue::steal() {
+		int64_t top = m_top.load(std::memory_order_acquire);
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		int64_t bottom = m_bottom.load(std::memory_order_acquire);
+
+		if (top >= bottom) {
+			return nullptr;
+		}
+
+		Job* job = m_jobs[top & MASK].load(std::memory_order_relaxed);
+		if (!m_top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+			return nullptr;
+		}
+		return job;
+	}
+
+	JobSystem::JobSystem(uint32_t workerCount) {
+		WP_PROFILE_FUNCTION();
+		WP_ASSERTM(!s_Instance, "Only one JobSystem can exist at a time");
+		s_Instance = this;
+
+		if (workerCount == 0) {
+			workerCount = std::max(1u, std::thread::hardware_concurrency());
+		}
+
+		m_queues.reserve(workerCount);
+		for (uint32_t i = 0; i < workerCount; ++i) {
+			m_queues.push_back(CreateScopedRef<WorkStealingQueue>());
+		}
+
+		s_WorkerIndex = 0;
+		m_workers.reserve(workerCount - 1);
+		for (uint32_t i = 1; i < workerCount; ++i) {
+			m_workers.emplace_back(&JobSystem::workerLoop, this, i);
+		}
+
+		WP_LOG_INFO("Started job system with {0} workers", workerCount);
+	}
+
+	JobSystem::~JobSystem() {
+		{
+			std::lock_guard<std::mutex> lock(m_wakeMutex);
+			m_running.store(false);
+		}
+		m_wakeCondition.notify_all();
+
+		for (auto& worker : m_workers) {
+			worker.join();
+		}
+
+		s_WorkerIndex = NOT_A_WORKER;
+		s_Instance = nullptr;
+	}
+
+	uint32_t JobSystem::getCurrentWorkerIndex() const {
+		return s_WorkerIndex;
+	}
+
+	void JobSystem::schedule(JobFunction function, void* data, JobCounter* counter, JobCounter* dependency) {
+		schedule([function, data]() { function(data); }, counter, dependency);
+	}
+
+	void JobSystem::wait(JobCounter& counter) {
+		while (!counter.isDone()) {
+			Job* job = getJob();
+			if (job) {
+				execute(job);
+			}
+			else {
+				std::this_thread::yield();
+			}
+		}
+		std::lock_guard<std::mutex> lock(counter.m_waitingMutex);
+	}
+
+	Job* JobSystem::allocateJob() {
+		if (!s_JobPool) {
+			s_JobPool = CreateScopedRef<Job[]>(JOB_POOL_SIZE);
+		}
+		Job* job = &s_JobPool[s_JobPoolIndex];
+		s_JobPoolIndex = (s_JobPoolIndex + 1) & (JOB_POOL_SIZE - 1);
+
+		// JOB_POOL_SIZE jobs are still queued or running, help out until the oldest one has finished
+		while (job->active.load(std::memory_order_acquire)) {
+			Job* other = getJob();
+			if (other) {
+				execute(other);
+			}
+			else {
+				std::this_thread::yield();
+			}
+		}
+		job->active.store(true, std::memory_order_relaxed);
+		return job;
+	}
+
+	void JobSystem::submit(Job* job, JobCounter* dependency) {
+		if (job->counter) {
+			job->counter->m_value.fetch_add(1, std::memory_order_relaxed);
+		}
+
+		if (dependency) {
+			std::lock_guard<std::mutex> lock(dependency->m_waitingMutex);
+			if (!dependency->isDone()) {
+				dependency->m_waitingJobs.push_back(job);
+				return;
+			}
+		}
+		push(job);
+	}
+
+	void JobSystem::push(Job* job) {
+		uint32_t workerIndex = s_WorkerIndex < m_queues.size() ? s_WorkerIndex : 0;
+
+		// Threads outside the job system, or a full queue, run the job right away
+		m_pendingJobs.fetch_add(1);
+		if (s_WorkerIndex == NOT_A_WORKER || !m_queues[workerIndex]->push(job)) {
+			m_pendingJobs.fetch_sub(1);
+			execute(job);
+			return;
+		}
+
+		if (m_sleepingWorkers.load() > 0) {
+			// Serializes with a worker that is about to sleep, so the wake up can't get lost
+			std::lock_guard<std::mutex> lock(m_wakeMutex);
+		}
+		m_wakeCondition.notify_one();
+	}
+
+	Job* JobSystem::getJob() {
+		uint32_t workerIndex = s_WorkerIndex;
+		uint32_t workerCount = getWorkerCount();
+
+		Job* job = nullptr;
+		if (workerIndex == NOT_A_WORKER) {
+			workerIndex = 0;
+			job = m_queues[0]->steal();
+		}
+		else {
+			job = m_queues[workerIndex]->pop();
+		}
+		for (uint32_t i = 1; !job && i < workerCount; ++i) {
+			job = m_queues[(workerIndex + i) % workerCount]->steal();
+		}
+
+		if (job) {
+			m_pendingJobs.fetch_sub(1);
+		}
+		return job;
+	}
+
+	void JobSystem::execute(Job* job) {
+		JobCounter* counter = job->counter;
+		job->function(job->payload);
+		job->active.store(false, std::memory_order_release);
+		if (counter) {
+			finish(counter);
+		}
+	}
+
+	void JobSystem::finish(JobCounter* counter) {
+		uint32_t value = counter->m_value.load(std::memory_order_relaxed);
+		while (value > 1) {
+			if (counter->m_value.compare_exchange_weak(value, value - 1, std::memory_order_acq_rel, std::memory_order_relaxed)) {
+				return;
+			}
+		}
+
+		// Probably the last job of this counter, reaching zero has to happen under the lock
+		// so a waiting thread can't destroy the counter while it is still in use here
+		std::vector<Job*> released;
+		{
+			std::lock_guard<std::mutex> lock(counter->m_waitingMutex);
+			if (counter->m_value.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+				released.swap(counter->m_waitingJobs);
+			}
+		}
+		for (Job* job : released) {
+			push(job);
+		}
+	}
+
+	void JobSystem::workerLoop(uint32_t workerIndex) {
+		s_WorkerIndex = workerIndex;
+		WP_PROFILE_THREAD("Worker " + std::to_string(workerIndex));
+
+		uint32_t idleSpins = 0;
+		while (m_running.load(std::memory_order_relaxed)) {
+			Job* job = getJob();
+			if (job) {
+				execute(job);
+				idleSpins = 0;
+				continue;
+			}
+
+			if (++idleSpins < IDLE_SPIN_COUNT) {
+				std::this_thread::yield();
+				continue;
+			}
+
+			std::unique_lock<std::mutex> lock(m_wakeMutex);
+			m_sleepingWorkers.fetch_add(1);
+			m_wakeCondition.wait(lock, [this]() {
+				return m_pendingJobs.load() > 0 || !m_running.load();
+			});
+			m_sleepingWorkers.fetch_sub(1);
+			idleSpins = 0;
+		}
+	}
+}
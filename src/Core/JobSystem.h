@@ -0,0 +1,181 @@
+#pragma once
+#include "Base.h"
+#include "Assert.h"
+
+#include <atomic>
+#include <array>
+#include <condition_variable>
+#include <cstddef>
+#include <mutex>
+#include <new>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace Warp {
+
+	class JobCounter;
+
+	using JobFunction = void(*)(void* data);
+
+	// A job is exactly one cache line, the callable is stored inline in the payload
+	struct alignas(64) Job {
+		static constexpr size_t PAYLOAD_SIZE = 64 - sizeof(JobFunction) - sizeof(JobCounter*) - 8;
+
+		JobFunction function;
+		JobCounter* counter;
+		// Set from allocation until the job has run, the pool slot can't be reused before
+		std::atomic<bool> active{ false };
+		alignas(8) std::byte payload[PAYLOAD_SIZE];
+	};
+
+	static_assert(sizeof(Job) == 64, "Job should fill exactly one cache line");
+
+	// Incremented for every job scheduled with it and decremented once that job finished.
+	// Jobs can also be deferred until another counter reaches zero.
+	class JobCounter {
+
+	public:
+		JobCounter() = default;
+		JobCounter(const JobCounter&) = delete;
+		JobCounter& operator=(const JobCounter&) = delete;
+
+		bool isDone() const { return m_value.load(std::memory_order_acquire) == 0; }
+
+		uint32_t getValue() const { return m_value.load(std::memory_order_acquire); }
+
+	private:
+		friend class JobSystem;
+
+		std::atomic<uint32_t> m_value{ 0 };
+
+		std::mutex m_waitingMutex;
+		std::vector<Job*> m_waitingJobs;
+	};
+
+	// Chase-Lev deque: the owning worker pushes and pops at the bottom, other workers steal from the top
+	class WorkStealingQueue {
+
+	public:
+		static constexpr int64_t CAPACITY = 4096;
+
+		bool push(Job* job);
+
+		Job* pop();
+
+		Job* steal();
+
+		int64_t size() const { return m_bottom.load(std::memory_order_relaxed) - m_top.load(std::memory_order_relaxed); }
+
+	private:
+		static constexpr int64_t MASK = CAPACITY - 1;
+		static_assert((CAPACITY & MASK) == 0, "Capacity must be a power of two");
+
+		alignas(64) std::atomic<int64_t> m_top{ 0 };
+		alignas(64) std::atomic<int64_t> m_bottom{ 0 };
+		alignas(64) std::array<std::atomic<Job*>, CAPACITY> m_jobs{};
+	};
+
+	class JobSystem {
+
+	public:
+		// Jobs each thread can have queued or running at once, creating more waits for the oldest ones to finish
+		static constexpr uint32_t JOB_POOL_SIZE = 4096;
+
+		// workerCount includes the calling thread, 0 uses one worker per hardware thread
+		explicit JobSystem(uint32_t workerCount = 0);
+		~JobSystem();
+
+		JobSystem(const JobSystem&) = delete;
+		JobSystem& operator=(const JobSystem&) = delete;
+
+		static JobSystem& get() { WP_ASSERTM(s_Instance, "JobSystem has not been created"); return *s_Instance; }
+
+		static bool exists() { return s_Instance != nullptr; }
+
+		uint32_t getWorkerCount() const { return static_cast<uint32_t>(m_queues.size()); }
+
+		// Index of the calling worker, the thread that created the job system is worker 0
+		uint32_t getCurrentWorkerIndex() const;
+
+		void schedule(JobFunction function, void* data, JobCounter* counter = nullptr, JobCounter* dependency = nullptr);
+
+		template<class Function>
+		void schedule(Function&& function, JobCounter* counter = nullptr, JobCounter* dependency = nullptr);
+
+		// Executes other jobs on the calling thread until the counter reaches zero
+		void wait(JobCounter& counter);
+
+		// Calls function(begin, end) for batches of [0, count) on all workers and blocks until all batches are done
+		template<class Function>
+		void parallel_for(uint32_t count, uint32_t batchSize, const Function& function);
+
+	private:
+		Job* allocateJob();
+
+		void submit(Job* job, JobCounter* dependency);
+
+		void push(Job* job);
+
+		Job* getJob();
+
+		void execute(Job* job);
+
+		void finish(JobCounter* counter);
+
+		void workerLoop(uint32_t workerIndex);
+
+		static JobSystem* s_Instance;
+
+		std::vector<ScopedRef<WorkStealingQueue>> m_queues;
+		std::vector<std::thread> m_workers;
+
+		std::atomic<bool> m_running{ true };
+		std::atomic<uint32_t> m_pendingJobs{ 0 };
+		std::atomic<uint32_t> m_sleepingWorkers{ 0 };
+
+		std::mutex m_wakeMutex;
+		std::condition_variable m_wakeCondition;
+	};
+
+	template<class Function>
+	void JobSystem::schedule(Function&& function, JobCounter* counter, JobCounter* dependency) {
+		using Callable = std::decay_t<Function>;
+		static_assert(sizeof(Callable) <= Job::PAYLOAD_SIZE, "Job callable is too large, capture by reference or use a data pointer");
+		static_assert(alignof(Callable) <= 8, "Job callable is over-aligned");
+
+		Job* job = allocateJob();
+		job->function = [](void* data) {
+			Callable* callable = std::launder(reinterpret_cast<Callable*>(data));
+			(*callable)();
+			callable->~Callable();
+		};
+		job->counter = counter;
+		new (job->payload) Callable(std::forward<Function>(function));
+
+		submit(job, dependency);
+	}
+
+	template<class Function>
+	void JobSystem::parallel_for(uint32_t count, uint32_t batchSize, const Function& function) {
+		if (count == 0) {
+			return;
+		}
+		// Keep the number of jobs in flight well below the per-thread job pool size
+		constexpr uint32_t MAX_BATCHES = 1024;
+		if (batchSize == 0) {
+			batchSize = 1;
+		}
+		if ((count + batchSize - 1) / batchSize > MAX_BATCHES) {
+			batchSize = (count + MAX_BATCHES - 1) / MAX_BATCHES;
+		}
+
+		JobCounter counter;
+		const Function* body = &function;
+		for (uint32_t begin = 0; begin < count; begin += batchSize) {
+			uint32_t end = begin + batchSize < count ? begin + batchSize : count;
+			schedule([body, begin, end]() { (*body)(begin, end); }, &counter);
+		}
+		wait(counter);
+	}
+}
@@ -0,0 +1,82 @@
+#pragma once
+#include "Base.h"
+#include "Events/Event.h"
+
+#include <cstddef>
+
+namespace Warp {
+
+	// The events of one drained batch that a layer subscribed to, in the order they arrived. Events handled by a
+	// layer above are skipped.
+	class EventBatch {
+
+	public:
+		class Iterator {
+
+		public:
+			Iterator(Event* event, Event* end, EventMask mask) : m_event(event), m_end(end), m_mask(mask) { skip(); }
+
+			Event& operator*() const { return *m_event; }
+			Event* operator->() const { return m_event; }
+
+			Iterator& operator++() {
+				++m_event;
+				skip();
+				return *this;
+			}
+
+			bool operator==(const Iterator& other) const { return m_event == other.m_event; }
+			bool operator!=(const Iterator& other) const { return m_event != other.m_event; }
+
+		private:
+			void skip() {
+				while (m_event != m_end && (m_event->handled || (eventBit(m_event->type) & m_mask) == 0)) {
+					++m_event;
+				}
+			}
+
+			Event* m_event;
+			Event* m_end;
+			EventMask m_mask;
+		};
+
+		EventBatch(Event* events, size_t count, EventMask mask) : m_events(events), m_count(count), m_mask(mask) {}
+
+		Iterator begin() const { return Iterator(m_events, m_events + m_count, m_mask); }
+		Iterator end() const { return Iterator(m_events + m_count, m_events + m_count, m_mask); }
+
+	private:
+		Event* m_events;
+		size_t m_count;
+		EventMask m_mask;
+	};
+
+	// A slice of the application, e.g. the game, a debug overlay or the UI. Layers are updated bottom to top every
+	// frame and receive events top to bottom, so an overlay can handle a click before the game sees it.
+	class Layer {
+
+	public:
+		explicit Layer(const char* name = "Layer", EventMask eventMask = EVENT_MASK_ALL) : m_name(name), m_eventMask(eventMask) {}
+		virtual ~Layer() = default;
+
+		virtual void onAttach() {}
+
+		virtual void onDetach() {}
+
+		virtual void onUpdate([[maybe_unused]] double deltaTime) {}
+
+		// Called once per batch that holds events of the subscribed types, set handled to stop them here
+		virtual void onEvents([[maybe_unused]] const EventBatch& events) {}
+
+		const char* getName() const { return m_name; }
+
+		EventMask getEventMask() const { return m_eventMask; }
+
+	protected:
+		void setEventMask(EventMask eventMask) { m_eventMask = eventMask; }
+
+	private:
+		const char* m_name;
+		EventMask m_eventMask;
+	};
+}
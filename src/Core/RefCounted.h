@@ -0,0 +1,190 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <functional>
+#include <type_traits>
+#include <utility>
+
+namespace Warp {
+
+	// Counter policies for BasicRefCounted
+	struct AtomicRefCounter {
+		std::atomic<uint32_t> value{ 0 };
+
+		void increment() { value.fetch_add(1, std::memory_order_relaxed); }
+
+		// Returns true when the last reference was released
+		bool decrement() {
+			if (value.fetch_sub(1, std::memory_order_release) == 1) {
+				std::atomic_thread_fence(std::memory_order_acquire);
+				return true;
+			}
+			return false;
+		}
+
+		uint32_t get() const { return value.load(std::memory_order_relaxed); }
+	};
+
+	// Plain integer count, only for objects whose references never leave the thread that created them
+	struct LocalRefCounter {
+		uint32_t value = 0;
+
+		void increment() { ++value; }
+
+		bool decrement() { return --value == 0; }
+
+		uint32_t get() const { return value; }
+	};
+
+	class RefCountedBase {
+
+	public:
+		virtual ~RefCountedBase() = default;
+
+	protected:
+		template<class T>
+		friend class IntrusiveRef;
+
+		// Called when the last reference is released, overridden for objects that came from an allocator
+		virtual void destroy() { delete this; }
+	};
+
+	// Base for objects held by IntrusiveRef. The count lives in the object, so an IntrusiveRef is a single pointer
+	// and needs no separate control block.
+	template<class Counter>
+	class BasicRefCounted : public RefCountedBase {
+
+	public:
+		BasicRefCounted() = default;
+
+		// A copy is a new object, it starts without references
+		BasicRefCounted(const BasicRefCounted&) {}
+		BasicRefCounted& operator=(const BasicRefCounted&) { return *this; }
+
+		uint32_t getRefCount() const { return m_refCount.get(); }
+
+	private:
+		template<class T>
+		friend class IntrusiveRef;
+
+		void addRef() const { m_refCount.increment(); }
+
+		bool releaseRef() const { return m_refCount.decrement(); }
+
+		mutable Counter m_refCount;
+	};
+
+	using RefCounted = BasicRefCounted<AtomicRefCounter>;
+	using LocalRefCounted = BasicRefCounted<LocalRefCounter>;
+
+	template<class T>
+	class IntrusiveRef {
+
+	public:
+		using element_type = T;
+
+		IntrusiveRef() = default;
+		IntrusiveRef(std::nullptr_t) {}
+
+		// Safe for any object that is already referenced elsewhere, e.g. this
+		explicit IntrusiveRef(T* pointer) : m_pointer(pointer) { retain(); }
+
+		IntrusiveRef(const IntrusiveRef& other) : m_pointer(other.m_pointer) { retain(); }
+		IntrusiveRef(IntrusiveRef&& other) noexcept : m_pointer(std::exchange(other.m_pointer, nullptr)) {}
+
+		template<class U, class = std::enable_if_t<std::is_convertible_v<U*, T*>>>
+		IntrusiveRef(const IntrusiveRef<U>& other) : m_pointer(other.get()) { retain(); }
+
+		template<class U, class = std::enable_if_t<std::is_convertible_v<U*, T*>>>
+		IntrusiveRef(IntrusiveRef<U>&& other) noexcept : m_pointer(other.detach()) {}
+
+		~IntrusiveRef() { release(); }
+
+		IntrusiveRef& operator=(const IntrusiveRef& other) {
+			IntrusiveRef(other).swap(*this);
+			return *this;
+		}
+
+		IntrusiveRef& operator=(IntrusiveRef&& other) noexcept {
+			IntrusiveRef(std::move(other)).swap(*this);
+			return *this;
+		}
+
+		IntrusiveRef& operator=(std::nullptr_t) {
+			reset();
+			return *this;
+		}
+
+		void reset() {
+			release();
+			m_pointer = nullptr;
+		}
+
+		void swap(IntrusiveRef& other) noexcept { std::swap(m_pointer, other.m_pointer); }
+
+		// Gives up ownership without releasing the reference
+		T* detach() { return std::exchange(m_pointer, nullptr); }
+
+		T* get() const { return m_pointer; }
+
+		T& operator*() const { return *m_pointer; }
+
+		T* operator->() const { return m_pointer; }
+
+		explicit operator bool() const { return m_pointer != nullptr; }
+
+		uint32_t use_count() const { return m_pointer ? m_pointer->getRefCount() : 0; }
+
+	private:
+		void retain() {
+			if (m_pointer) {
+				m_pointer->addRef();
+			}
+		}
+
+		void release() {
+			if (m_pointer && m_pointer->releaseRef()) {
+				const_cast<RefCountedBase*>(static_cast<const RefCountedBase*>(m_pointer))->destroy();
+			}
+		}
+
+		T* m_pointer = nullptr;
+	};
+
+	template<class T, class U>
+	bool operator==(const IntrusiveRef<T>& left, const IntrusiveRef<U>& right) { return left.get() == right.get(); }
+
+	template<class T, class U>
+	bool operator!=(const IntrusiveRef<T>& left, const IntrusiveRef<U>& right) { return left.get() != right.get(); }
+
+	template<class T, class U>
+	bool operator<(const IntrusiveRef<T>& left, const IntrusiveRef<U>& right) { return left.get() < right.get(); }
+
+	template<class T>
+	bool operator==(const IntrusiveRef<T>& left, std::nullptr_t) { return !left; }
+
+	template<class T>
+	bool operator!=(const IntrusiveRef<T>& left, std::nullptr_t) { return static_cast<bool>(left); }
+
+	template<class T>
+	bool operator==(std::nullptr_t, const IntrusiveRef<T>& right) { return !right; }
+
+	template<class T>
+	bool operator!=(std::nullptr_t, const IntrusiveRef<T>& right) { return static_cast<bool>(right); }
+
+	template<class T, class U>
+	IntrusiveRef<T> static_pointer_cast(const IntrusiveRef<U>& ref) { return IntrusiveRef<T>(static_cast<T*>(ref.get())); }
+
+	template<class T, class U>
+	IntrusiveRef<T> dynamic_pointer_cast(const IntrusiveRef<U>& ref) { return IntrusiveRef<T>(dynamic_cast<T*>(ref.get())); }
+
+	template<class T>
+	constexpr bool IS_REF_COUNTED = std::is_base_of_v<RefCountedBase, T>;
+}
+
+namespace std {
+	template<class T>
+	struct hash<Warp::IntrusiveRef<T>> {
+		size_t operator()(const Warp::IntrusiveRef<T>& ref) const { return hash<T*>()(ref.get()); }
+	};
+}
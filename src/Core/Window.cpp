@@ -5,24 +5,101 @@
 constexpr uint32_t WIDTH = 800, HEIGHT = 600;
 
 namespace Warp {
-	Window::Window() {
+	Window::Window(bool headless) {
+		WP_PROFILE_FUNCTION();
+		if (headless) {
+			return;
+		}
 		glfwInit();
 
-		glfwWindowHint(GLFW_RESIZABLE, GLFW_FALSE);
+		glfwWindowHint(GLFW_RESIZABLE, GLFW_TRUE);
 		glfwWindowHint(GLFW_CLIENT_API, GLFW_NO_API);
 
 		m_window = glfwCreateWindow(WIDTH, HEIGHT, "Warp", nullptr, nullptr);
+
+		glfwSetWindowUserPointer(m_window, this);
+		glfwSetWindowCloseCallback(m_window, onWindowClose);
+		glfwSetFramebufferSizeCallback(m_window, onFramebufferSize);
+		glfwSetWindowFocusCallback(m_window, onWindowFocus);
+		glfwSetKeyCallback(m_window, onKey);
+		glfwSetCharCallback(m_window, onChar);
+		glfwSetCursorPosCallback(m_window, onCursorPos);
+		glfwSetMouseButtonCallback(m_window, onMouseButton);
+		glfwSetScrollCallback(m_window, onScroll);
+	}
+
+	static EventQueue& getEvents(GLFWwindow* window) {
+		return static_cast<Window*>(glfwGetWindowUserPointer(window))->getEventQueue();
+	}
+
+	void Window::onWindowClose(GLFWwindow* window) {
+		getEvents(window).push(Event(EventType::WindowClose));
+	}
+
+	void Window::onFramebufferSize(GLFWwindow* window, int width, int height) {
+		Event event(EventType::WindowResize);
+		event.resize = { static_cast<uint32_t>(width), static_cast<uint32_t>(height) };
+		getEvents(window).push(event);
+	}
+
+	void Window::onWindowFocus(GLFWwindow* window, int focused) {
+		Event event(EventType::WindowFocus);
+		event.focus = { focused == GLFW_TRUE };
+		getEvents(window).push(event);
+	}
+
+	void Window::onKey(GLFWwindow* window, int key, int scancode, int action, int mods) {
+		Event event(action == GLFW_PRESS ? EventType::KeyPress : action == GLFW_RELEASE ? EventType::KeyRelease : EventType::KeyRepeat);
+		event.key = { key, scancode, mods };
+		getEvents(window).push(event);
+	}
+
+	void Window::onChar(GLFWwindow* window, unsigned int codepoint) {
+		Event event(EventType::Char);
+		event.character = { codepoint };
+		getEvents(window).push(event);
+	}
+
+	void Window::onCursorPos(GLFWwindow* window, double x, double y) {
+		Event event(EventType::MouseMove);
+		event.mouseMove = { static_cast<float>(x), static_cast<float>(y) };
+		getEvents(window).push(event);
+	}
+
+	void Window::onMouseButton(GLFWwindow* window, int button, int action, int mods) {
+		Event event(action == GLFW_PRESS ? EventType::MouseButtonPress : EventType::MouseButtonRelease);
+		event.mouseButton = { button, mods };
+		getEvents(window).push(event);
+	}
+
+	void Window::onScroll(GLFWwindow* window, double xOffset, double yOffset) {
+		Event event(EventType::MouseScroll);
+		event.mouseScroll = { static_cast<float>(xOffset), static_cast<float>(yOffset) };
+		getEvents(window).push(event);
 	}
 
 	bool Window::shouldClose() {
-		return glfwWindowShouldClose(m_window);
+		return m_window && glfwWindowShouldClose(m_window);
 	}
 
 	void Window::update() {
-		glfwPollEvents();
+		WP_PROFILE_FUNCTION();
+		if (m_window) {
+			glfwPollEvents();
+		}
+	}
+
+	void Window::waitEvents(double timeout) {
+		WP_PROFILE_FUNCTION();
+		if (m_window) {
+			glfwWaitEventsTimeout(timeout);
+		}
 	}
 
 	Window::~Window() {
+		if (!m_window) {
+			return;
+		}
 		glfwDestroyWindow(m_window);
 
 		glfwTerminate();
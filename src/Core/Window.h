@@ -1,19 +1,39 @@
 #pragma once
 #include <GLFW/glfw3.h>
 #include "Base.h"
+#include "Events/EventQueue.h"
 
 namespace Warp {
 
-	class Window {
+	class Window : public RefCounted {
 	public:
-		Window();
+		// A headless window creates no GLFW window at all, so it also works on machines without a display
+		explicit Window(bool headless = false);
 		~Window();
 
 		bool shouldClose();
 
+		bool isHeadless() const { return m_window == nullptr; }
+
+		// Processes pending events, the callbacks push them into the event queue
 		void update();
+
+		// Blocks until an event arrives or the timeout in seconds expires, then processes events
+		void waitEvents(double timeout);
+
+		// Filled while processing events, headless windows only get what is pushed by hand
+		EventQueue& getEventQueue() { return m_events; }
 	private:
-		GLFWwindow* m_window;
+		static void onWindowClose(GLFWwindow* window);
+		static void onFramebufferSize(GLFWwindow* window, int width, int height);
+		static void onWindowFocus(GLFWwindow* window, int focused);
+		static void onKey(GLFWwindow* window, int key, int scancode, int action, int mods);
+		static void onChar(GLFWwindow* window, unsigned int codepoint);
+		static void onCursorPos(GLFWwindow* window, double x, double y);
+		static void onMouseButton(GLFWwindow* window, int button, int action, int mods);
+		static void onScroll(GLFWwindow* window, double xOffset, double yOffset);
+
+		GLFWwindow* m_window = nullptr;
+		EventQueue m_events;
 	};
 }
-
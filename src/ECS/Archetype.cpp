@@ -0,0 +1,121 @@
+#include "wppch.h"
+#include "Archetype.h"
+
+#include <cstring>
+#include <new>
+
+namespace Warp {
+
+	// Chunks are cache line aligned, so are the arrays that are aligned to their components inside them
+	constexpr size_t CHUNK_ALIGNMENT = 64;
+
+	static size_t alignUp(size_t value, size_t alignment) {
+		return (value + alignment - 1) & ~(alignment - 1);
+	}
+
+	// Offsets of the arrays for a chunk holding capacity rows, returns the bytes used
+	static size_t layoutColumns(std::vector<Archetype::Column>& columns, size_t capacity) {
+		size_t size = sizeof(Entity) * capacity;
+		for (auto& column : columns) {
+			size = alignUp(size, column.info->alignment);
+			column.offset = static_cast<uint32_t>(size);
+			size += size_t(column.size) * capacity;
+		}
+		return size;
+	}
+
+	Archetype::Archetype(ComponentMask mask) : m_mask(mask) {
+		m_columnIndices.fill(NO_COLUMN);
+
+		size_t rowSize = sizeof(Entity);
+		for (ComponentId id = 0; id < MAX_COMPONENTS; ++id) {
+			if (mask & (ComponentMask(1) << id)) {
+				const ComponentInfo& info = ComponentRegistry::getInfo(id);
+				m_columnIndices[id] = static_cast<uint32_t>(m_columns.size());
+				m_columns.push_back({ id, 0, info.size, &info });
+				rowSize += info.size;
+			}
+		}
+
+		// Start from the capacity without padding and shrink until the aligned arrays fit
+		size_t capacity = CHUNK_SIZE / rowSize;
+		while (capacity > 0 && layoutColumns(m_columns, capacity) > CHUNK_SIZE) {
+			--capacity;
+		}
+		WP_ASSERTM(capacity > 0, "Components of an archetype do not fit into one chunk");
+		m_chunkCapacity = static_cast<uint32_t>(capacity);
+	}
+
+	Archetype::~Archetype() {
+		for (auto& chunk : m_chunks) {
+			for (const auto& column : m_columns) {
+				if (!column.info->destroy) {
+					continue;
+				}
+				for (uint32_t row = 0; row < chunk.count; ++row) {
+					column.info->destroy(chunk.data + column.offset + size_t(row) * column.size);
+				}
+			}
+			::operator delete(chunk.data, std::align_val_t(CHUNK_ALIGNMENT));
+		}
+		if (m_spareChunk) {
+			::operator delete(m_spareChunk, std::align_val_t(CHUNK_ALIGNMENT));
+		}
+	}
+
+	void Archetype::allocateRow(Entity entity, uint32_t& chunk, uint32_t& row) {
+		if (m_chunks.empty() || m_chunks.back().count == m_chunkCapacity) {
+			std::byte* data = m_spareChunk;
+			m_spareChunk = nullptr;
+			if (!data) {
+				data = static_cast<std::byte*>(::operator new(CHUNK_SIZE, std::align_val_t(CHUNK_ALIGNMENT)));
+			}
+			m_chunks.push_back({ data, 0 });
+		}
+
+		chunk = static_cast<uint32_t>(m_chunks.size() - 1);
+		row = m_chunks.back().count++;
+		getEntities(chunk)[row] = entity;
+		++m_entityCount;
+	}
+
+	Entity Archetype::removeRow(uint32_t chunk, uint32_t row, bool destroyComponents) {
+		WP_ASSERT(chunk < m_chunks.size() && row < m_chunks[chunk].count);
+
+		if (destroyComponents) {
+			for (uint32_t column = 0; column < m_columns.size(); ++column) {
+				if (m_columns[column].info->destroy) {
+					m_columns[column].info->destroy(getComponent(chunk, row, column));
+				}
+			}
+		}
+
+		uint32_t lastChunk = static_cast<uint32_t>(m_chunks.size() - 1);
+		uint32_t lastRow = m_chunks[lastChunk].count - 1;
+		Entity moved;
+		if (chunk != lastChunk || row != lastRow) {
+			for (uint32_t column = 0; column < m_columns.size(); ++column) {
+				void* destination = getComponent(chunk, row, column);
+				void* source = getComponent(lastChunk, lastRow, column);
+				if (m_columns[column].info->relocate) {
+					m_columns[column].info->relocate(destination, source);
+				}
+				else {
+					std::memcpy(destination, source, m_columns[column].size);
+				}
+			}
+			moved = getEntities(lastChunk)[lastRow];
+			getEntities(chunk)[row] = moved;
+		}
+
+		--m_entityCount;
+		if (--m_chunks[lastChunk].count == 0) {
+			if (m_spareChunk) {
+				::operator delete(m_spareChunk, std::align_val_t(CHUNK_ALIGNMENT));
+			}
+			m_spareChunk = m_chunks[lastChunk].data;
+			m_chunks.pop_back();
+		}
+		return moved;
+	}
+}
\ No newline at end of file
@@ -0,0 +1,97 @@
+#pragma once
+#include "Core/Base.h"
+#include "Component.h"
+#include "Entity.h"
+
+#include <array>
+#include <cstddef>
+#include <vector>
+
+namespace Warp {
+
+	// All entities with exactly the same set of components. They are stored in 16 KB chunks, every chunk holds one
+	// contiguous array per component (structure of arrays) plus the array of their entities. Rows are kept dense:
+	// removing a row moves the last row of the archetype into the hole, so only the last chunk is ever partially full.
+	class Archetype {
+
+	public:
+		static constexpr size_t CHUNK_SIZE = 16 * 1024;
+		static constexpr uint32_t NO_COLUMN = ~0u;
+
+		struct Column {
+			ComponentId id;
+			// Start of the component array inside a chunk
+			uint32_t offset;
+			uint32_t size;
+			const ComponentInfo* info;
+		};
+
+		struct Chunk {
+			std::byte* data;
+			uint32_t count;
+		};
+
+		explicit Archetype(ComponentMask mask);
+		~Archetype();
+
+		Archetype(const Archetype&) = delete;
+		Archetype& operator=(const Archetype&) = delete;
+
+		// Appends an uninitialized row for the entity and returns its chunk and row, the caller constructs every component
+		void allocateRow(Entity entity, uint32_t& chunk, uint32_t& row);
+
+		// Destroys the components of the row, or leaves them alone if they were already relocated, and moves the last
+		// row into the hole. Returns the entity that moved, which is invalid if the removed row was the last one.
+		Entity removeRow(uint32_t chunk, uint32_t row, bool destroyComponents);
+
+		ComponentMask getMask() const { return m_mask; }
+
+		const std::vector<Column>& getColumns() const { return m_columns; }
+
+		uint32_t getColumnIndex(ComponentId id) const { return m_columnIndices[id]; }
+
+		uint32_t getChunkCapacity() const { return m_chunkCapacity; }
+
+		uint32_t getChunkCount() const { return static_cast<uint32_t>(m_chunks.size()); }
+
+		const Chunk& getChunk(uint32_t chunk) const { return m_chunks[chunk]; }
+
+		uint64_t getEntityCount() const { return m_entityCount; }
+
+		Entity* getEntities(uint32_t chunk) const { return reinterpret_cast<Entity*>(m_chunks[chunk].data); }
+
+		void* getComponent(uint32_t chunk, uint32_t row, uint32_t column) const {
+			const Column& info = m_columns[column];
+			return m_chunks[chunk].data + info.offset + size_t(row) * info.size;
+		}
+
+		template<class T>
+		T* getArray(uint32_t chunk, uint32_t column) const {
+			return reinterpret_cast<T*>(m_chunks[chunk].data + m_columns[column].offset);
+		}
+
+		// Archetype graph, the archetype with one component more or less. Filled lazily by the world.
+		Archetype* getAddEdge(ComponentId id) const { return m_addEdges[id]; }
+
+		Archetype* getRemoveEdge(ComponentId id) const { return m_removeEdges[id]; }
+
+		void setAddEdge(ComponentId id, Archetype* archetype) { m_addEdges[id] = archetype; }
+
+		void setRemoveEdge(ComponentId id, Archetype* archetype) { m_removeEdges[id] = archetype; }
+
+	private:
+		ComponentMask m_mask;
+		std::vector<Column> m_columns;
+		std::array<uint32_t, MAX_COMPONENTS> m_columnIndices;
+		uint32_t m_chunkCapacity = 0;
+
+		std::vector<Chunk> m_chunks;
+		// The last chunk that ran empty, kept so an entity moving back and forth across a chunk boundary does not
+		// allocate every time
+		std::byte* m_spareChunk = nullptr;
+		uint64_t m_entityCount = 0;
+
+		std::array<Archetype*, MAX_COMPONENTS> m_addEdges{};
+		std::array<Archetype*, MAX_COMPONENTS> m_removeEdges{};
+	};
+}
\ No newline at end of file
@@ -0,0 +1,32 @@
+#include "wppch.h"
+#include "Component.h"
+
+#include <array>
+#include <mutex>
+
+namespace Warp {
+
+	// Fixed storage, so infos that are already registered never move while another thread registers a new type
+	static std::array<ComponentInfo, MAX_COMPONENTS> s_ComponentInfos;
+	static std::atomic<uint32_t> s_ComponentCount{ 0 };
+	static std::mutex s_RegistryMutex;
+
+	const ComponentInfo& ComponentRegistry::getInfo(ComponentId id) {
+		WP_ASSERTM(id < s_ComponentCount.load(std::memory_order_acquire), "Unknown component id");
+		return s_ComponentInfos[id];
+	}
+
+	uint32_t ComponentRegistry::getCount() {
+		return s_ComponentCount.load(std::memory_order_acquire);
+	}
+
+	ComponentId ComponentRegistry::registerComponent(const ComponentInfo& info) {
+		std::lock_guard<std::mutex> lock(s_RegistryMutex);
+
+		uint32_t id = s_ComponentCount.load(std::memory_order_relaxed);
+		WP_ASSERTM(id < MAX_COMPONENTS, "Too many component types, raise MAX_COMPONENTS and widen ComponentMask");
+		s_ComponentInfos[id] = info;
+		s_ComponentCount.store(id + 1, std::memory_order_release);
+		return id;
+	}
+}
\ No newline at end of file
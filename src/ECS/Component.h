@@ -0,0 +1,72 @@
+#pragma once
+#include "Core/Base.h"
+
+#include <cstdint>
+#include <new>
+#include <type_traits>
+#include <typeinfo>
+#include <utility>
+
+namespace Warp {
+
+	using ComponentId = uint32_t;
+	// One bit per component id, a set of components identifies an archetype
+	using ComponentMask = uint64_t;
+
+	constexpr uint32_t MAX_COMPONENTS = 64;
+
+	// Type erased operations of a component type. Null functions mean the type is trivially relocatable or destructible
+	// and its bytes can simply be copied or dropped.
+	struct ComponentInfo {
+		const char* name;
+		uint32_t size;
+		uint32_t alignment;
+		// Move constructs into uninitialized destination and destroys the source
+		void (*relocate)(void* destination, void* source);
+		void (*destroy)(void* component);
+	};
+
+	class ComponentRegistry {
+
+	public:
+		// Ids are handed out on first use, every type gets the same id for the lifetime of the program
+		template<class T>
+		static ComponentId getId() {
+			static const ComponentId s_Id = registerComponent(createInfo<T>());
+			return s_Id;
+		}
+
+		template<class T>
+		static ComponentMask getMask() { return ComponentMask(1) << getId<T>(); }
+
+		static const ComponentInfo& getInfo(ComponentId id);
+
+		static uint32_t getCount();
+
+	private:
+		static ComponentId registerComponent(const ComponentInfo& info);
+
+		template<class T>
+		static ComponentInfo createInfo() {
+			static_assert(std::is_same_v<T, std::decay_t<T>>, "Components are registered by their plain type");
+			static_assert(std::is_move_constructible_v<T>, "Components have to be move constructible");
+			static_assert(alignof(T) <= 64, "Components can be aligned to at most a cache line");
+
+			ComponentInfo info{};
+			info.name = typeid(T).name();
+			info.size = static_cast<uint32_t>(sizeof(T));
+			info.alignment = static_cast<uint32_t>(alignof(T));
+			if constexpr (!std::is_trivially_copyable_v<T>) {
+				info.relocate = [](void* destination, void* source) {
+					T* component = std::launder(static_cast<T*>(source));
+					new (destination) T(std::move(*component));
+					component->~T();
+				};
+			}
+			if constexpr (!std::is_trivially_destructible_v<T>) {
+				info.destroy = [](void* component) { std::launder(static_cast<T*>(component))->~T(); };
+			}
+			return info;
+		}
+	};
+}
\ No newline at end of file
@@ -0,0 +1,20 @@
+#pragma once
+#include <cstdint>
+
+namespace Warp {
+
+	// Handle to an entity of a World. The index is reused after the entity is destroyed, the generation tells the
+	// old handles apart from the new entity.
+	struct Entity {
+		static constexpr uint32_t INVALID_INDEX = ~0u;
+
+		uint32_t index = INVALID_INDEX;
+		uint32_t generation = 0;
+
+		bool isValid() const { return index != INVALID_INDEX; }
+
+		bool operator==(const Entity& other) const { return index == other.index && generation == other.generation; }
+
+		bool operator!=(const Entity& other) const { return !(*this == other); }
+	};
+}
\ No newline at end of file
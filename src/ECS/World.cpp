@@ -0,0 +1,138 @@
+#include "wppch.h"
+#include "World.h"
+
+#include <cstring>
+
+namespace Warp {
+
+	World::World() {
+		m_emptyArchetype = getArchetype(0);
+	}
+
+	World::~World() {
+		// Archetypes destroy the components that are still alive
+		m_archetypes.clear();
+	}
+
+	Entity World::create() {
+		WP_ASSERTM(m_iterationDepth == 0, "The world cannot change while a query iterates it");
+
+		uint32_t chunk, row;
+		return allocateEntity(m_emptyArchetype, chunk, row);
+	}
+
+	void World::destroy(Entity entity) {
+		WP_ASSERTM(m_iterationDepth == 0, "The world cannot change while a query iterates it");
+
+		const EntityRecord& record = getRecord(entity);
+		removeRow(record.archetype, record.chunk, record.row, true);
+		freeEntity(entity.index);
+	}
+
+	bool World::isAlive(Entity entity) const {
+		return entity.index < m_records.size() && m_records[entity.index].archetype && m_records[entity.index].generation == entity.generation;
+	}
+
+	Entity World::allocateEntity(Archetype* archetype, uint32_t& chunk, uint32_t& row) {
+		uint32_t index;
+		if (!m_freeIndices.empty()) {
+			index = m_freeIndices.back();
+			m_freeIndices.pop_back();
+		}
+		else {
+			index = static_cast<uint32_t>(m_records.size());
+			m_records.emplace_back();
+		}
+
+		EntityRecord& record = m_records[index];
+		Entity entity{ index, record.generation };
+		archetype->allocateRow(entity, chunk, row);
+		record.archetype = archetype;
+		record.chunk = chunk;
+		record.row = row;
+		++m_entityCount;
+		return entity;
+	}
+
+	void World::freeEntity(uint32_t index) {
+		EntityRecord& record = m_records[index];
+		record.archetype = nullptr;
+		++record.generation;
+		m_freeIndices.push_back(index);
+		--m_entityCount;
+	}
+
+	Archetype* World::getArchetype(ComponentMask mask) {
+		auto archetype = m_archetypeLookup.find(mask);
+		if (archetype != m_archetypeLookup.end()) {
+			return archetype->second;
+		}
+
+		m_archetypes.push_back(CreateScopedRef<Archetype>(mask));
+		m_archetypeLookup.emplace(mask, m_archetypes.back().get());
+		return m_archetypes.back().get();
+	}
+
+	Archetype* World::getAddTarget(Archetype* archetype, ComponentId id) {
+		Archetype* target = archetype->getAddEdge(id);
+		if (!target) {
+			target = getArchetype(archetype->getMask() | (ComponentMask(1) << id));
+			archetype->setAddEdge(id, target);
+			target->setRemoveEdge(id, archetype);
+		}
+		return target;
+	}
+
+	Archetype* World::getRemoveTarget(Archetype* archetype, ComponentId id) {
+		Archetype* target = archetype->getRemoveEdge(id);
+		if (!target) {
+			target = getArchetype(archetype->getMask() & ~(ComponentMask(1) << id));
+			archetype->setRemoveEdge(id, target);
+			target->setAddEdge(id, archetype);
+		}
+		return target;
+	}
+
+	void World::moveEntity(uint32_t index, Archetype* target) {
+		uint32_t chunk, row;
+		target->allocateRow(Entity{ index, m_records[index].generation }, chunk, row);
+		moveEntity(index, target, chunk, row);
+	}
+
+	void World::moveEntity(uint32_t index, Archetype* target, uint32_t chunk, uint32_t row) {
+		EntityRecord& record = m_records[index];
+		Archetype* source = record.archetype;
+
+		const auto& columns = source->getColumns();
+		for (uint32_t column = 0; column < columns.size(); ++column) {
+			void* component = source->getComponent(record.chunk, record.row, column);
+			uint32_t targetColumn = target->getColumnIndex(columns[column].id);
+
+			if (targetColumn == Archetype::NO_COLUMN) {
+				if (columns[column].info->destroy) {
+					columns[column].info->destroy(component);
+				}
+			}
+			else if (columns[column].info->relocate) {
+				columns[column].info->relocate(target->getComponent(chunk, row, targetColumn), component);
+			}
+			else {
+				std::memcpy(target->getComponent(chunk, row, targetColumn), component, columns[column].size);
+			}
+		}
+
+		// The components have all been relocated or destroyed, the row only has to be filled
+		removeRow(source, record.chunk, record.row, false);
+		record.archetype = target;
+		record.chunk = chunk;
+		record.row = row;
+	}
+
+	void World::removeRow(Archetype* archetype, uint32_t chunk, uint32_t row, bool destroyComponents) {
+		Entity moved = archetype->removeRow(chunk, row, destroyComponents);
+		if (moved.isValid()) {
+			m_records[moved.index].chunk = chunk;
+			m_records[moved.index].row = row;
+		}
+	}
+}
\ No newline at end of file
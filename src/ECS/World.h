@@ -0,0 +1,343 @@
+#pragma once
+#include "Core/Base.h"
+#include "Core/Assert.h"
+#include "Core/JobSystem.h"
+#include "Archetype.h"
+
+#include <array>
+#include <bitset>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace Warp {
+
+	class World;
+
+	// Iterates every entity that has at least the given components, chunk by chunk. Components listed as const T are
+	// only read. The matching archetypes are cached, archetypes created later are picked up by the next iteration.
+	// The world must not be changed structurally, i.e. no entities created or destroyed and no components added or
+	// removed, while a query iterates it.
+	template<class ... Components>
+	class Query {
+
+	public:
+		static_assert(sizeof...(Components) > 0, "A query needs at least one component");
+
+		explicit Query(World& world) : m_world(&world) {}
+
+		// function(Components&... components) for every entity
+		template<class Function>
+		void each(const Function& function);
+
+		// function(uint32_t count, const Entity* entities, Components*... arrays) for every chunk
+		template<class Function>
+		void eachChunk(const Function& function);
+
+		// Like each, but the chunks are split across the workers of the job system, function is called concurrently
+		template<class Function>
+		void eachParallel(const Function& function);
+
+		template<class Function>
+		void eachChunkParallel(const Function& function);
+
+		uint64_t getEntityCount();
+
+	private:
+		// Chunks per job, enough work per job to hide the scheduling cost
+		static constexpr uint32_t CHUNKS_PER_JOB = 4;
+
+		struct Match {
+			Archetype* archetype;
+			std::array<uint32_t, sizeof...(Components)> columns;
+		};
+
+		struct ChunkRef {
+			uint32_t match;
+			uint32_t chunk;
+		};
+
+		void update();
+
+		template<class Function, size_t ... indices>
+		static void callChunk(const Function& function, const Match& match, uint32_t chunk, std::index_sequence<indices...>) {
+			function(match.archetype->getChunk(chunk).count, static_cast<const Entity*>(match.archetype->getEntities(chunk)),
+				match.archetype->template getArray<Components>(chunk, match.columns[indices])...);
+		}
+
+		World* m_world;
+		std::vector<Match> m_matches;
+		// Archetypes of the world that have already been checked against the query
+		uint32_t m_checkedArchetypes = 0;
+		std::vector<ChunkRef> m_chunks;
+	};
+
+	// Owns the entities and their components, which are stored in archetypes. Adding or removing a component moves
+	// the entity into the archetype with one component more or less, which is found through the edges of the
+	// archetype graph after the first time. Not thread safe, structural changes have to be made from one thread.
+	class World {
+
+	public:
+		World();
+		~World();
+
+		World(const World&) = delete;
+		World& operator=(const World&) = delete;
+
+		// Creates an entity without components
+		Entity create();
+
+		// Creates an entity with all components at once, straight in its final archetype
+		template<class ... Components>
+		Entity create(Components&&... components);
+
+		void destroy(Entity entity);
+
+		bool isAlive(Entity entity) const;
+
+		template<class T, class ... args>
+		T& add(Entity entity, args&&... values);
+
+		template<class T>
+		void remove(Entity entity);
+
+		// nullptr if the entity does not have the component
+		template<class T>
+		T* get(Entity entity);
+
+		template<class T>
+		bool has(Entity entity) const;
+
+		template<class ... Components>
+		Query<Components...> query() { return Query<Components...>(*this); }
+
+		uint64_t getEntityCount() const { return m_entityCount; }
+
+		uint32_t getArchetypeCount() const { return static_cast<uint32_t>(m_archetypes.size()); }
+
+	private:
+		template<class ... Components>
+		friend class Query;
+
+		struct EntityRecord {
+			Archetype* archetype = nullptr;
+			uint32_t chunk = 0;
+			uint32_t row = 0;
+			uint32_t generation = 0;
+		};
+
+		// Guards against structural changes while a query iterates
+		class IterationScope {
+
+		public:
+			explicit IterationScope(World& world) : m_world(world) { ++m_world.m_iterationDepth; }
+
+			~IterationScope() { --m_world.m_iterationDepth; }
+
+		private:
+			World& m_world;
+		};
+
+		Entity allocateEntity(Archetype* archetype, uint32_t& chunk, uint32_t& row);
+
+		// Gives the index of an entity whose row is already gone back for reuse
+		void freeEntity(uint32_t index);
+
+		Archetype* getArchetype(ComponentMask mask);
+
+		Archetype* getAddTarget(Archetype* archetype, ComponentId id);
+
+		Archetype* getRemoveTarget(Archetype* archetype, ComponentId id);
+
+		// Moves the entity's components into a row of target, components target does not have are destroyed
+		void moveEntity(uint32_t index, Archetype* target);
+
+		// Same, into a row of target that has already been allocated for the entity
+		void moveEntity(uint32_t index, Archetype* target, uint32_t chunk, uint32_t row);
+
+		void removeRow(Archetype* archetype, uint32_t chunk, uint32_t row, bool destroyComponents);
+
+		const EntityRecord& getRecord(Entity entity) const {
+			WP_ASSERTM(isAlive(entity), "Entity has been destroyed");
+			return m_records[entity.index];
+		}
+
+		// In creation order, archetypes are never destroyed so queries can hold on to them
+		std::vector<ScopedRef<Archetype>> m_archetypes;
+		std::unordered_map<ComponentMask, Archetype*> m_archetypeLookup;
+		Archetype* m_emptyArchetype;
+
+		std::vector<EntityRecord> m_records;
+		std::vector<uint32_t> m_freeIndices;
+		uint64_t m_entityCount = 0;
+		uint32_t m_iterationDepth = 0;
+	};
+
+	template<class ... Components>
+	Entity World::create(Components&&... components) {
+		WP_ASSERTM(m_iterationDepth == 0, "The world cannot change while a query iterates it");
+
+		ComponentMask mask = (ComponentRegistry::getMask<std::decay_t<Components>>() | ...);
+		WP_ASSERTM(std::bitset<MAX_COMPONENTS>(mask).count() == sizeof...(Components), "A component can only be added once");
+
+		Archetype* archetype = getArchetype(mask);
+		uint32_t chunk, row;
+		Entity entity = allocateEntity(archetype, chunk, row);
+
+		// If a constructor throws, the components constructed before it are destroyed and the row and entity given back
+		size_t constructed = 0;
+		try {
+			((new (archetype->getComponent(chunk, row, archetype->getColumnIndex(ComponentRegistry::getId<std::decay_t<Components>>())))
+				std::decay_t<Components>(std::forward<Components>(components)), ++constructed), ...);
+		}
+		catch (...) {
+			ComponentId ids[] = { ComponentRegistry::getId<std::decay_t<Components>>()... };
+			for (size_t i = 0; i < constructed; ++i) {
+				const ComponentInfo& info = ComponentRegistry::getInfo(ids[i]);
+				if (info.destroy) {
+					info.destroy(archetype->getComponent(chunk, row, archetype->getColumnIndex(ids[i])));
+				}
+			}
+			removeRow(archetype, chunk, row, false);
+			freeEntity(entity.index);
+			throw;
+		}
+		return entity;
+	}
+
+	template<class T, class ... args>
+	T& World::add(Entity entity, args&&... values) {
+		WP_ASSERTM(m_iterationDepth == 0, "The world cannot change while a query iterates it");
+		WP_ASSERTM(!has<T>(entity), "Entity already has the component");
+
+		ComponentId id = ComponentRegistry::getId<T>();
+		Archetype* target = getAddTarget(getRecord(entity).archetype, id);
+		uint32_t chunk, row;
+		target->allocateRow(entity, chunk, row);
+
+		// Constructed before the entity moves, so a throwing constructor only has to give the new row back
+		T* component;
+		try {
+			component = new (target->getComponent(chunk, row, target->getColumnIndex(id))) T(std::forward<args>(values)...);
+		}
+		catch (...) {
+			removeRow(target, chunk, row, false);
+			throw;
+		}
+		moveEntity(entity.index, target, chunk, row);
+		return *component;
+	}
+
+	template<class T>
+	void World::remove(Entity entity) {
+		WP_ASSERTM(m_iterationDepth == 0, "The world cannot change while a query iterates it");
+		WP_ASSERTM(has<T>(entity), "Entity does not have the component");
+
+		moveEntity(entity.index, getRemoveTarget(getRecord(entity).archetype, ComponentRegistry::getId<T>()));
+	}
+
+	template<class T>
+	T* World::get(Entity entity) {
+		const EntityRecord& record = getRecord(entity);
+		uint32_t column = record.archetype->getColumnIndex(ComponentRegistry::getId<T>());
+		if (column == Archetype::NO_COLUMN) {
+			return nullptr;
+		}
+		return std::launder(static_cast<T*>(record.archetype->getComponent(record.chunk, record.row, column)));
+	}
+
+	template<class T>
+	bool World::has(Entity entity) const {
+		return (getRecord(entity).archetype->getMask() & ComponentRegistry::getMask<T>()) != 0;
+	}
+
+	template<class ... Components>
+	void Query<Components...>::update() {
+		ComponentMask required = (ComponentRegistry::getMask<std::remove_const_t<Components>>() | ...);
+		ComponentId ids[] = { ComponentRegistry::getId<std::remove_const_t<Components>>()... };
+
+		for (; m_checkedArchetypes < m_world->m_archetypes.size(); ++m_checkedArchetypes) {
+			Archetype* archetype = m_world->m_archetypes[m_checkedArchetypes].get();
+			if ((archetype->getMask() & required) != required) {
+				continue;
+			}
+
+			Match match;
+			match.archetype = archetype;
+			for (size_t i = 0; i < sizeof...(Components); ++i) {
+				match.columns[i] = archetype->getColumnIndex(ids[i]);
+			}
+			m_matches.push_back(match);
+		}
+	}
+
+	template<class ... Components>
+	template<class Function>
+	void Query<Components...>::each(const Function& function) {
+		eachChunk([&function](uint32_t count, const Entity*, Components*... arrays) {
+			for (uint32_t i = 0; i < count; ++i) {
+				function(arrays[i]...);
+			}
+		});
+	}
+
+	template<class ... Components>
+	template<class Function>
+	void Query<Components...>::eachChunk(const Function& function) {
+		update();
+		World::IterationScope scope(*m_world);
+
+		for (const auto& match : m_matches) {
+			for (uint32_t chunk = 0; chunk < match.archetype->getChunkCount(); ++chunk) {
+				callChunk(function, match, chunk, std::index_sequence_for<Components...>());
+			}
+		}
+	}
+
+	template<class ... Components>
+	template<class Function>
+	void Query<Components...>::eachParallel(const Function& function) {
+		eachChunkParallel([&function](uint32_t count, const Entity*, Components*... arrays) {
+			for (uint32_t i = 0; i < count; ++i) {
+				function(arrays[i]...);
+			}
+		});
+	}
+
+	template<class ... Components>
+	template<class Function>
+	void Query<Components...>::eachChunkParallel(const Function& function) {
+		if (!JobSystem::exists()) {
+			eachChunk(function);
+			return;
+		}
+
+		update();
+		World::IterationScope scope(*m_world);
+
+		m_chunks.clear();
+		for (uint32_t match = 0; match < m_matches.size(); ++match) {
+			for (uint32_t chunk = 0; chunk < m_matches[match].archetype->getChunkCount(); ++chunk) {
+				m_chunks.push_back({ match, chunk });
+			}
+		}
+
+		JobSystem::get().parallel_for(static_cast<uint32_t>(m_chunks.size()), CHUNKS_PER_JOB, [this, &function](uint32_t begin, uint32_t end) {
+			for (uint32_t i = begin; i < end; ++i) {
+				callChunk(function, m_matches[m_chunks[i].match], m_chunks[i].chunk, std::index_sequence_for<Components...>());
+			}
+		});
+	}
+
+	template<class ... Components>
+	uint64_t Query<Components...>::getEntityCount() {
+		update();
+
+		uint64_t count = 0;
+		for (const auto& match : m_matches) {
+			count += match.archetype->getEntityCount();
+		}
+		return count;
+	}
+}
\ No newline at end of file
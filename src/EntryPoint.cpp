@@ -1,18 +1,53 @@
 #include "wppch.h"
-#include "Core\Application.h"
+#include "Core/Application.h"
+
+#include <cstdlib>
+#include <cstring>
 
 int main(int argc, char** argv) {
 
 	WP_LOG_INIT();
+	WP_PROFILE_THREAD("Main");
+
+#ifdef WP_PROFILE_ENABLE
+	// --profile <file> records a trace, .bin files use the compact binary format
+	for (int i = 1; i + 1 < argc; ++i) {
+		if (std::strcmp(argv[i], "--profile") == 0) {
+			std::string path = argv[i + 1];
+			bool binary = path.size() >= 4 && path.compare(path.size() - 4, 4, ".bin") == 0;
+			Warp::Profiler::beginCapture(path, binary ? Warp::ProfileCaptureFormat::Binary : Warp::ProfileCaptureFormat::ChromeJson);
+		}
+	}
+#endif
+	// --headless runs without a window for --frames <count> frames
+	Warp::ApplicationSettings settings;
+	for (int i = 1; i < argc; ++i) {
+		if (std::strcmp(argv[i], "--headless") == 0) {
+			settings.headless = true;
+		}
+		else if (std::strcmp(argv[i], "--frames") == 0 && i + 1 < argc) {
+			settings.frameCount = std::strtoull(argv[i + 1], nullptr, 10);
+		}
+	}
+	if (settings.headless && settings.frameCount == 0) {
+		settings.frameCount = 1000;
+	}
+
 	WP_LOG_INFO("Creating app");
 	auto app = new Warp::Application();
 
 	WP_LOG_INFO("Initalizing app");
-	app->init();
+	app->init(settings);
 
 	WP_LOG_INFO("Running app");
 	app->run();
 
 	WP_LOG_INFO("Shutting down app");
 	delete app;
+
+#ifdef WP_PROFILE_ENABLE
+	Warp::Profiler::endCapture();
+#endif
+
+	WP_LOG_SHUTDOWN();
 }
\ No newline at end of file
@@ -0,0 +1,102 @@
+#pragma once
+#include "Core/Base.h"
+
+#include <chrono>
+#include <cstdint>
+#include <type_traits>
+
+namespace Warp {
+
+	enum class EventType : uint8_t {
+		None,
+		WindowClose,
+		WindowResize,
+		WindowFocus,
+		KeyPress,
+		KeyRelease,
+		KeyRepeat,
+		Char,
+		MouseMove,
+		MouseButtonPress,
+		MouseButtonRelease,
+		MouseScroll
+	};
+
+	// One bit per event type, layers subscribe to the types in their mask
+	using EventMask = uint32_t;
+
+	constexpr EventMask eventBit(EventType type) { return EventMask(1) << static_cast<uint32_t>(type); }
+
+	constexpr EventMask EVENT_MASK_WINDOW = eventBit(EventType::WindowClose) | eventBit(EventType::WindowResize) | eventBit(EventType::WindowFocus);
+	constexpr EventMask EVENT_MASK_KEYBOARD = eventBit(EventType::KeyPress) | eventBit(EventType::KeyRelease) | eventBit(EventType::KeyRepeat)
+		| eventBit(EventType::Char);
+	constexpr EventMask EVENT_MASK_MOUSE = eventBit(EventType::MouseMove) | eventBit(EventType::MouseButtonPress) | eventBit(EventType::MouseButtonRelease)
+		| eventBit(EventType::MouseScroll);
+	constexpr EventMask EVENT_MASK_INPUT = EVENT_MASK_KEYBOARD | EVENT_MASK_MOUSE;
+	constexpr EventMask EVENT_MASK_ALL = ~EventMask(0);
+
+	// GLFW key, button and modifier values are passed through unchanged
+	struct KeyEventData {
+		int32_t key;
+		int32_t scancode;
+		int32_t mods;
+	};
+
+	struct CharEventData {
+		uint32_t codepoint;
+	};
+
+	struct MouseMoveEventData {
+		float x, y;
+	};
+
+	struct MouseButtonEventData {
+		int32_t button;
+		int32_t mods;
+	};
+
+	struct MouseScrollEventData {
+		float xOffset, yOffset;
+	};
+
+	// Framebuffer size in pixels
+	struct WindowResizeEventData {
+		uint32_t width, height;
+	};
+
+	struct WindowFocusEventData {
+		bool focused;
+	};
+
+	// Plain data, so events are copied into the queue without constructors or allocations
+	struct Event {
+		using Clock = std::chrono::steady_clock;
+
+		EventType type = EventType::None;
+		// Set by a layer to keep the event from the layers below it
+		bool handled = false;
+		// Nanoseconds of Clock when the event was received, for the input to frame latency
+		int64_t timestamp = 0;
+
+		union {
+			KeyEventData key;
+			CharEventData character;
+			MouseMoveEventData mouseMove;
+			MouseButtonEventData mouseButton;
+			MouseScrollEventData mouseScroll;
+			WindowResizeEventData resize;
+			WindowFocusEventData focus;
+		};
+
+		Event() : key{} {}
+
+		explicit Event(EventType type) : type(type), timestamp(now()), key{} {}
+
+		bool isInput() const { return (eventBit(type) & EVENT_MASK_INPUT) != 0; }
+
+		static int64_t now() { return std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now().time_since_epoch()).count(); }
+	};
+
+	static_assert(std::is_trivially_copyable_v<Event>, "Events are copied as raw bytes");
+	static_assert(sizeof(Event) == 32, "Events should stay two to a cache line");
+}
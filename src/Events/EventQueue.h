@@ -0,0 +1,69 @@
+#pragma once
+#include "Core/Base.h"
+#include "Event.h"
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+
+namespace Warp {
+
+	// Single producer, single consumer ring of events with a fixed capacity, nothing is allocated after construction.
+	// The window callbacks push, the application drains once per frame. Both run on the main thread as GLFW calls the
+	// callbacks from within glfwPollEvents, the queue just doesn't rely on it. A full queue drops new events instead
+	// of waiting, the consumer could be the very thread that is blocked.
+	class EventQueue {
+
+	public:
+		static constexpr size_t CAPACITY = 1024;
+
+		EventQueue() = default;
+
+		EventQueue(const EventQueue&) = delete;
+		EventQueue& operator=(const EventQueue&) = delete;
+
+		// Returns false if the queue was full and the event was dropped
+		bool push(const Event& event) {
+			size_t head = m_head.load(std::memory_order_relaxed);
+			if (head - m_cachedTail == CAPACITY) {
+				m_cachedTail = m_tail.load(std::memory_order_acquire);
+				if (head - m_cachedTail == CAPACITY) {
+					m_droppedCount.fetch_add(1, std::memory_order_relaxed);
+					return false;
+				}
+			}
+			m_events[head & MASK] = event;
+			m_head.store(head + 1, std::memory_order_release);
+			return true;
+		}
+
+		// Copies up to maxCount of the oldest events into out and releases them, returns the number copied
+		size_t pop(Event* out, size_t maxCount) {
+			size_t tail = m_tail.load(std::memory_order_relaxed);
+			size_t count = m_head.load(std::memory_order_acquire) - tail;
+			count = count < maxCount ? count : maxCount;
+			for (size_t i = 0; i < count; ++i) {
+				out[i] = m_events[(tail + i) & MASK];
+			}
+			m_tail.store(tail + count, std::memory_order_release);
+			return count;
+		}
+
+		bool isEmpty() const { return m_head.load(std::memory_order_acquire) == m_tail.load(std::memory_order_acquire); }
+
+		// Events lost to a full queue since construction
+		uint64_t getDroppedCount() const { return m_droppedCount.load(std::memory_order_relaxed); }
+
+	private:
+		static constexpr size_t MASK = CAPACITY - 1;
+		static_assert((CAPACITY & MASK) == 0, "Capacity must be a power of two");
+
+		std::array<Event, CAPACITY> m_events;
+
+		alignas(64) std::atomic<size_t> m_head{ 0 };
+		size_t m_cachedTail = 0;
+		std::atomic<uint64_t> m_droppedCount{ 0 };
+
+		alignas(64) std::atomic<size_t> m_tail{ 0 };
+	};
+}
@@ -3,15 +3,172 @@
 
 #include <spdlog/sinks/stdout_color_sinks.h>
 
+#include <algorithm>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
 #ifdef WP_LOG_ENABLE
 
 namespace Warp {
 
 	CountedRef<spdlog::logger> Log::s_Logger;
+	std::atomic<LogMode> Log::s_Mode{ LogMode::Sync };
+
+	// Owns the per-thread rings and the thread that formats and writes their records
+	class LogBackend {
+
+	public:
+		LogBackend() : m_thread(&LogBackend::run, this) {}
+
+		~LogBackend() {
+			{
+				std::lock_guard<std::mutex> lock(m_mutex);
+				m_running = false;
+			}
+			wake();
+			m_thread.join();
+			drain();
+		}
+
+		IntrusiveRef<LogRingBuffer> registerThread() {
+			auto buffer = CreateIntrusiveRef<LogRingBuffer>();
+			std::lock_guard<std::mutex> lock(m_buffersMutex);
+			m_buffers.push_back(buffer);
+			return buffer;
+		}
+
+		void wake() {
+			m_wake.notify_one();
+		}
+
+		void flush() {
+			std::vector<std::pair<IntrusiveRef<LogRingBuffer>, size_t>> targets;
+			{
+				std::lock_guard<std::mutex> lock(m_buffersMutex);
+				for (auto& buffer : m_buffers) {
+					targets.emplace_back(buffer, buffer->getHead());
+				}
+			}
+			wake();
+
+			for (auto& [buffer, head] : targets) {
+				while (buffer->getTail() < head) {
+					std::this_thread::yield();
+				}
+			}
+			// The records have been consumed, wait for the batch they were in to reach the sink
+			std::lock_guard<std::mutex> lock(m_drainMutex);
+		}
+
+	private:
+		void run() {
+			std::unique_lock<std::mutex> lock(m_mutex);
+			while (m_running) {
+				lock.unlock();
+				size_t written = drain();
+				lock.lock();
+
+				if (written == 0) {
+					m_wake.wait_for(lock, std::chrono::milliseconds(2));
+				}
+			}
+		}
+
+		size_t drain() {
+			std::lock_guard<std::mutex> drainLock(m_drainMutex);
+
+			std::vector<IntrusiveRef<LogRingBuffer>> buffers;
+			{
+				std::lock_guard<std::mutex> lock(m_buffersMutex);
+				buffers = m_buffers;
+			}
+
+			size_t written = 0;
+			for (auto& buffer : buffers) {
+				bool abandoned = buffer->abandoned.load(std::memory_order_acquire);
+				written += buffer->consume([this](const LogRecordHeader& header, const std::byte* arguments) {
+					m_message.clear();
+					header.decode(header.format, arguments, m_message);
+					Log::getLogger()->log(header.time, spdlog::source_loc{}, static_cast<spdlog::level::level_enum>(header.level),
+						spdlog::string_view_t(m_message.data(), m_message.size()));
+				});
+
+				if (abandoned) {
+					std::lock_guard<std::mutex> lock(m_buffersMutex);
+					m_buffers.erase(std::remove(m_buffers.begin(), m_buffers.end(), buffer), m_buffers.end());
+				}
+			}
+
+			if (written > 0) {
+				Log::getLogger()->flush();
+			}
+			return written;
+		}
+
+		std::mutex m_buffersMutex;
+		std::vector<IntrusiveRef<LogRingBuffer>> m_buffers;
+
+		std::mutex m_drainMutex;
+		spdlog::memory_buf_t m_message;
+
+		std::mutex m_mutex;
+		std::condition_variable m_wake;
+		bool m_running = true;
 
-	void Log::init() {
+		std::thread m_thread;
+	};
+
+	static ScopedRef<LogBackend> s_Backend;
+	// Bumped on every init, so threads register a new ring after the log has been restarted
+	static std::atomic<uint32_t> s_BackendGeneration{ 0 };
+
+	// Marks the ring as abandoned when its thread exits, the backend frees it after the last record was written
+	struct ThreadLogBuffer {
+		IntrusiveRef<LogRingBuffer> buffer;
+		uint32_t generation = 0;
+
+		~ThreadLogBuffer() {
+			if (buffer) {
+				buffer->abandoned.store(true, std::memory_order_release);
+			}
+		}
+	};
+
+	static thread_local ThreadLogBuffer s_ThreadBuffer;
+
+	std::byte* LogRingBuffer::reserve(size_t size) {
+		size_t head = m_head.load(std::memory_order_relaxed);
+		size_t contiguous = CAPACITY - (head & MASK);
+		size_t required = contiguous < size ? contiguous + size : size;
+
+		while (head + required - m_cachedTail > CAPACITY) {
+			m_cachedTail = m_tail.load(std::memory_order_acquire);
+			if (head + required - m_cachedTail > CAPACITY) {
+				// Full, don't wait for the log thread's next poll
+				s_Backend->wake();
+				std::this_thread::yield();
+			}
+		}
+
+		if (contiguous < size) {
+			// Not enough room before the end of the ring, skip to the start
+			auto* padding = reinterpret_cast<LogRecordHeader*>(&m_buffer[head & MASK]);
+			padding->size = static_cast<uint32_t>(contiguous);
+			padding->level = LogRecordHeader::PADDING;
+			head += contiguous;
+		}
+
+		m_reservedHead = head + size;
+		return &m_buffer[head & MASK];
+	}
+
+	void Log::init(LogMode mode, spdlog::sink_ptr sink) {
+		if (!sink) {
+			sink = CreateCountedRef<spdlog::sinks::stdout_color_sink_mt>();
+		}
 		std::array<spdlog::sink_ptr, 1> logSinks = {
-			CreateCountedRef<spdlog::sinks::stdout_color_sink_mt>()
+			sink
 		};
 		logSinks[0]->set_pattern("[%H:%M:%S] [%n] %v%$");
 
@@ -19,8 +176,44 @@ namespace Warp {
 		spdlog::register_logger(s_Logger);
 
 		s_Logger->set_level(spdlog::level::trace);
-		s_Logger->flush_on(spdlog::level::trace);
+		if (mode == LogMode::Async) {
+			s_Backend = CreateScopedRef<LogBackend>();
+			s_BackendGeneration.fetch_add(1, std::memory_order_relaxed);
+		}
+		else {
+			s_Logger->flush_on(spdlog::level::trace);
+		}
+		// Published last, threads that see Async also see the backend
+		s_Mode.store(mode, std::memory_order_release);
+	}
+
+	void Log::shutdown() {
+		s_Mode.store(LogMode::Sync, std::memory_order_release);
+		s_Backend.reset();
+
+		if (s_Logger) {
+			s_Logger->flush();
+			spdlog::drop(s_Logger->name());
+		}
+	}
+
+	void Log::flush() {
+		if (s_Backend) {
+			s_Backend->flush();
+		}
+		else {
+			s_Logger->flush();
+		}
+	}
+
+	LogRingBuffer& Log::getThreadBuffer() {
+		uint32_t generation = s_BackendGeneration.load(std::memory_order_relaxed);
+		if (s_ThreadBuffer.generation != generation) {
+			s_ThreadBuffer.buffer = s_Backend->registerThread();
+			s_ThreadBuffer.generation = generation;
+		}
+		return *s_ThreadBuffer.buffer;
 	}
 }
 
-#endif
\ No newline at end of file
+#endif
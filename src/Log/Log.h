@@ -1,38 +1,192 @@
 #pragma once
 
+#define WP_LOG_LEVEL_TRACE 0
+#define WP_LOG_LEVEL_DEBUG 1
+#define WP_LOG_LEVEL_INFO 2
+#define WP_LOG_LEVEL_WARN 3
+#define WP_LOG_LEVEL_ERROR 4
+#define WP_LOG_LEVEL_CRITICAL 5
+#define WP_LOG_LEVEL_OFF 6
+
+// Calls below this level are removed by the preprocessor, arguments included
+#ifndef WP_LOG_ACTIVE_LEVEL
+#ifdef NDEBUG
+#define WP_LOG_ACTIVE_LEVEL WP_LOG_LEVEL_INFO
+#else
+#define WP_LOG_ACTIVE_LEVEL WP_LOG_LEVEL_TRACE
+#endif
+#endif
+
 #ifdef WP_LOG_ENABLE
 
-#include "Core\Base.h"
-#include <spdlog\spdlog.h>
+#include "Core/Base.h"
+#include "LogRingBuffer.h"
+#include <spdlog/spdlog.h>
 
 namespace Warp {
 
+	enum class LogMode {
+		// Formats and writes on the calling thread
+		Sync,
+		// Copies the arguments into a per-thread ring, a background thread formats and writes them
+		Async
+	};
+
 	class Log {
 
 	public:
-		static void init();
+		// Without a sink the log goes to the colored console
+		static void init(LogMode mode = LogMode::Async, spdlog::sink_ptr sink = nullptr);
+
+		// Writes all pending messages and stops the log thread
+		static void shutdown();
+
+		// Blocks until every message logged before the call has been written
+		static void flush();
 
 		static CountedRef<spdlog::logger>& getLogger() { return s_Logger; }
 
+		static LogMode getMode() { return s_Mode.load(std::memory_order_acquire); }
+
+		template<class... Args>
+		static void write(spdlog::level::level_enum level, const char* format, const Args&... args);
+
 	private:
+		template<class... Args>
+		static void enqueue(spdlog::level::level_enum level, const char* format, const Args&... args);
+
+		template<class... Args>
+		static void enqueueFormatted(spdlog::level::level_enum level, const char* format, const Args&... args);
+
+		template<class... Args>
+		static void writeSync(spdlog::level::level_enum level, const char* format, const Args&... args);
+
+		static LogRingBuffer& getThreadBuffer();
+
 		static CountedRef<spdlog::logger> s_Logger;
+		// Read by every thread that logs, set by init and shutdown
+		static std::atomic<LogMode> s_Mode;
 	};
+
+	template<class... Args>
+	void Log::write(spdlog::level::level_enum level, const char* format, const Args&... args) {
+		if (!s_Logger->should_log(level)) {
+			return;
+		}
+
+		if (s_Mode.load(std::memory_order_acquire) == LogMode::Async) {
+			if constexpr (LOG_ARGUMENTS_ENCODABLE<Args...>) {
+				enqueue(level, format, args...);
+			}
+			else {
+				enqueueFormatted(level, format, args...);
+			}
+			if (level >= spdlog::level::err) {
+				// Errors often precede a crash or a debug break, make sure they are visible
+				flush();
+			}
+			return;
+		}
+		writeSync(level, format, args...);
+	}
+
+	template<class... Args>
+	void Log::enqueue(spdlog::level::level_enum level, const char* format, const Args&... args) {
+		size_t size = LogRingBuffer::alignSize(sizeof(LogRecordHeader) + (LogArgument<std::decay_t<Args>>::size(args) + ... + 0));
+		if (size > LogRingBuffer::MAX_RECORD_SIZE) {
+			enqueueFormatted(level, format, args...);
+			return;
+		}
+
+		LogRingBuffer& buffer = getThreadBuffer();
+		std::byte* record = buffer.reserve(size);
+
+		auto* header = new (record) LogRecordHeader{
+			static_cast<uint32_t>(size),
+			static_cast<uint32_t>(level),
+			&decodeLogRecord<Args...>,
+			format,
+			spdlog::log_clock::now()
+		};
+
+		std::byte* out = reinterpret_cast<std::byte*>(header + 1);
+		(LogArgument<std::decay_t<Args>>::encode(out, args), ...);
+		(void)out;
+
+		buffer.commit();
+	}
+
+	// Arguments other than numbers, enums and strings are formatted on the calling thread and queued as text, so the
+	// message keeps its place among the ones queued before it
+	template<class... Args>
+	void Log::enqueueFormatted(spdlog::level::level_enum level, const char* format, const Args&... args) {
+		spdlog::memory_buf_t message;
+		fmt::vformat_to(std::back_inserter(message), fmt::string_view(format), fmt::make_format_args(args...));
+		std::string_view text(message.data(), message.size());
+
+		if (LogRingBuffer::alignSize(sizeof(LogRecordHeader) + LogStringArgument::size(text)) > LogRingBuffer::MAX_RECORD_SIZE) {
+			// Too large for the ring, the queued messages are written first
+			flush();
+			s_Logger->log(level, spdlog::string_view_t(text.data(), text.size()));
+			return;
+		}
+		enqueue(level, "{}", text);
+	}
+
+	template<class... Args>
+	void Log::writeSync(spdlog::level::level_enum level, const char* format, const Args&... args) {
+		spdlog::memory_buf_t message;
+		fmt::vformat_to(std::back_inserter(message), fmt::string_view(format), fmt::make_format_args(args...));
+		s_Logger->log(level, spdlog::string_view_t(message.data(), message.size()));
+	}
 }
 
 #define WP_LOG_INIT() ::Warp::Log::init();
+#define WP_LOG_SHUTDOWN() ::Warp::Log::shutdown();
+
+#if WP_LOG_ACTIVE_LEVEL <= WP_LOG_LEVEL_CRITICAL
+#define WP_LOG_CRITICAL(...)	::Warp::Log::write(spdlog::level::critical, __VA_ARGS__);
+#else
+#define WP_LOG_CRITICAL(...)
+#endif
 
-#define WP_LOG_CRITICAL(...)	::Warp::Log::getLogger()->critical(__VA_ARGS__);
-#define WP_LOG_ERROR(...)	::Warp::Log::getLogger()->error(__VA_ARGS__);
-#define WP_LOG_WRN(...)		::Warp::Log::getLogger()->warn(__VA_ARGS__);
-#define WP_LOG_DBG(...)		::Warp::Log::getLogger()->debug(__VA_ARGS__);
-#define WP_LOG_INFO(...)	::Warp::Log::getLogger()->info(__VA_ARGS__);
-#define WP_LOG_TRACE(...)	::Warp::Log::getLogger()->trace(__VA_ARGS__);
+#if WP_LOG_ACTIVE_LEVEL <= WP_LOG_LEVEL_ERROR
+#define WP_LOG_ERROR(...)	::Warp::Log::write(spdlog::level::err, __VA_ARGS__);
+#else
+#define WP_LOG_ERROR(...)
+#endif
+
+#if WP_LOG_ACTIVE_LEVEL <= WP_LOG_LEVEL_WARN
+#define WP_LOG_WRN(...)		::Warp::Log::write(spdlog::level::warn, __VA_ARGS__);
+#else
+#define WP_LOG_WRN(...)
+#endif
+
+#if WP_LOG_ACTIVE_LEVEL <= WP_LOG_LEVEL_DEBUG
+#define WP_LOG_DBG(...)		::Warp::Log::write(spdlog::level::debug, __VA_ARGS__);
+#else
+#define WP_LOG_DBG(...)
+#endif
+
+#if WP_LOG_ACTIVE_LEVEL <= WP_LOG_LEVEL_INFO
+#define WP_LOG_INFO(...)	::Warp::Log::write(spdlog::level::info, __VA_ARGS__);
+#else
+#define WP_LOG_INFO(...)
+#endif
+
+#if WP_LOG_ACTIVE_LEVEL <= WP_LOG_LEVEL_TRACE
+#define WP_LOG_TRACE(...)	::Warp::Log::write(spdlog::level::trace, __VA_ARGS__);
+#else
+#define WP_LOG_TRACE(...)
+#endif
 
 #else
 
 #define WP_LOG_INIT()
+#define WP_LOG_SHUTDOWN()
 
 #define WP_LOG_FATAL(...)
+#define WP_LOG_CRITICAL(...)
 #define WP_LOG_ERROR(...)
 #define WP_LOG_WRN(...)
 #define WP_LOG_DBG(...)
@@ -40,4 +194,4 @@ namespace Warp {
 #define WP_LOG_TRACE(...)
 #define WP_LOG_ALL(...)
 
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,158 @@
+#pragma once
+
+#ifdef WP_LOG_ENABLE
+
+#include "Core/Base.h"
+#include <spdlog/spdlog.h>
+
+#include <atomic>
+#include <cstddef>
+#include <cstring>
+#include <iterator>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+
+namespace Warp {
+
+	using LogDecodeFunction = void(*)(const char* format, const std::byte* arguments, spdlog::memory_buf_t& out);
+
+	struct LogRecordHeader {
+		static constexpr uint32_t PADDING = ~0u;
+
+		// Total size including the header, always a multiple of 8
+		uint32_t size;
+		// spdlog level, or PADDING for the unused space at the end of the ring
+		uint32_t level;
+		LogDecodeFunction decode;
+		const char* format;
+		spdlog::log_clock::time_point time;
+	};
+
+	// Numbers and enums are copied as raw bytes and only formatted on the logging thread. Other trivially copyable
+	// types may still point to memory the caller changes or frees, so they are formatted on the calling thread.
+	template<class T>
+	struct LogArgument {
+		static constexpr bool ENCODABLE = std::is_arithmetic_v<T> || std::is_enum_v<T>;
+
+		static size_t size(const T&) { return sizeof(T); }
+
+		static void encode(std::byte*& out, const T& value) {
+			std::memcpy(out, &value, sizeof(T));
+			out += sizeof(T);
+		}
+
+		static T decode(const std::byte*& in) {
+			T value;
+			std::memcpy(&value, in, sizeof(T));
+			in += sizeof(T);
+			return value;
+		}
+	};
+
+	// Strings are copied into the record, so the caller's buffer may die before the message is written
+	struct LogStringArgument {
+		static constexpr bool ENCODABLE = true;
+
+		static size_t size(std::string_view value) { return sizeof(uint32_t) + value.size(); }
+
+		static void encode(std::byte*& out, std::string_view value) {
+			uint32_t length = static_cast<uint32_t>(value.size());
+			std::memcpy(out, &length, sizeof(length));
+			std::memcpy(out + sizeof(length), value.data(), length);
+			out += sizeof(length) + length;
+		}
+
+		static std::string_view decode(const std::byte*& in) {
+			uint32_t length;
+			std::memcpy(&length, in, sizeof(length));
+			std::string_view value(reinterpret_cast<const char*>(in + sizeof(length)), length);
+			in += sizeof(length) + length;
+			return value;
+		}
+	};
+
+	template<> struct LogArgument<const char*> : LogStringArgument {
+		static size_t size(const char* value) { return LogStringArgument::size(value ? value : "(null)"); }
+		static void encode(std::byte*& out, const char* value) { LogStringArgument::encode(out, value ? value : "(null)"); }
+	};
+	template<> struct LogArgument<char*> : LogArgument<const char*> {};
+	template<> struct LogArgument<std::string> : LogStringArgument {};
+	template<> struct LogArgument<std::string_view> : LogStringArgument {};
+
+	template<class... Args>
+	constexpr bool LOG_ARGUMENTS_ENCODABLE = (LogArgument<std::decay_t<Args>>::ENCODABLE && ...);
+
+	template<class... Args>
+	void decodeLogRecord(const char* format, const std::byte* arguments, spdlog::memory_buf_t& out) {
+		// Braced initialization guarantees the arguments are decoded from left to right
+		std::tuple<decltype(LogArgument<std::decay_t<Args>>::decode(arguments))...> values{ LogArgument<std::decay_t<Args>>::decode(arguments)... };
+		std::apply([&](auto&... value) {
+			fmt::vformat_to(std::back_inserter(out), fmt::string_view(format), fmt::make_format_args(value...));
+		}, values);
+	}
+
+	// Single producer, single consumer byte ring. The owning thread writes records, the log thread reads them.
+	class LogRingBuffer : public RefCounted {
+
+	public:
+		static constexpr size_t CAPACITY = 64 * 1024;
+
+		LogRingBuffer() : m_buffer(CreateScopedRef<std::byte[]>(CAPACITY)) {}
+
+		// Largest record that fits without waiting on the consumer for too long
+		static constexpr size_t MAX_RECORD_SIZE = CAPACITY / 4;
+
+		static constexpr size_t alignSize(size_t size) { return (size + 7) & ~size_t(7); }
+
+		// Returns space for a record of the given size, waits while the consumer frees up space
+		std::byte* reserve(size_t size);
+
+		// Publishes the record written into the last reserve call
+		void commit() { m_head.store(m_reservedHead, std::memory_order_release); }
+
+		// Hands every published record to the function and releases it, returns the number of records
+		template<class Function>
+		size_t consume(const Function& function);
+
+		size_t getHead() const { return m_head.load(std::memory_order_acquire); }
+
+		size_t getTail() const { return m_tail.load(std::memory_order_acquire); }
+
+		// Set when the owning thread exited, the buffer is released once it has been drained
+		std::atomic<bool> abandoned{ false };
+
+	private:
+		static constexpr size_t MASK = CAPACITY - 1;
+		static_assert((CAPACITY & MASK) == 0, "Capacity must be a power of two");
+
+		ScopedRef<std::byte[]> m_buffer;
+
+		alignas(64) std::atomic<size_t> m_head{ 0 };
+		size_t m_reservedHead = 0;
+		size_t m_cachedTail = 0;
+
+		alignas(64) std::atomic<size_t> m_tail{ 0 };
+	};
+
+	template<class Function>
+	size_t LogRingBuffer::consume(const Function& function) {
+		size_t tail = m_tail.load(std::memory_order_relaxed);
+		size_t head = m_head.load(std::memory_order_acquire);
+
+		size_t count = 0;
+		while (tail != head) {
+			const auto* header = reinterpret_cast<const LogRecordHeader*>(&m_buffer[tail & MASK]);
+			if (header->level != LogRecordHeader::PADDING) {
+				function(*header, reinterpret_cast<const std::byte*>(header + 1));
+				++count;
+			}
+			tail += header->size;
+			m_tail.store(tail, std::memory_order_release);
+		}
+		return count;
+	}
+}
+
+#endif
@@ -0,0 +1,49 @@
+#pragma once
+#include "Mat4.h"
+#include "Vec.h"
+
+namespace Warp::Math {
+
+	struct Aabb {
+		Vec3 center;
+		// Half the size along every axis
+		Vec3 extent;
+	};
+
+	// Six planes facing inwards as (normal, distance), a point p is inside a plane if dot(normal, p) + distance >= 0
+	struct Frustum {
+		enum Plane { Left, Right, Bottom, Top, Near, Far, PLANE_COUNT };
+
+		Vec4 planes[PLANE_COUNT];
+
+		// Planes of a view projection matrix with a clip space depth from 0 to 1, as produced by Mat4::perspective
+		static Frustum fromMatrix(const Mat4& viewProjection) {
+			Mat4 rows = transpose(viewProjection);
+			Frustum frustum;
+			frustum.planes[Left] = rows.columns[3] + rows.columns[0];
+			frustum.planes[Right] = rows.columns[3] - rows.columns[0];
+			frustum.planes[Bottom] = rows.columns[3] + rows.columns[1];
+			frustum.planes[Top] = rows.columns[3] - rows.columns[1];
+			frustum.planes[Near] = rows.columns[2];
+			frustum.planes[Far] = rows.columns[3] - rows.columns[2];
+
+			for (auto& plane : frustum.planes) {
+				plane = plane * (1.0f / length(plane.xyz()));
+			}
+			return frustum;
+		}
+
+		// Conservative, boxes near a corner of the frustum can pass without touching it
+		bool intersects(const Aabb& box) const {
+			for (const auto& plane : planes) {
+				Vec3 normal = plane.xyz();
+				float distance = dot(normal, box.center) + plane.w();
+				float radius = std::fabs(normal.x) * box.extent.x + std::fabs(normal.y) * box.extent.y + std::fabs(normal.z) * box.extent.z;
+				if (distance + radius < 0.0f) {
+					return false;
+				}
+			}
+			return true;
+		}
+	};
+}
\ No newline at end of file
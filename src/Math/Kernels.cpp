@@ -0,0 +1,202 @@
+#include "wppch.h"
+#include "Kernels.h"
+
+#if defined(WP_MATH_X86) && defined(WP_MATH_SSE)
+#if defined(_MSC_VER)
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+#endif
+
+namespace Warp::Math {
+
+#if defined(WP_MATH_X86) && defined(WP_MATH_SSE)
+	// Defined in KernelsAvx2.cpp, which is compiled for AVX2 and FMA
+	const Kernels& getAvx2Kernels();
+#endif
+
+	const char* toString(SimdLevel level) {
+		switch (level) {
+		case SimdLevel::Scalar: return "Scalar";
+		case SimdLevel::Sse2: return "SSE2";
+		case SimdLevel::Avx2: return "AVX2";
+		}
+		return "Unknown";
+	}
+
+	static void transformPointsScalar(const Mat4& matrix, const float* x, const float* y, const float* z,
+		float* outX, float* outY, float* outZ, size_t count) {
+		const float* m = matrix.data();
+		for (size_t i = 0; i < count; ++i) {
+			float px = x[i], py = y[i], pz = z[i];
+			outX[i] = m[0] * px + m[4] * py + m[8] * pz + m[12];
+			outY[i] = m[1] * px + m[5] * py + m[9] * pz + m[13];
+			outZ[i] = m[2] * px + m[6] * py + m[10] * pz + m[14];
+		}
+	}
+
+	static void multiplyMatricesScalar(const Mat4* a, const Mat4* b, Mat4* out, size_t count) {
+		for (size_t i = 0; i < count; ++i) {
+			const float* left = a[i].data();
+			const float* right = b[i].data();
+			float result[16];
+			for (int column = 0; column < 4; ++column) {
+				for (int row = 0; row < 4; ++row) {
+					result[column * 4 + row] = left[row] * right[column * 4] + left[4 + row] * right[column * 4 + 1]
+						+ left[8 + row] * right[column * 4 + 2] + left[12 + row] * right[column * 4 + 3];
+				}
+			}
+			float* destination = out[i].data();
+			for (int element = 0; element < 16; ++element) {
+				destination[element] = result[element];
+			}
+		}
+	}
+
+	static void cullAabbsScalar(const Frustum& frustum, const AabbArrays& boxes, uint8_t* visible, size_t count) {
+		float planes[Frustum::PLANE_COUNT][4];
+		for (int plane = 0; plane < Frustum::PLANE_COUNT; ++plane) {
+			frustum.planes[plane].store(planes[plane]);
+		}
+
+		for (size_t i = 0; i < count; ++i) {
+			bool inside = true;
+			for (int plane = 0; plane < Frustum::PLANE_COUNT && inside; ++plane) {
+				const float* p = planes[plane];
+				float distance = p[0] * boxes.centerX[i] + p[1] * boxes.centerY[i] + p[2] * boxes.centerZ[i] + p[3];
+				float radius = std::fabs(p[0]) * boxes.extentX[i] + std::fabs(p[1]) * boxes.extentY[i] + std::fabs(p[2]) * boxes.extentZ[i];
+				inside = distance + radius >= 0.0f;
+			}
+			visible[i] = inside ? 1 : 0;
+		}
+	}
+
+#ifdef WP_MATH_SSE
+	static void transformPointsSse(const Mat4& matrix, const float* x, const float* y, const float* z,
+		float* outX, float* outY, float* outZ, size_t count) {
+		const float* m = matrix.data();
+		__m128 m0 = _mm_set1_ps(m[0]), m1 = _mm_set1_ps(m[1]), m2 = _mm_set1_ps(m[2]);
+		__m128 m4 = _mm_set1_ps(m[4]), m5 = _mm_set1_ps(m[5]), m6 = _mm_set1_ps(m[6]);
+		__m128 m8 = _mm_set1_ps(m[8]), m9 = _mm_set1_ps(m[9]), m10 = _mm_set1_ps(m[10]);
+		__m128 m12 = _mm_set1_ps(m[12]), m13 = _mm_set1_ps(m[13]), m14 = _mm_set1_ps(m[14]);
+
+		size_t i = 0;
+		for (; i + 4 <= count; i += 4) {
+			__m128 px = _mm_loadu_ps(x + i), py = _mm_loadu_ps(y + i), pz = _mm_loadu_ps(z + i);
+			_mm_storeu_ps(outX + i, _mm_add_ps(_mm_add_ps(_mm_mul_ps(m0, px), _mm_mul_ps(m4, py)), _mm_add_ps(_mm_mul_ps(m8, pz), m12)));
+			_mm_storeu_ps(outY + i, _mm_add_ps(_mm_add_ps(_mm_mul_ps(m1, px), _mm_mul_ps(m5, py)), _mm_add_ps(_mm_mul_ps(m9, pz), m13)));
+			_mm_storeu_ps(outZ + i, _mm_add_ps(_mm_add_ps(_mm_mul_ps(m2, px), _mm_mul_ps(m6, py)), _mm_add_ps(_mm_mul_ps(m10, pz), m14)));
+		}
+		transformPointsScalar(matrix, x + i, y + i, z + i, outX + i, outY + i, outZ + i, count - i);
+	}
+
+	static void multiplyMatricesSse(const Mat4* a, const Mat4* b, Mat4* out, size_t count) {
+		for (size_t i = 0; i < count; ++i) {
+			out[i] = a[i] * b[i];
+		}
+	}
+
+	static void cullAabbsSse(const Frustum& frustum, const AabbArrays& boxes, uint8_t* visible, size_t count) {
+		size_t i = 0;
+		for (; i + 4 <= count; i += 4) {
+			__m128 centerX = _mm_loadu_ps(boxes.centerX + i), centerY = _mm_loadu_ps(boxes.centerY + i), centerZ = _mm_loadu_ps(boxes.centerZ + i);
+			__m128 extentX = _mm_loadu_ps(boxes.extentX + i), extentY = _mm_loadu_ps(boxes.extentY + i), extentZ = _mm_loadu_ps(boxes.extentZ + i);
+
+			__m128 outside = _mm_setzero_ps();
+			for (const auto& plane : frustum.planes) {
+				Vec4 absolute = abs(plane);
+				__m128 distance = _mm_add_ps(_mm_add_ps(_mm_mul_ps(splat<0>(plane).m, centerX), _mm_mul_ps(splat<1>(plane).m, centerY)),
+					_mm_add_ps(_mm_mul_ps(splat<2>(plane).m, centerZ), splat<3>(plane).m));
+				__m128 radius = _mm_add_ps(_mm_add_ps(_mm_mul_ps(splat<0>(absolute).m, extentX), _mm_mul_ps(splat<1>(absolute).m, extentY)),
+					_mm_mul_ps(splat<2>(absolute).m, extentZ));
+				outside = _mm_or_ps(outside, _mm_cmplt_ps(_mm_add_ps(distance, radius), _mm_setzero_ps()));
+			}
+
+			int mask = _mm_movemask_ps(outside);
+			for (int lane = 0; lane < 4; ++lane) {
+				visible[i + lane] = (mask >> lane) & 1 ? 0 : 1;
+			}
+		}
+
+		AabbArrays rest = { boxes.centerX + i, boxes.centerY + i, boxes.centerZ + i, boxes.extentX + i, boxes.extentY + i, boxes.extentZ + i };
+		cullAabbsScalar(frustum, rest, visible + i, count - i);
+	}
+#endif
+
+#if defined(WP_MATH_X86) && defined(WP_MATH_SSE)
+	static void cpuid(int leaf, int subleaf, unsigned int registers[4]) {
+#if defined(_MSC_VER)
+		__cpuidex(reinterpret_cast<int*>(registers), leaf, subleaf);
+#else
+		__cpuid_count(leaf, subleaf, registers[0], registers[1], registers[2], registers[3]);
+#endif
+	}
+
+	static uint64_t readXcr0() {
+#if defined(_MSC_VER)
+		return _xgetbv(0);
+#else
+		uint32_t low, high;
+		__asm__ volatile("xgetbv" : "=a"(low), "=d"(high) : "c"(0));
+		return (uint64_t(high) << 32) | low;
+#endif
+	}
+#endif
+
+	static SimdLevel detectSimdLevel() {
+#if defined(WP_MATH_X86) && defined(WP_MATH_SSE)
+		unsigned int registers[4];
+		cpuid(0, 0, registers);
+		if (registers[0] < 7) {
+			return SimdLevel::Sse2;
+		}
+
+		cpuid(1, 0, registers);
+		bool fma = registers[2] & (1u << 12);
+		bool osxsave = registers[2] & (1u << 27);
+		bool avx = registers[2] & (1u << 28);
+		// The operating system has to save the upper halves of the YMM registers on context switches
+		if (!fma || !osxsave || !avx || (readXcr0() & 0x6) != 0x6) {
+			return SimdLevel::Sse2;
+		}
+
+		cpuid(7, 0, registers);
+		bool avx2 = registers[1] & (1u << 5);
+		return avx2 ? SimdLevel::Avx2 : SimdLevel::Sse2;
+#elif defined(WP_MATH_SSE)
+		return SimdLevel::Sse2;
+#else
+		return SimdLevel::Scalar;
+#endif
+	}
+
+	SimdLevel getSupportedSimdLevel() {
+		static const SimdLevel s_Level = detectSimdLevel();
+		return s_Level;
+	}
+
+	const Kernels& getKernels(SimdLevel level) {
+		WP_ASSERTM(level <= getSupportedSimdLevel(), "SIMD level is not supported by this CPU");
+
+		static const Kernels s_ScalarKernels = { SimdLevel::Scalar, transformPointsScalar, multiplyMatricesScalar, cullAabbsScalar };
+#ifdef WP_MATH_SSE
+		static const Kernels s_SseKernels = { SimdLevel::Sse2, transformPointsSse, multiplyMatricesSse, cullAabbsSse };
+#endif
+
+		switch (level) {
+#if defined(WP_MATH_X86) && defined(WP_MATH_SSE)
+		case SimdLevel::Avx2: return getAvx2Kernels();
+#endif
+#ifdef WP_MATH_SSE
+		case SimdLevel::Sse2: return s_SseKernels;
+#endif
+		default: return s_ScalarKernels;
+		}
+	}
+
+	const Kernels& getKernels() {
+		static const Kernels& s_Kernels = getKernels(getSupportedSimdLevel());
+		return s_Kernels;
+	}
+}
\ No newline at end of file
@@ -0,0 +1,65 @@
+#pragma once
+#include "Frustum.h"
+#include "Mat4.h"
+
+#include <cstddef>
+#include <cstdint>
+
+namespace Warp::Math {
+
+	enum class SimdLevel {
+		Scalar,
+		Sse2,
+		// Includes FMA
+		Avx2
+	};
+
+	const char* toString(SimdLevel level);
+
+	// Boxes as six arrays of count floats each
+	struct AabbArrays {
+		const float* centerX;
+		const float* centerY;
+		const float* centerZ;
+		const float* extentX;
+		const float* extentY;
+		const float* extentZ;
+	};
+
+	// Batched transform and culling kernels of one instruction set. The point and box data is stored as structure
+	// of arrays, so every SIMD lane works on a different element and no shuffling is needed.
+	struct Kernels {
+		SimdLevel level;
+
+		// out = matrix * (x, y, z, 1) without the perspective divide, the outputs may be the inputs
+		void (*transformPoints)(const Mat4& matrix, const float* x, const float* y, const float* z,
+			float* outX, float* outY, float* outZ, size_t count);
+
+		// out[i] = a[i] * b[i], out may be a or b
+		void (*multiplyMatrices)(const Mat4* a, const Mat4* b, Mat4* out, size_t count);
+
+		// visible[i] is 1 if box i intersects the frustum, 0 otherwise. Conservative like Frustum::intersects.
+		void (*cullAabbs)(const Frustum& frustum, const AabbArrays& boxes, uint8_t* visible, size_t count);
+	};
+
+	// Best level the CPU and the operating system support, detected once
+	SimdLevel getSupportedSimdLevel();
+
+	// The kernels of a level up to getSupportedSimdLevel(), e.g. to compare against the scalar versions
+	const Kernels& getKernels(SimdLevel level);
+
+	// The kernels of the supported level, chosen on first use
+	const Kernels& getKernels();
+
+	inline void transformPoints(const Mat4& matrix, const float* x, const float* y, const float* z, float* outX, float* outY, float* outZ, size_t count) {
+		getKernels().transformPoints(matrix, x, y, z, outX, outY, outZ, count);
+	}
+
+	inline void multiplyMatrices(const Mat4* a, const Mat4* b, Mat4* out, size_t count) {
+		getKernels().multiplyMatrices(a, b, out, count);
+	}
+
+	inline void cullAabbs(const Frustum& frustum, const AabbArrays& boxes, uint8_t* visible, size_t count) {
+		getKernels().cullAabbs(frustum, boxes, visible, count);
+	}
+}
\ No newline at end of file
@@ -0,0 +1,98 @@
+#include "wppch.h"
+#include "Kernels.h"
+
+#if defined(WP_MATH_X86) && defined(WP_MATH_SSE)
+
+namespace Warp::Math {
+
+	// Everything in here is only reached through getKernels(SimdLevel::Avx2), after the CPU has been checked.
+	// The tails that do not fill a whole register are handled by the SSE2 kernels.
+
+	WP_MATH_TARGET_AVX2
+	static void transformPointsAvx2(const Mat4& matrix, const float* x, const float* y, const float* z,
+		float* outX, float* outY, float* outZ, size_t count) {
+		const float* m = matrix.data();
+		__m256 m0 = _mm256_set1_ps(m[0]), m1 = _mm256_set1_ps(m[1]), m2 = _mm256_set1_ps(m[2]);
+		__m256 m4 = _mm256_set1_ps(m[4]), m5 = _mm256_set1_ps(m[5]), m6 = _mm256_set1_ps(m[6]);
+		__m256 m8 = _mm256_set1_ps(m[8]), m9 = _mm256_set1_ps(m[9]), m10 = _mm256_set1_ps(m[10]);
+		__m256 m12 = _mm256_set1_ps(m[12]), m13 = _mm256_set1_ps(m[13]), m14 = _mm256_set1_ps(m[14]);
+
+		size_t i = 0;
+		for (; i + 8 <= count; i += 8) {
+			__m256 px = _mm256_loadu_ps(x + i), py = _mm256_loadu_ps(y + i), pz = _mm256_loadu_ps(z + i);
+			_mm256_storeu_ps(outX + i, _mm256_fmadd_ps(m0, px, _mm256_fmadd_ps(m4, py, _mm256_fmadd_ps(m8, pz, m12))));
+			_mm256_storeu_ps(outY + i, _mm256_fmadd_ps(m1, px, _mm256_fmadd_ps(m5, py, _mm256_fmadd_ps(m9, pz, m13))));
+			_mm256_storeu_ps(outZ + i, _mm256_fmadd_ps(m2, px, _mm256_fmadd_ps(m6, py, _mm256_fmadd_ps(m10, pz, m14))));
+		}
+		getKernels(SimdLevel::Sse2).transformPoints(matrix, x + i, y + i, z + i, outX + i, outY + i, outZ + i, count - i);
+	}
+
+	WP_MATH_TARGET_AVX2
+	static void multiplyMatricesAvx2(const Mat4* a, const Mat4* b, Mat4* out, size_t count) {
+		for (size_t i = 0; i < count; ++i) {
+			// Two result columns per register: every column of a is broadcast to both halves and multiplied with the
+			// matching element of two columns of b
+			const float* left = a[i].data();
+			__m256 a0 = _mm256_broadcast_ps(reinterpret_cast<const __m128*>(left));
+			__m256 a1 = _mm256_broadcast_ps(reinterpret_cast<const __m128*>(left + 4));
+			__m256 a2 = _mm256_broadcast_ps(reinterpret_cast<const __m128*>(left + 8));
+			__m256 a3 = _mm256_broadcast_ps(reinterpret_cast<const __m128*>(left + 12));
+
+			const float* right = b[i].data();
+			__m256 b01 = _mm256_loadu_ps(right);
+			__m256 b23 = _mm256_loadu_ps(right + 8);
+
+			__m256 r01 = _mm256_mul_ps(a0, _mm256_permute_ps(b01, _MM_SHUFFLE(0, 0, 0, 0)));
+			r01 = _mm256_fmadd_ps(a1, _mm256_permute_ps(b01, _MM_SHUFFLE(1, 1, 1, 1)), r01);
+			r01 = _mm256_fmadd_ps(a2, _mm256_permute_ps(b01, _MM_SHUFFLE(2, 2, 2, 2)), r01);
+			r01 = _mm256_fmadd_ps(a3, _mm256_permute_ps(b01, _MM_SHUFFLE(3, 3, 3, 3)), r01);
+
+			__m256 r23 = _mm256_mul_ps(a0, _mm256_permute_ps(b23, _MM_SHUFFLE(0, 0, 0, 0)));
+			r23 = _mm256_fmadd_ps(a1, _mm256_permute_ps(b23, _MM_SHUFFLE(1, 1, 1, 1)), r23);
+			r23 = _mm256_fmadd_ps(a2, _mm256_permute_ps(b23, _MM_SHUFFLE(2, 2, 2, 2)), r23);
+			r23 = _mm256_fmadd_ps(a3, _mm256_permute_ps(b23, _MM_SHUFFLE(3, 3, 3, 3)), r23);
+
+			float* destination = out[i].data();
+			_mm256_storeu_ps(destination, r01);
+			_mm256_storeu_ps(destination + 8, r23);
+		}
+	}
+
+	WP_MATH_TARGET_AVX2
+	static void cullAabbsAvx2(const Frustum& frustum, const AabbArrays& boxes, uint8_t* visible, size_t count) {
+		float planes[Frustum::PLANE_COUNT][4];
+		for (int plane = 0; plane < Frustum::PLANE_COUNT; ++plane) {
+			frustum.planes[plane].store(planes[plane]);
+		}
+
+		size_t i = 0;
+		for (; i + 8 <= count; i += 8) {
+			__m256 centerX = _mm256_loadu_ps(boxes.centerX + i), centerY = _mm256_loadu_ps(boxes.centerY + i), centerZ = _mm256_loadu_ps(boxes.centerZ + i);
+			__m256 extentX = _mm256_loadu_ps(boxes.extentX + i), extentY = _mm256_loadu_ps(boxes.extentY + i), extentZ = _mm256_loadu_ps(boxes.extentZ + i);
+
+			__m256 outside = _mm256_setzero_ps();
+			for (const float* p : planes) {
+				__m256 distance = _mm256_fmadd_ps(_mm256_set1_ps(p[0]), centerX,
+					_mm256_fmadd_ps(_mm256_set1_ps(p[1]), centerY, _mm256_fmadd_ps(_mm256_set1_ps(p[2]), centerZ, _mm256_set1_ps(p[3]))));
+				__m256 radius = _mm256_fmadd_ps(_mm256_set1_ps(std::fabs(p[0])), extentX,
+					_mm256_fmadd_ps(_mm256_set1_ps(std::fabs(p[1])), extentY, _mm256_mul_ps(_mm256_set1_ps(std::fabs(p[2])), extentZ)));
+				outside = _mm256_or_ps(outside, _mm256_cmp_ps(_mm256_add_ps(distance, radius), _mm256_setzero_ps(), _CMP_LT_OQ));
+			}
+
+			int mask = _mm256_movemask_ps(outside);
+			for (int lane = 0; lane < 8; ++lane) {
+				visible[i + lane] = (mask >> lane) & 1 ? 0 : 1;
+			}
+		}
+
+		AabbArrays rest = { boxes.centerX + i, boxes.centerY + i, boxes.centerZ + i, boxes.extentX + i, boxes.extentY + i, boxes.extentZ + i };
+		getKernels(SimdLevel::Sse2).cullAabbs(frustum, rest, visible + i, count - i);
+	}
+
+	const Kernels& getAvx2Kernels() {
+		static const Kernels s_Kernels = { SimdLevel::Avx2, transformPointsAvx2, multiplyMatricesAvx2, cullAabbsAvx2 };
+		return s_Kernels;
+	}
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,107 @@
+#pragma once
+#include "Quat.h"
+#include "Vec.h"
+
+namespace Warp::Math {
+
+	// Column major, columns[3] holds the translation. 16 contiguous floats in both the SSE and the scalar build.
+	struct alignas(16) Mat4 {
+		Vec4 columns[4];
+
+		// Zero, use identity() for the neutral transform
+		Mat4() = default;
+		Mat4(const Vec4& c0, const Vec4& c1, const Vec4& c2, const Vec4& c3) : columns{ c0, c1, c2, c3 } {}
+
+		static Mat4 identity() {
+			return { { 1.0f, 0.0f, 0.0f, 0.0f }, { 0.0f, 1.0f, 0.0f, 0.0f }, { 0.0f, 0.0f, 1.0f, 0.0f }, { 0.0f, 0.0f, 0.0f, 1.0f } };
+		}
+
+		static Mat4 translation(const Vec3& offset) {
+			Mat4 result = identity();
+			result.columns[3] = Vec4(offset, 1.0f);
+			return result;
+		}
+
+		static Mat4 scale(const Vec3& factors) {
+			return { { factors.x, 0.0f, 0.0f, 0.0f }, { 0.0f, factors.y, 0.0f, 0.0f }, { 0.0f, 0.0f, factors.z, 0.0f }, { 0.0f, 0.0f, 0.0f, 1.0f } };
+		}
+
+		// The rotation of a unit quaternion
+		static Mat4 rotation(const Quat& q) {
+			float x = q.x(), y = q.y(), z = q.z(), w = q.w();
+			return {
+				{ 1.0f - 2.0f * (y * y + z * z), 2.0f * (x * y + w * z), 2.0f * (x * z - w * y), 0.0f },
+				{ 2.0f * (x * y - w * z), 1.0f - 2.0f * (x * x + z * z), 2.0f * (y * z + w * x), 0.0f },
+				{ 2.0f * (x * z + w * y), 2.0f * (y * z - w * x), 1.0f - 2.0f * (x * x + y * y), 0.0f },
+				{ 0.0f, 0.0f, 0.0f, 1.0f }
+			};
+		}
+
+		// Translation * rotation * scale
+		static Mat4 transform(const Vec3& position, const Quat& orientation, const Vec3& factors) {
+			Mat4 result = rotation(orientation);
+			result.columns[0] *= factors.x;
+			result.columns[1] *= factors.y;
+			result.columns[2] *= factors.z;
+			result.columns[3] = Vec4(position, 1.0f);
+			return result;
+		}
+
+		// Right handed view space looking down -z, Vulkan clip space with y pointing down and depth from 0 to 1
+		static Mat4 perspective(float fovY, float aspect, float nearPlane, float farPlane) {
+			float focal = 1.0f / std::tan(fovY * 0.5f);
+			float depth = farPlane / (nearPlane - farPlane);
+			return {
+				{ focal / aspect, 0.0f, 0.0f, 0.0f },
+				{ 0.0f, -focal, 0.0f, 0.0f },
+				{ 0.0f, 0.0f, depth, -1.0f },
+				{ 0.0f, 0.0f, nearPlane * depth, 0.0f }
+			};
+		}
+
+		static Mat4 lookAt(const Vec3& eye, const Vec3& target, const Vec3& up) {
+			Vec3 forward = normalize(target - eye);
+			Vec3 right = normalize(cross(forward, up));
+			Vec3 trueUp = cross(right, forward);
+			return {
+				{ right.x, trueUp.x, -forward.x, 0.0f },
+				{ right.y, trueUp.y, -forward.y, 0.0f },
+				{ right.z, trueUp.z, -forward.z, 0.0f },
+				{ -dot(right, eye), -dot(trueUp, eye), dot(forward, eye), 1.0f }
+			};
+		}
+
+		const float* data() const { return reinterpret_cast<const float*>(columns); }
+
+		float* data() { return reinterpret_cast<float*>(columns); }
+
+		Vec4 operator*(const Vec4& v) const {
+			return columns[0] * splat<0>(v) + columns[1] * splat<1>(v) + columns[2] * splat<2>(v) + columns[3] * splat<3>(v);
+		}
+
+		Mat4 operator*(const Mat4& other) const {
+			return { *this * other.columns[0], *this * other.columns[1], *this * other.columns[2], *this * other.columns[3] };
+		}
+
+		Mat4& operator*=(const Mat4& other) { return *this = *this * other; }
+
+		Vec3 transformPoint(const Vec3& point) const {
+			return (columns[0] * point.x + columns[1] * point.y + columns[2] * point.z + columns[3]).xyz();
+		}
+
+		Vec3 transformVector(const Vec3& vector) const {
+			return (columns[0] * vector.x + columns[1] * vector.y + columns[2] * vector.z).xyz();
+		}
+	};
+
+	inline Mat4 transpose(const Mat4& m) {
+#ifdef WP_MATH_SSE
+		__m128 c0 = m.columns[0].m, c1 = m.columns[1].m, c2 = m.columns[2].m, c3 = m.columns[3].m;
+		_MM_TRANSPOSE4_PS(c0, c1, c2, c3);
+		return { Vec4(c0), Vec4(c1), Vec4(c2), Vec4(c3) };
+#else
+		const float* d = m.data();
+		return { { d[0], d[4], d[8], d[12] }, { d[1], d[5], d[9], d[13] }, { d[2], d[6], d[10], d[14] }, { d[3], d[7], d[11], d[15] } };
+#endif
+	}
+}
\ No newline at end of file
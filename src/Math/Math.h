@@ -0,0 +1,6 @@
+#pragma once
+#include "Frustum.h"
+#include "Kernels.h"
+#include "Mat4.h"
+#include "Quat.h"
+#include "Vec.h"
\ No newline at end of file
@@ -0,0 +1,54 @@
+#pragma once
+#include "Vec.h"
+
+namespace Warp::Math {
+
+	// Rotation as a unit quaternion, x, y, z is the vector part
+	struct Quat {
+		Vec4 v;
+
+		Quat() : v(0.0f, 0.0f, 0.0f, 1.0f) {}
+		explicit Quat(const Vec4& v) : v(v) {}
+		Quat(float x, float y, float z, float w) : v(x, y, z, w) {}
+
+		static Quat identity() { return Quat(); }
+
+		// Counter clockwise around the normalized axis when looking against it
+		static Quat fromAxisAngle(const Vec3& axis, float radians) {
+			float halfSin = std::sin(radians * 0.5f);
+			return Quat(axis.x * halfSin, axis.y * halfSin, axis.z * halfSin, std::cos(radians * 0.5f));
+		}
+
+		float x() const { return v.x(); }
+		float y() const { return v.y(); }
+		float z() const { return v.z(); }
+		float w() const { return v.w(); }
+
+		// Applies other first, then this
+		Quat operator*(const Quat& other) const {
+			// Hamilton product as four broadcasts of this times sign flipped shuffles of other
+			const Vec4& q = other.v;
+			Vec4 result = splat<3>(v) * q;
+			result += splat<0>(v) * shuffle<3, 2, 1, 0>(q) * Vec4(1.0f, -1.0f, 1.0f, -1.0f);
+			result += splat<1>(v) * shuffle<2, 3, 0, 1>(q) * Vec4(1.0f, 1.0f, -1.0f, -1.0f);
+			result += splat<2>(v) * shuffle<1, 0, 3, 2>(q) * Vec4(-1.0f, 1.0f, 1.0f, -1.0f);
+			return Quat(result);
+		}
+
+		Quat& operator*=(const Quat& other) { return *this = *this * other; }
+	};
+
+	inline Quat conjugate(const Quat& q) {
+		return Quat(q.v * Vec4(-1.0f, -1.0f, -1.0f, 1.0f));
+	}
+
+	inline Quat normalize(const Quat& q) {
+		return Quat(normalize(q.v));
+	}
+
+	inline Vec3 rotate(const Quat& q, const Vec3& v) {
+		Vec3 axis = q.v.xyz();
+		Vec3 t = cross(axis, v) * 2.0f;
+		return v + t * q.w() + cross(axis, t);
+	}
+}
\ No newline at end of file
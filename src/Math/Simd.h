@@ -0,0 +1,21 @@
+#pragma once
+
+// Compile time choice of the vector types. x64 always has SSE2, which is all the types use, so they are vectorized on
+// every x64 build. Define WP_MATH_SCALAR to force the portable fallback, which other architectures get anyway.
+// Wider instruction sets are only used by the batched kernels, which pick them at runtime, see Kernels.h.
+#if !defined(WP_MATH_SCALAR) && (defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+#define WP_MATH_SSE
+#include <immintrin.h>
+#endif
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+#define WP_MATH_X86
+#endif
+
+// Functions compiled for AVX2 and FMA regardless of the compiler flags, they may only be called after checking the CPU.
+// MSVC accepts the intrinsics without a flag.
+#if defined(WP_MATH_X86) && (defined(__GNUC__) || defined(__clang__))
+#define WP_MATH_TARGET_AVX2 __attribute__((target("avx2,fma")))
+#else
+#define WP_MATH_TARGET_AVX2
+#endif
\ No newline at end of file
@@ -0,0 +1,160 @@
+#pragma once
+#include "Simd.h"
+
+#include <cmath>
+
+namespace Warp::Math {
+
+	// Storage type for positions and directions, math on it is scalar. Convert to Vec4 for vectorized work.
+	struct Vec3 {
+		float x = 0.0f, y = 0.0f, z = 0.0f;
+
+		Vec3() = default;
+		Vec3(float x, float y, float z) : x(x), y(y), z(z) {}
+		explicit Vec3(float value) : x(value), y(value), z(value) {}
+
+		Vec3 operator+(const Vec3& other) const { return { x + other.x, y + other.y, z + other.z }; }
+		Vec3 operator-(const Vec3& other) const { return { x - other.x, y - other.y, z - other.z }; }
+		Vec3 operator*(const Vec3& other) const { return { x * other.x, y * other.y, z * other.z }; }
+		Vec3 operator*(float scale) const { return { x * scale, y * scale, z * scale }; }
+		Vec3 operator/(float scale) const { return *this * (1.0f / scale); }
+		Vec3 operator-() const { return { -x, -y, -z }; }
+
+		Vec3& operator+=(const Vec3& other) { return *this = *this + other; }
+		Vec3& operator-=(const Vec3& other) { return *this = *this - other; }
+		Vec3& operator*=(float scale) { return *this = *this * scale; }
+	};
+
+	inline float dot(const Vec3& a, const Vec3& b) {
+		return a.x * b.x + a.y * b.y + a.z * b.z;
+	}
+
+	inline Vec3 cross(const Vec3& a, const Vec3& b) {
+		return { a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x };
+	}
+
+	inline float length(const Vec3& v) {
+		return std::sqrt(dot(v, v));
+	}
+
+	inline Vec3 normalize(const Vec3& v) {
+		return v / length(v);
+	}
+
+	// Four floats in one SSE register, or a plain array with the scalar fallback
+	struct alignas(16) Vec4 {
+#ifdef WP_MATH_SSE
+		__m128 m;
+
+		Vec4() : m(_mm_setzero_ps()) {}
+		explicit Vec4(__m128 m) : m(m) {}
+		Vec4(float x, float y, float z, float w) : m(_mm_setr_ps(x, y, z, w)) {}
+		explicit Vec4(float value) : m(_mm_set1_ps(value)) {}
+
+		static Vec4 load(const float* values) { return Vec4(_mm_loadu_ps(values)); }
+
+		void store(float* values) const { _mm_storeu_ps(values, m); }
+
+		float x() const { return _mm_cvtss_f32(m); }
+		float y() const { return _mm_cvtss_f32(_mm_shuffle_ps(m, m, _MM_SHUFFLE(1, 1, 1, 1))); }
+		float z() const { return _mm_cvtss_f32(_mm_movehl_ps(m, m)); }
+		float w() const { return _mm_cvtss_f32(_mm_shuffle_ps(m, m, _MM_SHUFFLE(3, 3, 3, 3))); }
+
+		Vec4 operator+(const Vec4& other) const { return Vec4(_mm_add_ps(m, other.m)); }
+		Vec4 operator-(const Vec4& other) const { return Vec4(_mm_sub_ps(m, other.m)); }
+		Vec4 operator*(const Vec4& other) const { return Vec4(_mm_mul_ps(m, other.m)); }
+		Vec4 operator/(const Vec4& other) const { return Vec4(_mm_div_ps(m, other.m)); }
+		Vec4 operator*(float scale) const { return Vec4(_mm_mul_ps(m, _mm_set1_ps(scale))); }
+		Vec4 operator-() const { return Vec4(_mm_sub_ps(_mm_setzero_ps(), m)); }
+#else
+		float v[4];
+
+		Vec4() : v{ 0.0f, 0.0f, 0.0f, 0.0f } {}
+		Vec4(float x, float y, float z, float w) : v{ x, y, z, w } {}
+		explicit Vec4(float value) : v{ value, value, value, value } {}
+
+		static Vec4 load(const float* values) { return Vec4(values[0], values[1], values[2], values[3]); }
+
+		void store(float* values) const { for (int i = 0; i < 4; ++i) values[i] = v[i]; }
+
+		float x() const { return v[0]; }
+		float y() const { return v[1]; }
+		float z() const { return v[2]; }
+		float w() const { return v[3]; }
+
+		Vec4 operator+(const Vec4& o) const { return { v[0] + o.v[0], v[1] + o.v[1], v[2] + o.v[2], v[3] + o.v[3] }; }
+		Vec4 operator-(const Vec4& o) const { return { v[0] - o.v[0], v[1] - o.v[1], v[2] - o.v[2], v[3] - o.v[3] }; }
+		Vec4 operator*(const Vec4& o) const { return { v[0] * o.v[0], v[1] * o.v[1], v[2] * o.v[2], v[3] * o.v[3] }; }
+		Vec4 operator/(const Vec4& o) const { return { v[0] / o.v[0], v[1] / o.v[1], v[2] / o.v[2], v[3] / o.v[3] }; }
+		Vec4 operator*(float scale) const { return { v[0] * scale, v[1] * scale, v[2] * scale, v[3] * scale }; }
+		Vec4 operator-() const { return { -v[0], -v[1], -v[2], -v[3] }; }
+#endif
+
+		Vec4(const Vec3& xyz, float w) : Vec4(xyz.x, xyz.y, xyz.z, w) {}
+
+		Vec3 xyz() const { return { x(), y(), z() }; }
+
+		Vec4& operator+=(const Vec4& other) { return *this = *this + other; }
+		Vec4& operator-=(const Vec4& other) { return *this = *this - other; }
+		Vec4& operator*=(const Vec4& other) { return *this = *this * other; }
+		Vec4& operator*=(float scale) { return *this = *this * scale; }
+	};
+
+	// Component i0, i1, i2, i3 of v, e.g. shuffle<3, 3, 3, 3>(v) broadcasts w
+	template<int i0, int i1, int i2, int i3>
+	inline Vec4 shuffle(const Vec4& v) {
+#ifdef WP_MATH_SSE
+		return Vec4(_mm_shuffle_ps(v.m, v.m, _MM_SHUFFLE(i3, i2, i1, i0)));
+#else
+		return Vec4(v.v[i0], v.v[i1], v.v[i2], v.v[i3]);
+#endif
+	}
+
+	template<int i>
+	inline Vec4 splat(const Vec4& v) {
+		return shuffle<i, i, i, i>(v);
+	}
+
+	inline Vec4 min(const Vec4& a, const Vec4& b) {
+#ifdef WP_MATH_SSE
+		return Vec4(_mm_min_ps(a.m, b.m));
+#else
+		return { std::fmin(a.v[0], b.v[0]), std::fmin(a.v[1], b.v[1]), std::fmin(a.v[2], b.v[2]), std::fmin(a.v[3], b.v[3]) };
+#endif
+	}
+
+	inline Vec4 max(const Vec4& a, const Vec4& b) {
+#ifdef WP_MATH_SSE
+		return Vec4(_mm_max_ps(a.m, b.m));
+#else
+		return { std::fmax(a.v[0], b.v[0]), std::fmax(a.v[1], b.v[1]), std::fmax(a.v[2], b.v[2]), std::fmax(a.v[3], b.v[3]) };
+#endif
+	}
+
+	inline Vec4 abs(const Vec4& v) {
+#ifdef WP_MATH_SSE
+		return Vec4(_mm_andnot_ps(_mm_set1_ps(-0.0f), v.m));
+#else
+		return { std::fabs(v.v[0]), std::fabs(v.v[1]), std::fabs(v.v[2]), std::fabs(v.v[3]) };
+#endif
+	}
+
+	inline float dot(const Vec4& a, const Vec4& b) {
+#ifdef WP_MATH_SSE
+		__m128 products = _mm_mul_ps(a.m, b.m);
+		__m128 sums = _mm_add_ps(products, _mm_shuffle_ps(products, products, _MM_SHUFFLE(2, 3, 0, 1)));
+		sums = _mm_add_ps(sums, _mm_movehl_ps(sums, sums));
+		return _mm_cvtss_f32(sums);
+#else
+		return a.v[0] * b.v[0] + a.v[1] * b.v[1] + a.v[2] * b.v[2] + a.v[3] * b.v[3];
+#endif
+	}
+
+	inline float length(const Vec4& v) {
+		return std::sqrt(dot(v, v));
+	}
+
+	inline Vec4 normalize(const Vec4& v) {
+		return v * (1.0f / length(v));
+	}
+}
\ No newline at end of file
@@ -0,0 +1,15 @@
+#include "wppch.h"
+#include "FrameAllocator.h"
+
+namespace Warp {
+
+	FrameAllocator::FrameAllocator(size_t capacityPerFrame) {
+		m_arenas[0] = CreateScopedRef<LinearAllocator>(capacityPerFrame);
+		m_arenas[1] = CreateScopedRef<LinearAllocator>(capacityPerFrame);
+	}
+
+	void FrameAllocator::beginFrame() {
+		m_current ^= 1;
+		m_arenas[m_current]->reset();
+	}
+}
@@ -0,0 +1,32 @@
+#pragma once
+#include "LinearAllocator.h"
+
+namespace Warp {
+
+	// Two linear arenas that swap every frame. Memory from the previous frame stays valid for one more frame,
+	// so data can be handed to work that is still in flight, e.g. on the GPU or in jobs that span frames.
+	class FrameAllocator {
+
+	public:
+		explicit FrameAllocator(size_t capacityPerFrame);
+
+		// Swaps the arenas and resets the one that becomes current, O(1)
+		void beginFrame();
+
+		void* allocate(size_t size, size_t alignment = alignof(std::max_align_t)) { return getCurrent().allocate(size, alignment); }
+
+		void deallocate(void*, size_t, size_t = alignof(std::max_align_t)) {}
+
+		// Uninitialized storage for count objects of type T
+		template<class T>
+		T* allocateArray(size_t count) { return static_cast<T*>(allocate(sizeof(T) * count, alignof(T))); }
+
+		LinearAllocator& getCurrent() { return *m_arenas[m_current]; }
+
+		LinearAllocator& getPrevious() { return *m_arenas[m_current ^ 1]; }
+
+	private:
+		ScopedRef<LinearAllocator> m_arenas[2];
+		uint32_t m_current = 0;
+	};
+}
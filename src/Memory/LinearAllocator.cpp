@@ -0,0 +1,34 @@
+#include "wppch.h"
+#include "LinearAllocator.h"
+
+namespace Warp {
+
+	// Cache line alignment for the block itself, so arenas don't share lines with unrelated data
+	constexpr size_t ARENA_ALIGNMENT = 64;
+
+	LinearAllocator::LinearAllocator(size_t capacity)
+		: m_memory(static_cast<std::byte*>(::operator new(capacity, std::align_val_t(ARENA_ALIGNMENT)))), m_capacity(capacity) {
+	}
+
+	LinearAllocator::~LinearAllocator() {
+		::operator delete(m_memory, std::align_val_t(ARENA_ALIGNMENT));
+	}
+
+	void* LinearAllocator::allocate(size_t size, size_t alignment) {
+		WP_ASSERTM((alignment & (alignment - 1)) == 0, "Alignment has to be a power of two");
+
+		size_t offset = m_offset.load(std::memory_order_relaxed);
+		size_t alignedOffset;
+		do {
+			uintptr_t address = reinterpret_cast<uintptr_t>(m_memory) + offset;
+			alignedOffset = offset + ((alignment - (address & (alignment - 1))) & (alignment - 1));
+
+			if (alignedOffset + size > m_capacity) {
+				WP_ASSERTM(false, "LinearAllocator is out of memory");
+				return nullptr;
+			}
+		} while (!m_offset.compare_exchange_weak(offset, alignedOffset + size, std::memory_order_relaxed));
+
+		return m_memory + alignedOffset;
+	}
+}
@@ -0,0 +1,39 @@
+#pragma once
+#include "Core/Base.h"
+
+#include <atomic>
+#include <cstddef>
+
+namespace Warp {
+
+	// Bump allocator over one fixed block. Individual frees are no-ops, reset releases everything at once.
+	// Allocation is lock-free, so jobs on any worker can share an arena.
+	class LinearAllocator {
+
+	public:
+		explicit LinearAllocator(size_t capacity);
+		~LinearAllocator();
+
+		LinearAllocator(const LinearAllocator&) = delete;
+		LinearAllocator& operator=(const LinearAllocator&) = delete;
+
+		// Returns nullptr when the arena is exhausted
+		void* allocate(size_t size, size_t alignment = alignof(std::max_align_t));
+
+		void deallocate(void*, size_t, size_t = alignof(std::max_align_t)) {}
+
+		// Objects allocated before are not destroyed, only their memory is handed out again
+		void reset() { m_offset.store(0, std::memory_order_relaxed); }
+
+		bool owns(const void* pointer) const { return pointer >= m_memory && pointer < m_memory + m_capacity; }
+
+		size_t getUsed() const { return m_offset.load(std::memory_order_relaxed); }
+
+		size_t getCapacity() const { return m_capacity; }
+
+	private:
+		std::byte* m_memory;
+		size_t m_capacity;
+		std::atomic<size_t> m_offset{ 0 };
+	};
+}
@@ -0,0 +1,116 @@
+#pragma once
+#include "Core/Base.h"
+#include "Core/Assert.h"
+#include "FrameAllocator.h"
+#include "LinearAllocator.h"
+#include "PoolAllocator.h"
+
+#include <memory>
+#include <type_traits>
+
+namespace Warp {
+
+	// Engine allocators provide allocate(size, alignment) and deallocate(pointer, size, alignment).
+	// These adapters hold a pointer to the allocator, it has to outlive everything allocated from it.
+
+	template<class T, class Allocator>
+	class StlAllocator {
+
+	public:
+		using value_type = T;
+
+		explicit StlAllocator(Allocator& allocator) : m_allocator(&allocator) {}
+
+		template<class U>
+		StlAllocator(const StlAllocator<U, Allocator>& other) : m_allocator(other.getAllocator()) {}
+
+		T* allocate(size_t count) { return static_cast<T*>(m_allocator->allocate(sizeof(T) * count, alignof(T))); }
+
+		void deallocate(T* pointer, size_t count) { m_allocator->deallocate(pointer, sizeof(T) * count, alignof(T)); }
+
+		Allocator* getAllocator() const { return m_allocator; }
+
+		template<class U>
+		bool operator==(const StlAllocator<U, Allocator>& other) const { return m_allocator == other.getAllocator(); }
+
+		template<class U>
+		bool operator!=(const StlAllocator<U, Allocator>& other) const { return m_allocator != other.getAllocator(); }
+
+	private:
+		Allocator* m_allocator;
+	};
+
+	template<class T, class Allocator>
+	class AllocatorDeleter {
+
+	public:
+		AllocatorDeleter() = default;
+
+		explicit AllocatorDeleter(Allocator& allocator) : m_allocator(&allocator), m_size(sizeof(T)), m_alignment(alignof(T)) {}
+
+		// Allows converting to a ScopedRef of a base class, the original size is kept for deallocation
+		template<class U, class = std::enable_if_t<std::is_convertible_v<U*, T*>>>
+		AllocatorDeleter(const AllocatorDeleter<U, Allocator>& other)
+			: m_allocator(other.getAllocator()), m_size(other.getSize()), m_alignment(other.getAlignment()) {}
+
+		void operator()(T* pointer) const {
+			pointer->~T();
+			m_allocator->deallocate(pointer, m_size, m_alignment);
+		}
+
+		Allocator* getAllocator() const { return m_allocator; }
+
+		size_t getSize() const { return m_size; }
+
+		size_t getAlignment() const { return m_alignment; }
+
+	private:
+		Allocator* m_allocator = nullptr;
+		size_t m_size = 0;
+		size_t m_alignment = 0;
+	};
+
+	template<class T, class Allocator>
+	using AllocatedScopedRef = ScopedRef<T, AllocatorDeleter<T, Allocator>>;
+
+	template<class T, class Allocator, class ... args>
+	AllocatedScopedRef<T, Allocator> CreateScopedRef(std::allocator_arg_t, Allocator& allocator, args&&... values) {
+		void* memory = allocator.allocate(sizeof(T), alignof(T));
+		WP_ASSERTM(memory, "Allocator returned no memory");
+		return AllocatedScopedRef<T, Allocator>(new (memory) T(std::forward<args>(values)...), AllocatorDeleter<T, Allocator>(allocator));
+	}
+
+	// Ref counted object that returns its memory to the allocator it came from
+	template<class T, class Allocator>
+	class AllocatedRefCounted final : public T {
+
+	public:
+		template<class ... args>
+		AllocatedRefCounted(Allocator& allocator, args&&... values) : T(std::forward<args>(values)...), m_allocator(&allocator) {}
+
+	protected:
+		void destroy() override {
+			Allocator* allocator = m_allocator;
+			this->~AllocatedRefCounted();
+			allocator->deallocate(this, sizeof(AllocatedRefCounted), alignof(AllocatedRefCounted));
+		}
+
+	private:
+		Allocator* m_allocator;
+	};
+
+	// The control block is placed in the same allocation as the object
+	template<class T, class Allocator, class ... args>
+	CountedRef<T> CreateCountedRef(std::allocator_arg_t, Allocator& allocator, args&&... values) {
+		return std::allocate_shared<T>(StlAllocator<T, Allocator>(allocator), std::forward<args>(values)...);
+	}
+
+	template<class T, class Allocator, class ... args>
+	IntrusiveRef<T> CreateIntrusiveRef(std::allocator_arg_t, Allocator& allocator, args&&... values) {
+		static_assert(IS_REF_COUNTED<T>, "IntrusiveRef needs a type deriving from RefCounted or LocalRefCounted");
+		using Object = AllocatedRefCounted<T, Allocator>;
+		void* memory = allocator.allocate(sizeof(Object), alignof(Object));
+		WP_ASSERTM(memory, "Allocator returned no memory");
+		return IntrusiveRef<T>(new (memory) Object(allocator, std::forward<args>(values)...));
+	}
+}
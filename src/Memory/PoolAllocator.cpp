@@ -0,0 +1,146 @@
+#include "wppch.h"
+#include "PoolAllocator.h"
+
+#include <array>
+#include <thread>
+
+namespace Warp {
+
+	constexpr size_t SIZE_CLASS_COUNT = 6;
+	constexpr size_t SIZE_CLASSES[SIZE_CLASS_COUNT] = { 16, 32, 64, 128, 256, PoolAllocator::MAX_POOLED_SIZE };
+
+	static size_t getSizeClass(size_t size) {
+		size_t sizeClass = 0;
+		while (SIZE_CLASSES[sizeClass] < size) {
+			++sizeClass;
+		}
+		return sizeClass;
+	}
+
+	// Blocks start after the chunk header, rounded up to the block size so power of two blocks stay naturally aligned
+	static size_t getFirstBlockOffset(size_t blockSize) {
+		size_t headerSize = 2 * sizeof(void*);
+		return (headerSize + blockSize - 1) / blockSize * blockSize;
+	}
+
+	FixedSizePool::FixedSizePool(size_t blockSize)
+		: m_blockSize(blockSize < sizeof(FreeBlock) ? sizeof(FreeBlock) : blockSize), m_ownerThread(std::this_thread::get_id()) {
+		WP_ASSERTM(m_blockSize <= CHUNK_SIZE / 4, "Block size too large for a pool chunk");
+	}
+
+	FixedSizePool::~FixedSizePool() {
+		WP_ASSERTM(getLiveBlocks() == 0, "FixedSizePool destroyed while blocks are still in use");
+
+		while (m_chunks) {
+			ChunkHeader* next = m_chunks->next;
+			::operator delete(m_chunks, std::align_val_t(CHUNK_SIZE));
+			m_chunks = next;
+		}
+	}
+
+	void* FixedSizePool::allocate() {
+		WP_ASSERTM(std::this_thread::get_id() == m_ownerThread, "FixedSizePool can only allocate on its own thread");
+
+		if (!m_freeList) {
+			// Reclaim everything other threads freed in one go
+			m_freeList = m_remoteFreeList.exchange(nullptr, std::memory_order_acquire);
+		}
+		if (!m_freeList) {
+			allocateChunk();
+		}
+
+		FreeBlock* block = m_freeList;
+		m_freeList = block->next;
+		m_liveBlocks.fetch_add(1, std::memory_order_relaxed);
+		return block;
+	}
+
+	void FixedSizePool::deallocate(void* pointer) {
+		if (!pointer) {
+			return;
+		}
+
+		FixedSizePool* pool = getOwner(pointer);
+		auto* block = static_cast<FreeBlock*>(pointer);
+
+		if (std::this_thread::get_id() == pool->m_ownerThread) {
+			block->next = pool->m_freeList;
+			pool->m_freeList = block;
+		}
+		else {
+			FreeBlock* head = pool->m_remoteFreeList.load(std::memory_order_relaxed);
+			do {
+				block->next = head;
+			} while (!pool->m_remoteFreeList.compare_exchange_weak(head, block, std::memory_order_release, std::memory_order_relaxed));
+		}
+		pool->m_liveBlocks.fetch_sub(1, std::memory_order_relaxed);
+	}
+
+	FixedSizePool* FixedSizePool::getOwner(const void* pointer) {
+		auto chunk = reinterpret_cast<uintptr_t>(pointer) & ~(uintptr_t(CHUNK_SIZE) - 1);
+		return reinterpret_cast<const ChunkHeader*>(chunk)->owner;
+	}
+
+	void FixedSizePool::allocateChunk() {
+		auto* memory = static_cast<std::byte*>(::operator new(CHUNK_SIZE, std::align_val_t(CHUNK_SIZE)));
+
+		auto* chunk = reinterpret_cast<ChunkHeader*>(memory);
+		chunk->owner = this;
+		chunk->next = m_chunks;
+		m_chunks = chunk;
+		++m_chunkCount;
+
+		// Thread the free list through the chunk back to front, so blocks are handed out in address order
+		for (size_t offset = CHUNK_SIZE - m_blockSize; offset >= getFirstBlockOffset(m_blockSize); offset -= m_blockSize) {
+			auto* block = reinterpret_cast<FreeBlock*>(memory + offset);
+			block->next = m_freeList;
+			m_freeList = block;
+		}
+	}
+
+	// The size class pools of one thread. If blocks are still alive when the thread exits, for example objects
+	// handed to another thread, the pool is leaked so those blocks can still be freed safely.
+	struct ThreadPools {
+		std::array<FixedSizePool*, SIZE_CLASS_COUNT> pools{};
+
+		~ThreadPools() {
+			for (FixedSizePool* pool : pools) {
+				if (pool && pool->getLiveBlocks() == 0) {
+					delete pool;
+				}
+			}
+		}
+
+		FixedSizePool& getPool(size_t sizeClass) {
+			if (!pools[sizeClass]) {
+				pools[sizeClass] = new FixedSizePool(SIZE_CLASSES[sizeClass]);
+			}
+			return *pools[sizeClass];
+		}
+	};
+
+	static thread_local ThreadPools s_ThreadPools;
+
+	PoolAllocator& PoolAllocator::get() {
+		static PoolAllocator s_Instance;
+		return s_Instance;
+	}
+
+	void* PoolAllocator::allocate(size_t size, size_t alignment) {
+		// Pool blocks are aligned to their power of two size class
+		size_t blockSize = size > alignment ? size : alignment;
+		if (blockSize > MAX_POOLED_SIZE) {
+			return ::operator new(size, std::align_val_t(alignment));
+		}
+		return s_ThreadPools.getPool(getSizeClass(blockSize)).allocate();
+	}
+
+	void PoolAllocator::deallocate(void* pointer, size_t size, size_t alignment) {
+		size_t blockSize = size > alignment ? size : alignment;
+		if (blockSize > MAX_POOLED_SIZE) {
+			::operator delete(pointer, std::align_val_t(alignment));
+			return;
+		}
+		FixedSizePool::deallocate(pointer);
+	}
+}
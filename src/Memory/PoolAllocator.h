@@ -0,0 +1,76 @@
+#pragma once
+#include "Core/Base.h"
+
+#include <atomic>
+#include <cstddef>
+#include <thread>
+
+namespace Warp {
+
+	// Fixed-size blocks carved out of 64 KB chunks. Chunks are aligned to their size, so the pool owning a block
+	// can be found from the block address alone. Only the owning thread allocates; a block freed on another
+	// thread goes onto a lock-free list that the owner reclaims on its next allocation.
+	class FixedSizePool {
+
+	public:
+		static constexpr size_t CHUNK_SIZE = 64 * 1024;
+
+		explicit FixedSizePool(size_t blockSize);
+		~FixedSizePool();
+
+		FixedSizePool(const FixedSizePool&) = delete;
+		FixedSizePool& operator=(const FixedSizePool&) = delete;
+
+		void* allocate();
+
+		// Frees a block of any pool, from any thread
+		static void deallocate(void* pointer);
+
+		static FixedSizePool* getOwner(const void* pointer);
+
+		size_t getBlockSize() const { return m_blockSize; }
+
+		int64_t getLiveBlocks() const { return m_liveBlocks.load(std::memory_order_relaxed); }
+
+		size_t getChunkCount() const { return m_chunkCount; }
+
+		// The thread the pool belongs to
+		std::thread::id getOwnerThread() const { return m_ownerThread; }
+
+	private:
+		struct FreeBlock {
+			FreeBlock* next;
+		};
+
+		struct ChunkHeader {
+			FixedSizePool* owner;
+			ChunkHeader* next;
+		};
+
+		void allocateChunk();
+
+		size_t m_blockSize;
+		std::thread::id m_ownerThread;
+
+		FreeBlock* m_freeList = nullptr;
+		ChunkHeader* m_chunks = nullptr;
+		size_t m_chunkCount = 0;
+		std::atomic<int64_t> m_liveBlocks{ 0 };
+
+		alignas(64) std::atomic<FreeBlock*> m_remoteFreeList{ nullptr };
+	};
+
+	// Thread-local fixed-size pools for small objects, one per size class. Larger requests go to the global heap.
+	class PoolAllocator {
+
+	public:
+		static constexpr size_t MAX_POOLED_SIZE = 512;
+
+		static PoolAllocator& get();
+
+		void* allocate(size_t size, size_t alignment = alignof(std::max_align_t));
+
+		// size and alignment have to match the allocate call
+		void deallocate(void* pointer, size_t size, size_t alignment = alignof(std::max_align_t));
+	};
+}
@@ -0,0 +1,279 @@
+#include "wppch.h"
+#include "Profiler.h"
+
+#ifdef WP_PROFILE_ENABLE
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <mutex>
+#include <unordered_map>
+
+namespace Warp {
+
+	// Binary capture layout, little endian:
+	//   header  "WPPF" u32 version
+	//   name    u8 0, u32 nameId, u16 length, chars
+	//   thread  u8 1, u32 threadIndex, u16 length, chars
+	//   event   u8 2, u32 nameId, u32 threadIndex, u64 start ns, u64 end ns
+	constexpr uint32_t BINARY_CAPTURE_VERSION = 1;
+	constexpr uint8_t BINARY_NAME_RECORD = 0;
+	constexpr uint8_t BINARY_THREAD_RECORD = 1;
+	constexpr uint8_t BINARY_EVENT_RECORD = 2;
+
+	// Samples per zone the summary is computed over
+	constexpr size_t ZONE_HISTORY_SIZE = 256;
+
+	struct ZoneStats {
+		uint64_t samples[ZONE_HISTORY_SIZE];
+		size_t count = 0;
+		size_t next = 0;
+
+		void add(uint64_t duration) {
+			samples[next] = duration;
+			next = (next + 1) % ZONE_HISTORY_SIZE;
+			count = std::min(count + 1, ZONE_HISTORY_SIZE);
+		}
+	};
+
+	struct ProfilerState {
+		std::mutex buffersMutex;
+		std::vector<CountedRef<ProfileThreadBuffer>> buffers;
+		uint32_t nextThreadIndex = 0;
+
+		// Only touched from endFrame and the capture functions, which run on the main thread
+		std::unordered_map<const char*, ZoneStats> zones;
+		uint64_t droppedEvents = 0;
+
+		std::ofstream capture;
+		ProfileCaptureFormat captureFormat = ProfileCaptureFormat::ChromeJson;
+		bool firstCaptureEvent = true;
+		uint64_t captureStart = 0;
+		std::unordered_map<const char*, uint32_t> captureNames;
+		std::vector<bool> capturedThreads;
+	};
+
+	static ProfilerState& getState() {
+		static ProfilerState s_State;
+		return s_State;
+	}
+
+	struct ThreadProfileBuffer {
+		CountedRef<ProfileThreadBuffer> buffer;
+
+		~ThreadProfileBuffer() {
+			if (buffer) {
+				buffer->abandoned.store(true, std::memory_order_release);
+			}
+		}
+	};
+
+	static thread_local ThreadProfileBuffer s_ThreadBuffer;
+
+	ProfileThreadBuffer& Profiler::getThreadBuffer() {
+		if (!s_ThreadBuffer.buffer) {
+			auto& state = getState();
+			std::lock_guard<std::mutex> lock(state.buffersMutex);
+			s_ThreadBuffer.buffer = CreateCountedRef<ProfileThreadBuffer>(state.nextThreadIndex++);
+			s_ThreadBuffer.buffer->name = "Thread " + std::to_string(s_ThreadBuffer.buffer->getThreadIndex());
+			state.buffers.push_back(s_ThreadBuffer.buffer);
+		}
+		return *s_ThreadBuffer.buffer;
+	}
+
+	void Profiler::setThreadName(const std::string& name) {
+		auto& buffer = getThreadBuffer();
+		std::lock_guard<std::mutex> lock(getState().buffersMutex);
+		buffer.name = name;
+	}
+
+	static void writeJsonString(std::ofstream& out, const char* text) {
+		out << '"';
+		for (const char* c = text; *c; ++c) {
+			if (*c == '"' || *c == '\\') {
+				out << '\\';
+			}
+			out << *c;
+		}
+		out << '"';
+	}
+
+	template<class T>
+	static void writeBinary(std::ofstream& out, const T& value) {
+		out.write(reinterpret_cast<const char*>(&value), sizeof(T));
+	}
+
+	static void writeBinaryString(std::ofstream& out, uint8_t type, uint32_t id, const std::string& text) {
+		writeBinary(out, type);
+		writeBinary(out, id);
+		writeBinary(out, static_cast<uint16_t>(text.size()));
+		out.write(text.data(), text.size());
+	}
+
+	static void captureThread(ProfilerState& state, ProfileThreadBuffer& buffer) {
+		uint32_t threadIndex = buffer.getThreadIndex();
+		if (threadIndex < state.capturedThreads.size() && state.capturedThreads[threadIndex]) {
+			return;
+		}
+		if (threadIndex >= state.capturedThreads.size()) {
+			state.capturedThreads.resize(threadIndex + 1, false);
+		}
+		state.capturedThreads[threadIndex] = true;
+
+		std::string name;
+		{
+			std::lock_guard<std::mutex> lock(state.buffersMutex);
+			name = buffer.name;
+		}
+
+		if (state.captureFormat == ProfileCaptureFormat::ChromeJson) {
+			state.capture << (state.firstCaptureEvent ? "\n" : ",\n");
+			state.capture << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":" << threadIndex << ",\"args\":{\"name\":";
+			writeJsonString(state.capture, name.c_str());
+			state.capture << "}}";
+			state.firstCaptureEvent = false;
+		}
+		else {
+			writeBinaryString(state.capture, BINARY_THREAD_RECORD, threadIndex, name);
+		}
+	}
+
+	static void captureEvent(ProfilerState& state, uint32_t threadIndex, const ProfileEvent& event) {
+		if (event.start < state.captureStart) {
+			return;
+		}
+
+		if (state.captureFormat == ProfileCaptureFormat::ChromeJson) {
+			// trace_event timestamps are microseconds
+			state.capture << (state.firstCaptureEvent ? "\n" : ",\n");
+			state.capture << "{\"name\":";
+			writeJsonString(state.capture, event.name);
+			state.capture << ",\"ph\":\"X\",\"pid\":0,\"tid\":" << threadIndex
+				<< ",\"ts\":" << (event.start - state.captureStart) / 1000.0
+				<< ",\"dur\":" << (event.end - event.start) / 1000.0 << "}";
+			state.firstCaptureEvent = false;
+			return;
+		}
+
+		auto name = state.captureNames.find(event.name);
+		if (name == state.captureNames.end()) {
+			uint32_t nameId = static_cast<uint32_t>(state.captureNames.size());
+			name = state.captureNames.emplace(event.name, nameId).first;
+			writeBinaryString(state.capture, BINARY_NAME_RECORD, nameId, event.name);
+		}
+
+		writeBinary(state.capture, BINARY_EVENT_RECORD);
+		writeBinary(state.capture, name->second);
+		writeBinary(state.capture, threadIndex);
+		writeBinary(state.capture, event.start - state.captureStart);
+		writeBinary(state.capture, event.end - state.captureStart);
+	}
+
+	void Profiler::endFrame() {
+		auto& state = getState();
+
+		std::vector<CountedRef<ProfileThreadBuffer>> buffers;
+		{
+			std::lock_guard<std::mutex> lock(state.buffersMutex);
+			buffers = state.buffers;
+		}
+
+		bool capturing = state.capture.is_open();
+		for (auto& buffer : buffers) {
+			bool abandoned = buffer->abandoned.load(std::memory_order_acquire);
+			uint32_t threadIndex = buffer->getThreadIndex();
+
+			if (capturing) {
+				captureThread(state, *buffer);
+			}
+			buffer->consume([&](const ProfileEvent& event) {
+				state.zones[event.name].add(event.end - event.start);
+				if (capturing) {
+					captureEvent(state, threadIndex, event);
+				}
+			});
+			state.droppedEvents += buffer->takeDroppedCount();
+
+			if (abandoned) {
+				std::lock_guard<std::mutex> lock(state.buffersMutex);
+				state.buffers.erase(std::remove(state.buffers.begin(), state.buffers.end(), buffer), state.buffers.end());
+			}
+		}
+	}
+
+	bool Profiler::beginCapture(const std::string& path, ProfileCaptureFormat format) {
+		auto& state = getState();
+		if (state.capture.is_open()) {
+			endCapture();
+		}
+
+		state.capture.open(path, std::ios::binary | std::ios::trunc);
+		if (!state.capture.is_open()) {
+			WP_LOG_ERROR("Failed to open profile capture {0}", path);
+			return false;
+		}
+
+		state.captureFormat = format;
+		state.firstCaptureEvent = true;
+		state.captureStart = now();
+		state.captureNames.clear();
+		state.capturedThreads.clear();
+
+		if (format == ProfileCaptureFormat::ChromeJson) {
+			state.capture << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+		}
+		else {
+			state.capture.write("WPPF", 4);
+			writeBinary(state.capture, BINARY_CAPTURE_VERSION);
+		}
+
+		WP_LOG_INFO("Started profile capture {0}", path);
+		return true;
+	}
+
+	void Profiler::endCapture() {
+		auto& state = getState();
+		if (!state.capture.is_open()) {
+			return;
+		}
+
+		// Pick up everything recorded since the last frame
+		endFrame();
+
+		if (state.captureFormat == ProfileCaptureFormat::ChromeJson) {
+			state.capture << "\n]}\n";
+		}
+		state.capture.close();
+	}
+
+	void Profiler::logSummary() {
+		auto& state = getState();
+
+		std::vector<std::pair<const char*, const ZoneStats*>> zones;
+		for (const auto& [name, stats] : state.zones) {
+			zones.emplace_back(name, &stats);
+		}
+		std::sort(zones.begin(), zones.end(), [](const auto& left, const auto& right) { return std::strcmp(left.first, right.first) < 0; });
+
+		WP_LOG_INFO("{0:<40} {1:>10} {2:>10} {3:>10} {4:>8}", "Zone", "min ms", "avg ms", "p99 ms", "samples");
+		std::vector<uint64_t> samples;
+		for (const auto& [name, stats] : zones) {
+			samples.assign(stats->samples, stats->samples + stats->count);
+			std::sort(samples.begin(), samples.end());
+
+			uint64_t sum = 0;
+			for (uint64_t sample : samples) {
+				sum += sample;
+			}
+			size_t p99 = std::min(samples.size() - 1, samples.size() * 99 / 100);
+
+			WP_LOG_INFO("{0:<40} {1:>10.3f} {2:>10.3f} {3:>10.3f} {4:>8}", name, samples.front() / 1e6,
+				sum / 1e6 / samples.size(), samples[p99] / 1e6, samples.size());
+		}
+		if (state.droppedEvents > 0) {
+			WP_LOG_WRN("Profiler dropped {0} events because a thread buffer was full", state.droppedEvents);
+		}
+	}
+}
+
+#endif
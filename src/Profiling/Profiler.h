@@ -0,0 +1,134 @@
+#pragma once
+
+#ifdef WP_PROFILE_ENABLE
+
+#include "Core/Base.h"
+
+#include <atomic>
+#include <chrono>
+#include <string>
+
+namespace Warp {
+
+	enum class ProfileCaptureFormat {
+		// chrome://tracing and Perfetto compatible trace_event JSON
+		ChromeJson,
+		// Name table plus fixed size event records, see Profiler.cpp for the layout
+		Binary
+	};
+
+	struct ProfileEvent {
+		const char* name;
+		uint64_t start;
+		uint64_t end;
+	};
+
+	// Events of one thread. Written lock-free by that thread, drained by the profiler at the end of every frame.
+	class ProfileThreadBuffer : public RefCounted {
+
+	public:
+		static constexpr uint32_t CAPACITY = 16384;
+
+		explicit ProfileThreadBuffer(uint32_t threadIndex) : m_threadIndex(threadIndex) {}
+
+		// Drops the event when the buffer is full, profiling never blocks the caller
+		void push(const ProfileEvent& event) {
+			uint32_t head = m_head.load(std::memory_order_relaxed);
+			if (head - m_tail.load(std::memory_order_acquire) >= CAPACITY) {
+				m_dropped.fetch_add(1, std::memory_order_relaxed);
+				return;
+			}
+			m_events[head % CAPACITY] = event;
+			m_head.store(head + 1, std::memory_order_release);
+		}
+
+		template<class Function>
+		void consume(const Function& function) {
+			uint32_t tail = m_tail.load(std::memory_order_relaxed);
+			uint32_t head = m_head.load(std::memory_order_acquire);
+			for (; tail != head; ++tail) {
+				function(m_events[tail % CAPACITY]);
+			}
+			m_tail.store(tail, std::memory_order_release);
+		}
+
+		uint32_t getThreadIndex() const { return m_threadIndex; }
+
+		uint32_t takeDroppedCount() { return m_dropped.exchange(0, std::memory_order_relaxed); }
+
+		std::string name;
+		std::atomic<bool> abandoned{ false };
+
+	private:
+		uint32_t m_threadIndex;
+
+		alignas(64) std::atomic<uint32_t> m_head{ 0 };
+		alignas(64) std::atomic<uint32_t> m_tail{ 0 };
+		std::atomic<uint32_t> m_dropped{ 0 };
+
+		ProfileEvent m_events[CAPACITY];
+	};
+
+	class Profiler {
+
+	public:
+		static uint64_t now() {
+			return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+		}
+
+		static void record(const char* name, uint64_t start, uint64_t end) {
+			getThreadBuffer().push({ name, start, end });
+		}
+
+		// Names the calling thread in captures
+		static void setThreadName(const std::string& name);
+
+		// Collects the events of all threads into the zone statistics and the active capture, call once per frame
+		static void endFrame();
+
+		static bool beginCapture(const std::string& path, ProfileCaptureFormat format = ProfileCaptureFormat::ChromeJson);
+
+		static void endCapture();
+
+		// Logs min/avg/p99 of the most recent samples of every zone
+		static void logSummary();
+
+	private:
+		static ProfileThreadBuffer& getThreadBuffer();
+	};
+
+	class ProfileScope {
+
+	public:
+		explicit ProfileScope(const char* name) : m_name(name), m_start(Profiler::now()) {}
+
+		~ProfileScope() { Profiler::record(m_name, m_start, Profiler::now()); }
+
+		ProfileScope(const ProfileScope&) = delete;
+		ProfileScope& operator=(const ProfileScope&) = delete;
+
+	private:
+		const char* m_name;
+		uint64_t m_start;
+	};
+}
+
+#define WP_PROFILE_CONCAT_INNER(a, b) a##b
+#define WP_PROFILE_CONCAT(a, b) WP_PROFILE_CONCAT_INNER(a, b)
+
+// name has to outlive the profiler, e.g. a string literal
+#define WP_PROFILE_SCOPE(name) ::Warp::ProfileScope WP_PROFILE_CONCAT(profileScope, __LINE__)(name);
+#define WP_PROFILE_FUNCTION() WP_PROFILE_SCOPE(__FUNCTION__)
+#define WP_PROFILE_THREAD(name) ::Warp::Profiler::setThreadName(name);
+#define WP_PROFILE_END_FRAME() ::Warp::Profiler::endFrame();
+#define WP_PROFILE_LOG_SUMMARY() ::Warp::Profiler::logSummary();
+
+#else
+
+#define WP_PROFILE_SCOPE(name)
+#define WP_PROFILE_FUNCTION()
+#define WP_PROFILE_THREAD(name)
+#define WP_PROFILE_END_FRAME()
+#define WP_PROFILE_LOG_SUMMARY()
+
+#endif
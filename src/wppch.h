@@ -6,9 +6,10 @@
 #include <string>
 #include <vector>
 
-#include "Log\Log.h"
-#include "Core\Base.h"
-#include "Core\Assert.h"
+#include "Log/Log.h"
+#include "Core/Base.h"
+#include "Core/Assert.h"
+#include "Profiling/Profiler.h"
 
 #ifdef WARP_PLATFORM_WINDOWS
 #include <Windows.h>